@@ -61,6 +61,55 @@ async function send(obj) {
   }
 }
 
+// Last full status; SSE deltas are merged into it
+let status = {};
+
+function applyStatus(j) {
+  const valid = !!j.valid;
+
+  $("tempH").textContent = (j.temp_h !== undefined && j.temp_h !== null) ? Number(j.temp_h).toFixed(1) : "—";
+  $("tempL").textContent = (j.temp_l !== undefined && j.temp_l !== null) ? Number(j.temp_l).toFixed(1) : "—";
+  $("ac_out_voltage").textContent = valid && j.ac_out_voltage !== undefined && j.ac_out_voltage !== null ? Number(j.ac_out_voltage).toFixed(1) : "—";
+  $("ac_out_frequency").textContent = valid && j.ac_out_frequency !== undefined && j.ac_out_frequency !== null ? Number(j.ac_out_frequency).toFixed(2) : "—";
+  $("ac_apparent_va").textContent = valid && j.ac_apparent_va !== undefined && j.ac_apparent_va !== null ? String(Math.round(j.ac_apparent_va)) : "—";
+  $("ac_active_w").textContent = valid && j.ac_active_w !== undefined && j.ac_active_w !== null ? String(Math.round(j.ac_active_w)) : "—";
+  $("load_percent").textContent = valid && j.load_percent !== undefined && j.load_percent !== null ? String(Math.round(j.load_percent)) : "—";
+  $("batt_voltage").textContent = valid && j.batt_voltage !== undefined && j.batt_voltage !== null ? Number(j.batt_voltage).toFixed(2) : "—";
+  $("batt_charge_current").textContent = valid && j.batt_charge_current !== undefined && j.batt_charge_current !== null ? Number(j.batt_charge_current).toFixed(2) : "—";
+  $("batt_soc").textContent = valid && j.batt_soc !== undefined && j.batt_soc !== null ? Number(j.batt_soc).toFixed(1) : "—";
+  $("heatsink_temp").textContent = valid && j.heatsink_temp !== undefined && j.heatsink_temp !== null ? Number(j.heatsink_temp).toFixed(1) : "—";
+  $("pv_input_current").textContent = valid && j.pv_input_current !== undefined && j.pv_input_current !== null ? Number(j.pv_input_current).toFixed(2) : "—";
+  $("pv_input_voltage").textContent = valid && j.pv_input_voltage !== undefined && j.pv_input_voltage !== null ? Number(j.pv_input_voltage).toFixed(2) : "—";
+  $("batt_voltage_from_scc").textContent = valid && j.batt_voltage_from_scc !== undefined && j.batt_voltage_from_scc !== null ? Number(j.batt_voltage_from_scc).toFixed(2) : "—";
+  $("batt_discharge_current").textContent = valid && j.batt_discharge_current !== undefined && j.batt_discharge_current !== null ? Number(j.batt_discharge_current).toFixed(2) : "—";
+  $("pv_charging_power").textContent = valid && j.pv_charging_power !== undefined && j.pv_charging_power !== null ? String(Math.round(j.pv_charging_power)) : "—";
+  $("g_inverter_mode_code").textContent = j.g_inverter_mode_code !== undefined && j.g_inverter_mode_code !== null ? j.g_inverter_mode_code : "—";
+  $("g_inverter_mode_name").textContent = j.g_inverter_mode_name !== undefined && j.g_inverter_mode_name !== null ? j.g_inverter_mode_name : "—";
+
+  if (!resetReasonLogged && (j.reset_reason !== undefined || j.reset_reason_str !== undefined)) {
+    const rr = (j.reset_reason_str || "").toString();
+    const rrn = (j.reset_reason !== undefined) ? String(j.reset_reason) : "";
+    const msg = rr || rrn ? `ESP reset reason: ${rr}${rr && rrn ? ` (${rrn})` : rrn ? rrn : ""}` : "ESP reset reason: (unknown)";
+    logln(msg);
+    resetReasonLogged = true;
+  }
+
+  const lim = Math.round(j.output_limit_w ?? -1);
+  if (lastServerLimit !== lim) {
+    lastServerLimit = lim;
+    limEl.value = lim;
+    $("limVal").textContent = lim;
+  }
+  const duty = j.output_duty_cycle !== undefined ? Math.round(j.output_duty_cycle * 100) : -1;
+  if (lastServerDuty !== duty) {
+    lastServerDuty = duty;
+    dutyEl.value = duty;
+    $("dutyVal").textContent = (duty >= 0 ? (duty + ' %') : "—");
+  }
+  updateModified();
+  updateModifiedDuty();
+}
+
 async function fetchStatus() {
   // Add a 1s timeout to the status fetch
   const ctrl = (typeof AbortController !== 'undefined') ? new AbortController() : null;
@@ -68,59 +117,19 @@ async function fetchStatus() {
     try { ctrl && ctrl.abort(); } catch (_) {/* noop */ }
   }, 1000);
   try {
-    const resp = await fetch('/status', { cache: 'no-store', signal: ctrl ? ctrl.signal : undefined });
+    // no-cache: the browser revalidates with If-None-Match, unchanged status is a 304
+    const resp = await fetch('/status', { cache: 'no-cache', signal: ctrl ? ctrl.signal : undefined });
     if (!resp.ok) {
       setConn(false, `HTTP ${resp.status}`);
       logln(`HTTP status ${resp.status}`);
       return;
     }
     const j = await resp.json();
-    setConn(true, "HTTP OK");
+    if (!events) setConn(true, "HTTP OK");
 
     if (j.type === "status") {
-      const valid = !!j.valid;
-
-      $("tempH").textContent = (j.temp_h !== undefined && j.temp_h !== null) ? Number(j.temp_h).toFixed(1) : "—";
-      $("tempL").textContent = (j.temp_l !== undefined && j.temp_l !== null) ? Number(j.temp_l).toFixed(1) : "—";
-      $("ac_out_voltage").textContent = valid && j.ac_out_voltage !== undefined && j.ac_out_voltage !== null ? Number(j.ac_out_voltage).toFixed(1) : "—";
-      $("ac_out_frequency").textContent = valid && j.ac_out_frequency !== undefined && j.ac_out_frequency !== null ? Number(j.ac_out_frequency).toFixed(2) : "—";
-      $("ac_apparent_va").textContent = valid && j.ac_apparent_va !== undefined && j.ac_apparent_va !== null ? String(Math.round(j.ac_apparent_va)) : "—";
-      $("ac_active_w").textContent = valid && j.ac_active_w !== undefined && j.ac_active_w !== null ? String(Math.round(j.ac_active_w)) : "—";
-      $("load_percent").textContent = valid && j.load_percent !== undefined && j.load_percent !== null ? String(Math.round(j.load_percent)) : "—";
-      $("batt_voltage").textContent = valid && j.batt_voltage !== undefined && j.batt_voltage !== null ? Number(j.batt_voltage).toFixed(2) : "—";
-      $("batt_charge_current").textContent = valid && j.batt_charge_current !== undefined && j.batt_charge_current !== null ? Number(j.batt_charge_current).toFixed(2) : "—";
-      $("batt_soc").textContent = valid && j.batt_soc !== undefined && j.batt_soc !== null ? Number(j.batt_soc).toFixed(1) : "—";
-      $("heatsink_temp").textContent = valid && j.heatsink_temp !== undefined && j.heatsink_temp !== null ? Number(j.heatsink_temp).toFixed(1) : "—";
-      $("pv_input_current").textContent = valid && j.pv_input_current !== undefined && j.pv_input_current !== null ? Number(j.pv_input_current).toFixed(2) : "—";
-      $("pv_input_voltage").textContent = valid && j.pv_input_voltage !== undefined && j.pv_input_voltage !== null ? Number(j.pv_input_voltage).toFixed(2) : "—";
-      $("batt_voltage_from_scc").textContent = valid && j.batt_voltage_from_scc !== undefined && j.batt_voltage_from_scc !== null ? Number(j.batt_voltage_from_scc).toFixed(2) : "—";
-      $("batt_discharge_current").textContent = valid && j.batt_discharge_current !== undefined && j.batt_discharge_current !== null ? Number(j.batt_discharge_current).toFixed(2) : "—";
-      $("pv_charging_power").textContent = valid && j.pv_charging_power !== undefined && j.pv_charging_power !== null ? String(Math.round(j.pv_charging_power)) : "—";
-      $("g_inverter_mode_code").textContent = j.g_inverter_mode_code !== undefined && j.g_inverter_mode_code !== null ? j.g_inverter_mode_code : "—";
-      $("g_inverter_mode_name").textContent = j.g_inverter_mode_name !== undefined && j.g_inverter_mode_name !== null ? j.g_inverter_mode_name : "—";
-
-      if (!resetReasonLogged && (j.reset_reason !== undefined || j.reset_reason_str !== undefined)) {
-        const rr = (j.reset_reason_str || "").toString();
-        const rrn = (j.reset_reason !== undefined) ? String(j.reset_reason) : "";
-        const msg = rr || rrn ? `ESP reset reason: ${rr}${rr && rrn ? ` (${rrn})` : rrn ? rrn : ""}` : "ESP reset reason: (unknown)";
-        logln(msg);
-        resetReasonLogged = true;
-      }
-
-      const lim = Math.round(j.output_limit_w ?? -1);
-      if (lastServerLimit !== lim) {
-        lastServerLimit = lim;
-        limEl.value = lim;
-        $("limVal").textContent = lim;
-      }
-      const duty = j.output_duty_cycle !== undefined ? Math.round(j.output_duty_cycle * 100) : -1;
-      if (lastServerDuty !== duty) {
-        lastServerDuty = duty;
-        dutyEl.value = duty;
-        $("dutyVal").textContent = (duty >= 0 ? (duty + ' %') : "—");
-      }
-      updateModified();
-      updateModifiedDuty();
+      status = j;
+      applyStatus(status);
       return;
     }
     logln("MSG: " + JSON.stringify(j));
@@ -137,6 +146,60 @@ async function fetchStatus() {
   }
 }
 
+// --- Push updates (SSE on /events), falling back to polling /status ---
+const POLL_MS = 1250;
+const SSE_FALLBACK_MS = 10000;   // poll while the event stream is down this long
+let events = null;
+let pollTimer = null;
+let sseDownSince = 0;
+
+function startPolling() {
+  if (pollTimer) return;
+  logln("Using /status polling");
+  fetchStatus();
+  pollTimer = setInterval(fetchStatus, POLL_MS);
+}
+
+function stopPolling() {
+  if (!pollTimer) return;
+  clearInterval(pollTimer);
+  pollTimer = null;
+}
+
+function onStatusEvent(ev) {
+  try {
+    const j = JSON.parse(ev.data);
+    // Full frame replaces the state, delta carries only changed fields
+    status = (j.type === "delta") ? Object.assign(status, j) : j;
+    applyStatus(status);
+  } catch (e) {
+    logln("SSE parse error: " + e);
+  }
+}
+
+function startEvents() {
+  if (typeof EventSource === 'undefined') {
+    startPolling();
+    return;
+  }
+  events = new EventSource('/events');
+  events.addEventListener('status', onStatusEvent);
+  events.addEventListener('delta', onStatusEvent);
+  events.onopen = () => {
+    sseDownSince = 0;
+    stopPolling();
+    setConn(true, "SSE OK");
+  };
+  events.onerror = () => {
+    // EventSource reconnects by itself (server sends retry:); poll meanwhile
+    if (!sseDownSince) sseDownSince = Date.now();
+    setConn(false, "SSE reconnecting");
+    if (events.readyState === EventSource.CLOSED || Date.now() - sseDownSince >= SSE_FALLBACK_MS) {
+      startPolling();
+    }
+  };
+}
+
 limEl.addEventListener("input", () => {
   $("limVal").textContent = limEl.value;
   updateModified();
@@ -158,6 +221,6 @@ $("btnApplyDuty").addEventListener("click", () => {
   send({ type: "cmd", name: "set_output_duty_cycle", value: v });
 });
 
-// Initial fetch and schedule polling
+// Initial fetch (also logs reset reason), then push updates
 fetchStatus();
-setInterval(fetchStatus, 1250);
+startEvents();
@@ -0,0 +1,222 @@
+// Closed-loop check of the PV-surplus diversion controller (src/diversion.cpp)
+// against a simple plant: PV with MPPT curtailment, house load, dump load on
+// the AC output and a battery that stops accepting charge as it fills.
+//
+// Each scenario steps one input and reports, for the dump power:
+//   settle    time from the step until it stays within max(50 W, 5 %) of its
+//             final value
+//   overshoot peak above the final value (upward steps) or below it
+//             (downward steps), in % of the step size
+//   disch     peak battery discharge into the dump load after the step [W]
+//             and the energy it took from the battery [Wh] - the cost of
+//             being late or overshooting
+//
+// A trace (CSV from doc/historyDump.py: t,ac_active_w,pv_charging_power,...)
+// is replayed with its house load and PV; PV headroom above what was
+// actually produced is not in the trace, so --pv-headroom adds some.
+//
+// Usage:
+//   g++ -std=gnu++17 -O2 -Isrc -Iinclude -o /tmp/diversionSim doc/diversionSim.cpp src/diversion.cpp
+//   /tmp/diversionSim
+//   /tmp/diversionSim --trace history.csv --pv-headroom 500
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "diversion.h"
+
+static const float BATT_WH = 5000.0f;          // 48 V 100 Ah
+static const float BATT_MAX_CHARGE_W = 3000.0f;
+static const float BATT_FLOAT_W = 30.0f;
+static const float BATT_V = 53.0f;
+static const uint32_t PLANT_STEP_MS = 100;
+static const uint32_t SAMPLE_MS = 1500;        // QPIGS period
+
+struct Plant {
+  float soc = 95.0f;
+  float dump_w = 0.0f;       // applied dump power (PWM averaged over the period)
+  float batt_w = 0.0f;       // + charging, - discharging
+  float pv_w = 0.0f;         // PV actually produced
+
+  // Charge acceptance tapers to a float trickle between 95 and 100 %
+  float accept_w() const {
+    if (soc < 95.0f) return BATT_MAX_CHARGE_W;
+    float f = (100.0f - soc) / 5.0f;
+    return BATT_FLOAT_W + (BATT_MAX_CHARGE_W - BATT_FLOAT_W) * (f < 0 ? 0 : f);
+  }
+
+  void step(float pv_avail, float house_w, float dt_s) {
+    float demand = house_w + dump_w;
+    float used = demand + accept_w();
+    pv_w = pv_avail < used ? pv_avail : used;   // MPPT curtails the rest
+    batt_w = pv_w - demand;
+    soc += batt_w * dt_s / 3600.0f / BATT_WH * 100.0f;
+    if (soc > 100.0f) soc = 100.0f;
+  }
+
+  InverterState sample(uint32_t t_ms, float house_w) const {
+    InverterState s = {};
+    s.ac_active_w = (int)lroundf(house_w + dump_w);
+    s.pv_charging_power = (int)lroundf(pv_w);
+    s.batt_voltage = BATT_V;
+    s.batt_charge_current = batt_w > 0 ? roundf(batt_w / BATT_V) : 0;   // QPIGS gives whole amps
+    s.batt_discharge_current = batt_w < 0 ? roundf(-batt_w / BATT_V) : 0;
+    s.batt_soc = (int)soc;
+    s.ts_ms = t_ms;
+    return s;
+  }
+};
+
+struct Point { uint32_t t_ms; float dump_w; float disch_w; };   // disch_w: caused by the dump load
+
+struct Run {
+  std::vector<Point> pts;
+  float discharge_wh = 0.0f;
+  float diverted_wh = 0.0f;
+};
+
+typedef float (*Profile)(uint32_t t_ms);
+
+static Run simulate(float soc0, uint32_t dur_ms, Profile pv, Profile house, float temp, int limit_w) {
+  Plant p;
+  p.soc = soc0;
+  DiversionController c;
+  Run r;
+  for (uint32_t t = 0; t < dur_ms; t += PLANT_STEP_MS) {
+    p.step(pv(t), house(t), PLANT_STEP_MS / 1000.0f);
+    // Discharge the dump load is responsible for (not the house load at night)
+    if (p.batt_w < 0) r.discharge_wh += fminf(-p.batt_w, p.dump_w) * PLANT_STEP_MS / 3.6e6f;
+    r.diverted_wh += p.dump_w * PLANT_STEP_MS / 3.6e6f;
+    r.pts.push_back({t, p.dump_w, p.batt_w < 0 ? fminf(-p.batt_w, p.dump_w) : 0.0f});
+    if (t % SAMPLE_MS == 0) {
+      c.update(p.sample(t, house(t)), temp, NAN, limit_w);
+      p.dump_w = c.power_w();
+    }
+  }
+  return r;
+}
+
+static void report(const char* name, const Run& r, uint32_t step_ms) {
+  float final_w = r.pts.back().dump_w;
+  float before_w = 0.0f;
+  for (const Point& pt : r.pts) if (pt.t_ms < step_ms) before_w = pt.dump_w;
+  float band = fmaxf(50.0f, 0.05f * fabsf(final_w));
+  uint32_t settled = step_ms;
+  float peak_dev = 0.0f, peak_disch = 0.0f, disch_wh = 0.0f;
+  bool up = final_w >= before_w;
+  for (const Point& pt : r.pts) {
+    if (pt.t_ms < step_ms) continue;
+    if (fabsf(pt.dump_w - final_w) > band) settled = pt.t_ms + PLANT_STEP_MS;
+    float dev = up ? pt.dump_w - final_w : final_w - pt.dump_w;
+    if (dev > peak_dev) peak_dev = dev;
+    if (pt.disch_w > peak_disch) peak_disch = pt.disch_w;
+    disch_wh += pt.disch_w * PLANT_STEP_MS / 3.6e6f;
+  }
+  float span = fabsf(final_w - before_w);
+  printf("%-28s %6.0f -> %6.0f W  settle %5.1f s  overshoot %5.1f %%  disch peak %5.0f W %6.2f Wh\n", name,
+    before_w, final_w, (settled - step_ms) / 1000.0f, span > 1 ? 100.0f * peak_dev / span : 0.0f, peak_disch, disch_wh);
+}
+
+// ---- Step scenarios (step between two samples at 120.7 s, 600 s total) ----
+static const uint32_t STEP_MS = 120700;
+static float house_300(uint32_t) { return 300.0f; }
+static float house_kettle(uint32_t t) { return t >= STEP_MS ? 2300.0f : 300.0f; }
+static float house_kettle_off(uint32_t t) { return t >= STEP_MS ? 300.0f : 2300.0f; }
+static float pv_2500(uint32_t) { return 2500.0f; }
+static float pv_cloud_clear(uint32_t t) { return t >= STEP_MS ? 2500.0f : 800.0f; }
+static float pv_cloud_edge(uint32_t t) { return t >= STEP_MS ? 800.0f : 2500.0f; }
+
+// ---- Trace replay ----
+static std::vector<std::pair<uint32_t, std::pair<float, float>>> g_trace;   // t, (house, pv)
+static float g_headroom = 0.0f;
+
+static const std::pair<float, float>& trace_at(uint32_t t_ms) {
+  size_t lo = 0, hi = g_trace.size();
+  while (hi - lo > 1) {
+    size_t mid = (lo + hi) / 2;
+    if (g_trace[mid].first <= t_ms) lo = mid; else hi = mid;
+  }
+  return g_trace[lo].second;
+}
+static float trace_pv(uint32_t t) { const auto& v = trace_at(t); return v.second > 0 ? v.second + g_headroom : 0.0f; }
+static float trace_house(uint32_t t) { return trace_at(t).first; }
+
+static bool load_trace(const char* path) {
+  FILE* f = fopen(path, "r");
+  if (!f) { perror(path); return false; }
+  char line[1024];
+  int col_t = -1, col_ac = -1, col_pv = -1;
+  double t0 = -1;
+  while (fgets(line, sizeof(line), f)) {
+    std::vector<std::string> cols;
+    for (char* tok = strtok(line, ",\r\n"); tok; tok = strtok(nullptr, ",\r\n")) cols.push_back(tok);
+    if (col_t < 0) {
+      for (size_t i = 0; i < cols.size(); i++) {
+        if (cols[i] == "t") col_t = (int)i;
+        if (cols[i] == "ac_active_w") col_ac = (int)i;
+        if (cols[i] == "pv_charging_power") col_pv = (int)i;
+      }
+      if (col_t < 0 || col_ac < 0 || col_pv < 0) { fprintf(stderr, "%s: need t, ac_active_w, pv_charging_power\n", path); fclose(f); return false; }
+      continue;
+    }
+    if ((int)cols.size() <= col_t || (int)cols.size() <= col_ac || (int)cols.size() <= col_pv) continue;
+    double t = atof(cols[col_t].c_str());
+    if (t0 < 0) t0 = t;
+    g_trace.push_back({(uint32_t)((t - t0) * 1000.0), {(float)atof(cols[col_ac].c_str()), (float)atof(cols[col_pv].c_str())}});
+  }
+  fclose(f);
+  return !g_trace.empty();
+}
+
+// Synthetic day when no trace is given: clear-sky bell with cloud edges,
+// base load with kettle/oven steps
+static void synth_day() {
+  srand(1);
+  float cloud = 1.0f;
+  for (uint32_t t = 6 * 3600; t < 20 * 3600; t += 10) {
+    float sun = sinf((float)M_PI * (t - 6 * 3600) / (14 * 3600.0f));
+    if (rand() % 200 == 0) cloud = cloud < 1.0f ? 1.0f : 0.3f + 0.4f * (rand() % 100) / 100.0f;
+    float house = 250.0f + (rand() % 50);
+    uint32_t h = t / 3600;
+    if ((t / 60) % 97 < 4) house += 2000.0f;     // kettle
+    if (h == 12 && (t % 3600) < 2400) house += 1500.0f;  // oven
+    g_trace.push_back({(t - 6 * 3600) * 1000u, {house, 3200.0f * sun * cloud}});
+  }
+}
+
+int main(int argc, char** argv) {
+  const char* trace = nullptr;
+  float soc0 = 92.0f;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--trace") && i + 1 < argc) trace = argv[++i];
+    else if (!strcmp(argv[i], "--pv-headroom") && i + 1 < argc) g_headroom = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--soc") && i + 1 < argc) soc0 = atof(argv[++i]);
+    else { fprintf(stderr, "usage: %s [--trace history.csv] [--pv-headroom W] [--soc %%]\n", argv[0]); return 2; }
+  }
+
+  printf("Steps (QPIGS every %u ms, limit 2000 W, load %d W):\n", (unsigned)SAMPLE_MS, DIVERSION_LOAD_W);
+  report("cloud clears, SOC 99", simulate(99.0f, 600000, pv_cloud_clear, house_300, NAN, 2000), STEP_MS);
+  report("cloud edge, SOC 99", simulate(99.0f, 600000, pv_cloud_edge, house_300, NAN, 2000), STEP_MS);
+  report("kettle on, SOC 99", simulate(99.0f, 600000, pv_2500, house_kettle, NAN, 2000), STEP_MS);
+  report("kettle off, SOC 99", simulate(99.0f, 600000, pv_2500, house_kettle_off, NAN, 2000), STEP_MS);
+  report("cloud clears, SOC 93", simulate(93.0f, 600000, pv_cloud_clear, house_300, NAN, 2000), STEP_MS);
+  report("cloud clears, 70 C", simulate(99.0f, 600000, pv_cloud_clear, house_300, 70.0f, 2000), STEP_MS);
+  report("cloud clears, limit 1000 W", simulate(99.0f, 600000, pv_cloud_clear, house_300, NAN, 1000), STEP_MS);
+
+  if (trace) {
+    if (!load_trace(trace)) return 1;
+  } else {
+    synth_day();
+  }
+  uint32_t dur = g_trace.back().first;
+  Run r = simulate(soc0, dur, trace_pv, trace_house, NAN, 2000);
+  float pv_wh = 0.0f;
+  for (uint32_t t = 0; t < dur; t += PLANT_STEP_MS) pv_wh += trace_pv(t) * PLANT_STEP_MS / 3.6e6f;
+  printf("\n%s (%.1f h, start SOC %.0f %%):\n", trace ? trace : "synthetic day", dur / 3.6e6, soc0);
+  printf("  diverted %.0f Wh of %.0f Wh PV available, battery discharged by the dump load %.1f Wh\n",
+    r.diverted_wh, pv_wh, r.discharge_wh);
+  return 0;
+}
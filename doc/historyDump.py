@@ -0,0 +1,125 @@
+# -*- coding: utf-8 -*-
+"""
+Decode persisted inverter history (src/history_store.h) to CSV.
+
+Input is any mix of:
+  - segment files copied off the device (/hist/XXXXXXXX.seg)
+  - directories containing segment files
+  - a raw LittleFS partition image (e.g. from `esptool.py read_flash`); this
+    needs the optional `littlefs-python` package (pip install littlefs-python)
+
+Usage:
+  python3 doc/historyDump.py hist/ > history.csv
+  python3 doc/historyDump.py --image littlefs.bin --block-count 352 --from 1700000000
+
+Values are scaled back to engineering units; missing values are left empty.
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+BLOCK_SIZE = 4096
+HEADER = struct.Struct("<IHHII8I")
+RECORD = struct.Struct("<I14h")
+MAGIC = 0x31425348
+NO_VALUE = -32768
+
+# Must match FIELDS[] in src/history.cpp (name, scale)
+FIELDS = [
+    ("grid_voltage", 10),
+    ("ac_out_voltage", 10),
+    ("ac_active_w", 1),
+    ("ac_apparent_va", 1),
+    ("load_percent", 1),
+    ("batt_voltage", 100),
+    ("batt_charge_current", 1),
+    ("batt_discharge_current", 1),
+    ("batt_soc", 1),
+    ("pv_input_voltage", 10),
+    ("pv_input_current", 10),
+    ("pv_charging_power", 1),
+    ("temp_h", 10),
+    ("temp_l", 10),
+]
+
+
+def decode_segment(data, name="", from_t=0):
+    """Yield (t, values) for every record in a segment image."""
+    for off in range(0, len(data) - BLOCK_SIZE + 1, BLOCK_SIZE):
+        magic, rec_size, count, t_first, t_last, *_index = HEADER.unpack_from(data, off)
+        if magic != MAGIC or rec_size != RECORD.size:
+            print("%s: bad block at 0x%x, skipped" % (name, off), file=sys.stderr)
+            continue
+        if t_last < from_t:
+            continue
+        for i in range(count):
+            t, *v = RECORD.unpack_from(data, off + HEADER.size + i * RECORD.size)
+            if t >= from_t:
+                yield t, v
+
+
+def segments_from_paths(paths):
+    for p in paths:
+        if os.path.isdir(p):
+            for n in sorted(os.listdir(p)):
+                if n.endswith(".seg"):
+                    with open(os.path.join(p, n), "rb") as f:
+                        yield n, f.read()
+        else:
+            with open(p, "rb") as f:
+                yield os.path.basename(p), f.read()
+
+
+def segments_from_image(path, block_size, block_count):
+    try:
+        from littlefs import LittleFS
+    except ImportError:
+        sys.exit("--image needs littlefs-python (pip install littlefs-python)")
+    with open(path, "rb") as f:
+        image = f.read()
+    if not block_count:
+        block_count = len(image) // block_size
+    fs = LittleFS(block_size=block_size, block_count=block_count, mount=False)
+    fs.context.buffer = bytearray(image)
+    fs.mount()
+    for n in sorted(fs.listdir("/hist")):
+        if n.endswith(".seg"):
+            with fs.open("/hist/" + n, "rb") as f:
+                yield n, f.read()
+
+
+def fmt(raw, scale):
+    if raw == NO_VALUE:
+        return ""
+    if scale == 1:
+        return str(raw)
+    return "%.*f" % (len(str(scale)) - 1, raw / scale)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("paths", nargs="*", help="segment files or directories")
+    ap.add_argument("--image", help="raw LittleFS partition image")
+    ap.add_argument("--block-size", type=int, default=4096, help="LittleFS block size (default 4096)")
+    ap.add_argument("--block-count", type=int, default=0, help="LittleFS block count (default: image size / block size)")
+    ap.add_argument("--from", dest="from_t", type=int, default=0, help="only records with t >= FROM (epoch s)")
+    args = ap.parse_args()
+    if not args.paths and not args.image:
+        ap.error("give segment paths or --image")
+
+    segs = list(segments_from_paths(args.paths))
+    if args.image:
+        segs += list(segments_from_image(args.image, args.block_size, args.block_count))
+    segs.sort(key=lambda s: s[0])
+
+    out = sys.stdout
+    out.write("t," + ",".join(n for n, _ in FIELDS) + "\n")
+    for name, data in segs:
+        for t, v in decode_segment(data, name, args.from_t):
+            out.write("%d,%s\n" % (t, ",".join(fmt(r, s) for r, (_, s) in zip(v, FIELDS))))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,159 @@
+# -*- coding: utf-8 -*-
+"""
+HTTP load test: show that loop() cadence stays flat while clients hammer
+the web server (which runs in its own task since the esp_http_server move).
+
+Runs for --duration seconds:
+  --clients N   keep-alive clients looping GET /status (+ /history every 10th)
+  --slow M      clients that send half a request and stall (exercise the
+                receive timeout and socket limit)
+  --sse K       /events subscribers
+  --etag        send If-None-Match with the last /status ETag (304 path)
+and every --sample seconds prints the loop() window from GET /events/stats
+(iterations, avg and max period; max is reset on each read) next to the
+request rate and latency seen by the clients.
+
+Usage:
+  python3 doc/httpLoadTest.py --host inverter.local --clients 4 --slow 1 --sse 1 --duration 60
+"""
+
+import argparse
+import http.client
+import json
+import socket
+import threading
+import time
+
+
+class Counters:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.ok = 0
+        self.errors = 0
+        self.lat_ms = []
+
+    def add(self, ok, ms):
+        with self.lock:
+            if ok:
+                self.ok += 1
+                self.lat_ms.append(ms)
+            else:
+                self.errors += 1
+
+    def take(self):
+        with self.lock:
+            ok, err, lat = self.ok, self.errors, self.lat_ms
+            self.ok, self.errors, self.lat_ms = 0, 0, []
+        return ok, err, lat
+
+
+def fast_client(host, port, stop, ctr, use_etag):
+    conn = None
+    etag = None
+    i = 0
+    while not stop.is_set():
+        try:
+            if conn is None:
+                conn = http.client.HTTPConnection(host, port, timeout=5)
+            path = "/history?field=batt_voltage&res=1m" if i % 10 == 9 else "/status"
+            t0 = time.monotonic()
+            headers = {"If-None-Match": etag} if (use_etag and etag and path == "/status") else {}
+            conn.request("GET", path, headers=headers)
+            resp = conn.getresponse()
+            resp.read()
+            if path == "/status":
+                etag = resp.getheader("ETag") or etag
+            ctr.add(resp.status in (200, 304), (time.monotonic() - t0) * 1000)
+        except (OSError, http.client.HTTPException):
+            ctr.add(False, 0)
+            if conn:
+                conn.close()
+            conn = None
+            stop.wait(0.5)
+        i += 1
+    if conn:
+        conn.close()
+
+
+def slow_client(host, port, stop):
+    while not stop.is_set():
+        try:
+            with socket.create_connection((host, port), timeout=30) as s:
+                s.sendall(b"GET /status HTTP/1.1\r\nHost: x\r\n")   # never finish the headers
+                s.recv(1024)   # returns when the server times us out
+        except OSError:
+            pass
+        stop.wait(0.2)
+
+
+def sse_client(host, port, stop):
+    while not stop.is_set():
+        try:
+            with socket.create_connection((host, port), timeout=1) as s:
+                s.sendall(b"GET /events HTTP/1.1\r\nHost: x\r\n\r\n")
+                while not stop.is_set():
+                    try:
+                        if not s.recv(4096):
+                            break
+                    except socket.timeout:
+                        pass
+        except OSError:
+            stop.wait(1)
+
+
+def loop_stats(host, port):
+    conn = http.client.HTTPConnection(host, port, timeout=5)
+    try:
+        conn.request("GET", "/events/stats")
+        return json.loads(conn.getresponse().read())["loop"]
+    finally:
+        conn.close()
+
+
+def pct(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(p / 100.0 * len(values)))]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--host", required=True)
+    ap.add_argument("--port", type=int, default=80)
+    ap.add_argument("--clients", type=int, default=4)
+    ap.add_argument("--slow", type=int, default=0)
+    ap.add_argument("--sse", type=int, default=0)
+    ap.add_argument("--duration", type=int, default=60)
+    ap.add_argument("--sample", type=float, default=5.0)
+    ap.add_argument("--etag", action="store_true", help="revalidate /status with If-None-Match")
+    args = ap.parse_args()
+
+    stop = threading.Event()
+    ctr = Counters()
+    loop_stats(args.host, args.port)   # reset the window
+    threads = [threading.Thread(target=fast_client, args=(args.host, args.port, stop, ctr, args.etag)) for _ in range(args.clients)]
+    threads += [threading.Thread(target=slow_client, args=(args.host, args.port, stop)) for _ in range(args.slow)]
+    threads += [threading.Thread(target=sse_client, args=(args.host, args.port, stop)) for _ in range(args.sse)]
+    for t in threads:
+        t.daemon = True
+        t.start()
+
+    print("  t[s]  req/s  err  p50[ms]  p95[ms] | loop iters  avg[us]  max[us]")
+    t_end = time.monotonic() + args.duration
+    t_start = time.monotonic()
+    while time.monotonic() < t_end:
+        time.sleep(args.sample)
+        ok, err, lat = ctr.take()
+        try:
+            ls = loop_stats(args.host, args.port)
+        except (OSError, http.client.HTTPException, ValueError, KeyError):
+            ls = {"iterations": 0, "avg_us": 0, "max_us": 0}
+        print("%6.0f %6.1f %4d %8.1f %8.1f | %10d %8d %8d" % (
+            time.monotonic() - t_start, ok / args.sample, err, pct(lat, 50), pct(lat, 95),
+            ls["iterations"], ls["avg_us"], ls["max_us"]))
+    stop.set()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,206 @@
+// Simulated-time run of the inquiry scheduler (src/inverter_sched.cpp) with
+// the firmware's schedule table and duration seeding (inverter_comm.cpp) on a
+// modelled 2400 baud link: a transaction takes the request bytes, the
+// inverter's response latency (+/- jitter) and the response bytes. Response
+// lengths are the expected_rx_len values of g_cmd_defs.
+//
+// QPGS answers go through ParallelSystem (src/parallel.cpp) as in the
+// firmware: with --units 0 a standalone inverter answers the QPGS0 probe and
+// QPGS stays a background command; with --units N the units are discovered
+// and polled round-robin. After every QPIGS the period is recomputed as
+// adapt_poll_rate() does: the requested period (--period, what the poll
+// rate controller asked for; 0 = a transient, i.e. the floor) but never
+// below the link floor from the current estimates. --no-slack drops the
+// longest-background-inquiry term from the floor.
+//
+// Reported:
+//   QPIGS     start-to-start interval min/mean/max against the period
+//   per cmd   runs, deadline misses, skipped releases, worst start delay
+//             after release and the final duration estimate
+//   link      busy share over the whole run and the worst 10 s window
+//   parallel  units found, final period and floor
+//
+// Usage:
+//   g++ -std=gnu++17 -O2 -Isrc -Iinclude -o /tmp/inquirySchedSim doc/inquirySchedSim.cpp src/inverter_sched.cpp src/parallel.cpp
+//   /tmp/inquirySchedSim
+//   /tmp/inquirySchedSim --minutes 60 --latency 50 --jitter 20 --period 1200
+//   /tmp/inquirySchedSim --units 2 --period 0
+
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "inverter_sched.h"
+#include "parallel.h"
+
+#define POLL_DEFAULT_MS                 1500    // src/poll_rate.h
+#define PARALLEL_PROBE_MS               60000   // src/parallel.h
+#define INVERTER_FIRST_BYTE_TIMEOUT_MS  300     // src/inverter_uart.h
+#define BAUD                            2400    // INVERTER_BAUD in config.h
+#define SCHED_IDX_QPIGS                 0       // inverter_comm.cpp
+#define SCHED_IDX_QMOD                  1
+#define SCHED_IDX_QPGS                  2
+#define QPGS_PROBE_PRIORITY             2
+#define QPGS_UNIT_PRIORITY              1
+
+struct CmdDef {
+  const char* name;
+  size_t frame_len;        // request incl. CRC and CR
+  size_t expected_rx_len;  // full response incl. '(' CRC CR
+};
+
+// g_cmd_defs in inverter_comm.cpp, indexed by the SchedEntry cmd below
+static const CmdDef CMDS[] = {
+  { "QPIGS", 8, 110 }, { "QMOD", 7, 5 },  { "QPGS", 8, 133 }, { "QPIWS", 8, 40 },
+  { "QFLAG", 8, 16 },  { "QPIRI", 8, 102 }, { "QDI", 6, 84 }, { "QVFW", 7, 18 },
+};
+
+// SCHEDULE in inverter_comm.cpp (cmd = index into CMDS)
+static SchedEntry g_schedule[] = {
+  { 0, POLL_DEFAULT_MS, 0, 250, 0 },
+  { 1, POLL_DEFAULT_MS, 0, 750, 0 },
+  { 2, PARALLEL_PROBE_MS, 2, PARALLEL_PROBE_MS, 0 },
+  { 3, 10000, 1, 10000, 0 },
+  { 4, 60000, 2, 60000, 0 },
+  { 5, 60000, 2, 60000, 0 },
+  { 6, 600000, 3, 600000, 0 },
+  { 7, 3600000, 3, 3600000, 0 },
+};
+static const size_t SCHEDULE_LEN = sizeof(g_schedule) / sizeof(g_schedule[0]);
+
+static InquiryScheduler g_sched;
+static ParallelSystem g_parallel;
+
+// Same formula as inverter_uart_timeout_ms()
+static uint32_t bytes_time_ms(size_t n) { return (uint32_t)((n * 10 * 1000 + BAUD - 1) / BAUD); }
+static uint32_t timeout_ms(size_t tx_len, size_t rx_len) {
+  uint32_t rx_ms = bytes_time_ms(rx_len);
+  return bytes_time_ms(tx_len) + INVERTER_FIRST_BYTE_TIMEOUT_MS + rx_ms + rx_ms / 4;
+}
+
+// tune_schedule() in inverter_comm.cpp
+static void tune_schedule(uint32_t period, uint32_t now) {
+  g_sched.set_period(SCHED_IDX_QPIGS, period, now);
+  g_sched.set_period(SCHED_IDX_QMOD, period < POLL_DEFAULT_MS ? POLL_DEFAULT_MS : period, now);
+  uint8_t units = g_parallel.count();
+  if (units) {
+    g_sched.set_priority(SCHED_IDX_QPGS, QPGS_UNIT_PRIORITY, period);
+    g_sched.set_period(SCHED_IDX_QPGS, period / units, now);
+  } else {
+    g_sched.set_priority(SCHED_IDX_QPGS, QPGS_PROBE_PRIORITY, PARALLEL_PROBE_MS);
+    g_sched.set_period(SCHED_IDX_QPGS, PARALLEL_PROBE_MS, now);
+  }
+}
+
+// Link floor of adapt_poll_rate() in inverter_comm.cpp
+static uint32_t poll_floor(bool slack_term) {
+  uint32_t min_ms = g_sched.stats(SCHED_IDX_QPIGS).est_ms + g_sched.stats(SCHED_IDX_QMOD).est_ms + 50;
+  uint8_t units = g_parallel.count();
+  if (units) {
+    uint32_t slack = 0;
+    for (size_t i = 0; slack_term && i < g_sched.size(); ++i) {
+      if (i == SCHED_IDX_QPGS || g_schedule[i].priority == 0) continue;
+      if (g_sched.stats(i).est_ms > slack) slack = g_sched.stats(i).est_ms;
+    }
+    min_ms += units * g_sched.stats(SCHED_IDX_QPGS).est_ms + slack;
+  }
+  return min_ms;
+}
+
+int main(int argc, char** argv) {
+  double minutes = 10, latency_ms = 30, jitter_ms = 10;   // inverterEmulator.py defaults
+  uint32_t requested = POLL_DEFAULT_MS;
+  int units = 0;
+  bool slack_term = true;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--minutes") && i + 1 < argc) minutes = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--latency") && i + 1 < argc) latency_ms = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--jitter") && i + 1 < argc) jitter_ms = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--period") && i + 1 < argc) requested = (uint32_t)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--units") && i + 1 < argc) units = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--no-slack")) slack_term = false;
+    else {
+      fprintf(stderr, "usage: %s [--minutes 10] [--latency 30] [--jitter 10] [--period 1500, 0 = floor] "
+              "[--units 0..%d] [--no-slack]\n", argv[0], INVERTER_MAX_UNITS);
+      return 2;
+    }
+  }
+  if (units < 0 || units > INVERTER_MAX_UNITS) {
+    fprintf(stderr, "%s: --units must be 0..%d\n", argv[0], INVERTER_MAX_UNITS);
+    return 2;
+  }
+
+  for (size_t i = 0; i < SCHEDULE_LEN; ++i) {
+    const CmdDef& d = CMDS[g_schedule[i].cmd];
+    g_schedule[i].est_ms = timeout_ms(d.frame_len, d.expected_rx_len);
+  }
+  uint32_t now = 1000;
+  g_sched.begin(g_schedule, SCHEDULE_LEN, now);
+  uint32_t period = requested > POLL_DEFAULT_MS || requested == 0 ? POLL_DEFAULT_MS : requested;
+  tune_schedule(period, now);
+
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> jitter(-1.0, 1.0);
+  const uint32_t end = now + (uint32_t)(minutes * 60000.0);
+  uint32_t last_qpigs = 0, iv_min = UINT32_MAX, iv_max = 0, util_max = 0;
+  uint64_t iv_sum = 0, iv_n = 0;
+  uint32_t qpgs_polls[INVERTER_MAX_UNITS] = {};
+
+  while (now < end) {
+    uint32_t wait = 0;
+    int idx = g_sched.next(now, &wait);
+    if (idx < 0) {
+      now += wait;
+      continue;
+    }
+    uint8_t unit = idx == SCHED_IDX_QPGS ? g_parallel.next_unit(now) : 0;
+    const CmdDef& d = CMDS[g_schedule[idx].cmd];
+    double lat = latency_ms + jitter(rng) * jitter_ms;
+    uint32_t dur = bytes_time_ms(d.frame_len) + (uint32_t)(lat > 0 ? lat : 0) + bytes_time_ms(d.expected_rx_len);
+    uint32_t start = now;
+    now += dur;
+    g_sched.complete(idx, start, now);
+
+    if (idx == SCHED_IDX_QPIGS) {
+      if (last_qpigs) {
+        uint32_t iv = start - last_qpigs;
+        if (iv < iv_min) iv_min = iv;
+        if (iv > iv_max) iv_max = iv;
+        iv_sum += iv;
+        iv_n++;
+      }
+      last_qpigs = start;
+      uint32_t floor = poll_floor(slack_term);
+      period = requested > floor ? requested : floor;
+      tune_schedule(period, now);
+    } else if (idx == SCHED_IDX_QPGS) {
+      // Units 0..units-1 answer in parallel mode, higher indices "not present";
+      // a standalone inverter answers QPGS0 in output mode 0
+      InverterUnitState u = {};
+      u.present = unit < units || unit == 0;
+      u.output_mode = unit < units ? 1 : 0;
+      qpgs_polls[unit]++;
+      uint8_t before = g_parallel.count();
+      if (g_parallel.apply(unit, &u, now) && g_parallel.count() != before) tune_schedule(period, now);
+    }
+    if (g_sched.link().util_permille > util_max) util_max = g_sched.link().util_permille;
+  }
+
+  printf("sim: %.0f min, period %u ms requested, latency %.0f +/- %.0f ms, %u baud, %d unit(s)%s\n", minutes,
+         (unsigned)requested, latency_ms, jitter_ms, BAUD, units, slack_term ? "" : ", no slack term");
+  if (iv_n)
+    printf("QPIGS interval: min %u  mean %.1f  max %u ms\n", (unsigned)iv_min, (double)iv_sum / iv_n, (unsigned)iv_max);
+  printf("%-6s %6s %6s %7s %9s %6s\n", "cmd", "runs", "miss", "skipped", "max late", "est");
+  for (size_t i = 0; i < g_sched.size(); ++i) {
+    const SchedCmdStats& s = g_sched.stats(i);
+    printf("%-6s %6u %6u %7u %6u ms %3u ms\n", CMDS[g_schedule[i].cmd].name, (unsigned)s.runs,
+           (unsigned)s.deadline_misses, (unsigned)s.skipped, (unsigned)s.max_lateness_ms, (unsigned)s.est_ms);
+  }
+  double total = minutes * 60000.0;
+  printf("link: busy %.1f %% of the run, worst %u ms window %.1f %%\n", 100.0 * g_sched.link().busy_ms / total,
+         (unsigned)SCHED_UTIL_WINDOW_MS, util_max / 10.0);
+  printf("parallel: %u unit(s) found, QPGSn polls", (unsigned)g_parallel.count());
+  for (int u = 0; u < INVERTER_MAX_UNITS; ++u) printf(" %u", (unsigned)qpgs_polls[u]);
+  printf(", period %u ms, floor %u ms\n", (unsigned)period, (unsigned)poll_floor(slack_term));
+  return 0;
+}
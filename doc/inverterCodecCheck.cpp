@@ -0,0 +1,338 @@
+// Host check and micro-benchmark for the Arduino-free inverter codec:
+// CRC-16/XMODEM and frame building (src/inverter_crc.h), the streaming
+// response parser (src/inverter_frame.h) and the payload parsers
+// (src/inverter_parse.cpp).
+//
+// Checks:
+//   crc      table update against the bitwise reference over random buffers,
+//            the standard check value ("123456789" -> 0x31C3)
+//   frames   every precomputed inv_frames:: request against
+//            inverter_build_frame() and the reference, incl. reserved-byte
+//            adjustment of the CRC
+//   parser   random responses fed byte by byte: Complete with the payload
+//            intact, one flipped bit -> CrcError, NAK with and without CRC,
+//            Malformed and Overflow
+//   decode   tokenizer, fixed point (padding, truncation, signs, int32
+//            limits) and bit strings
+//   payloads the protocol examples of QPIGS, QPGSn and QMOD field by field,
+//            short or non-numeric payloads rejected with out untouched, and
+//            random mutations of the QPIGS example (build with
+//            -fsanitize=address,undefined to catch out-of-bounds reads)
+// Bench: ns per byte for the CRC, ns per frame for FrameParser and ns per
+// QPIGS parse (host CPU, only useful to compare changes against each other).
+//
+// Exits 1 if any check fails.
+//
+// Usage:
+//   g++ -std=gnu++17 -O2 -Isrc -Iinclude -o /tmp/inverterCodecCheck doc/inverterCodecCheck.cpp src/inverter_parse.cpp
+//   /tmp/inverterCodecCheck
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "inverter_crc.h"
+#include "inverter_frame.h"
+#include "inverter_parse.h"
+
+static int g_checks = 0;
+static int g_failed = 0;
+
+#define CHECK(cond, ...)                                          \
+  do {                                                            \
+    g_checks++;                                                   \
+    if (!(cond)) {                                                \
+      g_failed++;                                                 \
+      printf("  FAIL %s:%d: %s: ", __FILE__, __LINE__, #cond);    \
+      printf(__VA_ARGS__);                                        \
+      printf("\n");                                               \
+    }                                                             \
+  } while (0)
+
+static std::mt19937 rng(1);
+
+// Same as doc/inverterTest.py
+static uint16_t crc_reference(const uint8_t* p, size_t n) {
+  uint16_t crc = 0;
+  for (size_t i = 0; i < n; ++i) {
+    crc ^= (uint16_t)(p[i] << 8);
+    for (int b = 0; b < 8; ++b) crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
+
+// '(' payload CRC CR as the inverter sends it; the CRC covers the '('
+static std::vector<uint8_t> make_response(const std::string& payload) {
+  std::vector<uint8_t> f;
+  f.reserve(payload.size() + 4);
+  f.push_back('(');
+  for (char c : payload) f.push_back((uint8_t)c);
+  uint16_t crc = crc_reference(f.data(), f.size());
+  f.push_back(adjust_crc_byte((uint8_t)(crc >> 8)));
+  f.push_back(adjust_crc_byte((uint8_t)(crc & 0xFF)));
+  f.push_back(0x0D);
+  return f;
+}
+
+static FrameStatus feed_all(FrameParser& fp, const std::vector<uint8_t>& f) {
+  FrameStatus st = FrameStatus::InProgress;
+  for (uint8_t b : f) {
+    st = fp.feed(b);
+    if (st != FrameStatus::InProgress) break;
+  }
+  return st;
+}
+
+static std::string random_payload(size_t n) {
+  // Printable like real answers, so a CR or '(' never lands in the payload
+  std::uniform_int_distribution<int> ch(0x20, 0x7E);
+  std::string s;
+  for (size_t i = 0; i < n; ++i) {
+    char c = (char)ch(rng);
+    s += c == '(' ? ')' : c;
+  }
+  return s;
+}
+
+static void check_crc() {
+  printf("crc\n");
+  const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+  CHECK(crc16_xmodem(check, sizeof(check)) == 0x31C3, "got %04X", crc16_xmodem(check, sizeof(check)));
+  std::uniform_int_distribution<int> byte(0, 255), len(0, 128);
+  for (int i = 0; i < 2000; ++i) {
+    std::vector<uint8_t> buf(len(rng));
+    for (auto& b : buf) b = (uint8_t)byte(rng);
+    uint16_t a = crc16_xmodem(buf.data(), buf.size());
+    uint16_t r = crc_reference(buf.data(), buf.size());
+    CHECK(a == r, "len %zu table %04X reference %04X", buf.size(), a, r);
+    if (a != r) break;
+  }
+}
+
+template <size_t N>
+static void check_frame(const char* cmd, const InverterTxFrame<N>& f) {
+  size_t n = strlen(cmd);
+  uint8_t built[32];
+  size_t len = inverter_build_frame(cmd, n, built);
+  uint16_t crc = crc_reference((const uint8_t*)cmd, n);
+  CHECK(len == N && memcmp(built, f.data(), N) == 0, "%s: build_frame differs from inv_frames", cmd);
+  CHECK(f.bytes[n] == adjust_crc_byte((uint8_t)(crc >> 8)) && f.bytes[n + 1] == adjust_crc_byte((uint8_t)crc) &&
+        f.bytes[n + 2] == 0x0D, "%s: CRC %04X, frame has %02X %02X", cmd, crc, f.bytes[n], f.bytes[n + 1]);
+}
+
+static void check_frames() {
+  printf("frames\n");
+  check_frame("QPI", inv_frames::QPI);
+  check_frame("QID", inv_frames::QID);
+  check_frame("QSID", inv_frames::QSID);
+  check_frame("QVFW", inv_frames::QVFW);
+  check_frame("QVFW2", inv_frames::QVFW2);
+  check_frame("QPIRI", inv_frames::QPIRI);
+  check_frame("QFLAG", inv_frames::QFLAG);
+  check_frame("QPIGS", inv_frames::QPIGS);
+  check_frame("QMOD", inv_frames::QMOD);
+  check_frame("QPIWS", inv_frames::QPIWS);
+  check_frame("QDI", inv_frames::QDI);
+  check_frame("QMCHGCR", inv_frames::QMCHGCR);
+  check_frame("QMUCHGCR", inv_frames::QMUCHGCR);
+  check_frame("QBOOT", inv_frames::QBOOT);
+  check_frame("QOPM", inv_frames::QOPM);
+  check_frame("QPGS0", inv_frames::QPGS0);
+  check_frame("QPGS1", inv_frames::QPGS1);
+  check_frame("QPGS2", inv_frames::QPGS2);
+  check_frame("QPGS3", inv_frames::QPGS3);
+}
+
+static void check_parser() {
+  printf("parser\n");
+  uint8_t buf[128];
+  FrameParser fp;
+  std::uniform_int_distribution<int> len(0, 110);
+  int adjusted = 0;
+  for (int i = 0; i < 2000; ++i) {
+    std::string payload = random_payload(len(rng));
+    std::vector<uint8_t> f = make_response(payload);
+    uint16_t crc = crc_reference(f.data(), f.size() - 3);
+    if (f[f.size() - 3] != (uint8_t)(crc >> 8) || f[f.size() - 2] != (uint8_t)crc) adjusted++;
+
+    fp.reset(buf, sizeof(buf));
+    FrameStatus st = feed_all(fp, f);
+    bool nak = payload == "NAK";
+    CHECK(st == (nak ? FrameStatus::Nak : FrameStatus::Complete), "payload \"%s\": status %d", payload.c_str(), (int)st);
+    if (st != FrameStatus::Complete) continue;
+    CHECK(fp.payload_length() == payload.size() && memcmp(fp.payload(), payload.data(), payload.size()) == 0,
+          "payload \"%s\" not returned intact", payload.c_str());
+
+    // Any single bit flip in payload or CRC is caught (CRC-16 detects all of them)
+    std::uniform_int_distribution<size_t> pos(1, f.size() - 2);
+    std::vector<uint8_t> bad = f;
+    size_t at = pos(rng);
+    bad[at] ^= (uint8_t)(1u << (rng() % 8));
+    if (bad[at] == 0x0D || bad[at] == '(') continue;   // turned into a frame boundary
+    fp.reset(buf, sizeof(buf));
+    st = feed_all(fp, bad);
+    CHECK(st == FrameStatus::CrcError, "flip at %zu of \"%s\": status %d", at, payload.c_str(), (int)st);
+  }
+  CHECK(adjusted > 0, "no random frame exercised the reserved-byte adjustment");
+
+  const uint8_t nak_plain[] = { '(', 'N', 'A', 'K', 0x0D };
+  fp.reset(buf, sizeof(buf));
+  CHECK(feed_all(fp, std::vector<uint8_t>(nak_plain, nak_plain + sizeof(nak_plain))) == FrameStatus::Nak, "NAK without CRC");
+  fp.reset(buf, sizeof(buf));
+  CHECK(feed_all(fp, make_response("NAK")) == FrameStatus::Nak, "NAK with CRC");
+  fp.reset(buf, sizeof(buf));
+  CHECK(feed_all(fp, { 'X', 'N', 'A', 'K', 0x0D }) == FrameStatus::Malformed, "missing '('");
+  fp.reset(buf, sizeof(buf));
+  CHECK(feed_all(fp, { '(', 'A', 0x0D }) == FrameStatus::Malformed, "shorter than '(' + CRC");
+  fp.reset(buf, 16);
+  CHECK(feed_all(fp, make_response(random_payload(20))) == FrameStatus::Overflow, "frame past the buffer");
+}
+
+static TokenSpan span(const char* p) { return TokenSpan{ p, (uint8_t)strlen(p) }; }
+static bool near(float a, float b) { return a - b < 0.001f && b - a < 0.001f; }
+
+static void check_decode() {
+  printf("decode\n");
+  TokenSpan t[8];
+  const char* line = "  12 3.5   -7 ";
+  size_t n = inverter_tokenize(line, strlen(line), t, 8);
+  CHECK(n == 3 && t[0].n == 2 && t[1].n == 3 && t[2].n == 2 && t[2].p[0] == '-', "got %zu tokens", n);
+  CHECK(inverter_tokenize(line, strlen(line), t, 2) == 2, "max_tokens not honoured");
+  CHECK(inverter_tokenize("", 0, t, 8) == 0, "empty payload");
+
+  struct Case { const char* s; uint8_t dec; bool ok; int32_t v; };
+  static const Case CASES[] = {
+    { "230.0", 1, true, 2300 },        { "49.9", 2, true, 4990 },       { "57.456", 2, true, 5745 },
+    { "0161", 0, true, 161 },          { "-12", 0, true, -12 },          { "+3.25", 1, true, 32 },
+    { "7.", 1, true, 70 },             { ".5", 1, true, 5 },             { "2147483647", 0, true, 2147483647 },
+    { "-2147483647", 0, true, -2147483647 },                             { "99999.99999", 4, true, 999999999 },
+    { "2147483648", 0, false, 0 },     { "21474836.48", 2, false, 0 },   { "999999999", 2, false, 0 },
+    { "", 0, false, 0 },               { "-", 0, false, 0 },             { ".", 1, false, 0 },
+    { "1.2.3", 1, false, 0 },          { "12a", 0, false, 0 },           { "1", 5, false, 0 },
+  };
+  for (const Case& c : CASES) {
+    int32_t v = -1;
+    bool ok = inverter_decode_fixed(span(c.s), c.dec, &v);
+    CHECK(ok == c.ok && (!ok || v == c.v), "\"%s\" decimals %u: ok %d value %d", c.s, (unsigned)c.dec, ok, (int)v);
+  }
+
+  uint32_t bits = 0;
+  CHECK(inverter_decode_bits(span("00110110"), &bits) && bits == 0x36, "bits %08X", (unsigned)bits);
+  CHECK(!inverter_decode_bits(span("0012"), &bits), "non-binary digit accepted");
+  CHECK(!inverter_decode_bits(span("000000000000000000000000000000001"), &bits), "33 bits accepted");
+}
+
+// Examples from doc/ps_rs232_protocol_FULL_ai_ready.txt
+static const char QPIGS_EXAMPLE[] =
+  "000.0 00.0 230.0 49.9 0161 0119 003 460 57.50 012 100 0069 0014 103.8 57.45 00000 00110110 00 00 00856 010";
+static const char QPGS_EXAMPLE[] =
+  "1 92931701100510 B 00 000.0 00.00 230.0 50.00 0161 0119 003 51.1 012 100 000.0 012 00161 00119 003 10100110 1 2 060 080 10 00 000";
+
+static void check_payloads() {
+  printf("payloads\n");
+  InverterState s = {};
+  CHECK(inverter_parse_qpigs(QPIGS_EXAMPLE, strlen(QPIGS_EXAMPLE), &s), "QPIGS example rejected");
+  CHECK(near(s.ac_out_voltage, 230.0f) && near(s.ac_out_frequency, 49.9f) && s.ac_apparent_va == 161 &&
+        s.ac_active_w == 119 && s.load_percent == 3 && near(s.bus_voltage, 460) && near(s.batt_voltage, 57.5f) &&
+        near(s.batt_charge_current, 12) && s.batt_soc == 100 && near(s.heatsink_temp, 69) &&
+        near(s.pv_input_current, 14.0f) && near(s.pv_input_voltage, 103.8f) && near(s.batt_voltage_from_scc, 57.45f) &&
+        near(s.batt_discharge_current, 0) && s.device_status_bits == 0x36 && s.pv_charging_power == 856 &&
+        s.additional_status_bits == 0x02, "QPIGS fields: out %.1f V batt %.2f V pv %.1f V %d W", s.ac_out_voltage,
+        s.batt_voltage, s.pv_input_voltage, s.pv_charging_power);
+
+  // Rejected payloads leave out untouched
+  InverterState before = s;
+  std::string shortp(QPIGS_EXAMPLE, strrchr(QPIGS_EXAMPLE, ' ') - QPIGS_EXAMPLE);
+  CHECK(!inverter_parse_qpigs(shortp.c_str(), shortp.size(), &s), "20-field QPIGS accepted");
+  std::string bad = QPIGS_EXAMPLE;
+  bad[bad.find("57.50")] = 'x';
+  CHECK(!inverter_parse_qpigs(bad.c_str(), bad.size(), &s), "non-numeric QPIGS field accepted");
+  CHECK(memcmp(&before, &s, sizeof(s)) == 0, "rejected QPIGS modified out");
+
+  InverterUnitState u = {};
+  CHECK(inverter_parse_qpgs(QPGS_EXAMPLE, strlen(QPGS_EXAMPLE), &u), "QPGS example rejected");
+  CHECK(u.present && !strcmp(u.serial, "92931701100510") && u.work_mode == 'B' && u.fault_code == 0 &&
+        near(u.ac_out_voltage, 230.0f) && near(u.ac_out_frequency, 50.0f) && u.ac_active_w == 119 &&
+        near(u.batt_voltage, 51.1f) && u.batt_soc == 100 && u.total_active_w == 119 && u.status_bits == 0xA6 &&
+        u.output_mode == 1 && u.charger_priority == 2 && u.max_charge_current == 60 && u.max_ac_charge_current == 10,
+        "QPGS fields: serial %s mode %c batt %.1f V", u.serial, u.work_mode, u.batt_voltage);
+  std::string absent = QPGS_EXAMPLE;
+  absent[0] = '0';
+  CHECK(inverter_parse_qpgs(absent.c_str(), absent.size(), &u) && !u.present, "absent unit");
+  std::string longserial = QPGS_EXAMPLE;
+  longserial.insert(2, "0");
+  CHECK(!inverter_parse_qpgs(longserial.c_str(), longserial.size(), &u), "15-digit serial accepted");
+
+  const char* name = nullptr;
+  static const char MODES[] = "PSLBFH";
+  for (const char* m = MODES; *m; ++m) {
+    CHECK(inverter_parse_qmod(m, 1, &name) == *m && strcmp(name, "Unknown") != 0, "QMOD %c", *m);
+  }
+  CHECK(inverter_parse_qmod("X", 1, &name) == 'X' && !strcmp(name, "Unknown"), "unknown QMOD code");
+  CHECK(inverter_parse_qmod("", 0, &name) == '\0' && !strcmp(name, "Unknown"), "empty QMOD");
+
+  // Mutations: must never crash or read past len; count what still parses
+  std::uniform_int_distribution<int> ch(0x20, 0x7E);
+  int accepted = 0;
+  for (int i = 0; i < 20000; ++i) {
+    std::string m = QPIGS_EXAMPLE;
+    int edits = 1 + (int)(rng() % 4);
+    for (int e = 0; e < edits; ++e) {
+      size_t at = rng() % m.size();
+      switch (rng() % 3) {
+        case 0: m[at] = (char)ch(rng); break;
+        case 1: m.erase(at, 1); break;
+        default: m.insert(at, 1, (char)ch(rng)); break;
+      }
+    }
+    // Parse from a heap copy of exactly len bytes so ASan sees overreads
+    std::vector<char> exact(m.begin(), m.end());
+    if (inverter_parse_qpigs(exact.data(), exact.size(), &s)) accepted++;
+  }
+  printf("  %d of 20000 mutated QPIGS payloads still parse\n", accepted);
+}
+
+template <typename F>
+static double ns_per_iter(int iters, F&& f) {
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < iters; ++i) f();
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / iters;
+}
+
+static volatile uint32_t g_sink;
+
+static void bench() {
+  printf("bench (host CPU)\n");
+  std::vector<uint8_t> buf(110);
+  for (auto& b : buf) b = (uint8_t)rng();
+  double table = ns_per_iter(200000, [&] { g_sink += crc16_xmodem(buf.data(), buf.size()); });
+  double ref = ns_per_iter(200000, [&] { g_sink += crc_reference(buf.data(), buf.size()); });
+  printf("  crc 110 B     table %6.1f ns (%.2f ns/B)   bitwise %6.1f ns\n", table, table / buf.size(), ref);
+
+  std::vector<uint8_t> f = make_response(random_payload(106));
+  uint8_t rx[128];
+  FrameParser fp;
+  double parse = ns_per_iter(200000, [&] {
+    fp.reset(rx, sizeof(rx));
+    g_sink += (uint32_t)feed_all(fp, f);
+  });
+  printf("  FrameParser   %zu B frame %6.1f ns\n", f.size(), parse);
+
+  InverterState s;
+  double qpigs = ns_per_iter(200000, [&] { g_sink += inverter_parse_qpigs(QPIGS_EXAMPLE, sizeof(QPIGS_EXAMPLE) - 1, &s); });
+  printf("  QPIGS parse   %6.1f ns\n", qpigs);
+}
+
+int main() {
+  check_crc();
+  check_frames();
+  check_parser();
+  check_decode();
+  check_payloads();
+  bench();
+  printf("%d checks, %d failed\n", g_checks, g_failed);
+  return g_failed ? 1 : 0;
+}
@@ -0,0 +1,516 @@
+# -*- coding: utf-8 -*-
+"""
+Host-side PS RS232 inverter emulator + poll benchmark (Linux).
+
+The emulator serves the protocol from doc/ps_rs232_protocol_FULL_ai_ready.txt
+over a pseudo terminal, using the same framing as doc/inverterTest.py:
+  request:  <CMD><CRC_hi><CRC_lo><CR>
+  response: (<PAYLOAD><CRC_hi><CRC_lo><CR>   (CRC bytes 0x28/0x0D/0x0A incremented)
+
+Served inquiries: QPI QID QSID QVFW QVFW2 QMOD QPIGS QPIRI QFLAG QPIWS QDI
+QMCHGCR QMUCHGCR QBOOT QOPM QPGSn. Setters (POP, PCP, PE/PD, MCHGC, MUCHGC,
+PBCV, PBDV, PSDV, PCVV, PBFT, PBT, PGR, F, ...) are validated, applied to the
+emulated state and answered with ACK/NAK.
+
+Link impairments: baud-rate pacing, response latency + jitter, dropped bytes,
+CRC corruption and silently ignored requests.
+
+Usage:
+  # Serve on a pty (prints the slave path, e.g. /dev/pts/7)
+  python3 doc/inverterEmulator.py serve --latency 50 --jitter 20 --drop 0.001
+
+  # Run the poll benchmark against an in-process emulator (or --port for a
+  # real inverter / external emulator). Mirrors the firmware poll cycle
+  # (QMOD + QPIGS, per-command timeouts from src/inverter_uart.cpp).
+  python3 doc/inverterEmulator.py bench --duration 120 --crc-error 0.02
+
+Reported: cycles per minute, RTT percentiles per command, timeout/CRC/NAK
+counters and recovery time (first failed cycle -> next good cycle).
+
+doc/inverterPollBench.cpp runs the same cycle with the firmware's own C++
+framing and parsers against a "serve" pty.
+"""
+
+import argparse
+import os
+import random
+import re
+import select
+import sys
+import termios
+import threading
+import time
+import tty
+
+RESERVED = {0x28, 0x0D, 0x0A}  # '(', CR, LF
+
+# Timing constants mirrored from src/inverter_uart.h
+FIRST_BYTE_TIMEOUT_MS = 300
+INTERBYTE_TIMEOUT_MS = 100
+POLL_INTERVAL_MS = 3000
+
+
+def crc16_xmodem(data: bytes) -> int:
+    """CRC-16/XMODEM (poly 0x1021, init 0x0000, no xorout)."""
+    crc = 0x0000
+    for b in data:
+        crc ^= (b << 8)
+        for _ in range(8):
+            if crc & 0x8000:
+                crc = ((crc << 1) ^ 0x1021) & 0xFFFF
+            else:
+                crc = (crc << 1) & 0xFFFF
+    return crc
+
+
+def crc_bytes(data: bytes) -> bytes:
+    """CRC of data as two adjusted bytes (hi, lo)."""
+    crc = crc16_xmodem(data)
+    hi, lo = (crc >> 8) & 0xFF, crc & 0xFF
+    if hi in RESERVED:
+        hi += 1
+    if lo in RESERVED:
+        lo += 1
+    return bytes([hi, lo])
+
+
+def build_frame(payload_ascii: str) -> bytes:
+    """Request frame: PAYLOAD + CRC(hi,lo adjusted) + CR."""
+    payload = payload_ascii.encode("ascii")
+    return payload + crc_bytes(payload) + b"\r"
+
+
+def build_response(payload_ascii: str) -> bytes:
+    """Response frame: '(' + PAYLOAD + CRC(hi,lo adjusted) + CR."""
+    body = b"(" + payload_ascii.encode("ascii")
+    return body + crc_bytes(body) + b"\r"
+
+
+# ------------------------------------------------------------------
+# Emulated device
+# ------------------------------------------------------------------
+
+class InverterModel:
+    """Emulated inverter state; values drift slowly so consumers see changes."""
+
+    FLAG_LETTERS = "ABJKUVXYZ"
+
+    def __init__(self, units: int = 1, seed: int = 1):
+        self.rng = random.Random(seed)
+        self.mode = "B"
+        self.serial = "92932105100123"
+        self.output_priority = 2     # SBU
+        self.charger_priority = 3    # solar only
+        self.max_charge_a = 60
+        self.max_utility_charge_a = 30
+        self.batt_type = 0
+        self.grid_range = 0
+        self.out_freq = 50
+        self.batt_recharge_v = 46.0
+        self.batt_redischarge_v = 54.0
+        self.batt_cutoff_v = 42.0
+        self.batt_cv_v = 56.4
+        self.batt_float_v = 54.0
+        self.flags = {c: c in "AXYZ" for c in self.FLAG_LETTERS}
+        self.units = max(1, units)
+        self.t0 = time.monotonic()
+        # step-change injection (set by the bench to measure detection time)
+        self.load_offset_w = 0
+
+    # --- live values ---
+    def _live(self):
+        t = time.monotonic() - self.t0
+        pv_v = 300.0 + 20.0 * self.rng.uniform(-1, 1)
+        pv_w = max(0, int(1500 + 400 * self.rng.uniform(-1, 1)))
+        load_w = max(0, int(650 + 50 * self.rng.uniform(-1, 1) + self.load_offset_w))
+        batt_v = 52.0 + 0.3 * ((t / 60.0) % 2 - 1)
+        charge_a = max(0, int((pv_w - load_w) / batt_v))
+        discharge_a = max(0, int((load_w - pv_w) / batt_v))
+        return {
+            "pv_v": pv_v, "pv_w": pv_w, "load_w": load_w, "batt_v": batt_v,
+            "charge_a": charge_a, "discharge_a": discharge_a,
+            "pv_a": pv_w / batt_v,
+        }
+
+    def qpigs(self) -> str:
+        v = self._live()
+        va = int(v["load_w"] * 1.08)
+        load_pct = min(100, int(v["load_w"] * 100 / 5000))
+        return (f"230.0 50.0 230.1 50.0 {va:04d} {v['load_w']:04d} {load_pct:03d} 392 "
+                f"{v['batt_v']:05.2f} {v['charge_a']:03d} 076 0038 {int(v['pv_a']):04d} "
+                f"{v['pv_v']:05.1f} {v['batt_v'] + 0.05:05.2f} {v['discharge_a']:05d} "
+                f"00010110 00 05 {v['pv_w']:05d} 110")
+
+    def qpiri(self) -> str:
+        return (f"230.0 21.7 230.0 {self.out_freq:.1f} 21.7 5000 5000 48.0 {self.batt_recharge_v:.1f} "
+                f"{self.batt_cutoff_v:.1f} {self.batt_cv_v:.1f} {self.batt_float_v:.1f} {self.batt_type} "
+                f"{self.max_utility_charge_a:02d} {self.max_charge_a:03d} {self.grid_range} "
+                f"{self.output_priority} {self.charger_priority} {self.units} 01 0 "
+                f"{'01' if self.units > 1 else '00'} {self.batt_redischarge_v:.1f} 0 1")
+
+    def qflag(self) -> str:
+        en = "".join(c.lower() for c in self.FLAG_LETTERS if self.flags[c])
+        dis = "".join(c.lower() for c in self.FLAG_LETTERS if not self.flags[c])
+        return f"E{en}D{dis}"
+
+    def qpiws(self) -> str:
+        bits = ["0"] * 32
+        if self._live()["batt_v"] < 51.8:
+            bits[12] = "1"  # battery low alarm
+        return "".join(bits)
+
+    def qdi(self) -> str:
+        return "230.0 50.0 0030 42.0 54.0 56.4 46.0 60 0 0 2 0 0 0 0 0 1 1 0 0 1 00 54.0 0 1"
+
+    def qpgs(self, n: int) -> str:
+        if n >= self.units:
+            return "0 00000000000000 B 00 000.0 00.00 000.0 00.00 0000 0000 000 00.0 000 000 000.0 000 00000 00000 000 00000000 0 0 000 000 00 00 000"
+        v = self._live()
+        share = 1.0 / self.units
+        w = int(v["load_w"] * share)
+        va = int(w * 1.08)
+        tot_w = v["load_w"]
+        tot_va = int(tot_w * 1.08)
+        serial = f"{int(self.serial) + n:014d}"
+        return (f"1 {serial} {self.mode} 00 230.0 50.00 230.1 50.00 {va:04d} {w:04d} "
+                f"{min(100, w * 100 // 5000):03d} {v['batt_v']:04.1f} {int(v['charge_a'] * share):03d} 076 "
+                f"{v['pv_v']:05.1f} {v['charge_a']:03d} {tot_va:05d} {tot_w:05d} "
+                f"{min(100, tot_w * 100 // (5000 * self.units)):03d} 10100010 "
+                f"{1 if self.units > 1 else 0} {self.charger_priority} {self.max_charge_a:03d} 080 "
+                f"{self.max_utility_charge_a:02d} {int(v['pv_a'] * share):02d} {int(v['discharge_a'] * share):03d}")
+
+    # --- dispatcher ---
+    def handle(self, cmd: str):
+        """Return response payload, or None to stay silent."""
+        fixed = {
+            "QPI": lambda: "PI30",
+            "QID": lambda: self.serial,
+            "QSID": lambda: f"{len(self.serial):02d}{self.serial:0<20}",
+            "QVFW": lambda: "VERFW:00072.70",
+            "QVFW2": lambda: "VERFW2:00000.00",
+            "QMOD": lambda: self.mode,
+            "QPIGS": self.qpigs,
+            "QPIRI": self.qpiri,
+            "QFLAG": self.qflag,
+            "QPIWS": self.qpiws,
+            "QDI": self.qdi,
+            "QMCHGCR": lambda: "010 020 030 040 050 060 070 080",
+            "QMUCHGCR": lambda: "002 010 020 030 040 050 060",
+            "QBOOT": lambda: "0",
+            "QOPM": lambda: "01" if self.units > 1 else "00",
+        }
+        if cmd in fixed:
+            return fixed[cmd]()
+        m = re.fullmatch(r"QPGS(\d)", cmd)
+        if m:
+            return self.qpgs(int(m.group(1)))
+        return "ACK" if self._apply_setter(cmd) else "NAK"
+
+    def _apply_setter(self, cmd: str) -> bool:
+        def num(pattern):
+            m = re.fullmatch(pattern, cmd)
+            return m.group(1) if m else None
+
+        if (v := num(r"POP(0[0-2])")) is not None:
+            self.output_priority = int(v)
+        elif (v := num(r"PCP(0[0-3])")) is not None:
+            self.charger_priority = int(v)
+        elif (v := num(r"MCHGC(\d{3})")) is not None:
+            if int(v) % 10 or not 10 <= int(v) <= 80:
+                return False
+            self.max_charge_a = int(v)
+        elif (v := num(r"MUCHGC(\d{3})")) is not None:
+            if int(v) not in (2, 10, 20, 30, 40, 50, 60):
+                return False
+            self.max_utility_charge_a = int(v)
+        elif (v := num(r"PBCV(\d\d\.\d)")) is not None:
+            self.batt_recharge_v = float(v)
+        elif (v := num(r"PBDV(\d\d\.\d)")) is not None:
+            self.batt_redischarge_v = float(v)
+        elif (v := num(r"PSDV(\d\d\.\d)")) is not None:
+            if not 40.0 <= float(v) <= 48.0:
+                return False
+            self.batt_cutoff_v = float(v)
+        elif (v := num(r"PCVV(\d\d\.\d)")) is not None:
+            if not 48.0 <= float(v) <= 58.4:
+                return False
+            self.batt_cv_v = float(v)
+        elif (v := num(r"PBFT(\d\d\.\d)")) is not None:
+            if not 48.0 <= float(v) <= 58.4:
+                return False
+            self.batt_float_v = float(v)
+        elif (v := num(r"PBT(0[01])")) is not None:
+            self.batt_type = int(v)
+        elif (v := num(r"PGR(0[01])")) is not None:
+            self.grid_range = int(v)
+        elif (v := num(r"F(50|60)")) is not None:
+            self.out_freq = int(v)
+        elif (m := re.fullmatch(r"P([ED])([ABJKUVXYZ]+)", cmd)) is not None:
+            for c in m.group(2):
+                self.flags[c] = (m.group(1) == "E")
+        elif cmd in ("PF", "PSDF", "PMID", "PSAVE", "BTA0", "PVA0"):
+            pass
+        else:
+            return False
+        return True
+
+
+class Impairments:
+    def __init__(self, baud=2400, latency_ms=30.0, jitter_ms=10.0, drop=0.0,
+                 crc_error=0.0, silent=0.0, seed=2):
+        self.baud = baud
+        self.latency_ms = latency_ms
+        self.jitter_ms = jitter_ms
+        self.drop = drop
+        self.crc_error = crc_error
+        self.silent = silent
+        self.rng = random.Random(seed)
+
+
+class Emulator:
+    """Serves one pty master fd until stop() is called."""
+
+    def __init__(self, model: InverterModel, imp: Impairments, verbose=False):
+        self.model = model
+        self.imp = imp
+        self.verbose = verbose
+        self.master, self.slave = os.openpty()
+        tty.setraw(self.slave)
+        self.slave_path = os.ttyname(self.slave)
+        self._stop = threading.Event()
+        self.thread = threading.Thread(target=self._run, daemon=True)
+        self.requests = 0
+
+    def start(self):
+        self.thread.start()
+        return self
+
+    def stop(self):
+        self._stop.set()
+        self.thread.join(timeout=2)
+
+    def _byte_time(self) -> float:
+        return 10.0 / self.imp.baud  # 8N1
+
+    def _read_request(self):
+        buf = bytearray()
+        while not self._stop.is_set():
+            r, _, _ = select.select([self.master], [], [], 0.1)
+            if not r:
+                continue
+            chunk = os.read(self.master, 256)
+            for b in chunk:
+                buf.append(b)
+                if b == 0x0D:
+                    return bytes(buf)
+        return None
+
+    def _send(self, frame: bytes):
+        imp = self.imp
+        if imp.crc_error and imp.rng.random() < imp.crc_error:
+            frame = frame[:-3] + bytes([frame[-3] ^ 0x01]) + frame[-2:]
+        bt = self._byte_time()
+        next_t = time.monotonic()
+        for b in frame:
+            if imp.drop and imp.rng.random() < imp.drop:
+                next_t += bt  # byte lost on the wire, time still passes
+                continue
+            next_t += bt
+            delay = next_t - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+            os.write(self.master, bytes([b]))
+
+    def _run(self):
+        while not self._stop.is_set():
+            req = self._read_request()
+            if req is None:
+                return
+            self.requests += 1
+            body = req[:-1]
+            if len(body) < 3 or crc_bytes(body[:-2]) != body[-2:]:
+                # device ignores garbage; real units may answer (NAK
+                if self.verbose:
+                    print(f"[EMU] bad request {req!r}")
+                continue
+            cmd = body[:-2].decode("ascii", errors="replace")
+            if self.imp.silent and self.imp.rng.random() < self.imp.silent:
+                continue
+            payload = self.model.handle(cmd)
+            if payload is None:
+                continue
+            delay = (self.imp.latency_ms + self.imp.rng.uniform(-1, 1) * self.imp.jitter_ms) / 1000.0
+            # request itself took len(req) byte times on the wire
+            time.sleep(max(0.0, delay))
+            if self.verbose:
+                print(f"[EMU] {cmd} -> {payload}")
+            self._send(build_response(payload))
+
+
+# ------------------------------------------------------------------
+# Poll benchmark (client side mirrors the firmware poll cycle)
+# ------------------------------------------------------------------
+
+def open_port(path: str, baud: int) -> int:
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    attrs = termios.tcgetattr(fd)
+    tty.setraw(fd)
+    speed = getattr(termios, f"B{baud}", termios.B2400)
+    attrs = termios.tcgetattr(fd)
+    attrs[4] = attrs[5] = speed
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    return fd
+
+
+def bytes_time_ms(n: int, baud: int) -> float:
+    return n * 10 * 1000.0 / baud
+
+
+def command_timeout_ms(tx_len: int, rx_len: int, baud: int) -> float:
+    """Same formula as inverter_uart_timeout_ms()."""
+    rx_ms = bytes_time_ms(rx_len, baud)
+    return bytes_time_ms(tx_len, baud) + FIRST_BYTE_TIMEOUT_MS + rx_ms * 1.25
+
+
+def transact(fd: int, cmd: str, expected_rx_len: int, baud: int):
+    """Returns (status, rtt_ms, payload). status: ok|timeout|crc|nak|malformed."""
+    termios.tcflush(fd, termios.TCIFLUSH)
+    frame = build_frame(cmd)
+    start = time.monotonic()
+    deadline = start + command_timeout_ms(len(frame), expected_rx_len, baud) / 1000.0
+    os.write(fd, frame)
+    buf = bytearray()
+    last_rx = None
+    while True:
+        now = time.monotonic()
+        wait = deadline - now
+        if last_rx is not None:
+            wait = min(wait, last_rx + INTERBYTE_TIMEOUT_MS / 1000.0 - now)
+        if wait <= 0:
+            return "timeout", (time.monotonic() - start) * 1000.0, None
+        r, _, _ = select.select([fd], [], [], wait)
+        if not r:
+            continue
+        for b in os.read(fd, 512):
+            if not buf and b != 0x28:
+                return "malformed", (time.monotonic() - start) * 1000.0, None
+            if b == 0x0D:
+                rtt = (time.monotonic() - start) * 1000.0
+                if bytes(buf) == b"(NAK":
+                    return "nak", rtt, None
+                if len(buf) < 3 or crc_bytes(bytes(buf[:-2])) != bytes(buf[-2:]):
+                    return "crc", rtt, None
+                payload = bytes(buf[1:-2]).decode("ascii", errors="replace")
+                return ("nak" if payload == "NAK" else "ok"), rtt, payload
+            buf.append(b)
+        last_rx = time.monotonic()
+
+
+def percentile(values, p):
+    if not values:
+        return float("nan")
+    s = sorted(values)
+    k = min(len(s) - 1, max(0, int(round(p / 100.0 * (len(s) - 1)))))
+    return s[k]
+
+
+def run_bench(args):
+    emu = None
+    if args.port:
+        path = args.port
+    else:
+        imp = Impairments(args.baud, args.latency, args.jitter, args.drop, args.crc_error, args.silent)
+        emu = Emulator(InverterModel(args.units), imp, args.verbose).start()
+        path = emu.slave_path
+    fd = open_port(path, args.baud)
+
+    commands = [("QMOD", 5), ("QPIGS", 110)]
+    stats = {c: {"rtt": [], "ok": 0, "timeout": 0, "crc": 0, "nak": 0, "malformed": 0} for c, _ in commands}
+    cycles = good_cycles = 0
+    recoveries = []
+    fail_since = None
+    t_end = time.monotonic() + args.duration
+    interval = args.interval / 1000.0
+
+    print(f"bench: {path} baud={args.baud} duration={args.duration}s interval={args.interval}ms")
+    while time.monotonic() < t_end:
+        cycle_start = time.monotonic()
+        ok = True
+        for cmd, rx_len in commands:
+            st, rtt, _ = transact(fd, cmd, rx_len, args.baud)
+            s = stats[cmd]
+            s[st] += 1
+            if st == "ok":
+                s["rtt"].append(rtt)
+            else:
+                ok = False
+        cycles += 1
+        now = time.monotonic()
+        if ok:
+            good_cycles += 1
+            if fail_since is not None:
+                recoveries.append((now - fail_since) * 1000.0)
+                fail_since = None
+        elif fail_since is None:
+            fail_since = cycle_start
+        sleep = interval - (time.monotonic() - cycle_start)
+        if sleep > 0:
+            time.sleep(sleep)
+
+    elapsed_min = args.duration / 60.0
+    print(f"cycles: {cycles} ({cycles / elapsed_min:.1f}/min), good: {good_cycles} ({good_cycles / elapsed_min:.1f}/min)")
+    for cmd, _ in commands:
+        s = stats[cmd]
+        r = s["rtt"]
+        print(f"{cmd:6s} ok={s['ok']} timeout={s['timeout']} crc={s['crc']} nak={s['nak']} malformed={s['malformed']} "
+              f"rtt p50={percentile(r, 50):.1f} p90={percentile(r, 90):.1f} p99={percentile(r, 99):.1f} "
+              f"max={max(r) if r else float('nan'):.1f} ms")
+    if recoveries:
+        print(f"recovery after error: n={len(recoveries)} p50={percentile(recoveries, 50):.0f} "
+              f"max={max(recoveries):.0f} ms")
+    else:
+        print("recovery after error: no errors")
+    os.close(fd)
+    if emu:
+        emu.stop()
+
+
+def run_serve(args):
+    imp = Impairments(args.baud, args.latency, args.jitter, args.drop, args.crc_error, args.silent)
+    emu = Emulator(InverterModel(args.units), imp, args.verbose).start()
+    print(f"Inverter emulator listening on {emu.slave_path} (Ctrl+C to stop)")
+    try:
+        while True:
+            time.sleep(1)
+    except KeyboardInterrupt:
+        pass
+    emu.stop()
+    print(f"served {emu.requests} requests")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = ap.add_subparsers(dest="mode", required=True)
+    for name in ("serve", "bench"):
+        p = sub.add_parser(name)
+        p.add_argument("--baud", type=int, default=2400, help="pacing baud rate (8N1)")
+        p.add_argument("--latency", type=float, default=30.0, help="response latency [ms]")
+        p.add_argument("--jitter", type=float, default=10.0, help="latency jitter +/- [ms]")
+        p.add_argument("--drop", type=float, default=0.0, help="probability of dropping each response byte")
+        p.add_argument("--crc-error", type=float, default=0.0, help="probability of corrupting a response CRC")
+        p.add_argument("--silent", type=float, default=0.0, help="probability of ignoring a request")
+        p.add_argument("--units", type=int, default=1, help="number of parallel units (QPGSn)")
+        p.add_argument("-v", "--verbose", action="store_true")
+        if name == "bench":
+            p.add_argument("--port", help="use this serial device instead of an in-process emulator")
+            p.add_argument("--duration", type=float, default=60.0, help="benchmark length [s]")
+            p.add_argument("--interval", type=float, default=POLL_INTERVAL_MS, help="poll interval [ms], 0 = back to back")
+    args = ap.parse_args()
+    if args.mode == "serve":
+        run_serve(args)
+    else:
+        run_bench(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
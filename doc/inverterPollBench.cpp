@@ -0,0 +1,227 @@
+// Poll client built from the firmware's own Arduino-free inverter code:
+// request frames from inv_frames (src/inverter_crc.h), byte-wise response
+// framing with FrameParser (src/inverter_frame.h) and the payload parsers
+// (src/inverter_parse.cpp). Runs the firmware poll cycle (QMOD + QPIGS, plus
+// QPGS0..n-1 with --units) against a serial device, with the timeouts of
+// src/inverter_uart.cpp, so the firmware code path is exercised against
+// doc/inverterEmulator.py or a real inverter behind a USB adapter.
+//
+// The Python "bench" subcommand of the emulator has its own framing and
+// parsing; this one answers whether the C++ code handles what the link
+// delivers (impairments, parallel units) the same way.
+//
+// Reported: cycles per minute, RTT percentiles per command, timeout, CRC,
+// NAK, malformed and parse-reject counters, recovery time (first failed
+// cycle -> next good cycle) and the last decoded QPIGS/QMOD.
+//
+// Usage (Linux):
+//   g++ -std=gnu++17 -O2 -Isrc -Iinclude -o /tmp/inverterPollBench doc/inverterPollBench.cpp src/inverter_parse.cpp
+//   python3 doc/inverterEmulator.py serve --latency 50 --jitter 20 --crc-error 0.02 &   # prints /dev/pts/N
+//   /tmp/inverterPollBench --port /dev/pts/N --duration 120
+//   /tmp/inverterPollBench --port /dev/ttyUSB0 --interval 0 --units 2
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+#include "inverter_crc.h"
+#include "inverter_frame.h"
+#include "inverter_parse.h"
+
+#define INVERTER_INTERBYTE_TIMEOUT_MS  100   // src/inverter_uart.h
+#define INVERTER_FIRST_BYTE_TIMEOUT_MS 300
+#define RX_BUF_SIZE                    512   // InverterLink::rx_buf in inverter_comm.cpp
+
+static double now_ms() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static speed_t baud_const(unsigned baud) {
+  switch (baud) {
+    case 2400: return B2400;
+    case 4800: return B4800;
+    case 9600: return B9600;
+    case 19200: return B19200;
+    default: return 0;
+  }
+}
+
+static int open_port(const char* path, unsigned baud) {
+  int fd = open(path, O_RDWR | O_NOCTTY);
+  if (fd < 0) return -1;
+  termios t;
+  if (tcgetattr(fd, &t) != 0) { close(fd); return -1; }
+  cfmakeraw(&t);
+  cfsetispeed(&t, baud_const(baud));
+  cfsetospeed(&t, baud_const(baud));
+  tcsetattr(fd, TCSANOW, &t);
+  return fd;
+}
+
+// Same formula as inverter_uart_timeout_ms()
+static uint32_t bytes_time_ms(size_t n, unsigned baud) { return (uint32_t)((n * 10 * 1000 + baud - 1) / baud); }
+static uint32_t command_timeout_ms(size_t tx_len, size_t rx_len, unsigned baud) {
+  uint32_t rx_ms = bytes_time_ms(rx_len, baud);
+  return bytes_time_ms(tx_len, baud) + INVERTER_FIRST_BYTE_TIMEOUT_MS + rx_ms + rx_ms / 4;
+}
+
+// inverter_uart_transact() on a file descriptor: InProgress means timeout
+static FrameStatus transact(int fd, unsigned baud, const uint8_t* tx, size_t tx_len, size_t expected_rx_len,
+                            FrameParser& parser, uint8_t* rx, size_t rx_cap, double* rtt_ms) {
+  tcflush(fd, TCIFLUSH);
+  parser.reset(rx, rx_cap);
+  double start = now_ms();
+  double deadline = start + command_timeout_ms(tx_len, expected_rx_len, baud);
+  if (write(fd, tx, tx_len) != (ssize_t)tx_len) return FrameStatus::InProgress;
+
+  double last_rx = 0;
+  FrameStatus st = FrameStatus::InProgress;
+  while (st == FrameStatus::InProgress) {
+    double t = now_ms();
+    double limit = deadline;
+    if (parser.length() > 0) limit = std::min(limit, last_rx + INVERTER_INTERBYTE_TIMEOUT_MS);
+    if (t >= limit) break;
+    pollfd p = { fd, POLLIN, 0 };
+    int r = poll(&p, 1, (int)(limit - t) + 1);
+    if (r < 0 && errno == EINTR) continue;
+    if (r <= 0) continue;
+    uint8_t chunk[64];
+    ssize_t n = read(fd, chunk, sizeof(chunk));
+    if (n <= 0) continue;
+    last_rx = now_ms();
+    for (ssize_t i = 0; i < n && st == FrameStatus::InProgress; ++i) st = parser.feed(chunk[i]);
+  }
+  *rtt_ms = now_ms() - start;
+  return st;
+}
+
+struct Command {
+  const char* name;
+  const uint8_t* frame;
+  size_t frame_len;
+  size_t rx_len;
+};
+
+struct CmdStats {
+  std::vector<double> rtt;
+  int ok = 0, timeout = 0, crc = 0, nak = 0, malformed = 0, rejected = 0;
+};
+
+static double percentile(std::vector<double> v, double p) {
+  if (v.empty()) return 0.0 / 0.0;
+  std::sort(v.begin(), v.end());
+  size_t k = (size_t)(p / 100.0 * (v.size() - 1) + 0.5);
+  return v[std::min(k, v.size() - 1)];
+}
+
+int main(int argc, char** argv) {
+  const char* port = nullptr;
+  unsigned baud = 2400;
+  double duration_s = 60, interval_ms = 1500;   // POLL_DEFAULT_MS
+  int units = 0;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--port") && i + 1 < argc) port = argv[++i];
+    else if (!strcmp(argv[i], "--baud") && i + 1 < argc) baud = (unsigned)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--duration") && i + 1 < argc) duration_s = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--interval") && i + 1 < argc) interval_ms = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--units") && i + 1 < argc) units = atoi(argv[++i]);
+    else {
+      fprintf(stderr, "usage: %s --port DEV [--baud 2400] [--duration s] [--interval ms, 0 = back to back] [--units 0..4]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  if (!port || !baud_const(baud) || units < 0 || units > 4) {
+    fprintf(stderr, "%s: need --port, a standard baud rate and --units 0..4\n", argv[0]);
+    return 2;
+  }
+  int fd = open_port(port, baud);
+  if (fd < 0) { perror(port); return 2; }
+
+  std::vector<Command> cmds = {
+    { "QMOD", inv_frames::QMOD.data(), inv_frames::QMOD.size, 5 },
+    { "QPIGS", inv_frames::QPIGS.data(), inv_frames::QPIGS.size, 110 },
+  };
+  const InverterTxFrame<8>* qpgs[] = { &inv_frames::QPGS0, &inv_frames::QPGS1, &inv_frames::QPGS2, &inv_frames::QPGS3 };
+  static const char* const QPGS_NAMES[] = { "QPGS0", "QPGS1", "QPGS2", "QPGS3" };
+  for (int u = 0; u < units; ++u) cmds.push_back({ QPGS_NAMES[u], qpgs[u]->data(), qpgs[u]->size, 130 });
+  std::vector<CmdStats> stats(cmds.size());
+
+  uint8_t rx[RX_BUF_SIZE];
+  FrameParser parser;
+  InverterState state = {};
+  char mode = '?';
+  const char* mode_name = "Unknown";
+  int cycles = 0, good = 0;
+  std::vector<double> recoveries;
+  double fail_since = -1;
+
+  printf("bench: %s baud=%u duration=%.0fs interval=%.0fms units=%d\n", port, baud, duration_s, interval_ms, units);
+  double t_end = now_ms() + duration_s * 1000.0;
+  while (now_ms() < t_end) {
+    double cycle_start = now_ms();
+    bool ok = true;
+    for (size_t i = 0; i < cmds.size(); ++i) {
+      double rtt = 0;
+      FrameStatus st = transact(fd, baud, cmds[i].frame, cmds[i].frame_len, cmds[i].rx_len, parser, rx, sizeof(rx), &rtt);
+      CmdStats& s = stats[i];
+      const char* payload = (const char*)parser.payload();
+      size_t len = parser.payload_length();
+      switch (st) {
+        case FrameStatus::Complete: {
+          bool parsed = true;
+          if (i == 0) mode = inverter_parse_qmod(payload, len, &mode_name);
+          else if (i == 1) parsed = inverter_parse_qpigs(payload, len, &state);
+          else {
+            InverterUnitState u;
+            parsed = inverter_parse_qpgs(payload, len, &u);
+          }
+          if (parsed) { s.ok++; s.rtt.push_back(rtt); }
+          else { s.rejected++; ok = false; }
+          break;
+        }
+        case FrameStatus::InProgress: s.timeout++; ok = false; break;
+        case FrameStatus::CrcError: s.crc++; ok = false; break;
+        case FrameStatus::Nak: s.nak++; ok = false; break;
+        default: s.malformed++; ok = false; break;
+      }
+    }
+    cycles++;
+    double now = now_ms();
+    if (ok) {
+      good++;
+      if (fail_since >= 0) { recoveries.push_back(now - fail_since); fail_since = -1; }
+    } else if (fail_since < 0) {
+      fail_since = cycle_start;
+    }
+    double sleep_ms = interval_ms - (now_ms() - cycle_start);
+    if (sleep_ms > 0) usleep((useconds_t)(sleep_ms * 1000));
+  }
+  close(fd);
+
+  double minutes = duration_s / 60.0;
+  printf("cycles: %d (%.1f/min), good: %d (%.1f/min)\n", cycles, cycles / minutes, good, good / minutes);
+  for (size_t i = 0; i < cmds.size(); ++i) {
+    const CmdStats& s = stats[i];
+    double mx = s.rtt.empty() ? 0.0 / 0.0 : *std::max_element(s.rtt.begin(), s.rtt.end());
+    printf("%-6s ok=%d timeout=%d crc=%d nak=%d malformed=%d rejected=%d rtt p50=%.1f p90=%.1f p99=%.1f max=%.1f ms\n",
+           cmds[i].name, s.ok, s.timeout, s.crc, s.nak, s.malformed, s.rejected, percentile(s.rtt, 50),
+           percentile(s.rtt, 90), percentile(s.rtt, 99), mx);
+  }
+  if (recoveries.empty()) printf("recovery after error: %s\n", fail_since < 0 ? "no errors" : "never recovered");
+  else printf("recovery after error: n=%zu p50=%.0f max=%.0f ms\n", recoveries.size(), percentile(recoveries, 50),
+              *std::max_element(recoveries.begin(), recoveries.end()));
+  printf("last: mode %c (%s) out %.1f V %d W batt %.2f V %d%% pv %.1f V %d W\n", mode ? mode : '?', mode_name,
+         state.ac_out_voltage, state.ac_active_w, state.batt_voltage, state.batt_soc, state.pv_input_voltage,
+         state.pv_charging_power);
+  return 0;
+}
@@ -0,0 +1,174 @@
+# -*- coding: utf-8 -*-
+"""
+LCD bus time per frame: whole-line redraws (the old display_redraw() with
+LiquidCrystal from loop()) against the display task's changed-run writes
+(src/display.cpp).
+
+Model (default): replays a synthetic hour of the firmware's rows (SoC, PV,
+battery and thermistor rows in their real formats, values moving like a
+sunny afternoon with load steps) for each scroll position, with the same
+run merging as flush_line(), and prints bytes and bus time per frame.
+Per-byte cost is command/character execution time plus strobes:
+  old  LiquidCrystal send(): 37 us execution wait + 2 strobes + ~12
+       digitalWrite() calls          -> --old-byte-us (default 42)
+  new  GPIO_FAST_SET_* nibbles, 2 x (1 us E high + 1 us E low) + 40 us
+                                     -> --new-byte-us (default 44)
+so the gain comes from sending fewer bytes and from not doing it in loop().
+
+Device (--host): scrapes /metrics twice, --duration apart, and prints the
+measured bus time per frame (display_frame_seconds) together with bytes
+sent against bytes whole-line redraws of the same frames would have sent.
+
+Usage:
+  python3 doc/lcdBusTime.py
+  python3 doc/lcdBusTime.py --host inverter.local --duration 300
+"""
+
+import argparse
+import http.client
+import math
+import random
+import re
+import time
+
+COLS = 16
+LINE_ADDR = (0x00, 0x40)
+
+
+def pad(s):
+    return (s + " " * COLS)[:COLS]
+
+
+def flush_line(have, want, line, cursor):
+    """Mirror of flush_line() in src/display.cpp; returns (bytes, cursor)"""
+    n = 0
+    col = 0
+    have = list(have)
+    while col < COLS:
+        if want[col] == have[col]:
+            col += 1
+            continue
+        end = col + 1
+        while end < COLS:
+            if want[end] != have[end]:
+                end += 1
+                continue
+            if end + 1 < COLS and want[end + 1] != have[end + 1]:
+                end += 2
+                continue
+            break
+        addr = LINE_ADDR[line] + col
+        if cursor != addr:
+            n += 1
+        n += end - col
+        for c in range(col, end):
+            have[c] = want[c]
+        cursor = addr + (end - col)
+        col = end
+    return n, cursor
+
+
+def fmt_temp(t):
+    return "%4.1f" % t
+
+
+def synthetic_rows(seconds, seed=1):
+    """Yield (t_ms, rows) every 250 ms (status refresh) with temperatures every 1 s"""
+    rnd = random.Random(seed)
+    soc, pv, load = 80.0, 2400.0, 400.0
+    th, tl = 41.0, 28.0
+    for step in range(seconds * 4):
+        t = step * 250
+        if step % 6 == 0:   # new QPIGS sample every 1.5 s
+            pv = max(0.0, pv + rnd.gauss(0, 40))
+            if rnd.random() < 0.01:
+                load = 2400.0 if load < 1000 else 400.0
+            soc = min(100.0, soc + 0.002)
+        if step % 4 == 0:
+            th += rnd.gauss(0, 0.05)
+            tl += rnd.gauss(0, 0.03)
+        v = 53.2
+        charge = max(0.0, pv - load)
+        rows = [
+            "SoC: %d%%" % int(soc),
+            "H %s L %s\xdfC" % (fmt_temp(th), fmt_temp(tl)),
+            "PV: %dW" % int(pv),
+            "Bat: %d/%dW" % (int(v * round(charge / v)), -int(v * round(max(0.0, load - pv) / v))),
+        ]
+        yield t, rows
+
+
+def model(args):
+    for pos in range(4):
+        shadow = [pad(""), pad("")]
+        cursor = 0
+        old_bytes = new_bytes = frames = 0
+        for _, rows in synthetic_rows(args.seconds):
+            want = [pad(rows[pos % 4]), pad(rows[(pos + 1) % 4])]
+            if want == shadow:
+                continue
+            frames += 1
+            for i in range(2):
+                if want[i] != shadow[i]:
+                    old_bytes += 1 + COLS
+                    n, cursor = flush_line(shadow[i], want[i], i, cursor)
+                    new_bytes += n
+            shadow = want
+        if not frames:
+            continue
+        print("rows %d+%d: %5d frames, bytes/frame old %5.1f new %4.1f, bus/frame old %6.0f us new %5.0f us" % (
+            pos, (pos + 1) % 4, frames, old_bytes / frames, new_bytes / frames,
+            old_bytes / frames * args.old_byte_us, new_bytes / frames * args.new_byte_us))
+
+
+BUCKET_RE = re.compile(r'^display_frame_seconds_bucket\{le="([^"]+)"\} (\d+)', re.M)
+
+
+def scrape(host):
+    conn = http.client.HTTPConnection(host, timeout=10)
+    try:
+        conn.request("GET", "/metrics")
+        text = conn.getresponse().read().decode("utf-8", errors="replace")
+    finally:
+        conn.close()
+    vals = {}
+    for name in ("display_frames_total", "display_bus_bytes_total", "display_full_line_bytes_total",
+                 "display_frame_seconds_sum", "display_frame_max_seconds"):
+        m = re.search(r"^%s ([0-9.eE+-]+)" % name, text, re.M)
+        vals[name] = float(m.group(1)) if m else math.nan
+    return vals
+
+
+def device(args):
+    a = scrape(args.host)
+    time.sleep(args.duration)
+    b = scrape(args.host)
+    d = {k: b[k] - a[k] for k in a}
+    frames = d["display_frames_total"]
+    if not frames:
+        print("no LCD frames in %.0f s" % args.duration)
+        return
+    print("frames: %d in %.0f s" % (frames, args.duration))
+    print("bytes/frame: %.1f sent, %.1f with whole-line redraws" % (
+        d["display_bus_bytes_total"] / frames, d["display_full_line_bytes_total"] / frames))
+    print("bus time/frame: %.0f us measured (max since boot %.0f us), whole lines ~%.0f us at %.0f us/byte" % (
+        d["display_frame_seconds_sum"] / frames * 1e6, b["display_frame_max_seconds"] * 1e6,
+        d["display_full_line_bytes_total"] / frames * args.old_byte_us, args.old_byte_us))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--host")
+    ap.add_argument("--duration", type=float, default=300.0)
+    ap.add_argument("--seconds", type=int, default=3600, help="model: trace length")
+    ap.add_argument("--old-byte-us", type=float, default=42.0)
+    ap.add_argument("--new-byte-us", type=float, default=44.0)
+    args = ap.parse_args()
+    if args.host:
+        device(args)
+    else:
+        model(args)
+
+
+if __name__ == "__main__":
+    main()
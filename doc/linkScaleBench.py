@@ -0,0 +1,86 @@
+# -*- coding: utf-8 -*-
+"""
+Serial link scaling: show that the sample rate grows linearly with the
+number of inverter links (INVERTER_LINK_COUNT in include/config.h).
+
+Each link has its own UART, poll task, scheduler and snapshot, so links do
+not wait for each other; the only shared resource is CPU time, which a
+2400 Bd link barely uses. Reads GET /inverter?dev=N for every device at the
+start and end of --duration seconds and prints, per device, completed
+QPIGS and QPGSn samples per second plus link utilization, then the
+aggregate and the scaling efficiency:
+
+  efficiency = aggregate / (devices x fastest single link)
+
+which is 1.0 when adding a link adds a full link's worth of samples. Run
+it once with INVERTER_LINK_COUNT 1 and once with 2 to compare the
+aggregate directly.
+
+Usage:
+  python3 doc/linkScaleBench.py --host inverter.local --duration 60
+"""
+
+import argparse
+import http.client
+import json
+import time
+
+SAMPLE_COMMANDS = ("QPIGS", "QPGS")
+
+
+def get_json(host, path, timeout):
+    conn = http.client.HTTPConnection(host, timeout=timeout)
+    try:
+        conn.request("GET", path)
+        resp = conn.getresponse()
+        body = resp.read()
+        if resp.status != 200:
+            raise RuntimeError("%s -> HTTP %d" % (path, resp.status))
+        return json.loads(body)
+    finally:
+        conn.close()
+
+
+def sample_runs(doc):
+    return sum(c.get("runs", 0) for c in doc.get("commands", []) if c.get("name") in SAMPLE_COMMANDS)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--host", required=True)
+    ap.add_argument("--duration", type=float, default=60.0, help="measurement window [s]")
+    ap.add_argument("--timeout", type=float, default=5.0)
+    args = ap.parse_args()
+
+    first = get_json(args.host, "/inverter", args.timeout)
+    devices = first.get("devices", 1)
+
+    def snapshot():
+        t = time.monotonic()
+        return t, [get_json(args.host, "/inverter?dev=%d" % d, args.timeout) for d in range(devices)]
+
+    t0, start = snapshot()
+    print("%d device(s), measuring %.0f s ..." % (devices, args.duration))
+    time.sleep(args.duration)
+    t1, end = snapshot()
+    dt = t1 - t0
+
+    rates = []
+    print("%-4s %-6s %-9s %10s %12s" % ("dev", "uart", "pins", "samples/s", "utilization"))
+    for d in range(devices):
+        rate = (sample_runs(end[d]) - sample_runs(start[d])) / dt
+        rates.append(rate)
+        info = end[d].get("device", {})
+        pins = "%s/%s" % (info.get("rx_pin", "?"), info.get("tx_pin", "?"))
+        util = end[d].get("link", {}).get("utilization", 0.0)
+        print("%-4d %-6s %-9s %10.2f %11.0f%%" % (d, info.get("uart", "?"), pins, rate, util * 100.0))
+
+    total = sum(rates)
+    best = max(rates) if rates else 0.0
+    print("aggregate  %.2f samples/s" % total)
+    if best > 0:
+        print("efficiency %.2f (aggregate / %d x %.2f)" % (total / (devices * best), devices, best))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,62 @@
+// Check the compile-time NTC tables (src/ntc_curves.h) against the exact
+// formula: sweep the divider voltage in 0.1 mV steps and report the largest
+// interpolation error inside a few temperature ranges. Exits non-zero when
+// an error inside -20..120 °C exceeds --max (default 0.1 °C; one ADC code
+// is about 0.25 °C at 120 °C for a 10k/B3950 divider), so it can run as a
+// check after adding a curve.
+//
+// The same sweep also checks that ntc_ln() (used in constant expressions)
+// matches log() and that the table and exact conversions agree on where
+// the rails are (NAN).
+//
+// Usage:
+//   g++ -std=gnu++17 -O2 -Isrc -o /tmp/ntcTableCheck doc/ntcTableCheck.cpp && /tmp/ntcTableCheck
+//   /tmp/ntcTableCheck --max 0.05
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ntc_curves.h"
+
+struct Range { double lo, hi; double max_err; double at_c; };
+
+int main(int argc, char** argv) {
+  double limit = 0.1;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--max") && i + 1 < argc) limit = atof(argv[++i]);
+    else { fprintf(stderr, "usage: %s [--max degC]\n", argv[0]); return 2; }
+  }
+
+  int failed = 0;
+  double ln_err = 0.0;
+  for (double x = 1e-3; x < 1e7; x *= 1.01) ln_err = fmax(ln_err, fabs(ntc_ln(x) - log(x)));
+  printf("ntc_ln vs log: max abs error %.2e\n", ln_err);
+  if (ln_err > 1e-12) failed = 1;
+
+  printf("table: %d points, %.2f mV step\n", NTC_TABLE_POINTS, NTC_CURVES[0].table->mv_step);
+  for (const NtcCurveEntry& e : NTC_CURVES) {
+    Range ranges[] = { { -20, 120, 0, 0 }, { -40, 150, 0, 0 }, { 0, 100, 0, 0 } };
+    int nan_mismatch = 0;
+    for (double mv = 0.0; mv <= e.curve->vsupply_mv; mv += 0.1) {
+      double exact = ntc_exact_c(*e.curve, mv);
+      float table = ntc_table_c(*e.table, (float)mv);
+      // The table gives up one segment earlier at each rail, never later
+      if (isnan(exact) && !isnan(table)) nan_mismatch++;
+      if (isnan(exact) || isnan(table)) continue;
+      for (Range& r : ranges) {
+        if (exact < r.lo || exact > r.hi) continue;
+        double err = fabs(table - exact);
+        if (err > r.max_err) { r.max_err = err; r.at_c = exact; }
+      }
+    }
+    printf("%s:\n", e.name);
+    for (const Range& r : ranges) {
+      printf("  %4.0f..%-4.0f C  max error %.4f C (at %.1f C)\n", r.lo, r.hi, r.max_err, r.at_c);
+    }
+    if (nan_mismatch) printf("  %d readings valid in the table but not in the formula\n", nan_mismatch);
+    if (ranges[0].max_err > limit || nan_mismatch) failed = 1;
+  }
+  printf(failed ? "FAIL\n" : "OK\n");
+  return failed;
+}
@@ -0,0 +1,211 @@
+// Replay a trace through the adaptive QPIGS rate (PollRateController,
+// src/poll_rate.cpp) and compare it with fixed polling: samples taken (link
+// load) and time to detect step changes (the first sample at or after the
+// step).
+//
+// Trace: a CSV from doc/historyDump.py (t in seconds, zero-order hold between
+// rows) or, without --trace, a synthetic day with a quiet night, PV with cloud
+// edges and a few kettle/oven load steps.
+//
+// Also reported: samples in the 10 s after each step, i.e. how finely the
+// transient itself is resolved once detected.
+//
+// Steps are found in the trace as changes of ac_active_w, pv_charging_power
+// (W) or pv_input_voltage (V x10) above --step within one trace row.
+//
+// Usage:
+//   g++ -std=gnu++17 -O2 -Isrc -Iinclude -o /tmp/pollRateSim doc/pollRateSim.cpp src/poll_rate.cpp
+//   /tmp/pollRateSim
+//   /tmp/pollRateSim --trace history.csv --link-min 700
+
+#include <algorithm>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "poll_rate.h"
+
+struct Row {
+  uint32_t t_s;
+  InverterState s;
+};
+
+static std::vector<Row> g_rows;
+
+// One day at 1 s resolution
+static void synthetic_trace(unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> uni(0.0, 1.0);
+  std::vector<uint32_t> load_steps;
+  while (load_steps.size() < 12) {
+    uint32_t t = 6 * 3600 + (uint32_t)(uni(rng) * 16 * 3600);
+    if (std::find(load_steps.begin(), load_steps.end(), t) == load_steps.end()) load_steps.push_back(t);
+  }
+  static const double CLOUDS[] = { 0.25, 0.5, 1.0 };
+  double cloud = 1.0;
+  for (uint32_t t = 0; t < 24 * 3600; ++t) {
+    double hour = t / 3600.0;
+    double sun = hour >= 6.0 && hour <= 20.0 ? std::max(0.0, sin((hour - 6.0) / 14.0 * M_PI)) : 0.0;
+    if (sun > 0 && uni(rng) < 1 / 600.0) cloud = CLOUDS[rng() % 3];   // cloud edge
+    int pv_w = (int)lround(3000 * sun * cloud / 10) * 10;
+    bool step = false;
+    for (uint32_t s : load_steps) step |= s <= t && t < s + 180;
+    int load = 180 + (step ? 2000 : 0);
+    Row r = { t, {} };
+    r.s.ac_active_w = load;
+    r.s.pv_charging_power = pv_w;
+    r.s.pv_input_voltage = sun == 0 ? 0.0f : (float)(300.0 + 20 * cloud);
+    r.s.batt_discharge_current = std::max(0.0f, (load - pv_w) / 50.0f);
+    r.s.batt_charge_current = std::max(0.0f, (pv_w - load) / 54.0f);
+    g_rows.push_back(r);
+  }
+}
+
+// Comma split that keeps empty fields (historyDump.py leaves gaps empty)
+static std::vector<std::string> split_csv(const char* line) {
+  std::vector<std::string> cols(1);
+  for (const char* p = line; *p && *p != '\r' && *p != '\n'; ++p) {
+    if (*p == ',') cols.emplace_back();
+    else cols.back() += *p;
+  }
+  return cols;
+}
+
+static bool load_trace(const char* path) {
+  FILE* f = fopen(path, "r");
+  if (!f) { perror(path); return false; }
+  char line[2048];
+  int col_t = -1, col_ac = -1, col_pv = -1, col_pvv = -1, col_dis = -1, col_chg = -1;
+  bool header = true;
+  while (fgets(line, sizeof(line), f)) {
+    std::vector<std::string> cols = split_csv(line);
+    if (header) {
+      for (size_t i = 0; i < cols.size(); i++) {
+        if (cols[i] == "t") col_t = (int)i;
+        if (cols[i] == "ac_active_w") col_ac = (int)i;
+        if (cols[i] == "pv_charging_power") col_pv = (int)i;
+        if (cols[i] == "pv_input_voltage") col_pvv = (int)i;
+        if (cols[i] == "batt_discharge_current") col_dis = (int)i;
+        if (cols[i] == "batt_charge_current") col_chg = (int)i;
+      }
+      if (col_t < 0) { fprintf(stderr, "%s: need a t column\n", path); fclose(f); return false; }
+      header = false;
+      continue;
+    }
+    auto val = [&](int c) { return c >= 0 && c < (int)cols.size() ? atof(cols[c].c_str()) : 0.0; };
+    Row r = { (uint32_t)val(col_t), {} };
+    r.s.ac_active_w = (int)val(col_ac);
+    r.s.pv_charging_power = (int)val(col_pv);
+    r.s.pv_input_voltage = (float)val(col_pvv);
+    r.s.batt_discharge_current = (float)val(col_dis);
+    r.s.batt_charge_current = (float)val(col_chg);
+    g_rows.push_back(r);
+  }
+  fclose(f);
+  std::stable_sort(g_rows.begin(), g_rows.end(), [](const Row& a, const Row& b) { return a.t_s < b.t_s; });
+  return !g_rows.empty();
+}
+
+static std::vector<uint32_t> find_steps(double threshold) {
+  std::vector<uint32_t> steps;
+  for (size_t i = 1; i < g_rows.size(); ++i) {
+    const InverterState& a = g_rows[i - 1].s;
+    const InverterState& b = g_rows[i].s;
+    if (abs(b.ac_active_w - a.ac_active_w) >= threshold || abs(b.pv_charging_power - a.pv_charging_power) >= threshold ||
+        fabs(b.pv_input_voltage - a.pv_input_voltage) * 10 >= threshold) {
+      steps.push_back(g_rows[i].t_s * 1000);
+    }
+  }
+  return steps;
+}
+
+// Row in effect at t_ms (zero-order hold)
+static const InverterState& state_at(uint32_t t_ms) {
+  auto it = std::upper_bound(g_rows.begin(), g_rows.end(), t_ms / 1000,
+                             [](uint32_t t, const Row& r) { return t < r.t_s; });
+  return (it == g_rows.begin() ? it : it - 1)->s;
+}
+
+// Sample times [ms] with a fixed period, or the controller when period == 0
+static std::vector<uint32_t> run(uint32_t period, uint32_t link_min, bool live) {
+  PollRateController ctl;
+  ctl.begin(link_min);
+  uint32_t now = g_rows.front().t_s * 1000;
+  uint32_t t_end = g_rows.back().t_s * 1000;
+  std::vector<uint32_t> samples;
+  while (now <= t_end) {
+    samples.push_back(now);
+    now += period ? period : ctl.update(state_at(now), now, live);
+  }
+  return samples;
+}
+
+static std::vector<uint32_t> detect_latency(const std::vector<uint32_t>& samples, const std::vector<uint32_t>& steps) {
+  std::vector<uint32_t> lat;
+  for (uint32_t s : steps) {
+    auto it = std::lower_bound(samples.begin(), samples.end(), s);
+    if (it != samples.end()) lat.push_back(*it - s);
+  }
+  return lat;
+}
+
+// Samples in the window after each step (how well the transient is resolved)
+static double follow_samples(const std::vector<uint32_t>& samples, const std::vector<uint32_t>& steps,
+                             uint32_t window_ms = 10000) {
+  if (steps.empty()) return NAN;
+  size_t n = 0;
+  for (uint32_t s : steps) {
+    n += std::lower_bound(samples.begin(), samples.end(), s + window_ms) -
+         std::lower_bound(samples.begin(), samples.end(), s);
+  }
+  return (double)n / steps.size();
+}
+
+static double pct(std::vector<uint32_t> v, double p) {
+  if (v.empty()) return NAN;
+  std::sort(v.begin(), v.end());
+  return v[std::min(v.size() - 1, (size_t)(p / 100.0 * v.size()))];
+}
+
+int main(int argc, char** argv) {
+  const char* trace = nullptr;
+  unsigned seed = 1;
+  uint32_t link_min = 700;   // QPIGS+QMOD transaction time
+  double step = 300.0;       // W, or V x10
+  bool live = false;         // a live SSE subscriber
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--trace") && i + 1 < argc) trace = argv[++i];
+    else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = (unsigned)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--link-min") && i + 1 < argc) link_min = (uint32_t)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--step") && i + 1 < argc) step = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--live")) live = true;
+    else {
+      fprintf(stderr, "usage: %s [--trace history.csv] [--seed 1] [--link-min 700] [--step 300] [--live]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (trace) {
+    if (!load_trace(trace)) return 2;
+  } else {
+    synthetic_trace(seed);
+  }
+
+  std::vector<uint32_t> steps = find_steps(step);
+  double hours = (g_rows.back().t_s - g_rows.front().t_s) / 3600.0;
+  printf("trace: %.1f h, %zu steps >= %g\n", hours, steps.size(), step);
+  printf("policy        samples/h  detect p50[ms]  p95[ms]  max[ms]  samples in 10s after step\n");
+  static const uint32_t POLICIES[] = { 3000, POLL_DEFAULT_MS, 0 };
+  for (uint32_t period : POLICIES) {
+    std::vector<uint32_t> samples = run(period, link_min, live);
+    std::vector<uint32_t> lat = detect_latency(samples, steps);
+    char name[24];
+    if (period) snprintf(name, sizeof(name), "fixed %u", (unsigned)period);
+    else snprintf(name, sizeof(name), "adaptive");
+    printf("%-12s %10.0f %15.0f %8.0f %8.0f %10.1f\n", name, samples.size() / hours, pct(lat, 50), pct(lat, 95),
+           lat.empty() ? NAN : (double)*std::max_element(lat.begin(), lat.end()), follow_samples(samples, steps));
+  }
+  return 0;
+}
@@ -0,0 +1,125 @@
+# -*- coding: utf-8 -*-
+"""
+Compare /status polling with the /events SSE push on a running device.
+
+For each mode, N simulated dashboards run for --duration seconds:
+  poll  GET /status every --interval s (new TCP connection each time, like
+        fetch() through the WireGuard tunnel without keep-alive)
+  sse   one GET /events stream per client
+
+Bytes on the wire are counted at the socket (request + response, headers
+included; TCP/IP overhead excluded). Device CPU time comes from the
+counters on GET /events/stats (time spent building and writing responses).
+
+Usage:
+  python3 doc/pushVsPollBench.py --host inverter.local --clients 3 --duration 120
+"""
+
+import argparse
+import json
+import socket
+import threading
+import time
+
+
+def http_get(host, port, path, timeout=5.0):
+    """Plain HTTP/1.0 GET; returns (bytes_sent, bytes_received, body)."""
+    req = ("GET %s HTTP/1.0\r\nHost: %s\r\n\r\n" % (path, host)).encode()
+    with socket.create_connection((host, port), timeout=timeout) as s:
+        s.sendall(req)
+        chunks = []
+        while True:
+            b = s.recv(4096)
+            if not b:
+                break
+            chunks.append(b)
+    data = b"".join(chunks)
+    body = data.split(b"\r\n\r\n", 1)[1] if b"\r\n\r\n" in data else b""
+    return len(req), len(data), body
+
+
+def device_stats(host, port):
+    _, _, body = http_get(host, port, "/events/stats")
+    return json.loads(body)
+
+
+def poll_client(host, port, interval, stop, acc, lock):
+    while not stop.is_set():
+        t0 = time.monotonic()
+        try:
+            tx, rx, _ = http_get(host, port, "/status")
+            with lock:
+                acc["bytes"] += tx + rx
+                acc["requests"] += 1
+        except OSError:
+            with lock:
+                acc["errors"] += 1
+        stop.wait(max(0.0, interval - (time.monotonic() - t0)))
+
+
+def sse_client(host, port, stop, acc, lock):
+    req = ("GET /events HTTP/1.1\r\nHost: %s\r\nAccept: text/event-stream\r\n\r\n" % host).encode()
+    try:
+        with socket.create_connection((host, port), timeout=1.0) as s:
+            s.sendall(req)
+            with lock:
+                acc["bytes"] += len(req)
+            while not stop.is_set():
+                try:
+                    b = s.recv(4096)
+                except socket.timeout:
+                    continue
+                if not b:
+                    break
+                with lock:
+                    acc["bytes"] += len(b)
+                    acc["events"] += b.count(b"\n\n")
+    except OSError:
+        with lock:
+            acc["errors"] += 1
+
+
+def run_mode(mode, args):
+    acc = {"bytes": 0, "requests": 0, "events": 0, "errors": 0}
+    lock = threading.Lock()
+    stop = threading.Event()
+    before = device_stats(args.host, args.port)
+    threads = []
+    for _ in range(args.clients):
+        if mode == "poll":
+            t = threading.Thread(target=poll_client, args=(args.host, args.port, args.interval, stop, acc, lock))
+        else:
+            t = threading.Thread(target=sse_client, args=(args.host, args.port, stop, acc, lock))
+        t.daemon = True
+        t.start()
+        threads.append(t)
+    time.sleep(args.duration)
+    stop.set()
+    for t in threads:
+        t.join(timeout=5)
+    after = device_stats(args.host, args.port)
+
+    key = "poll" if mode == "poll" else "sse"
+    cpu_us = after[key]["cpu_us"] - before[key]["cpu_us"]
+    client_min = args.clients * args.duration / 60.0
+    print("%-4s clients=%d duration=%ds" % (mode, args.clients, args.duration))
+    print("     wire bytes / client-minute : %10.0f" % (acc["bytes"] / client_min))
+    print("     device CPU us / client-min : %10.0f" % (cpu_us / client_min))
+    print("     requests=%d events=%d errors=%d" % (acc["requests"], acc["events"], acc["errors"]))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--host", required=True)
+    ap.add_argument("--port", type=int, default=80)
+    ap.add_argument("--clients", type=int, default=2)
+    ap.add_argument("--duration", type=int, default=60)
+    ap.add_argument("--interval", type=float, default=1.25, help="poll interval (s), as in data/app.js")
+    ap.add_argument("--mode", choices=["poll", "sse", "both"], default="both")
+    args = ap.parse_args()
+    for mode in (["poll", "sse"] if args.mode == "both" else [args.mode]):
+        run_mode(mode, args)
+
+
+if __name__ == "__main__":
+    main()
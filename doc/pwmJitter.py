@@ -0,0 +1,158 @@
+# -*- coding: utf-8 -*-
+"""
+PWM edge jitter from the firmware's own edge probe (src/pwm_output.cpp).
+
+The firmware timestamps every rising edge on PWM_PIN in a GPIO interrupt and
+histograms |rise-to-rise interval - period|. This script sets a duty that
+produces one edge per period, scrapes /metrics at the start and end of
+--duration seconds and prints the jitter distribution of the edges in
+between (interpolated percentiles from the histogram buckets, plus the
+worst case since boot).
+
+Before/after: build once with PWM_MODE PWM_MODE_SOFTWARE (the old loop()
+phase comparison) and once with the default (esp_timer for the 2 s period,
+LEDC for periods up to 1 s), run with the same --duty and load (e.g. run
+doc/httpLoadTest.py at the same time) and compare.
+
+Model (--model, no device): simulates rising edges of both backends for
+--periods periods and prints the same percentiles. SOFTWARE: the pin rises
+in the first loop() iteration after the period boundary; iterations are
+delay(5) on a 1 ms tick plus a body of --body-ms (uniform), a heavier one
+every 250 ms (--heavy-ms, status refresh and task table) and a stall of
+--stall-ms with probability --stall-p per iteration. TIMER: the edge is
+late by the esp_timer task's dispatch latency, uniform up to
+--timer-latency-us. Compare with a device run before trusting either.
+
+Usage:
+  python3 doc/pwmJitter.py --host inverter.local --duty 0.5 --duration 120
+  python3 doc/pwmJitter.py --model
+"""
+
+import argparse
+import http.client
+import json
+import random
+import re
+import time
+
+BUCKET_RE = re.compile(r'^pwm_edge_jitter_seconds_bucket\{le="([^"]+)"\} (\d+)', re.M)
+VALUE_RE = r'^%s(?:\{[^}]*\})? ([0-9.eE+-]+)'
+
+
+def fetch(host, method="GET", path="/metrics", body=None):
+    conn = http.client.HTTPConnection(host, timeout=10)
+    try:
+        conn.request(method, path, body=body, headers={"Content-Type": "application/json"} if body else {})
+        resp = conn.getresponse()
+        return resp.read().decode("utf-8", errors="replace")
+    finally:
+        conn.close()
+
+
+def value(text, name):
+    m = re.search(VALUE_RE % re.escape(name), text, re.M)
+    return float(m.group(1)) if m else None
+
+
+def buckets(text):
+    out = []
+    for le, n in BUCKET_RE.findall(text):
+        out.append((float("inf") if le == "+Inf" else float(le), int(n)))
+    return out
+
+
+def percentile(bks, p):
+    total = bks[-1][1] if bks else 0
+    if total == 0:
+        return float("nan")
+    target = p / 100.0 * total
+    prev_le, prev_n = 0.0, 0
+    for le, n in bks:
+        if n >= target:
+            if le == float("inf") or n == prev_n:
+                return prev_le
+            return prev_le + (le - prev_le) * (target - prev_n) / (n - prev_n)
+        prev_le, prev_n = le, n
+    return prev_le
+
+
+def model_software(args, rnd):
+    """Rise instants (us) of the loop() phase comparison"""
+    period = args.period_ms * 1000.0
+    t, last_heavy, rises, next_boundary = 0.0, 0.0, [], period
+    while len(rises) < args.periods:
+        body = rnd.uniform(*args.body_ms) * 1000.0
+        if t - last_heavy >= 250000.0:
+            body += rnd.uniform(*args.heavy_ms) * 1000.0
+            last_heavy = t
+        if rnd.random() < args.stall_p:
+            body += args.stall_ms * 1000.0
+        t += body
+        if t >= next_boundary:
+            rises.append(t)
+            next_boundary += period * (1 + int((t - next_boundary) // period))
+        # delay(5): wakes on the 5th tick boundary from now
+        t = (t // 1000.0 + 5) * 1000.0
+    return rises
+
+
+def model_timer(args, rnd):
+    period = args.period_ms * 1000.0
+    return [i * period + rnd.uniform(0, args.timer_latency_us) for i in range(1, args.periods + 1)]
+
+
+def model(args):
+    rnd = random.Random(1)
+    period = args.period_ms * 1000.0
+    for name, rises in (("software", model_software(args, rnd)), ("timer", model_timer(args, rnd))):
+        jit = sorted(abs(b - a - period) for a, b in zip(rises, rises[1:]) if abs(b - a - period) < period / 2)
+        print("%-8s %d edges (model)" % (name, len(jit)))
+        for p in (50, 90, 99):
+            print("  p%-3d %9.1f us" % (p, jit[min(len(jit) - 1, int(p / 100.0 * len(jit)))]))
+        print("  max  %9.1f us" % jit[-1])
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--host")
+    ap.add_argument("--model", action="store_true")
+    ap.add_argument("--periods", type=int, default=20000)
+    ap.add_argument("--period-ms", type=float, default=2000.0)
+    ap.add_argument("--body-ms", type=float, nargs=2, default=(0.1, 1.0))
+    ap.add_argument("--heavy-ms", type=float, nargs=2, default=(1.0, 4.0))
+    ap.add_argument("--stall-ms", type=float, default=80.0)
+    ap.add_argument("--stall-p", type=float, default=1e-4)
+    ap.add_argument("--timer-latency-us", type=float, default=50.0)
+    ap.add_argument("--duty", type=float, default=0.5)
+    ap.add_argument("--duration", type=float, default=120.0)
+    args = ap.parse_args()
+    if args.model:
+        model(args)
+        return
+    if not args.host:
+        ap.error("--host or --model")
+
+    cmd = {"type": "cmd", "name": "set_output_duty_cycle", "value": args.duty}
+    print(fetch(args.host, "POST", "/cmd", json.dumps(cmd)))
+    start = fetch(args.host)
+    mode = re.search(r'^pwm_info\{mode="([^"]+)",period_ms="(\d+)"', start, re.M)
+    if mode:
+        print("backend %s, period %s ms" % (mode.group(1), mode.group(2)))
+    time.sleep(args.duration)
+    end = fetch(args.host)
+
+    b0 = dict(buckets(start))
+    delta = [(le, n - b0.get(le, 0)) for le, n in buckets(end)]
+    edges = delta[-1][1] if delta else 0
+    print("edges measured: %d" % edges)
+    for p in (50, 90, 99):
+        print("  p%-3d %9.1f us" % (p, percentile(delta, p) * 1e6))
+    worst = value(end, "pwm_edge_jitter_max_seconds")
+    if worst is not None:
+        print("  max  %9.1f us (since boot)" % (worst * 1e6))
+    trips = value(end, "pwm_failsafe_trips_total")
+    print("fail-safe trips since boot: %s" % (int(trips) if trips is not None else "?"))
+
+
+if __name__ == "__main__":
+    main()
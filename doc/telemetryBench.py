@@ -0,0 +1,136 @@
+# -*- coding: utf-8 -*-
+"""
+Binary telemetry vs. /status JSON, and a UDP stream listener.
+
+  http  fetch /status --count times on one keep-alive connection, once as
+        JSON and once with Accept: application/x-inverter-telemetry; print
+        bytes per sample (headers + body), request rate and client-side
+        decode time for each
+  udp   listen for the UDP stream (enable it with the /cmd command
+        {"type":"cmd","name":"set_telemetry_udp","value":"<this-host>:47800"}
+        or a multicast group), print samples and count sequence gaps
+
+The decoder below mirrors lib/InverterTelemetry/src/inverter_telemetry.h.
+
+Usage:
+  python3 doc/telemetryBench.py http --host inverter.local --count 200
+  python3 doc/telemetryBench.py udp --port 47800 [--group 239.255.0.1]
+"""
+
+import argparse
+import http.client
+import json
+import socket
+import struct
+import time
+
+CONTENT_TYPE = "application/x-inverter-telemetry"
+VERSION = 1
+HEADER = struct.Struct("<2sBBIIII")   # magic, version, flags, seq, generation, ts_ms, present
+
+# (name, struct code, scale) in field id order
+FIELDS = [
+    ("ac_out_voltage", "H", 10), ("ac_out_frequency", "H", 100),
+    ("ac_apparent_va", "H", 1), ("ac_active_w", "H", 1), ("load_percent", "B", 1),
+    ("batt_voltage", "H", 100), ("batt_charge_current", "H", 10), ("batt_soc", "B", 1),
+    ("heatsink_temp", "h", 10), ("pv_input_current", "H", 10), ("pv_input_voltage", "H", 10),
+    ("batt_voltage_from_scc", "H", 100), ("batt_discharge_current", "H", 10),
+    ("pv_charging_power", "H", 1), ("g_inverter_mode_code", "B", 1),
+    ("temp_h", "h", 10), ("temp_l", "h", 10), ("output_limit_w", "H", 1),
+    ("output_duty_cycle", "H", 10000), ("grid_voltage", "H", 10), ("grid_frequency", "H", 100),
+    ("bus_voltage", "H", 1), ("device_status_bits", "B", 1), ("additional_status_bits", "B", 1),
+]
+
+
+def decode(frame):
+    magic, version, flags, seq, gen, ts_ms, present = HEADER.unpack_from(frame)
+    if magic != b"IT" or version != VERSION:
+        raise ValueError("not a v%d telemetry frame" % VERSION)
+    out = {"seq": seq, "generation": gen, "ts_ms": ts_ms, "valid": bool(flags & 1)}
+    pos = HEADER.size
+    for i, (name, code, scale) in enumerate(FIELDS):
+        if present >> i & 1:
+            (raw,) = struct.unpack_from("<" + code, frame, pos)
+            pos += struct.calcsize(code)
+            out[name] = chr(raw) if name == "g_inverter_mode_code" else raw / scale
+    return out
+
+
+def bench_http(args):
+    print("format   bytes/sample  body[B]  req/s  decode[us]")
+    for name, accept in (("json", "application/json"), ("binary", CONTENT_TYPE)):
+        conn = http.client.HTTPConnection(args.host, args.port, timeout=5)
+        wire = body_total = 0
+        decode_s = 0.0
+        t0 = time.monotonic()
+        for _ in range(args.count):
+            req = "GET /status HTTP/1.1\r\nHost: %s\r\nAccept: %s\r\n\r\n" % (args.host, accept)
+            conn.request("GET", "/status", headers={"Accept": accept})
+            resp = conn.getresponse()
+            body = resp.read()
+            head = sum(len(k) + len(v) + 4 for k, v in resp.getheaders()) + 17
+            wire += len(req) + head + len(body)
+            body_total += len(body)
+            t1 = time.perf_counter()
+            if name == "json":
+                json.loads(body)
+            else:
+                decode(body)
+            decode_s += time.perf_counter() - t1
+        elapsed = time.monotonic() - t0
+        conn.close()
+        print("%-8s %12.0f %8.0f %6.1f %11.1f" % (
+            name, wire / args.count, body_total / args.count, args.count / elapsed,
+            decode_s / args.count * 1e6))
+
+
+def listen_udp(args):
+    s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    s.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    s.bind(("", args.port))
+    if args.group:
+        mreq = struct.pack("4s4s", socket.inet_aton(args.group), socket.inet_aton("0.0.0.0"))
+        s.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, mreq)
+    last_seq = None
+    received = lost = 0
+    try:
+        while True:
+            frame, peer = s.recvfrom(512)
+            try:
+                d = decode(frame)
+            except (ValueError, struct.error) as e:
+                print("%s: bad frame (%s)" % (peer[0], e))
+                continue
+            received += 1
+            if last_seq is not None:
+                gap = (d["seq"] - last_seq - 1) & 0xFFFFFFFF
+                if gap and gap < 0x80000000:
+                    lost += gap
+                    print("  gap: %d frame(s) lost before seq %d" % (gap, d["seq"]))
+            last_seq = d["seq"]
+            print("seq=%d gen=%d %dB batt=%sV pv=%sW  (rx %d, lost %d)" % (
+                d["seq"], d["generation"], len(frame), d.get("batt_voltage"),
+                d.get("pv_charging_power"), received, lost))
+    except KeyboardInterrupt:
+        pass
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = ap.add_subparsers(dest="mode", required=True)
+    h = sub.add_parser("http")
+    h.add_argument("--host", required=True)
+    h.add_argument("--port", type=int, default=80)
+    h.add_argument("--count", type=int, default=200)
+    u = sub.add_parser("udp")
+    u.add_argument("--port", type=int, default=47800)
+    u.add_argument("--group", help="multicast group to join")
+    args = ap.parse_args()
+    if args.mode == "http":
+        bench_http(args)
+    else:
+        listen_udp(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,215 @@
+// Host round-trip check of the binary telemetry codec
+// (lib/InverterTelemetry/src/inverter_telemetry.h).
+//
+// Checks:
+//   fields   every field encoded at its minimum, maximum, out of range on
+//            both sides (clamped to the limits), NaN (left absent) and a
+//            value that rounds to the nearest step, decoded back
+//   random   random field subsets and in-range values: header, presence
+//            bitmap and values survive, frame length matches the widths,
+//            a full frame fits TELEMETRY_MAX_FRAME
+//   bitmap   present bits beyond the known fields are dropped by the
+//            encoder and ignored (with trailing bytes) by the decoder
+//   seq      telemetry_seq_gap() in order, with losses and across the
+//            2^32 wrap
+//   reject   every truncated length of a full frame, wrong magic and
+//            versions, encode into a buffer that is too small
+//
+// Exits 1 if any check fails.
+//
+// Usage:
+//   g++ -std=gnu++17 -O2 -Ilib/InverterTelemetry/src -o /tmp/telemetryCodecCheck doc/telemetryCodecCheck.cpp
+//   /tmp/telemetryCodecCheck
+
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include "inverter_telemetry.h"
+
+static int g_checks = 0;
+static int g_failed = 0;
+
+#define CHECK(cond, ...)                                          \
+  do {                                                            \
+    g_checks++;                                                   \
+    if (!(cond)) {                                                \
+      g_failed++;                                                 \
+      printf("  FAIL %s:%d: %s: ", __FILE__, __LINE__, #cond);    \
+      printf(__VA_ARGS__);                                        \
+      printf("\n");                                               \
+    }                                                             \
+  } while (0)
+
+static std::mt19937 rng(1);
+
+// Raw integer limits of a field type
+static void raw_range(TelemetryType t, double* lo, double* hi) {
+  *lo = 0.0;
+  switch (t) {
+  case TELEM_U8:  *hi = 255.0; break;
+  case TELEM_U16: *hi = 65535.0; break;
+  case TELEM_I16: *lo = -32768.0; *hi = 32767.0; break;
+  default:        *hi = 4294967295.0; break;
+  }
+}
+
+// Encode one field set to v and decode it again; false if either step fails
+static bool round_trip_one(TelemetryField f, float v, TelemetrySample* out) {
+  TelemetrySample s;
+  telemetry_clear(&s);
+  telemetry_set(&s, f, v);
+  uint8_t buf[TELEMETRY_MAX_FRAME];
+  size_t n = telemetry_encode(s, buf, sizeof(buf));
+  return n >= TELEMETRY_HEADER_SIZE && telemetry_decode(buf, n, out);
+}
+
+static void check_fields() {
+  printf("fields\n");
+  for (int i = 0; i < TELEM_FIELD_COUNT; ++i) {
+    TelemetryField f = (TelemetryField)i;
+    const TelemetryFieldDesc& d = TELEMETRY_FIELDS[i];
+    double lo, hi;
+    raw_range(d.type, &lo, &hi);
+    float vmin = (float)(lo / d.scale), vmax = (float)(hi / d.scale);
+    float step = 1.0f / d.scale;
+    TelemetrySample r;
+
+    CHECK(round_trip_one(f, vmin, &r) && telemetry_has(r, f) && r.present == (1u << i) && r.values[i] == vmin,
+          "%s: min %g decoded %g", d.name, vmin, r.values[i]);
+    CHECK(round_trip_one(f, vmax, &r) && telemetry_has(r, f) && r.values[i] == vmax,
+          "%s: max %g decoded %g", d.name, vmax, r.values[i]);
+    CHECK(round_trip_one(f, vmax * 2.0f + 1000.0f, &r) && r.values[i] == vmax,
+          "%s: above range decoded %g, want %g", d.name, r.values[i], vmax);
+    CHECK(round_trip_one(f, vmin * 2.0f - 1000.0f, &r) && r.values[i] == vmin,
+          "%s: below range decoded %g, want %g", d.name, r.values[i], vmin);
+    CHECK(round_trip_one(f, NAN, &r) && r.present == 0, "%s: NaN present %08X", d.name, (unsigned)r.present);
+
+    // 0.4 step above a step rounds down, 0.6 rounds up (compared as raw steps)
+    long raw = (long)(hi / 2);
+    float base = (float)(raw / d.scale);
+    CHECK(round_trip_one(f, base + 0.4f * step, &r) && lround(r.values[i] * d.scale) == raw,
+          "%s: %g + 0.4 step decoded %g", d.name, base, r.values[i]);
+    CHECK(round_trip_one(f, base + 0.6f * step, &r) && lround(r.values[i] * d.scale) == raw + 1,
+          "%s: %g + 0.6 step decoded %g", d.name, base, r.values[i]);
+  }
+}
+
+static void check_random() {
+  printf("random\n");
+  std::uniform_int_distribution<uint32_t> u32;
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  size_t full = TELEMETRY_HEADER_SIZE;
+  for (int i = 0; i < TELEM_FIELD_COUNT; ++i) full += telemetry_type_size(TELEMETRY_FIELDS[i].type);
+  CHECK(full <= TELEMETRY_MAX_FRAME, "all fields need %zu bytes, TELEMETRY_MAX_FRAME %d", full, TELEMETRY_MAX_FRAME);
+
+  for (int iter = 0; iter < 5000; ++iter) {
+    TelemetrySample s;
+    telemetry_clear(&s);
+    s.seq = u32(rng);
+    s.generation = u32(rng);
+    s.ts_ms = u32(rng);
+    s.flags = (uint8_t)u32(rng);
+    uint32_t mask = iter == 0 ? (1u << TELEM_FIELD_COUNT) - 1 : u32(rng) & ((1u << TELEM_FIELD_COUNT) - 1);
+    size_t want_len = TELEMETRY_HEADER_SIZE;
+    for (int i = 0; i < TELEM_FIELD_COUNT; ++i) {
+      if (!((mask >> i) & 1u)) continue;
+      const TelemetryFieldDesc& d = TELEMETRY_FIELDS[i];
+      double lo, hi;
+      raw_range(d.type, &lo, &hi);
+      telemetry_set(&s, (TelemetryField)i, (float)((lo + unit(rng) * (hi - lo)) / d.scale));
+      want_len += telemetry_type_size(d.type);
+    }
+    uint8_t buf[TELEMETRY_MAX_FRAME];
+    size_t n = telemetry_encode(s, buf, sizeof(buf));
+    CHECK(n == want_len, "mask %08X: length %zu, want %zu", (unsigned)mask, n, want_len);
+    TelemetrySample r;
+    bool ok = telemetry_decode(buf, n, &r);
+    CHECK(ok && r.seq == s.seq && r.generation == s.generation && r.ts_ms == s.ts_ms && r.flags == s.flags,
+          "mask %08X: header differs", (unsigned)mask);
+    CHECK(ok && r.present == mask, "present %08X, want %08X", (unsigned)r.present, (unsigned)mask);
+    for (int i = 0; ok && i < TELEM_FIELD_COUNT; ++i) {
+      if (!((mask >> i) & 1u)) continue;
+      float tol = 0.5f / TELEMETRY_FIELDS[i].scale + fabsf(s.values[i]) * 1e-6f;
+      CHECK(fabsf(r.values[i] - s.values[i]) <= tol, "%s: %g decoded %g", TELEMETRY_FIELDS[i].name, s.values[i],
+            r.values[i]);
+    }
+    if (g_failed) break;
+  }
+}
+
+static void check_bitmap() {
+  printf("bitmap\n");
+  TelemetrySample s;
+  telemetry_clear(&s);
+  telemetry_set(&s, TELEM_AC_ACTIVE_W, 1234.0f);
+  telemetry_set(&s, TELEM_ADDITIONAL_STATUS_BITS, 5.0f);
+  s.present |= 1u << 31;   // a field this encoder does not know
+  uint8_t buf[TELEMETRY_MAX_FRAME + 8];
+  size_t n = telemetry_encode(s, buf, TELEMETRY_MAX_FRAME);
+  uint32_t want = (1u << TELEM_AC_ACTIVE_W) | (1u << TELEM_ADDITIONAL_STATUS_BITS);
+  CHECK(telemetry_get_le(buf + 16, 4) == want, "encoded present %08X, want %08X",
+        (unsigned)telemetry_get_le(buf + 16, 4), (unsigned)want);
+  CHECK(n == TELEMETRY_HEADER_SIZE + 2 + 1, "length %zu", n);
+
+  // A newer encoder: unknown present bits and their bytes after the known ones
+  telemetry_put_le(buf + 16, want | (1u << 30) | (1u << 31), 4);
+  memset(buf + n, 0xA5, 6);
+  TelemetrySample r;
+  bool ok = telemetry_decode(buf, n + 6, &r);
+  CHECK(ok && r.present == want && r.values[TELEM_AC_ACTIVE_W] == 1234.0f &&
+        r.values[TELEM_ADDITIONAL_STATUS_BITS] == 5.0f, "newer frame: ok %d present %08X", ok, (unsigned)r.present);
+  CHECK(!telemetry_has(r, TELEM_AC_OUT_VOLTAGE) && telemetry_has(r, TELEM_AC_ACTIVE_W), "telemetry_has");
+}
+
+static void check_seq() {
+  printf("seq\n");
+  CHECK(telemetry_seq_gap(5, 6) == 0, "in order");
+  CHECK(telemetry_seq_gap(5, 9) == 3, "3 lost");
+  CHECK(telemetry_seq_gap(0xFFFFFFFFu, 0) == 0, "wrap in order");
+  CHECK(telemetry_seq_gap(0xFFFFFFFEu, 1) == 2, "2 lost across the wrap");
+  CHECK(telemetry_seq_gap(0xFFFFFFF0u, 0x10) == 31, "31 lost across the wrap");
+  // A repeat or a restarted counter shows up as a huge gap, not a negative one
+  CHECK(telemetry_seq_gap(5, 5) == 0xFFFFFFFFu, "repeat gives %u", (unsigned)telemetry_seq_gap(5, 5));
+}
+
+static void check_reject() {
+  printf("reject\n");
+  TelemetrySample s;
+  telemetry_clear(&s);
+  for (int i = 0; i < TELEM_FIELD_COUNT; ++i) telemetry_set(&s, (TelemetryField)i, 1.0f);
+  uint8_t buf[TELEMETRY_MAX_FRAME];
+  size_t n = telemetry_encode(s, buf, sizeof(buf));
+  TelemetrySample r;
+  CHECK(n > TELEMETRY_HEADER_SIZE && telemetry_decode(buf, n, &r), "full frame (%zu bytes) rejected", n);
+  for (size_t len = 0; len < n; ++len) {
+    CHECK(!telemetry_decode(buf, len, &r), "truncated to %zu of %zu bytes accepted", len, n);
+  }
+  for (size_t cap = 0; cap < n; ++cap) {
+    uint8_t small[TELEMETRY_MAX_FRAME];
+    CHECK(telemetry_encode(s, small, cap) == 0, "encode into %zu of %zu bytes", cap, n);
+  }
+
+  static const uint8_t VERSIONS[] = { 0, TELEMETRY_VERSION + 1, 0xFF };
+  for (uint8_t v : VERSIONS) {
+    uint8_t bad[TELEMETRY_MAX_FRAME];
+    memcpy(bad, buf, n);
+    bad[2] = v;
+    CHECK(!telemetry_decode(bad, n, &r), "version %u accepted", v);
+  }
+  for (int b = 0; b < 2; ++b) {
+    uint8_t bad[TELEMETRY_MAX_FRAME];
+    memcpy(bad, buf, n);
+    bad[b] ^= 0x20;
+    CHECK(!telemetry_decode(bad, n, &r), "magic byte %d %02X accepted", b, bad[b]);
+  }
+}
+
+int main() {
+  check_fields();
+  check_random();
+  check_bitmap();
+  check_seq();
+  check_reject();
+  printf("%d checks, %d failed\n", g_checks, g_failed);
+  return g_failed ? 1 : 0;
+}
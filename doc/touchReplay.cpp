@@ -0,0 +1,208 @@
+// Replay touch pad traces through TouchButton (src/touch_button.h) the way
+// touch_input.cpp drives it, next to the old loop() scan (touchRead() every
+// 50 ms against a raw threshold of 35), and count events and press latency.
+//
+// Hardware model: the touch FSM measures once per round (4 pads x 0.5 ms +
+// 3.4 ms sleep = 5.4 ms, config.h) and holds the value; the interrupt fires
+// at the end of a round that reads below the press level. The task then
+// samples every TOUCH_SAMPLE_MS until the pad is idle, otherwise every
+// TOUCH_IDLE_MS. Latency is from the finger landing to the press event
+// (loop() dispatch, up to one 5 ms loop iteration, is not included for
+// either).
+//
+// Built-in scenarios are synthetic (seeded noise): clean taps with contact
+// bounce, a 2 s hold, baseline drift down past the old threshold, a water
+// film that stays for a minute and a finger on the pad at boot. A recorded
+// trace (CSV "t_ms,value", 1 ms or coarser steps, e.g. from touch_value_counts
+// scrapes or a serial dump) can be replayed with --csv.
+//
+// Usage:
+//   g++ -std=gnu++17 -O2 -Isrc -Iinclude -o /tmp/touchReplay doc/touchReplay.cpp src/touch_button.cpp
+//   /tmp/touchReplay
+//   /tmp/touchReplay --csv pad.csv
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+#include <vector>
+#include "touch_button.h"
+
+#define TOUCH_SAMPLE_MS 5      // config.h
+#define TOUCH_IDLE_MS   1000
+static const double ROUND_MS = 5.4;
+static const uint16_t OLD_THRESHOLD = 35;
+static const uint32_t OLD_PERIOD_MS = 50;
+
+struct Result {
+  int events[TOUCH_EVENT_TYPES] = {};
+  std::vector<int> latency_ms;
+  int spurious = 0;
+  int samples = 0;
+};
+
+// Finger landings (ms) for the latency pairing
+static std::vector<uint32_t> onsets(const std::vector<uint8_t>& finger) {
+  std::vector<uint32_t> out;
+  if (!finger.empty() && finger[0]) out.push_back(0);
+  for (size_t t = 1; t < finger.size(); ++t) {
+    if (finger[t] && !finger[t - 1]) out.push_back((uint32_t)t);
+  }
+  return out;
+}
+
+// A press within PAIR_MS of a finger landing is that touch, anything else is spurious
+static const uint32_t PAIR_MS = 500;
+static void pair_latency(Result& r, const std::vector<uint32_t>& press_ms, const std::vector<uint32_t>& on) {
+  size_t j = 0;
+  for (uint32_t p : press_ms) {
+    while (j + 1 < on.size() && on[j + 1] <= p) ++j;
+    if (j < on.size() && on[j] <= p && p - on[j] < PAIR_MS) r.latency_ms.push_back((int)(p - on[j]));
+    else r.spurious++;
+  }
+}
+
+static Result run_new(const std::vector<uint16_t>& trace, const std::vector<uint8_t>& finger, uint16_t cal) {
+  Result r;
+  TouchButton b;
+  b.calibrate(cal);
+  std::vector<uint32_t> press_ms;
+  uint16_t held = trace[0];
+  double next_round = ROUND_MS;
+  uint32_t next_sample = TOUCH_IDLE_MS;
+  for (uint32_t t = 0; t < trace.size(); ++t) {
+    bool irq = false;
+    if (t >= next_round) {
+      held = trace[t];
+      next_round += ROUND_MS;
+      irq = !b.active() && held < b.press_level();
+    }
+    if (!irq && t < next_sample) continue;
+    r.samples++;
+    TouchEvent ev[2];
+    uint8_t n = b.update(held, t, ev);
+    for (uint8_t k = 0; k < n; ++k) {
+      r.events[ev[k].type]++;
+      if (ev[k].type == TOUCH_PRESS) press_ms.push_back(t);
+    }
+    next_sample = t + (b.active() ? TOUCH_SAMPLE_MS : TOUCH_IDLE_MS);
+  }
+  pair_latency(r, press_ms, onsets(finger));
+  return r;
+}
+
+static Result run_old(const std::vector<uint16_t>& trace, const std::vector<uint8_t>& finger) {
+  Result r;
+  bool pressed = false;
+  std::vector<uint32_t> press_ms;
+  for (uint32_t t = 0; t < trace.size(); t += OLD_PERIOD_MS) {
+    r.samples++;
+    bool now = trace[t] <= OLD_THRESHOLD;
+    if (now && !pressed) { r.events[TOUCH_PRESS]++; press_ms.push_back(t); }
+    if (!now && pressed) r.events[TOUCH_RELEASE]++;
+    pressed = now;
+  }
+  pair_latency(r, press_ms, onsets(finger));
+  return r;
+}
+
+static void print(const char* algo, const Result& r, double seconds) {
+  double mean = 0, mx = 0;
+  for (int l : r.latency_ms) { mean += l; mx = fmax(mx, l); }
+  if (!r.latency_ms.empty()) mean /= r.latency_ms.size();
+  printf("  %-4s press %3d (spurious %3d) release %3d long %2d repeat %3d | latency mean %5.1f max %3.0f ms"
+         " | %5.1f samples/s\n", algo, r.events[TOUCH_PRESS], r.spurious, r.events[TOUCH_RELEASE],
+         r.events[TOUCH_LONG], r.events[TOUCH_REPEAT], mean, mx, r.samples / seconds);
+}
+
+// --- Synthetic traces (1 ms steps) ---
+struct Trace {
+  const char* name;
+  const char* expect;
+  std::vector<uint16_t> v;
+  std::vector<uint8_t> finger;
+  uint16_t cal;
+};
+
+static std::mt19937 rng(1);
+static double noise(double sd) { return std::normal_distribution<double>(0.0, sd)(rng); }
+
+// base(t) untouched level, touches: [start, end) with contact bounce at both edges
+static Trace make(const char* name, const char* expect, uint32_t len_ms, double (*base)(uint32_t),
+                  const std::vector<std::pair<uint32_t, uint32_t>>& touches, double depth = 0.55) {
+  Trace tr{ name, expect, std::vector<uint16_t>(len_ms), std::vector<uint8_t>(len_ms), 0 };
+  for (uint32_t t = 0; t < len_ms; ++t) {
+    double b = base(t);
+    bool on = false;
+    for (auto& p : touches) {
+      if (t >= p.first && t < p.second) {
+        on = true;
+        // 4 ms of chatter after landing and before lifting
+        uint32_t in = t - p.first, out = p.second - t;
+        if ((in < 4 || out < 4) && (t % 2)) on = false;
+      }
+    }
+    bool finger = false;
+    for (auto& p : touches) if (t >= p.first && t < p.second) finger = true;
+    double v = b * (on ? 1.0 - depth : 1.0) + noise(1.2);
+    tr.v[t] = (uint16_t)fmax(0.0, v);
+    tr.finger[t] = finger;
+  }
+  tr.cal = (uint16_t)base(0);
+  return tr;
+}
+
+static double flat60(uint32_t) { return 60.0; }
+static double drift_down(uint32_t t) { return 60.0 - 24.0 * fmin(1.0, t / 600000.0); }
+
+int main(int argc, char** argv) {
+  std::vector<Trace> traces;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--csv") && i + 1 < argc) {
+      FILE* f = fopen(argv[++i], "r");
+      if (!f) { perror(argv[i]); return 2; }
+      Trace tr{ argv[i], "recorded", {}, {}, 0 };
+      unsigned t, v, last_t = 0;
+      uint16_t last_v = 0;
+      while (fscanf(f, "%u,%u", &t, &v) == 2) {
+        while (last_t < t && !tr.v.empty()) { tr.v.push_back(last_v); last_t++; }
+        tr.v.push_back((uint16_t)v);
+        last_v = (uint16_t)v;
+        last_t = t + 1;
+      }
+      fclose(f);
+      if (tr.v.empty()) { fprintf(stderr, "%s: no samples\n", argv[i]); return 2; }
+      tr.finger.assign(tr.v.size(), 0);
+      tr.cal = tr.v[0];
+      traces.push_back(tr);
+    } else {
+      fprintf(stderr, "usage: %s [--csv t_ms,value file]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  if (traces.empty()) {
+    std::vector<std::pair<uint32_t, uint32_t>> taps;
+    std::uniform_int_distribution<uint32_t> dur(80, 200), gap(300, 900);
+    for (uint32_t t = 1000; taps.size() < 20; ) { uint32_t d = dur(rng); taps.push_back({ t, t + d }); t += d + gap(rng); }
+    traces.push_back(make("taps", "20 presses/releases", 25000, flat60, taps));
+    traces.push_back(make("hold", "1 press, 1 long, ~10 repeats", 5000, flat60, { { 1013, 3013 } }));
+    std::vector<std::pair<uint32_t, uint32_t>> drift_taps;
+    for (uint32_t t = 30000; t < 720000; t += 60000) drift_taps.push_back({ t, t + 150 });
+    traces.push_back(make("drift", "12 presses; the base sinks to 36 (old threshold 35)", 720000, drift_down, drift_taps));
+    traces.push_back(make("water", "film for 60 s: 1 press, <= TOUCH_REPEAT_MAX repeats, released and re-baselined at 30 s", 90000, flat60, { { 10000, 70000 } }, 0.4));
+    Trace boot = make("boot", "finger on at calibration, then 3 taps", 10000, flat60,
+                      { { 0, 1500 }, { 2507, 2657 }, { 4011, 4161 }, { 6023, 6173 } });
+    boot.cal = (uint16_t)(60 * 0.45);
+    traces.push_back(boot);
+  }
+
+  for (const Trace& tr : traces) {
+    double seconds = tr.v.size() / 1000.0;
+    printf("%s (%.0f s): expect %s\n", tr.name, seconds, tr.expect);
+    print("new", run_new(tr.v, tr.finger, tr.cal), seconds);
+    print("old", run_old(tr.v, tr.finger), seconds);
+  }
+  return 0;
+}
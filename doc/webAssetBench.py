@@ -0,0 +1,119 @@
+# -*- coding: utf-8 -*-
+"""
+First-load benchmark for the web UI: GET / and every script/stylesheet it
+references, as a browser with an empty cache would, then a warm reload that
+revalidates with If-None-Match.
+
+Two variants are compared:
+  gzip      Accept-Encoding: gzip -> served from the built-in asset table
+            (src/web_assets_data.h, pre-gzipped in flash)
+  identity  no Accept-Encoding    -> falls back to LittleFS (the old path)
+
+Each variant is repeated --runs times on a fresh keep-alive connection;
+reported are median time to last byte and bytes on the wire (headers +
+body, TCP/IP overhead excluded).
+
+Usage:
+  python3 doc/webAssetBench.py --host inverter.local --runs 10
+"""
+
+import argparse
+import gzip
+import re
+import socket
+import statistics
+import time
+
+
+def read_response(s, buf):
+    """Read one HTTP/1.1 response (Content-Length or chunked) from socket s."""
+    while b"\r\n\r\n" not in buf:
+        b = s.recv(4096)
+        if not b:
+            raise OSError("connection closed")
+        buf += b
+    head, rest = buf.split(b"\r\n\r\n", 1)
+    lines = head.decode("latin-1").split("\r\n")
+    status = int(lines[0].split()[1])
+    hdrs = {k.strip().lower(): v.strip() for k, v in (l.split(":", 1) for l in lines[1:] if ":" in l)}
+    wire = len(head) + 4
+    if status == 304:
+        return status, hdrs, b"", wire, rest
+    if hdrs.get("transfer-encoding", "").lower() == "chunked":
+        body = b""
+        while True:
+            while b"\r\n" not in rest:
+                rest += s.recv(4096)
+            size_line, rest = rest.split(b"\r\n", 1)
+            n = int(size_line.split(b";")[0], 16)
+            while len(rest) < n + 2:
+                rest += s.recv(4096)
+            body += rest[:n]
+            wire += len(size_line) + 2 + n + 2
+            rest = rest[n + 2:]
+            if n == 0:
+                return status, hdrs, body, wire, rest
+    n = int(hdrs.get("content-length", "0"))
+    while len(rest) < n:
+        b = s.recv(4096)
+        if not b:
+            break
+        rest += b
+    return status, hdrs, rest[:n], wire + n, rest[n:]
+
+
+def page_load(host, port, use_gzip, etags):
+    """Fetch / and its assets on one connection; returns (seconds, bytes, etags)."""
+    enc = "Accept-Encoding: gzip\r\n" if use_gzip else ""
+    t0 = time.monotonic()
+    total = 0
+    new_etags = {}
+    with socket.create_connection((host, port), timeout=10) as s:
+        buf = b""
+        paths = ["/"]
+        i = 0
+        while i < len(paths):
+            path = paths[i]
+            inm = ("If-None-Match: %s\r\n" % etags[path]) if path in etags else ""
+            req = ("GET %s HTTP/1.1\r\nHost: %s\r\n%s%s\r\n" % (path, host, enc, inm)).encode()
+            s.sendall(req)
+            status, hdrs, body, wire, buf = read_response(s, buf)
+            total += len(req) + wire
+            if "etag" in hdrs:
+                new_etags[path] = hdrs["etag"]
+            if path == "/" and status == 200:
+                if hdrs.get("content-encoding") == "gzip":
+                    body = gzip.decompress(body)
+                for ref in re.findall(rb'(?:src|href)="\.?(/?[^"/][^"]*\.(?:js|css))"', body):
+                    p = ref.decode()
+                    paths.append(p if p.startswith("/") else "/" + p)
+            elif path == "/" and status == 304:
+                paths += [p for p in etags if p != "/"]
+            i += 1
+    return time.monotonic() - t0, total, new_etags
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--host", required=True)
+    ap.add_argument("--port", type=int, default=80)
+    ap.add_argument("--runs", type=int, default=10)
+    args = ap.parse_args()
+
+    print("variant    cold[ms]  cold[B]   warm[ms]  warm[B]")
+    for name, gz in (("identity", False), ("gzip", True)):
+        cold_t, cold_b, warm_t, warm_b = [], [], [], []
+        for _ in range(args.runs):
+            t, b, etags = page_load(args.host, args.port, gz, {})
+            cold_t.append(t * 1000)
+            cold_b.append(b)
+            t, b, _ = page_load(args.host, args.port, gz, etags)
+            warm_t.append(t * 1000)
+            warm_b.append(b)
+        print("%-9s %9.1f %8d %10.1f %8d" % (
+            name, statistics.median(cold_t), statistics.median(cold_b),
+            statistics.median(warm_t), statistics.median(warm_b)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,241 @@
+# -*- coding: utf-8 -*-
+"""
+Setter command latency: HTTP POST /cmd (inverter_write) until the ACK.
+
+Sends --count setter commands, one at a time. POST /cmd answers right away
+(202, state "queued", ticket id); the script polls GET /cmd?id= every
+20 ms until the final state and measures on the client the time from
+sending the POST to seeing it. Commands are spread over random phases of
+the poll cycle, so some land right after a QPIGS/QPGS started and show the
+worst in-flight wait. With --burst N, N commands are queued back to back
+and then polled together, which shows the cost of the queue ahead.
+
+Use a command that re-applies the current setting (e.g. the output source
+priority the inverter already has) so the benchmark changes nothing.
+
+Reported: client-side p50/p95/max per answer, the firmware's own
+submission-to-answer latency (reply "latency_ms") and the analytic worst
+case from the timeouts in src/inverter_uart.h (see src/inverter_write.h).
+
+--emulate runs the same bus-owner loop as the firmware (writes first, then
+QPIGS/QMOD every 1.5 s and QPGSn slots, waits cut short by a submission)
+against doc/inverterEmulator.py on a pty, in real time, and reports
+submission-to-ACK latency without a device; --crc-error/--silent add the
+retry path.
+
+Usage:
+  python3 doc/writeLatencyBench.py --host inverter.local --cmd POP01 --count 50
+  python3 doc/writeLatencyBench.py --host inverter.local --cmd POP01 --burst 8
+  python3 doc/writeLatencyBench.py --model
+  python3 doc/writeLatencyBench.py --emulate --duration 60 --units 2 --silent 0.05
+"""
+
+import argparse
+import http.client
+import json
+import os
+import random
+import sys
+import threading
+import time
+
+# Mirror of src/inverter_uart.h / inverter_write.h
+BAUD = 2400
+FIRST_BYTE_TIMEOUT_MS = 300
+WRITE_MAX_ATTEMPTS = 3
+WRITE_RX_LEN = 7          # (ACK<CRC><CR>
+QPGS_RX_LEN = 133         # longest inquiry response
+
+
+def bytes_time_ms(n):
+    return (n * 10 * 1000 + BAUD - 1) // BAUD
+
+
+def timeout_ms(tx_len, rx_len):
+    rx = bytes_time_ms(rx_len)
+    return bytes_time_ms(tx_len) + FIRST_BYTE_TIMEOUT_MS + rx + rx // 4
+
+
+def print_model():
+    write = timeout_ms(12, WRITE_RX_LEN)
+    inflight = timeout_ms(8, QPGS_RX_LEN)
+    print("write transaction timeout      %5d ms" % write)
+    print("in-flight inquiry (QPGS) max   %5d ms" % inflight)
+    print("ACK on first attempt, worst    %5d ms" % (inflight + write))
+    print("FAILED after %d attempts, worst %5d ms" % (WRITE_MAX_ATTEMPTS, inflight + WRITE_MAX_ATTEMPTS * write))
+    print("each write queued ahead adds   %5d ms (worst)" % (WRITE_MAX_ATTEMPTS * write))
+
+
+def request(host, method, path, body=None, timeout=10.0):
+    conn = http.client.HTTPConnection(host, timeout=timeout)
+    try:
+        headers = {"Content-Type": "application/json"} if body is not None else {}
+        conn.request(method, path, body=json.dumps(body) if body is not None else None, headers=headers)
+        resp = conn.getresponse()
+        return resp.status, json.loads(resp.read() or b"{}")
+    finally:
+        conn.close()
+
+
+def percentile(values, p):
+    if not values:
+        return float("nan")
+    s = sorted(values)
+    return s[min(len(s) - 1, int(round(p / 100.0 * (len(s) - 1))))]
+
+
+def report(title, results):
+    print(title)
+    by_state = {}
+    for state, client_ms, fw_ms in results:
+        by_state.setdefault(state, []).append((client_ms, fw_ms))
+    for state, rows in sorted(by_state.items()):
+        c = [r[0] for r in rows]
+        f = [r[1] for r in rows if r[1] is not None]
+        print("  %-8s n=%-4d client p50 %6.0f p95 %6.0f max %6.0f ms | firmware p50 %6.0f max %6.0f ms" % (
+            state, len(rows), percentile(c, 50), percentile(c, 95), max(c),
+            percentile(f, 50), max(f) if f else float("nan")))
+
+
+def wait_final(host, dev, ticket, t0):
+    """Poll GET /cmd?id= until the write is final: (state, client ms, firmware ms)"""
+    while True:
+        status, reply = request(host, "GET", "/cmd?id=%d&dev=%d" % (ticket, dev))
+        if status == 404:
+            return "expired", (time.monotonic() - t0) * 1000.0, None
+        if reply.get("state") in ("ack", "nak", "failed"):
+            return reply["state"], (time.monotonic() - t0) * 1000.0, reply.get("latency_ms")
+        time.sleep(0.02)
+
+
+def run_single(args):
+    results = []
+    for _ in range(args.count):
+        time.sleep(random.uniform(0.0, args.spread))
+        body = {"type": "cmd", "name": "inverter_write", "value": args.cmd, "dev": args.dev}
+        t0 = time.monotonic()
+        _, reply = request(args.host, "POST", "/cmd", body)
+        if "id" not in reply:
+            results.append((reply.get("code", "error"), (time.monotonic() - t0) * 1000.0, None))
+            continue
+        results.append(wait_final(args.host, args.dev, reply["id"], t0))
+    report("single commands (%d x %s)" % (args.count, args.cmd), results)
+
+
+def run_burst(args):
+    t0 = time.monotonic()
+    ids = []
+    for _ in range(args.burst):
+        body = {"type": "cmd", "name": "inverter_write", "value": args.cmd, "dev": args.dev}
+        _, reply = request(args.host, "POST", "/cmd", body)
+        if "id" in reply:
+            ids.append(reply["id"])
+        else:
+            print("  rejected: %s" % reply.get("msg"))
+    results = {}
+    while len(results) < len(ids):
+        for i in ids:
+            if i in results:
+                continue
+            status, reply = request(args.host, "GET", "/cmd?id=%d&dev=%d" % (i, args.dev))
+            if status == 404:
+                results[i] = ("expired", (time.monotonic() - t0) * 1000.0, None)
+            elif reply.get("state") in ("ack", "nak", "failed"):
+                results[i] = (reply["state"], (time.monotonic() - t0) * 1000.0, reply.get("latency_ms"))
+        time.sleep(0.02)
+    report("burst of %d (client time from the first POST)" % args.burst, [results[i] for i in ids])
+
+
+def run_emulated(args):
+    sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+    import inverterEmulator as emu_mod
+
+    imp = emu_mod.Impairments(BAUD, args.latency, 10.0, 0.0, args.crc_error, args.silent)
+    emu = emu_mod.Emulator(emu_mod.InverterModel(args.units), imp).start()
+    fd = emu_mod.open_port(emu.slave_path, BAUD)
+
+    lock = threading.Lock()
+    wake = threading.Event()
+    queue = []        # (submit time, attempts)
+    results = []      # (state, latency ms, attempts)
+    stop = time.monotonic() + args.duration
+
+    def submitter():
+        while time.monotonic() < stop:
+            time.sleep(random.uniform(0.2, 2.0 * args.spread))
+            with lock:
+                queue.append([time.monotonic(), 0])
+            wake.set()
+
+    threading.Thread(target=submitter, daemon=True).start()
+    # Inquiry cadence as in the firmware schedule with parallel units
+    polls = [("QPIGS", 110, 1.5), ("QMOD", 5, 1.5)]
+    polls += [("QPGS%d" % u, 133, 1.5 / max(1, args.units)) for u in range(args.units if args.units > 1 else 0)]
+    due = {name: time.monotonic() for name, _, _ in polls}
+    while time.monotonic() < stop:
+        with lock:
+            job = queue[0] if queue else None
+        if job:
+            job[1] += 1
+            st, _, _ = emu_mod.transact(fd, args.cmd or "POP01", WRITE_RX_LEN, BAUD)
+            if st in ("ok", "nak") or job[1] >= WRITE_MAX_ATTEMPTS:
+                state = {"ok": "ack", "nak": "nak"}.get(st, "failed")
+                results.append((state, (time.monotonic() - job[0]) * 1000.0, job[1]))
+                with lock:
+                    queue.pop(0)
+            continue
+        now = time.monotonic()
+        name, rx_len, period = min(polls, key=lambda p: due[p[0]])
+        if due[name] > now:
+            wake.wait(due[name] - now)
+            wake.clear()
+            continue
+        emu_mod.transact(fd, name, rx_len, BAUD)
+        due[name] += period
+        if due[name] < now:
+            due[name] = now + period
+    os.close(fd)
+    emu.stop()
+
+    print("emulated: %d unit(s), latency %.0f ms, crc-error %.2f, silent %.2f" % (
+        args.units, args.latency, args.crc_error, args.silent))
+    report("submission to final answer", [(s, ms, ms) for s, ms, _ in results])
+    retried = sum(1 for _, _, a in results if a > 1)
+    print("  retried %d of %d" % (retried, len(results)))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--host")
+    ap.add_argument("--cmd", help="setter to send, e.g. POP01 (must not change anything)")
+    ap.add_argument("--dev", type=int, default=0)
+    ap.add_argument("--count", type=int, default=30)
+    ap.add_argument("--spread", type=float, default=2.0, help="random pause before each command [s]")
+    ap.add_argument("--burst", type=int, default=0, help="queue N commands at once instead")
+    ap.add_argument("--model", action="store_true", help="print the analytic worst case and exit")
+    ap.add_argument("--emulate", action="store_true", help="measure against an in-process emulator")
+    ap.add_argument("--duration", type=float, default=60.0, help="--emulate run time [s]")
+    ap.add_argument("--units", type=int, default=1, help="--emulate parallel units")
+    ap.add_argument("--latency", type=float, default=30.0, help="--emulate response latency [ms]")
+    ap.add_argument("--crc-error", type=float, default=0.0, help="--emulate CRC corruption probability")
+    ap.add_argument("--silent", type=float, default=0.0, help="--emulate ignored request probability")
+    args = ap.parse_args()
+
+    if args.model:
+        print_model()
+        return
+    if args.emulate:
+        print_model()
+        run_emulated(args)
+        return
+    if not args.host or not args.cmd:
+        ap.error("--host and --cmd are required (or --model)")
+    print_model()
+    if args.burst:
+        run_burst(args)
+    else:
+        run_single(args)
+
+
+if __name__ == "__main__":
+    main()
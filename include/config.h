@@ -8,6 +8,18 @@
 // Feather ESP32 default: RX2=GPIO16, TX2=GPIO17
 #define INVERTER_RX_PIN 16
 #define INVERTER_TX_PIN 17
+// UART peripheral and baud rate used for the inverter link
+#define INVERTER_UART_NUM 1
+#define INVERTER_BAUD 2400
+
+// Additional inverter on its own UART (one poll task per link, devices are
+// addressed by index: 0 = the link above, 1 = this one). UART0 is the USB
+// console, so the ESP32 has room for two links. Set INVERTER_LINK_COUNT to 2
+// once the second MAX3232 is wired.
+#define INVERTER_LINK_COUNT 1
+#define INVERTER2_RX_PIN 32
+#define INVERTER2_TX_PIN 33
+#define INVERTER2_UART_NUM 2
 
 // --- LCD QC1602A (4-bit parallel mode) ---
 #define LCD_RS 21
@@ -23,17 +35,30 @@
 
 // --- PWM output ---
 #define PWM_PIN 25
+// Period and duty resolution (see pwm_output.h). Periods above 1 s (SSR,
+// whole mains cycles) run on esp_timer, shorter ones on the LEDC peripheral.
+#define PWM_PERIOD_MS 2000
+#define PWM_RESOLUTION_BITS 10
+#define PWM_MODE PWM_MODE_AUTO
+// Output is forced off if pwm_output_set_duty() is not called for this long
+#define PWM_WATCHDOG_MS 3000
 
 // --- Capacitive touch inputs (ESP32 Touch) ---
 // Physical button positions: Up, Left, Down, Right
 
 #define BTN_UP_TOUCH    4   // Touch0 (GPIO4)
-#define BTN_LEFT_TOUCH  14  // Touch1 (GPIO14)
-#define BTN_DOWN_TOUCH  13  // Touch2 (GPIO13)
+#define BTN_LEFT_TOUCH  14  // Touch6 (GPIO14)
+#define BTN_DOWN_TOUCH  13  // Touch4 (GPIO13)
 #define BTN_RIGHT_TOUCH 15  // Touch3 (GPIO15)
 
-// Touch threshold for detecting a press. Raw values vary by board/environment.
-#define BTN_TOUCH_THRESHOLD 35
+// Hardware measurement and sampling (see touch_input.h). Press/release levels
+// are relative to each pad's tracked baseline (touch_button.h), so there is
+// no raw threshold to tune per board.
+#define TOUCH_MEAS_CYCLES       0x1000  // per pad, 8 MHz: 0.5 ms
+#define TOUCH_SLEEP_CYCLES      0x200   // between rounds, 150 kHz: 3.4 ms
+#define TOUCH_SAMPLE_MS         5       // while a pad is touched
+#define TOUCH_IDLE_MS           1000    // baseline tracking while idle
+#define TOUCH_CALIBRATE_SAMPLES 16
 
 // --- NTC Thermistor (temperature sensor) ---
 // Wiring per: https://www.smartlab.at/a-diy-guide-measuring-water-temperature-with-an-ntc-10k-thermistor-and-esp32/
@@ -41,6 +66,19 @@
 // Note: GPIO34 is input-only on ESP32, suitable for ADC.
 #define THERMISTOR_L_PIN 34
 #define THERMISTOR_H_PIN 35
+// Thermistor channels: X(name, LCD label, ADC1 pin, curve from src/ntc_curves.h).
+// "h" and "l" also go into the inverter snapshot (history, telemetry, /status
+// temp_h/temp_l). More points, e.g. X(batt, "B", 36, NTC_10K_SH) or
+// X(encl, "E", 39, NTC_10K_B3950); ADC1 pins only (GPIO32..39) as ADC2 is
+// unusable with WiFi on.
+#define THERMISTOR_CHANNELS(X) \
+  X(h, "H", THERMISTOR_H_PIN, NTC_10K_B3950) \
+  X(l, "L", THERMISTOR_L_PIN, NTC_10K_B3950)
+// Background sampling (see thermistor.h)
+#define THERMISTOR_SAMPLE_MS   20     // one oversampled burst per pin
+#define THERMISTOR_OVERSAMPLE  16     // conversions averaged per burst
+#define THERMISTOR_TAU_MS      2000   // IIR time constant after the median-of-3
+#define THERMISTOR_OUTPUT_MS   1000   // publish rate
 
 // At microsecond speeds, the functions from gpio.h are too heavy
 #define GPIO_FAST_SET_1(gpio_num) GPIO.out_w1ts |= (0x1 << gpio_num)
@@ -0,0 +1,207 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+// Compact binary encoding of the status snapshot for machine consumers
+// (GET /status with Accept: application/x-inverter-telemetry, and the
+// optional UDP stream). Header-only and free of Arduino dependencies so
+// collectors can use the same code as the firmware.
+//
+// Frame layout, all little-endian:
+//   u8  magic[2]   'I' 'T'
+//   u8  version    TELEMETRY_VERSION
+//   u8  flags      TELEMETRY_FLAG_*
+//   u32 seq        per-stream counter; a gap means lost frames
+//   u32 generation snapshot generation (same as the JSON "generation")
+//   u32 ts_ms      device millis() when the values were last updated
+//   u32 present    bit i set = field i follows
+//   ...            present fields in id order, each as a fixed-point
+//                  integer of the width/scale in TELEMETRY_FIELDS
+//
+// Compatibility: fields are only ever appended. A decoder ignores present
+// bits (and trailing bytes) beyond the fields it knows; the version is only
+// bumped for incompatible layout changes.
+
+#define TELEMETRY_MAGIC0        'I'
+#define TELEMETRY_MAGIC1        'T'
+#define TELEMETRY_VERSION       1
+#define TELEMETRY_HEADER_SIZE   20
+#define TELEMETRY_MAX_FRAME     96
+#define TELEMETRY_CONTENT_TYPE  "application/x-inverter-telemetry"
+
+#define TELEMETRY_FLAG_VALID    0x01   // last poll cycle succeeded
+
+enum TelemetryField : uint8_t {
+  TELEM_AC_OUT_VOLTAGE = 0,
+  TELEM_AC_OUT_FREQUENCY,
+  TELEM_AC_APPARENT_VA,
+  TELEM_AC_ACTIVE_W,
+  TELEM_LOAD_PERCENT,
+  TELEM_BATT_VOLTAGE,
+  TELEM_BATT_CHARGE_CURRENT,
+  TELEM_BATT_SOC,
+  TELEM_HEATSINK_TEMP,
+  TELEM_PV_INPUT_CURRENT,
+  TELEM_PV_INPUT_VOLTAGE,
+  TELEM_BATT_VOLTAGE_FROM_SCC,
+  TELEM_BATT_DISCHARGE_CURRENT,
+  TELEM_PV_CHARGING_POWER,
+  TELEM_MODE_CODE,              // ASCII letter from QMOD
+  TELEM_TEMP_H,
+  TELEM_TEMP_L,
+  TELEM_OUTPUT_LIMIT_W,
+  TELEM_OUTPUT_DUTY_CYCLE,
+  TELEM_GRID_VOLTAGE,
+  TELEM_GRID_FREQUENCY,
+  TELEM_BUS_VOLTAGE,
+  TELEM_DEVICE_STATUS_BITS,
+  TELEM_ADDITIONAL_STATUS_BITS,
+  TELEM_FIELD_COUNT
+};
+
+enum TelemetryType : uint8_t { TELEM_U8, TELEM_U16, TELEM_I16, TELEM_U32 };
+
+struct TelemetryFieldDesc {
+  const char* name;    // same key as the /status JSON
+  TelemetryType type;
+  float scale;         // raw = round(value * scale)
+};
+
+static const TelemetryFieldDesc TELEMETRY_FIELDS[TELEM_FIELD_COUNT] = {
+  { "ac_out_voltage",          TELEM_U16, 10.0f },
+  { "ac_out_frequency",        TELEM_U16, 100.0f },
+  { "ac_apparent_va",          TELEM_U16, 1.0f },
+  { "ac_active_w",             TELEM_U16, 1.0f },
+  { "load_percent",            TELEM_U8,  1.0f },
+  { "batt_voltage",            TELEM_U16, 100.0f },
+  { "batt_charge_current",     TELEM_U16, 10.0f },
+  { "batt_soc",                TELEM_U8,  1.0f },
+  { "heatsink_temp",           TELEM_I16, 10.0f },
+  { "pv_input_current",        TELEM_U16, 10.0f },
+  { "pv_input_voltage",        TELEM_U16, 10.0f },
+  { "batt_voltage_from_scc",   TELEM_U16, 100.0f },
+  { "batt_discharge_current",  TELEM_U16, 10.0f },
+  { "pv_charging_power",       TELEM_U16, 1.0f },
+  { "g_inverter_mode_code",    TELEM_U8,  1.0f },
+  { "temp_h",                  TELEM_I16, 10.0f },
+  { "temp_l",                  TELEM_I16, 10.0f },
+  { "output_limit_w",          TELEM_U16, 1.0f },
+  { "output_duty_cycle",       TELEM_U16, 10000.0f },
+  { "grid_voltage",            TELEM_U16, 10.0f },
+  { "grid_frequency",          TELEM_U16, 100.0f },
+  { "bus_voltage",             TELEM_U16, 1.0f },
+  { "device_status_bits",      TELEM_U8,  1.0f },
+  { "additional_status_bits",  TELEM_U8,  1.0f },
+};
+
+// Decoded (or to-be-encoded) frame; values are in engineering units
+struct TelemetrySample {
+  uint32_t seq;
+  uint32_t generation;
+  uint32_t ts_ms;
+  uint8_t flags;
+  uint32_t present;
+  float values[TELEM_FIELD_COUNT];
+};
+
+static inline void telemetry_clear(TelemetrySample* s) {
+  memset(s, 0, sizeof(*s));
+}
+
+// Set a field; NaN leaves it absent
+static inline void telemetry_set(TelemetrySample* s, TelemetryField f, float v) {
+  if (isnan(v)) return;
+  s->values[f] = v;
+  s->present |= 1u << f;
+}
+
+static inline bool telemetry_has(const TelemetrySample& s, TelemetryField f) {
+  return (s.present >> f) & 1u;
+}
+
+static inline size_t telemetry_type_size(TelemetryType t) {
+  switch (t) {
+  case TELEM_U8:  return 1;
+  case TELEM_U16:
+  case TELEM_I16: return 2;
+  default:        return 4;
+  }
+}
+
+static inline void telemetry_put_le(uint8_t* p, uint32_t v, size_t n) {
+  for (size_t i = 0; i < n; ++i) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static inline uint32_t telemetry_get_le(const uint8_t* p, size_t n) {
+  uint32_t v = 0;
+  for (size_t i = 0; i < n; ++i) v |= (uint32_t)p[i] << (8 * i);
+  return v;
+}
+
+// Encode into out; returns the frame length, or 0 if cap is too small.
+// Values outside a field's range are clamped.
+static inline size_t telemetry_encode(const TelemetrySample& s, uint8_t* out, size_t cap) {
+  if (cap < TELEMETRY_HEADER_SIZE) return 0;
+  out[0] = TELEMETRY_MAGIC0;
+  out[1] = TELEMETRY_MAGIC1;
+  out[2] = TELEMETRY_VERSION;
+  out[3] = s.flags;
+  telemetry_put_le(out + 4, s.seq, 4);
+  telemetry_put_le(out + 8, s.generation, 4);
+  telemetry_put_le(out + 12, s.ts_ms, 4);
+  uint32_t present = s.present & ((1u << TELEM_FIELD_COUNT) - 1);
+  telemetry_put_le(out + 16, present, 4);
+  size_t n = TELEMETRY_HEADER_SIZE;
+  for (uint8_t i = 0; i < TELEM_FIELD_COUNT; ++i) {
+    if (!((present >> i) & 1u)) continue;
+    const TelemetryFieldDesc& d = TELEMETRY_FIELDS[i];
+    size_t w = telemetry_type_size(d.type);
+    if (n + w > cap) return 0;
+    double raw = round((double)s.values[i] * d.scale);
+    double lo = 0.0, hi;
+    switch (d.type) {
+    case TELEM_U8:  hi = 255.0; break;
+    case TELEM_U16: hi = 65535.0; break;
+    case TELEM_I16: lo = -32768.0; hi = 32767.0; break;
+    default:        hi = 4294967295.0; break;
+    }
+    if (raw < lo) raw = lo;
+    if (raw > hi) raw = hi;
+    uint32_t v = (d.type == TELEM_I16) ? (uint32_t)(uint16_t)(int16_t)raw : (uint32_t)raw;
+    telemetry_put_le(out + n, v, w);
+    n += w;
+  }
+  return n;
+}
+
+// Decode a frame; false if it is truncated or not a compatible version
+static inline bool telemetry_decode(const uint8_t* in, size_t len, TelemetrySample* s) {
+  if (len < TELEMETRY_HEADER_SIZE) return false;
+  if (in[0] != TELEMETRY_MAGIC0 || in[1] != TELEMETRY_MAGIC1 || in[2] != TELEMETRY_VERSION) return false;
+  telemetry_clear(s);
+  s->flags = in[3];
+  s->seq = telemetry_get_le(in + 4, 4);
+  s->generation = telemetry_get_le(in + 8, 4);
+  s->ts_ms = telemetry_get_le(in + 12, 4);
+  uint32_t present = telemetry_get_le(in + 16, 4);
+  size_t n = TELEMETRY_HEADER_SIZE;
+  for (uint8_t i = 0; i < TELEM_FIELD_COUNT; ++i) {
+    if (!((present >> i) & 1u)) continue;
+    const TelemetryFieldDesc& d = TELEMETRY_FIELDS[i];
+    size_t w = telemetry_type_size(d.type);
+    if (n + w > len) return false;
+    uint32_t v = telemetry_get_le(in + n, w);
+    float raw = (d.type == TELEM_I16) ? (float)(int16_t)(uint16_t)v : (float)v;
+    s->values[i] = raw / d.scale;
+    s->present |= 1u << i;
+    n += w;
+  }
+  return true;
+}
+
+// Frames lost between two consecutive sequence numbers (wraps at 2^32)
+static inline uint32_t telemetry_seq_gap(uint32_t prev_seq, uint32_t seq) {
+  return seq - prev_seq - 1;
+}
@@ -0,0 +1,152 @@
+# -*- coding: utf-8 -*-
+"""
+Build step: compile data/ web UI files into a flash-resident asset table.
+
+Every file in data/ is gzipped (level 9, mtime 0 so output is reproducible)
+and fingerprinted with the first 16 hex digits of its SHA-256. Non-HTML
+assets get a second, fingerprinted path (app.js -> app.<hash>.js) that is
+served as immutable; HTML references to them are rewritten to that path, so
+only the HTML itself needs revalidation (ETag / 304).
+
+Output: src/web_assets_data.h (generated, git-ignored), consumed by
+src/web_assets.cpp. The table is sorted by FNV-1a hash of the path.
+
+Runs automatically as a PlatformIO pre-build script (see platformio.ini) and
+can also be run by hand:  python3 scripts/gen_web_assets.py
+"""
+
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+try:
+    Import("env")  # noqa: F821  (provided by PlatformIO/SCons)
+    PROJECT_DIR = env.subst("$PROJECT_DIR")  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+DATA_DIR = os.path.join(PROJECT_DIR, "data")
+OUT_FILE = os.path.join(PROJECT_DIR, "src", "web_assets_data.h")
+
+CONTENT_TYPES = {
+    ".html": "text/html; charset=utf-8",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".png": "image/png",
+    ".svg": "image/svg+xml",
+    ".json": "application/json",
+    ".ico": "image/x-icon",
+}
+
+# Already-compressed formats are stored as-is
+NO_GZIP = {".png", ".ico"}
+
+
+def fnv1a32(s):
+    h = 0x811C9DC5
+    for b in s.encode():
+        h = ((h ^ b) * 0x01000193) & 0xFFFFFFFF
+    return h
+
+
+def fingerprint(data):
+    return hashlib.sha256(data).hexdigest()[:16]
+
+
+def fingerprinted_name(name, fp):
+    base, ext = os.path.splitext(name)
+    return "%s.%s%s" % (base, fp, ext)
+
+
+def rewrite_refs(html, renames):
+    """Point src/href attributes at fingerprinted asset names."""
+    def sub(m):
+        attr, prefix, name = m.group(1), m.group(2) or "", m.group(3)
+        return '%s="%s%s"' % (attr, prefix, renames.get(name, name))
+    names = "|".join(re.escape(n) for n in sorted(renames, key=len, reverse=True))
+    if not names:
+        return html
+    return re.sub(r'(src|href)="(\./|/)?(%s)"' % names, sub, html)
+
+
+def collect():
+    files = {}
+    for name in sorted(os.listdir(DATA_DIR)):
+        path = os.path.join(DATA_DIR, name)
+        if os.path.isfile(path) and not name.startswith("."):
+            with open(path, "rb") as f:
+                files[name] = f.read()
+
+    renames = {}
+    for name, data in files.items():
+        if not name.endswith(".html"):
+            renames[name] = fingerprinted_name(name, fingerprint(data))
+
+    entries = []   # (url, raw bytes, immutable)
+    for name, data in files.items():
+        if name.endswith(".html"):
+            data = rewrite_refs(data.decode("utf-8"), renames).encode("utf-8")
+            entries.append(("/" + name, data, False))
+        else:
+            entries.append(("/" + name, data, False))
+            entries.append(("/" + renames[name], data, True))
+    return entries
+
+
+def c_bytes(data):
+    lines = []
+    for i in range(0, len(data), 20):
+        lines.append("  " + ",".join("0x%02x" % b for b in data[i:i + 20]) + ",")
+    return "\n".join(lines)
+
+
+def generate():
+    entries = collect()
+    blobs = {}     # fingerprint -> (symbol, stored bytes, gzipped)
+    rows = []
+    for url, raw, immutable in entries:
+        ext = os.path.splitext(url)[1]
+        fp = fingerprint(raw)
+        if fp not in blobs:
+            gz = ext not in NO_GZIP
+            stored = gzip.compress(raw, 9, mtime=0) if gz else raw
+            blobs[fp] = ("WEB_ASSET_%s" % fp, stored, gz)
+        sym, stored, gz = blobs[fp]
+        rows.append((fnv1a32(url), url, sym, len(stored), CONTENT_TYPES.get(ext, "application/octet-stream"),
+                     '"%s"' % fp, immutable, gz, len(raw)))
+    rows.sort(key=lambda r: r[0])
+    hashes = [r[0] for r in rows]
+    if len(set(hashes)) != len(hashes):
+        sys.exit("gen_web_assets: FNV-1a path hash collision, rename a file in data/")
+
+    out = ["// Generated by scripts/gen_web_assets.py from data/ -- do not edit.",
+           "#pragma once", "#include <stdint.h>", "#include <stddef.h>", ""]
+    for sym, stored, _ in blobs.values():
+        out.append("static const uint8_t %s[%d] = {" % (sym, len(stored)))
+        out.append(c_bytes(stored))
+        out.append("};")
+    out.append("")
+    out.append("// { path hash, path, data, length, content type, ETag, immutable, gzip }")
+    out.append("static const WebAsset WEB_ASSETS[] = {")
+    for h, url, sym, n, ctype, etag, imm, gz, raw_len in rows:
+        out.append('  { 0x%08xu, "%s", %s, %d, "%s", "\\%s\\"", %s, %s },  // %d B raw' % (
+            h, url, sym, n, ctype, etag[:-1], "true" if imm else "false", "true" if gz else "false", raw_len))
+    out.append("};")
+    out.append("")
+    text = "\n".join(out)
+
+    old = None
+    if os.path.exists(OUT_FILE):
+        with open(OUT_FILE, "r") as f:
+            old = f.read()
+    if old != text:
+        with open(OUT_FILE, "w") as f:
+            f.write(text)
+    total_raw = sum(r[8] for r in rows if not r[6])
+    total_gz = sum(r[3] for r in rows if not r[6])
+    print("gen_web_assets: %d entries, %d B -> %d B gzip" % (len(rows), total_raw, total_gz))
+
+
+generate()
@@ -1,36 +1,170 @@
 #include "display.h"
-#include <LiquidCrystal.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
+#include <esp_timer.h>
+#include <rom/ets_sys.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
 #define LCD_COLS  16
 #define LCD_LINES 2
 
-// Create LiquidCrystal instance using 4-bit wiring (RS, EN, D4, D5, D6, D7)
-static LiquidCrystal lcd(LCD_RS, LCD_EN, LCD_D4, LCD_D5, LCD_D6, LCD_D7);
+// HD44780 timing (R/W is tied low, so no busy flag: wait the worst case)
+#define LCD_EN_PULSE_US  1      // E high >= 450 ns, cycle >= 1 us
+#define LCD_EXEC_US      40     // most instructions 37 us @ 270 kHz
+#define LCD_CLEAR_US     2000   // clear / home 1.52 ms
 
-// --- Scrollable row system ---
+#define LCD_CMD_CLEAR        0x01
+#define LCD_CMD_ENTRY_INC    0x06
+#define LCD_CMD_DISPLAY_ON   0x0C
+#define LCD_CMD_FUNC_4BIT_2L 0x28
+#define LCD_CMD_DDRAM        0x80
+
+static_assert(LCD_RS < 32 && LCD_EN < 32 && LCD_D4 < 32 && LCD_D5 < 32 && LCD_D6 < 32 && LCD_D7 < 32,
+              "GPIO_FAST_SET_* only reach GPIO0..31");
+static const uint8_t LCD_DATA_PINS[4] = { LCD_D4, LCD_D5, LCD_D6, LCD_D7 };
+static const uint8_t LINE_ADDR[LCD_LINES] = { 0x00, 0x40 };
+
+// --- Shared state (loop/httpd writers, display task reader) ---
+static portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
 static char display_rows[DISPLAY_MAX_ROWS][LCD_COLS + 1]; // logical row data
 static uint8_t display_row_count = 0;
 static uint8_t display_scroll_pos = 0;
+static char overlay[LCD_LINES][LCD_COLS + 1];             // lcd_printf_line text
+static bool overlay_on[LCD_LINES] = { false, false };
+static bool rows_dirty = false;                           // rows changed since display_redraw()
+static TaskHandle_t g_task = nullptr;
+
+// --- Display task state ---
+static char shadow[LCD_LINES][LCD_COLS];   // what is on the glass
+static int16_t cursor_addr = -1;           // DDRAM address the next write lands on, -1 unknown
+static uint32_t bus_bytes = 0;
+
+static const uint32_t FRAME_BOUNDS_US[] = { 250, 500, 1000, 2000, 4000, 8000, 16000 };
+static DisplayStats g_stats = {};
+
+// ---- HD44780 bus ----
+static void lcd_nibble(uint8_t v) {
+  for (uint8_t b = 0; b < 4; ++b) {
+    if (v & (1 << b)) GPIO_FAST_SET_1(LCD_DATA_PINS[b]);
+    else GPIO_FAST_SET_0(LCD_DATA_PINS[b]);
+  }
+  // Data and RS are set up long before E rises (>= 40 ns); latched on the fall
+  GPIO_FAST_SET_1(LCD_EN);
+  ets_delay_us(LCD_EN_PULSE_US);
+  GPIO_FAST_SET_0(LCD_EN);
+  ets_delay_us(LCD_EN_PULSE_US);
+}
 
-// Buffer of what's currently shown on the LCD (for diff-based redraw)
-static char lcd_buffer[LCD_LINES][LCD_COLS + 1];
+static void lcd_byte(uint8_t v, bool data) {
+  if (data) GPIO_FAST_SET_1(LCD_RS);
+  else GPIO_FAST_SET_0(LCD_RS);
+  lcd_nibble(v >> 4);
+  lcd_nibble(v & 0x0F);
+  ets_delay_us(LCD_EXEC_US);
+  bus_bytes++;
+}
 
-// Write a single padded line to LCD hardware (no diff check).
-static void lcd_write_line(uint8_t line, const char* text) {
-  lcd.setCursor(0, line);
-  lcd.print(text);
+static void lcd_command(uint8_t cmd) { lcd_byte(cmd, false); }
+
+static void lcd_hw_init() {
+  const uint8_t pins[] = { LCD_RS, LCD_EN, LCD_D4, LCD_D5, LCD_D6, LCD_D7 };
+  for (uint8_t p : pins) {
+    pinMode(p, OUTPUT);
+    GPIO_FAST_SET_0(p);
+  }
+  // Power-on: > 40 ms after Vcc, then force 8-bit mode three times and
+  // switch to 4-bit (datasheet "initializing by instruction")
+  delay(50);
+  lcd_nibble(0x3); ets_delay_us(4500);
+  lcd_nibble(0x3); ets_delay_us(4500);
+  lcd_nibble(0x3); ets_delay_us(150);
+  lcd_nibble(0x2); ets_delay_us(LCD_EXEC_US);
+  lcd_command(LCD_CMD_FUNC_4BIT_2L);
+  lcd_command(LCD_CMD_DISPLAY_ON);
+  lcd_command(LCD_CMD_CLEAR);
+  ets_delay_us(LCD_CLEAR_US);
+  lcd_command(LCD_CMD_ENTRY_INC);
+  memset(shadow, ' ', sizeof(shadow));
+  cursor_addr = 0;
 }
 
-// Pad src into dst (LCD_COLS chars + null). dst must be at least LCD_COLS+1.
+// Pad src into dst (LCD_COLS chars, no terminator)
 static void pad_to_lcd(char* dst, const char* src) {
-  int len = strlen(src);
-  if (len > LCD_COLS) len = LCD_COLS;
+  size_t len = strnlen(src, LCD_COLS);
   memcpy(dst, src, len);
-  for (int i = len; i < LCD_COLS; i++) dst[i] = ' ';
-  dst[LCD_COLS] = '\0';
+  memset(dst + len, ' ', LCD_COLS - len);
+}
+
+// ---- Frame: write only the changed runs of one line ----
+static void flush_line(uint8_t line, const char* want) {
+  char* have = shadow[line];
+  uint8_t col = 0;
+  while (col < LCD_COLS) {
+    if (want[col] == have[col]) { col++; continue; }
+    // Run end: stop at two unchanged characters in a row (one is cheaper to rewrite)
+    uint8_t end = col + 1;
+    while (end < LCD_COLS) {
+      if (want[end] != have[end]) { end++; continue; }
+      if (end + 1 < LCD_COLS && want[end + 1] != have[end + 1]) { end += 2; continue; }
+      break;
+    }
+    uint8_t addr = LINE_ADDR[line] + col;
+    if (cursor_addr != addr) lcd_command(LCD_CMD_DDRAM | addr);
+    for (uint8_t c = col; c < end; ++c) {
+      lcd_byte((uint8_t)want[c], true);
+      have[c] = want[c];
+    }
+    cursor_addr = addr + (end - col);
+    col = end;
+  }
+}
+
+static void compose(char out[LCD_LINES][LCD_COLS]) {
+  portENTER_CRITICAL(&g_mux);
+  for (uint8_t i = 0; i < LCD_LINES; i++) {
+    if (overlay_on[i]) {
+      pad_to_lcd(out[i], overlay[i]);
+    } else if (display_row_count) {
+      pad_to_lcd(out[i], display_rows[(display_scroll_pos + i) % display_row_count]);
+    } else {
+      memset(out[i], ' ', LCD_COLS);
+    }
+  }
+  portEXIT_CRITICAL(&g_mux);
+}
+
+static void display_task(void* arg) {
+  (void)arg;
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    char frame[LCD_LINES][LCD_COLS];
+    compose(frame);
+
+    uint32_t bytes0 = bus_bytes;
+    uint32_t full = 0;
+    int64_t t0 = esp_timer_get_time();
+    for (uint8_t i = 0; i < LCD_LINES; i++) {
+      if (memcmp(frame[i], shadow[i], LCD_COLS) == 0) continue;
+      full += 1 + LCD_COLS;   // cursor + whole line, the old redraw
+      flush_line(i, frame[i]);
+    }
+    uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+    if (bus_bytes == bytes0) continue;
+
+    portENTER_CRITICAL(&g_mux);
+    g_stats.frames++;
+    g_stats.bytes += bus_bytes - bytes0;
+    g_stats.full_line_bytes += full;
+    if (us > g_stats.max_frame_us) g_stats.max_frame_us = us;
+    histogram_observe(&g_stats.frame_us, us);
+    portEXIT_CRITICAL(&g_mux);
+  }
+}
+
+static void wake() {
+  if (g_task) xTaskNotifyGive(g_task);
 }
 
 // --- Public API ---
@@ -38,71 +172,81 @@ static void pad_to_lcd(char* dst, const char* src) {
 void display_init() {
   pinMode(LCD_BACKLIGHT_PIN, OUTPUT);
   GPIO_FAST_OUTPUT_ENABLE(LCD_BACKLIGHT_PIN);
-  lcd.begin(LCD_COLS, LCD_LINES);
-  lcd.clear();
   memset(display_rows, 0, sizeof(display_rows));
-  memset(lcd_buffer, 0, sizeof(lcd_buffer));
+  histogram_init(&g_stats.frame_us, FRAME_BOUNDS_US, sizeof(FRAME_BOUNDS_US) / sizeof(FRAME_BOUNDS_US[0]), 1000000);
+  lcd_hw_init();
+  // Low priority on core 0: a frame is a few hundred us of waits, preemption
+  // anywhere in it is harmless (E has no maximum high time)
+  xTaskCreatePinnedToCore(display_task, "display", 2048, NULL, 1, &g_task, 0);
 }
 
 void display_set_row_count(uint8_t count) {
   if (count > DISPLAY_MAX_ROWS) count = DISPLAY_MAX_ROWS;
+  portENTER_CRITICAL(&g_mux);
+  if (count != display_row_count) rows_dirty = true;
   display_row_count = count;
   if (display_scroll_pos >= count) display_scroll_pos = 0;
+  portEXIT_CRITICAL(&g_mux);
 }
 
 void display_set_row(uint8_t index, const char* text) {
   if (index >= DISPLAY_MAX_ROWS) return;
-  strncpy(display_rows[index], text, LCD_COLS);
-  display_rows[index][LCD_COLS] = '\0';
+  portENTER_CRITICAL(&g_mux);
+  if (strncmp(display_rows[index], text, LCD_COLS) != 0) {
+    strncpy(display_rows[index], text, LCD_COLS);
+    display_rows[index][LCD_COLS] = '\0';
+    rows_dirty = true;
+  }
+  portEXIT_CRITICAL(&g_mux);
 }
 
 void display_redraw() {
-  if (display_row_count == 0) return;
-
-  for (uint8_t i = 0; i < LCD_LINES; i++) {
-    uint8_t row_idx = (display_scroll_pos + i) % display_row_count;
-    char padded[LCD_COLS + 1];
-    pad_to_lcd(padded, display_rows[row_idx]);
-
-    if (strcmp(padded, lcd_buffer[i]) != 0) {
-      memcpy(lcd_buffer[i], padded, LCD_COLS + 1);
-      lcd_write_line(i, padded);
-    }
+  portENTER_CRITICAL(&g_mux);
+  bool changed = rows_dirty;
+  if (changed) {
+    rows_dirty = false;
+    overlay_on[0] = overlay_on[1] = false;
   }
+  portEXIT_CRITICAL(&g_mux);
+  if (changed) wake();
 }
 
-void display_scroll_up() {
-  if (display_row_count == 0) return;
-  display_scroll_pos = (display_scroll_pos + display_row_count - 1) % display_row_count;
-  display_redraw();
+static void scroll(int8_t step) {
+  portENTER_CRITICAL(&g_mux);
+  if (display_row_count) {
+    display_scroll_pos = (display_scroll_pos + display_row_count + step) % display_row_count;
+    overlay_on[0] = overlay_on[1] = false;
+  }
+  portEXIT_CRITICAL(&g_mux);
+  wake();
 }
 
-void display_scroll_down() {
-  if (display_row_count == 0) return;
-  display_scroll_pos = (display_scroll_pos + 1) % display_row_count;
-  display_redraw();
-}
+void display_scroll_up() { scroll(-1); }
+void display_scroll_down() { scroll(1); }
 
 // Printf-style line write (bypasses row system, e.g. for WiFi connect screen).
-// Also invalidates lcd_buffer for that line so next display_redraw() will refresh it.
+// Stays up until the next scroll or row change redraws the rows.
 void lcd_printf_line(uint8_t line, const char* fmt, ...) {
   char buf[LCD_COLS + 1];
   va_list ap;
   va_start(ap, fmt);
   int n = vsnprintf(buf, sizeof(buf), fmt, ap);
   va_end(ap);
-
   if (n < 0) return;
-  if (n > LCD_COLS) n = LCD_COLS;
-  for (int i = n; i < LCD_COLS; ++i) buf[i] = ' ';
-  buf[LCD_COLS] = '\0';
 
   if (line > 1) line = 1;
-  lcd.setCursor(0, line);
-  lcd.print(buf);
+  portENTER_CRITICAL(&g_mux);
+  memcpy(overlay[line], buf, sizeof(buf));
+  overlay_on[line] = true;
+  portEXIT_CRITICAL(&g_mux);
+  wake();
+}
 
-  // Invalidate buffer so display_redraw() will overwrite this transient message
-  lcd_buffer[line][0] = '\0';
+void display_get_stats(DisplayStats* out) {
+  if (!out) return;
+  portENTER_CRITICAL(&g_mux);
+  *out = g_stats;
+  portEXIT_CRITICAL(&g_mux);
 }
 
 // --- Backlight control ---
@@ -1,10 +1,23 @@
 #pragma once
 #include <Arduino.h>
 #include "config.h"
-
-#define DISPLAY_MAX_ROWS 8
-
-// Initialize the LCD. Call from setup().
+#include "histogram.h"
+
+#define DISPLAY_MAX_ROWS 12   // 4 status rows + extra thermistor rows + system total + INVERTER_MAX_UNITS units
+
+// 16x2 HD44780 (QC1602A) in 4-bit mode, R/W tied low, see README_QC1602A.md.
+//
+// A display task owns the bus and a shadow of what is on the glass. The
+// functions below only update the row buffers (under a spinlock) and wake
+// the task; it composes the two visible lines, compares them with the
+// shadow character by character and writes only the runs that changed
+// (one cursor command per run; runs one unchanged character apart are
+// merged, as rewriting it is as cheap as moving the cursor). Pins are driven
+// with GPIO_FAST_SET_* and every transfer waits the controller's execution
+// time, so nothing here blocks loop().
+
+// Initialize the LCD (blocks ~60 ms for the power-on sequence) and start the
+// display task. Call from setup().
 void display_init();
 
 // --- Scrollable row-based display ---
@@ -15,7 +28,7 @@ void display_set_row_count(uint8_t count);
 // Update one row's text (index < row_count). Does NOT redraw.
 void display_set_row(uint8_t index, const char* text);
 
-// Redraw visible rows to LCD (only writes lines that actually changed).
+// Wake the display task if any row changed since the last frame.
 void display_redraw();
 
 // Scroll up/down cyclically and redraw.
@@ -23,9 +36,20 @@ void display_scroll_up();
 void display_scroll_down();
 
 // Print formatted text to LCD line (0 or 1), auto-cleared with spaces to 16 chars.
-// Bypasses the row system — use for transient messages (e.g. WiFi connect).
+// Bypasses the row system — use for transient messages (e.g. WiFi connect);
+// shown until the next scroll or row change redraws that line.
 void lcd_printf_line(uint8_t line, const char* fmt, ...);
 
+// Bus statistics: frames are wakeups that wrote something
+struct DisplayStats {
+  uint32_t frames;
+  uint32_t bytes;              // commands + characters sent
+  uint32_t full_line_bytes;    // what rewriting every changed line would have sent
+  uint32_t max_frame_us;
+  Histogram frame_us;          // bus time per frame
+};
+void display_get_stats(DisplayStats* out);
+
 // Check if LCD backlight is currently on.
 inline boolean isBacklightOn();
 
@@ -0,0 +1,83 @@
+#include "diversion.h"
+#include <math.h>
+
+void DiversionController::reset() {
+  *this = DiversionController();
+}
+
+float DiversionController::thermal_derate(float temp_h, float temp_l) {
+  float t = NAN;
+  if (!isnan(temp_h)) t = temp_h;
+  if (!isnan(temp_l) && (isnan(t) || temp_l > t)) t = temp_l;
+  if (isnan(t) || t <= DIVERSION_DERATE_START_C) return 1.0f;
+  if (t >= DIVERSION_DERATE_STOP_C) return 0.0f;
+  return (DIVERSION_DERATE_STOP_C - t) / (DIVERSION_DERATE_STOP_C - DIVERSION_DERATE_START_C);
+}
+
+float DiversionController::update(const InverterState& s, float temp_h, float temp_l, int limit_w) {
+  uint32_t dt_ms = have_prev_ ? s.ts_ms - prev_ms_ : 0;
+  if (dt_ms > DIVERSION_MAX_GAP_MS) {
+    // Stale state: start over instead of slewing from an old command
+    power_w_ = 0.0f;
+    integral_w_ = 0.0f;
+    dt_ms = 0;
+  }
+  have_prev_ = true;
+  prev_ms_ = s.ts_ms;
+  float dt = dt_ms / 1000.0f;
+
+  float batt_w = s.batt_voltage * (s.batt_charge_current - s.batt_discharge_current);
+  float target_w = s.batt_soc >= DIVERSION_SOC_FULL ? 0.0f : (float)DIVERSION_RESERVE_W;
+  float house_w = (float)s.ac_active_w - power_w_;
+  surplus_w_ = (float)s.pv_charging_power - house_w - target_w;
+  error_w_ = batt_w - target_w;
+
+  derate_ = thermal_derate(temp_h, temp_l);
+  float rated = (float)DIVERSION_LOAD_W;
+  float cap = (limit_w < 0 ? 0.0f : (float)limit_w);
+  if (cap > rated) cap = rated;
+  cap *= derate_;
+
+  if (s.batt_soc < DIVERSION_SOC_START || s.pv_charging_power <= 0) {
+    reason_ = s.batt_soc < DIVERSION_SOC_START ? DIVERSION_BATTERY_FIRST : DIVERSION_NO_PV;
+    power_w_ = 0.0f;
+    integral_w_ = 0.0f;
+    return duty();
+  }
+
+  float ff = surplus_w_ > 0.0f ? surplus_w_ : 0.0f;
+  integral_w_ += DIVERSION_KI * error_w_ * dt;
+  float u = ff + DIVERSION_KP * error_w_ + integral_w_;
+
+  // Clamp, then slew limit against the previous command
+  float applied = u;
+  reason_ = DIVERSION_ACTIVE;
+  if (applied > cap) {
+    applied = cap;
+    reason_ = derate_ < 1.0f ? DIVERSION_DERATED : DIVERSION_LIMITED;
+  }
+  if (applied < 0.0f) applied = 0.0f;
+  float up = DIVERSION_RAMP_UP_W_S * dt;
+  float down = DIVERSION_RAMP_DOWN_W_S * dt;
+  if (applied > power_w_ + up) applied = power_w_ + up;
+  if (applied < power_w_ - down) applied = power_w_ - down;
+  if (applied < 0.0f) applied = 0.0f;
+
+  // Anti-windup: the integral is whatever makes u equal the applied value
+  if (applied != u) integral_w_ = applied - ff - DIVERSION_KP * error_w_;
+  if (integral_w_ > rated) integral_w_ = rated;
+  if (integral_w_ < -rated) integral_w_ = -rated;
+  power_w_ = applied;
+  return duty();
+}
+
+const char* DiversionController::reason_name(DiversionReason r) {
+  switch (r) {
+  case DIVERSION_BATTERY_FIRST: return "battery_first";
+  case DIVERSION_NO_PV:         return "no_pv";
+  case DIVERSION_ACTIVE:        return "active";
+  case DIVERSION_LIMITED:       return "limited";
+  case DIVERSION_DERATED:       return "derated";
+  default:                      return "off";
+  }
+}
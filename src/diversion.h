@@ -0,0 +1,78 @@
+#pragma once
+#include <stdint.h>
+#include "inverter_state.h"
+
+// PV-surplus diversion: drives the dump load on PWM_PIN so that PV power the
+// battery does not need goes into the load instead of being curtailed by the
+// MPPT. Plain C++ without Arduino dependencies so it can be built on a host
+// (doc/diversionSim.cpp replays traces through it).
+//
+// One update per QPIGS sample. The dump load hangs on the AC output, so it
+// is part of ac_active_w:
+//   house    = ac_active_w - dump power commanded for the previous sample
+//   target   = battery charge power to keep: DIVERSION_RESERVE_W below
+//              DIVERSION_SOC_FULL, 0 (never discharge) at or above it
+//   surplus  = pv_charging_power - house - target      (feed-forward)
+//   error    = battery power - target                  (PI feedback)
+//   dump     = surplus + Kp * error + I
+// The feed-forward does most of the work on load and cloud steps. The PI
+// term finds the PV the MPPT is curtailing once the battery is full: there
+// pv_charging_power only covers what is drawn, and the battery current shows
+// whether the PV can carry more (still charging) or not (discharging).
+//
+// The command is clamped to [0, min(limit_w, DIVERSION_LOAD_W) x derate] and
+// slew limited (slow up, fast down). Anti-windup by integrator tracking:
+// after clamping, I is reset to what produces the applied value, so leaving
+// a limit never waits for an integral to unwind. Thermal derating scales
+// the cap linearly from 1 at DIVERSION_DERATE_START_C to 0 at
+// DIVERSION_DERATE_STOP_C on the hotter thermistor (NaN = not fitted).
+
+#define DIVERSION_LOAD_W          2000    // dump load power at 100 % duty
+#define DIVERSION_SOC_START       90      // % below: battery first, no diversion
+#define DIVERSION_SOC_FULL        98      // % at/above: no charge reserve
+#define DIVERSION_RESERVE_W       300     // charge power kept for the battery below SOC_FULL
+#define DIVERSION_KP              0.1f    // W dump per W battery power error
+#define DIVERSION_KI              0.2f    // 1/s
+#define DIVERSION_RAMP_UP_W_S     250.0f  // slew limit while increasing
+#define DIVERSION_RAMP_DOWN_W_S   2000.0f // shedding may be fast
+#define DIVERSION_DERATE_START_C  60.0f
+#define DIVERSION_DERATE_STOP_C   80.0f
+#define DIVERSION_MAX_GAP_MS      10000   // longer between samples: restart from 0
+
+enum DiversionReason : uint8_t {
+  DIVERSION_OFF = 0,        // not updated yet / disabled
+  DIVERSION_BATTERY_FIRST,  // SOC below DIVERSION_SOC_START
+  DIVERSION_NO_PV,          // no PV charging power
+  DIVERSION_ACTIVE,         // regulating
+  DIVERSION_LIMITED,        // at the cap (outputLimitW or load rating)
+  DIVERSION_DERATED,        // cap reduced by temperature
+};
+
+class DiversionController {
+public:
+  void reset();
+
+  // Feed one sample (s.ts_ms is its time); returns the duty 0..1
+  float update(const InverterState& s, float temp_h, float temp_l, int limit_w);
+
+  float duty() const { return power_w_ / (float)DIVERSION_LOAD_W; }
+  float power_w() const { return power_w_; }
+  float surplus_w() const { return surplus_w_; }
+  float error_w() const { return error_w_; }
+  float derate() const { return derate_; }
+  DiversionReason reason() const { return reason_; }
+  static const char* reason_name(DiversionReason r);
+
+  // Cap factor 0..1 for the hotter of two temperatures (NaN ignored)
+  static float thermal_derate(float temp_h, float temp_l);
+
+private:
+  bool have_prev_ = false;
+  uint32_t prev_ms_ = 0;
+  float integral_w_ = 0.0f;
+  float power_w_ = 0.0f;
+  float surplus_w_ = 0.0f;
+  float error_w_ = 0.0f;
+  float derate_ = 1.0f;
+  DiversionReason reason_ = DIVERSION_OFF;
+};
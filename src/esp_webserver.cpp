@@ -1,12 +1,25 @@
-#include <WebServer.h>
 #include "esp_webserver.h"
+#include <esp_http_server.h>
+#include <lwip/sockets.h>
 #include <LittleFS.h>
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include <atomic>
 #include "inverter_comm.h"
+#include "history.h"
+#include "logger.h"
+#include "status_events.h"
+#include "web_assets.h"
+#include "telemetry.h"
+#include "metrics.h"
+#include "thermistor.h"
 
-// `server` is defined in main.cpp; declare it here for use in this TU.
-extern WebServer server;
+// esp_http_server runs its own task: handlers never block loop(), and they
+// only touch thread-safe state (seqlock snapshot, mutex-guarded history and
+// log file, atomics for the control values). Handlers run one at a time on
+// that task, so they share the scratch buffer below.
+static httpd_handle_t g_httpd = NULL;
+static char g_scratch[1024];
 
 void initWebServer() {
   if (!LittleFS.begin()) {
@@ -14,39 +27,105 @@ void initWebServer() {
   }
 }
 
-void handleRoot() {
-  server.sendHeader("Cache-Control", "no-cache, no-store, must-revalidate");
-  server.sendHeader("Pragma", "no-cache");
-  server.sendHeader("Expires", "-1");
-  File f = LittleFS.open("/index.html", "r");
-  if (!f) {
-    server.send(500, "text/plain", "index.html not found");
-    return;
+// ---- Small request/response helpers ----
+
+// Copy query parameter `key` into out; false if missing
+static bool queryArg(httpd_req_t* req, const char* key, char* out, size_t cap) {
+  if (cap) out[0] = '\0';
+  size_t qlen = httpd_req_get_url_query_len(req);
+  if (qlen == 0 || qlen >= 256) return false;
+  char query[256];
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK) return false;
+  return httpd_query_key_value(query, key, out, cap) == ESP_OK;
+}
+
+// Inverter device from ?dev=N (0 when absent); false if out of range
+static bool deviceArg(httpd_req_t* req, uint8_t* dev) {
+  char arg[8];
+  *dev = 0;
+  if (!queryArg(req, "dev", arg, sizeof(arg))) return true;
+  char* end;
+  long v = strtol(arg, &end, 10);
+  if (end == arg || *end || v < 0 || v >= inverter_device_count()) return false;
+  *dev = (uint8_t)v;
+  return true;
+}
+
+static void setNoCache(httpd_req_t* req) {
+  httpd_resp_set_hdr(req, "Cache-Control", "no-cache, no-store, must-revalidate");
+  httpd_resp_set_hdr(req, "Pragma", "no-cache");
+  httpd_resp_set_hdr(req, "Expires", "-1");
+}
+
+static esp_err_t sendJson(httpd_req_t* req, const char* status, const String& body) {
+  httpd_resp_set_status(req, status);
+  httpd_resp_set_type(req, "application/json");
+  return httpd_resp_send(req, body.c_str(), body.length());
+}
+
+static const char* contentTypeFor(const char* path) {
+  const char* ext = strrchr(path, '.');
+  if (!ext) return "text/plain";
+  if (strcmp(ext, ".html") == 0) return "text/html; charset=utf-8";
+  if (strcmp(ext, ".css") == 0) return "text/css";
+  if (strcmp(ext, ".js") == 0) return "application/javascript";
+  if (strcmp(ext, ".png") == 0) return "image/png";
+  if (strcmp(ext, ".svg") == 0) return "image/svg+xml";
+  return "text/plain";
+}
+
+static esp_err_t streamFile(httpd_req_t* req, const char* path) {
+  File f = LittleFS.open(path, "r");
+  if (!f) return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Not found");
+  httpd_resp_set_type(req, contentTypeFor(path));
+  size_t n;
+  while ((n = f.read((uint8_t*)g_scratch, sizeof(g_scratch))) > 0) {
+    if (httpd_resp_send_chunk(req, g_scratch, n) != ESP_OK) {
+      f.close();
+      return ESP_FAIL; // client went away; httpd closes the socket
+    }
   }
-  server.streamFile(f, "text/html; charset=utf-8");
   f.close();
+  return httpd_resp_send_chunk(req, NULL, 0);
 }
 
-void handleNotFound() {
-  String uri = server.uri();
-  String path = uri;
-  if (!path.startsWith("/")) path = "/" + path;
-
-  if (LittleFS.exists(path)) {
-    File f = LittleFS.open(path, "r");
-    String contentType = "text/plain";
-    if (path.endsWith(".html")) contentType = "text/html; charset=utf-8";
-    else if (path.endsWith(".css")) contentType = "text/css";
-    else if (path.endsWith(".js")) contentType = "application/javascript";
-    else if (path.endsWith(".png")) contentType = "image/png";
-    else if (path.endsWith(".svg")) contentType = "image/svg+xml";
+// True if the request's Accept-Encoding lists gzip
+static bool acceptsGzip(httpd_req_t* req) {
+  char ae[64];
+  if (httpd_req_get_hdr_value_str(req, "Accept-Encoding", ae, sizeof(ae)) != ESP_OK) return false;
+  return strstr(ae, "gzip") != nullptr;
+}
 
-    server.streamFile(f, contentType);
-    f.close();
-    return;
+// Built-in asset: pre-gzipped from flash, no filesystem access or copy
+static esp_err_t sendAsset(httpd_req_t* req, const WebAsset* a) {
+  httpd_resp_set_hdr(req, "ETag", a->etag);
+  httpd_resp_set_hdr(req, "Cache-Control", a->immutable ? "public, max-age=31536000, immutable" : "no-cache");
+  char inm[40];
+  if (httpd_req_get_hdr_value_str(req, "If-None-Match", inm, sizeof(inm)) == ESP_OK && strcmp(inm, a->etag) == 0) {
+    httpd_resp_set_status(req, "304 Not Modified");
+    return httpd_resp_send(req, NULL, 0);
   }
+  httpd_resp_set_type(req, a->content_type);
+  if (a->gzip) httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+  httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+  return httpd_resp_send(req, (const char*)a->data, a->length);
+}
 
-  server.send(404, "text/plain", "Not found");
+// GET / and any other path: the built-in asset table, else files from LittleFS
+// (index.html is never cached)
+static esp_err_t handleFile(httpd_req_t* req) {
+  char path[96];
+  size_t len = strcspn(req->uri, "?");
+  if (len == 0 || len >= sizeof(path) - 16) return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Not found");
+  memcpy(path, req->uri, len);
+  path[len] = '\0';
+  if (strstr(path, "..")) return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Bad path");
+  if (strcmp(path, "/") == 0) strcpy(path, "/index.html");
+  const WebAsset* a = web_asset_find(path, strlen(path));
+  if (a && (!a->gzip || acceptsGzip(req))) return sendAsset(req, a);
+  if (strcmp(path, "/index.html") == 0) setNoCache(req);
+  if (!LittleFS.exists(path)) return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Not found");
+  return streamFile(req, path);
 }
 
 // ---- Internal state for reset info (provided by main.cpp during setup) ----
@@ -59,19 +138,20 @@ void webserver_set_reset_info(int reason, const char* reason_str) {
 }
 
 // ---- Externals from main.cpp (control state reflected in JSON/commands) ----
-extern int outputLimitW;
-extern float outputDutyCycle;
+extern std::atomic<int> outputLimitW;
+extern std::atomic<float> outputDutyCycle;
+extern std::atomic<bool> diversionAuto;
+extern portMUX_TYPE diversionMux;
+extern DiversionController diversionState;
 
 // --------- JSON helpers (moved from main.cpp) ----------
-static String makeStatusJson() {
+// Serialize one snapshot + control state into out; returns length (0 if it did not fit).
+// units is the parallel view, only read when the snapshot reports units.
+static size_t buildStatusJson(const InverterSnapshot& snap, const ParallelView& units, int limitW, float duty,
+                              char* out, size_t cap) {
   JsonDocument doc;
   doc["type"] = "status";
-  InverterState s = {};
-  inverter_get_status(&s);
-  // Also obtain current mode (thread-safe accessor)
-  char mode_code = '\0';
-  char mode_name[32] = "";
-  inverter_get_mode(&mode_code, mode_name, sizeof(mode_name));
+  const InverterState& s = snap.status;
   // Insert attributes in the order requested by the UI
   doc["ac_out_voltage"] = s.ac_out_voltage;
   doc["ac_out_frequency"] = s.ac_out_frequency;
@@ -87,26 +167,114 @@ static String makeStatusJson() {
   doc["batt_voltage_from_scc"] = s.batt_voltage_from_scc;
   doc["batt_discharge_current"] = s.batt_discharge_current;
   doc["pv_charging_power"] = s.pv_charging_power;
-  doc["g_inverter_mode_code"] = String(mode_code);
-  doc["g_inverter_mode_name"] = mode_name;
+  doc["g_inverter_mode_code"] = String(snap.mode_code);
+  doc["g_inverter_mode_name"] = snap.mode_name;
   // Map InverterState to UI schema
-  doc["valid"] = g_inverter_data_valid;
+  doc["valid"] = snap.valid;
   doc["ts_ms"] = s.ts_ms;
-  doc["temp_h"] = isnan(g_temp_h) ? JsonVariant() : g_temp_h;
-  doc["temp_l"] = isnan(g_temp_l) ? JsonVariant() : g_temp_l;
+  doc["generation"] = snap.generation;
+  doc["temp_h"] = isnan(snap.temp_h) ? JsonVariant() : snap.temp_h;
+  doc["temp_l"] = isnan(snap.temp_l) ? JsonVariant() : snap.temp_l;
+  // Every thermistor channel by name (config.h THERMISTOR_CHANNELS)
+  JsonObject temps = doc["temps"].to<JsonObject>();
+  for (uint8_t i = 0; i < THERMISTOR_COUNT; ++i) {
+    float t = thermistor_temp_c(i);
+    temps[thermistor_info(i).name] = isnan(t) ? JsonVariant() : t;
+  }
+
+  // Parallel system: totals always (zero on a single unit), per-unit detail when present
+  const ParallelTotals& pt = snap.parallel;
+  doc["sys_units"] = pt.present;
+  doc["sys_apparent_va"] = pt.ac_apparent_va;
+  doc["sys_active_w"] = pt.ac_active_w;
+  doc["sys_charge_current"] = pt.batt_charge_current;
+  doc["sys_discharge_current"] = pt.batt_discharge_current;
+  if (pt.units) {
+    JsonArray arr = doc["units"].to<JsonArray>();
+    for (uint8_t i = 0; i < pt.units; ++i) {
+      const InverterUnitState& u = units.units[i];
+      JsonObject o = arr.add<JsonObject>();
+      o["present"] = u.present;
+      if (!u.present) continue;
+      o["serial"] = u.serial;
+      o["mode"] = String(u.work_mode);
+      o["fault"] = u.fault_code;
+      o["ac_out_voltage"] = u.ac_out_voltage;
+      o["ac_apparent_va"] = u.ac_apparent_va;
+      o["ac_active_w"] = u.ac_active_w;
+      o["load_percent"] = u.load_percent;
+      o["batt_voltage"] = u.batt_voltage;
+      o["batt_charge_current"] = u.batt_charge_current;
+      o["batt_discharge_current"] = u.batt_discharge_current;
+      o["batt_soc"] = u.batt_soc;
+      o["pv_input_voltage"] = u.pv_input_voltage;
+      o["pv_input_current"] = u.pv_input_current;
+      o["status_bits"] = u.status_bits;
+      o["output_mode"] = u.output_mode;
+      o["ts_ms"] = u.ts_ms;
+    }
+  }
 
   // Include some “control state” so UI can reflect it
 
-  doc["output_limit_w"] = outputLimitW;
-  doc["output_duty_cycle"] = outputDutyCycle;
+  doc["output_limit_w"] = limitW;
+  doc["output_duty_cycle"] = duty;
 
   // System diagnostics
   doc["reset_reason"] = (int)g_reset_reason_ws;
   doc["reset_reason_str"] = g_reset_reason_str_ws;
 
-  String out;
-  serializeJson(doc, out);
-  return out;
+  if (measureJson(doc) >= cap) return 0;
+  return serializeJson(doc, out, cap);
+}
+
+// /status body (JSON and binary), serialized once per (generation, control
+// state) and then served as-is to every request until either changes. Only
+// the httpd task touches it, so no locking. One per inverter device.
+struct StatusCache {
+  char body[2560];   // ~700 B single unit, ~400 B more per parallel unit
+  size_t len;
+  uint8_t bin[TELEMETRY_MAX_FRAME];
+  size_t bin_len;
+  uint32_t generation;
+  int limit_w;
+  float duty;
+  char etag[32];
+  char bin_etag[32];
+  uint32_t rebuilds;
+  uint32_t not_modified;
+  uint32_t bin_requests;
+};
+static StatusCache g_status_cache[INVERTER_MAX_DEVICES] = {};
+
+static StatusCache& currentStatus(uint8_t dev) {
+  StatusCache& c = g_status_cache[dev];
+  // One consistent, lock-free copy of status + mode + temperatures
+  InverterSnapshot snap;
+  inverter_get_snapshot(&snap, dev);
+  int limitW = outputLimitW.load();
+  float duty = outputDutyCycle.load();
+  if (c.len && c.generation == snap.generation && c.limit_w == limitW && c.duty == duty) return c;
+
+  // Unit detail is published before the totals that bump the generation
+  static ParallelView units;
+  if (snap.parallel.units) inverter_get_parallel(&units, dev);
+  c.len = buildStatusJson(snap, units, limitW, duty, c.body, sizeof(c.body));
+  // HTTP frames are not a stream; seq carries the generation
+  TelemetrySample ts;
+  telemetry_fill(snap, limitW, duty, snap.generation, &ts);
+  c.bin_len = telemetry_encode(ts, c.bin, sizeof(c.bin));
+  c.generation = snap.generation;
+  c.limit_w = limitW;
+  c.duty = duty;
+  c.rebuilds++;
+  // Control values are not part of the generation; fold them into the tag
+  uint32_t duty_bits;
+  memcpy(&duty_bits, &duty, sizeof(duty_bits));
+  unsigned ctl = (unsigned)((uint32_t)limitW * 2654435761u ^ duty_bits);
+  snprintf(c.etag, sizeof(c.etag), "\"%u-%x\"", (unsigned)snap.generation, ctl);
+  snprintf(c.bin_etag, sizeof(c.bin_etag), "\"%u-%x-b\"", (unsigned)snap.generation, ctl);
+  return c;
 }
 
 static String makeAckJson(const char* msg) {
@@ -130,12 +298,48 @@ static String makeErrJson(const char* code, const char* msg) {
   return out;
 }
 
+static String makeWriteJson(const WriteJob& j, uint8_t dev) {
+  JsonDocument doc;
+  doc["type"] = "write";
+  doc["ok"] = j.state != WRITE_NAK && j.state != WRITE_FAILED;
+  doc["id"] = j.id;
+  doc["dev"] = dev;
+  doc["cmd"] = j.cmd;
+  doc["state"] = inverter_write_state_name(j.state);
+  doc["attempts"] = j.attempts;
+  if (inverter_write_final(j.state)) doc["latency_ms"] = j.done_ms - j.submit_ms;
+  String out;
+  serializeJson(doc, out);
+  return out;
+}
+
+// { "type":"cmd", "name":"inverter_write", "value":"POP02", "dev":0 }
+// Queues the setter ahead of all polling and answers right away (202, state
+// "queued", with the ticket id). The answer takes up to seconds on a bad
+// link (see inverter_write.h), far too long to hold the only httpd task:
+// clients poll GET /cmd?id=<id>&dev=<dev> for the final state.
+static String handleInverterWrite(JsonDocument& doc, const char** status) {
+  const char* cmd = doc["value"].as<const char*>();
+  if (!cmd) return makeErrJson("bad_request", "Missing 'value'");
+  if (!inverter_write_valid(cmd)) return makeErrJson("bad_request", "Not an allowed setter command");
+  int dev = doc["dev"].as<int>();
+  if (dev < 0 || dev >= inverter_device_count()) return makeErrJson("bad_request", "Unknown 'dev'");
+
+  uint32_t id = inverter_write_submit(cmd, (uint8_t)dev);
+  if (!id) return makeErrJson("busy", "Write queue full");
+  WriteJob j;
+  if (!inverter_write_status(id, &j, (uint8_t)dev)) return makeErrJson("busy", "Write expired");
+  *status = "202 Accepted";
+  return makeWriteJson(j, (uint8_t)dev);
+}
+
 // --------- Command handling ----------
-static String handleCommand(JsonDocument& doc) {
+// *status stays "200 OK" unless the command answers before it is done
+static String handleCommand(JsonDocument& doc, const char** status) {
   // Expected: { "type":"cmd", "name":"...", "value": ... }
   const char* name = doc["name"].as<const char*>();
   if (!name) {
-    Serial.println("[CMD] missing name field");
+    LOGW(LOG_MOD_WEB, "[CMD] missing name field");
     return makeErrJson("bad_request", "Missing 'name'");
   }
 
@@ -153,42 +357,633 @@ static String handleCommand(JsonDocument& doc) {
     if (doc["value"].isNull()) return makeErrJson("bad_request", "Missing 'value'");
     float v = doc["value"].as<float>();
     if (v < 0.0f || v > 1.0f) return makeErrJson("range", "output_duty_cycle out of range");
+    if (diversionAuto.load()) return makeErrJson("busy", "Duty is set by the diversion controller");
     outputDutyCycle = v;
     return makeAckJson("duty cycle updated");
   }
 
+  // set_diversion_auto (bool): PV-surplus controller drives the duty (see diversion.h)
+  if (strcmp(name, "set_diversion_auto") == 0) {
+    if (!doc["value"].is<bool>()) return makeErrJson("bad_request", "Expected true or false");
+    diversionAuto = doc["value"].as<bool>();
+    return makeAckJson(diversionAuto.load() ? "diversion auto" : "diversion manual");
+  }
+
+  // set_thermistor_offset: { "sensor":"h", "value":-0.8 } sets the offset [°C],
+  // { "sensor":"h", "reference":41.5 } derives it from a reference thermometer
+  if (strcmp(name, "set_thermistor_offset") == 0) {
+    int i = thermistor_find(doc["sensor"].as<const char*>());
+    if (i < 0) return makeErrJson("bad_request", "Unknown 'sensor'");
+    float offset;
+    if (!doc["reference"].isNull()) {
+      float raw = thermistor_temp_c(i) - thermistor_offset_c(i);
+      if (isnan(raw)) return makeErrJson("busy", "No reading from this sensor");
+      offset = doc["reference"].as<float>() - raw;
+    } else if (!doc["value"].isNull()) {
+      offset = doc["value"].as<float>();
+    } else {
+      return makeErrJson("bad_request", "Missing 'value' or 'reference'");
+    }
+    if (!thermistor_set_offset_c(i, offset)) return makeErrJson("range", "Offset out of range or not saved");
+    return makeAckJson("thermistor offset updated");
+  }
+
+  // set_telemetry_udp: "a.b.c.d[:port]" (unicast or multicast), "" or "off"
+  if (strcmp(name, "set_telemetry_udp") == 0) {
+    const char* v = doc["value"].as<const char*>();
+    if (!telemetry_udp_set_target(v)) return makeErrJson("bad_request", "Expected a.b.c.d[:port] or off");
+    return makeAckJson("telemetry UDP target updated");
+  }
+
+  if (strcmp(name, "inverter_write") == 0) return handleInverterWrite(doc, status);
+
   return makeErrJson("unknown_cmd", "Unknown command name");
 }
 
 // --------- HTTP API handlers (status + command via POST) ---------
-static void handleStatus() {
-  server.sendHeader("Cache-Control", "no-cache, no-store, must-revalidate");
-  server.sendHeader("Pragma", "no-cache");
-  server.sendHeader("Expires", "-1");
-  String s = makeStatusJson();
-  server.send(200, "application/json", s);
+// GET /status[?dev=N] -> cached JSON with ETag; If-None-Match on the current tag -> 304
+// True if the Accept header asks for the binary telemetry frame
+static bool wantsTelemetry(httpd_req_t* req) {
+  char accept[96];
+  if (httpd_req_get_hdr_value_str(req, "Accept", accept, sizeof(accept)) != ESP_OK) return false;
+  return strstr(accept, TELEMETRY_CONTENT_TYPE) != nullptr;
 }
 
-static void handleCmdHttp() {
-  if (!server.hasArg("plain")) {
-    server.send(400, "application/json", makeErrJson("bad_request", "Missing body"));
-    return;
+static esp_err_t handleStatus(httpd_req_t* req) {
+  uint32_t t0 = micros();
+  uint8_t dev;
+  if (!deviceArg(req, &dev)) return sendJson(req, "400 Bad Request", makeErrJson("bad_request", "Unknown 'dev'"));
+  StatusCache& c = currentStatus(dev);
+  bool bin = wantsTelemetry(req);
+  if (bin ? c.bin_len == 0 : c.len == 0) return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "status too large");
+  const char* etag = bin ? c.bin_etag : c.etag;
+  // no-cache = cache but always revalidate, so browsers send If-None-Match
+  httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+  httpd_resp_set_hdr(req, "Vary", "Accept");
+  httpd_resp_set_hdr(req, "ETag", etag);
+  if (bin) c.bin_requests++;
+
+  char inm[32];
+  if (httpd_req_get_hdr_value_str(req, "If-None-Match", inm, sizeof(inm)) == ESP_OK && strcmp(inm, etag) == 0) {
+    c.not_modified++;
+    httpd_resp_set_status(req, "304 Not Modified");
+    esp_err_t err = httpd_resp_send(req, NULL, 0);
+    status_events_count_poll(0, micros() - t0);
+    return err;
+  }
+  esp_err_t err;
+  size_t len;
+  if (bin) {
+    httpd_resp_set_type(req, TELEMETRY_CONTENT_TYPE);
+    len = c.bin_len;
+    err = httpd_resp_send(req, (const char*)c.bin, len);
+  } else {
+    httpd_resp_set_type(req, "application/json");
+    len = c.len;
+    err = httpd_resp_send(req, c.body, len);
+  }
+  status_events_count_poll(len, micros() - t0);
+  return err;
+}
+
+// GET /events -> text/event-stream (see status_events.h); the socket is
+// handed over to the push module and stays open after this handler returns.
+static esp_err_t handleEvents(httpd_req_t* req) {
+  if (!status_events_subscribe(req)) {
+    return sendJson(req, "503 Service Unavailable", makeErrJson("busy", "Too many event subscribers"));
+  }
+  return ESP_OK;
+}
+
+// GET /events/stats -> push vs. polling traffic counters and loop() cadence
+static esp_err_t handleEventsStats(httpd_req_t* req) {
+  WebTrafficStats st;
+  status_events_get_stats(&st);
+  JsonDocument doc;
+  doc["uptime_ms"] = millis();
+  JsonObject sse = doc["sse"].to<JsonObject>();
+  sse["clients"] = st.sse_clients;
+  sse["frames"] = st.sse_frames;
+  sse["bytes"] = st.sse_bytes;
+  sse["cpu_us"] = st.sse_cpu_us;
+  JsonObject poll = doc["poll"].to<JsonObject>();
+  poll["requests"] = st.poll_requests;
+  poll["bytes"] = st.poll_bytes;
+  poll["cpu_us"] = st.poll_cpu_us;
+  uint32_t rebuilds = 0, not_modified = 0, binary = 0;
+  for (const auto& c : g_status_cache) {
+    rebuilds += c.rebuilds;
+    not_modified += c.not_modified;
+    binary += c.bin_requests;
+  }
+  poll["cache_rebuilds"] = rebuilds;
+  poll["not_modified"] = not_modified;
+  poll["binary"] = binary;
+  TelemetryUdpStats us;
+  telemetry_udp_get_stats(&us);
+  JsonObject udp = doc["udp"].to<JsonObject>();
+  udp["enabled"] = us.enabled;
+  udp["seq"] = us.seq;
+  udp["frames"] = us.frames;
+  udp["bytes"] = us.bytes;
+  udp["errors"] = us.errors;
+  LoopStats ls;
+  webserver_take_loop_stats(&ls);
+  JsonObject loop = doc["loop"].to<JsonObject>();
+  loop["iterations"] = ls.iterations;
+  loop["avg_us"] = ls.iterations ? (uint32_t)(ls.sum_us / ls.iterations) : 0;
+  loop["max_us"] = ls.max_us;
+  String out;
+  serializeJson(doc, out);
+  return sendJson(req, "200 OK", out);
+}
+
+// GET /inverter[?dev=N] -> command schedule with statistics and the last
+// response of each slow inquiry (QPIRI, QFLAG, QDI, QPIWS, QVFW) as raw
+// payload text, for one device
+static esp_err_t handleInverter(httpd_req_t* req) {
+  uint8_t dev;
+  if (!deviceArg(req, &dev)) return sendJson(req, "400 Bad Request", makeErrJson("bad_request", "Unknown 'dev'"));
+  JsonDocument doc;
+  InverterDeviceInfo info;
+  inverter_get_device_info(dev, &info);
+  doc["devices"] = inverter_device_count();
+  JsonObject d = doc["device"].to<JsonObject>();
+  d["index"] = dev;
+  d["uart"] = info.uart_num;
+  d["rx_pin"] = info.rx_pin;
+  d["tx_pin"] = info.tx_pin;
+  d["baud"] = info.baud;
+  SchedLinkStats link;
+  inverter_get_link_stats(&link, dev);
+  JsonObject l = doc["link"].to<JsonObject>();
+  l["busy_ms"] = link.busy_ms;
+  l["utilization"] = link.util_permille / 1000.0f;
+  l["window_ms"] = link.window_ms;
+  uint32_t poll_ms;
+  PollReason reason;
+  inverter_get_poll_rate(&poll_ms, &reason, dev);
+  JsonObject poll = doc["poll"].to<JsonObject>();
+  poll["period_ms"] = poll_ms;
+  poll["reason"] = PollRateController::reason_name(reason);
+  WriteStats ws;
+  Histogram wh;
+  inverter_get_write_stats(&ws, &wh, dev);
+  JsonObject writes = doc["writes"].to<JsonObject>();
+  writes["submitted"] = ws.submitted;
+  writes["rejected"] = ws.rejected;
+  writes["acks"] = ws.acks;
+  writes["naks"] = ws.naks;
+  writes["failed"] = ws.failed;
+  writes["retries"] = ws.retries;
+  writes["max_latency_ms"] = ws.max_latency_ms;
+  JsonArray cmds = doc["commands"].to<JsonArray>();
+  SchedEntry e;
+  SchedCmdStats ss;
+  for (size_t i = 0; inverter_get_schedule(i, &e, &ss, dev); ++i) {
+    JsonObject c = cmds.add<JsonObject>();
+    c["name"] = inverter_cmd_name((InverterCmdId)e.cmd);
+    c["period_ms"] = ss.period_ms;
+    c["priority"] = e.priority;
+    c["deadline_ms"] = e.deadline_ms;
+    c["est_ms"] = ss.est_ms;
+    c["runs"] = ss.runs;
+    c["deadline_misses"] = ss.deadline_misses;
+    c["skipped"] = ss.skipped;
+    c["max_lateness_ms"] = ss.max_lateness_ms;
+    char text[INVERTER_RESPONSE_MAX + 1];
+    uint32_t age_ms;
+    if (inverter_get_response((InverterCmdId)e.cmd, text, sizeof(text), &age_ms, dev)) {
+      c["response"] = text;
+      c["response_age_ms"] = age_ms;
+    }
+  }
+  String out;
+  serializeJson(doc, out);
+  return sendJson(req, "200 OK", out);
+}
+
+#define CMD_BODY_MAX 512
+
+static esp_err_t handleCmdHttp(httpd_req_t* req) {
+  if (req->content_len == 0) {
+    return sendJson(req, "400 Bad Request", makeErrJson("bad_request", "Missing body"));
+  }
+  if (req->content_len > CMD_BODY_MAX) {
+    return sendJson(req, "400 Bad Request", makeErrJson("bad_request", "Body too large"));
+  }
+  size_t got = 0;
+  int timeouts = 0;
+  while (got < req->content_len) {
+    int r = httpd_req_recv(req, g_scratch + got, req->content_len - got);
+    if (r == HTTPD_SOCK_ERR_TIMEOUT) {
+      // Each timeout already waited WEB_RECV_TIMEOUT_S; a stalled client must not pin the httpd task
+      if (++timeouts > WEB_RECV_RETRIES) {
+        return sendJson(req, "408 Request Timeout", makeErrJson("timeout", "Body not received"));
+      }
+      continue;
+    }
+    if (r <= 0) return ESP_FAIL;
+    got += (size_t)r;
   }
-  String body = server.arg("plain");
   // Parse JSON body
   JsonDocument doc;
-  DeserializationError err = deserializeJson(doc, body);
+  DeserializationError err = deserializeJson(doc, g_scratch, got);
   if (err) {
-    server.send(400, "application/json", makeErrJson("json_parse", err.c_str()));
-    return;
+    return sendJson(req, "400 Bad Request", makeErrJson("json_parse", err.c_str()));
   }
-  String reply = handleCommand(doc);
-  server.send(200, "application/json", reply);
+  const char* status = "200 OK";
+  String reply = handleCommand(doc, &status);
+  return sendJson(req, status, reply);
+}
+
+// GET /cmd?id=<ticket>[&dev=N] -> state of an inverter_write command
+static esp_err_t handleCmdResult(httpd_req_t* req) {
+  uint8_t dev;
+  if (!deviceArg(req, &dev)) return sendJson(req, "400 Bad Request", makeErrJson("bad_request", "Unknown 'dev'"));
+  char arg[16];
+  queryArg(req, "id", arg, sizeof(arg));
+  WriteJob j;
+  if (!inverter_write_status((uint32_t)strtoul(arg, nullptr, 10), &j, dev)) {
+    return sendJson(req, "404 Not Found", makeErrJson("not_found", "Unknown or expired id"));
+  }
+  return sendJson(req, "200 OK", makeWriteJson(j, dev));
+}
+
+// --------- History (streamed in chunks, no big String) ---------
+
+// Append fixed-point value as decimal text ("null" when missing). Returns length.
+static int formatFixed(char* out, size_t cap, int16_t v, int scale) {
+  if (v == HISTORY_NO_VALUE) return snprintf(out, cap, "null");
+  int decimals = (scale >= 100) ? 2 : (scale >= 10) ? 1 : 0;
+  if (decimals == 0) return snprintf(out, cap, "%d", v);
+  int a = v < 0 ? -v : v;
+  return snprintf(out, cap, "%s%d.%0*d", v < 0 ? "-" : "", a / scale, decimals, a % scale);
+}
+
+// GET /history?field=<name>&unit=<n>|total&from=<epoch s> -> parallel units,
+// 1-minute averages only: {"field":"..","res":"1m","unit":"..","points":[[t,avg],..]}
+// "total" sums the units that reported in that minute (null if none did).
+static esp_err_t handleHistoryUnits(httpd_req_t* req, const char* unitArg) {
+  char name[32], arg[32];
+  queryArg(req, "field", name, sizeof(name));
+  HistoryUnitField field = history_unit_field_by_name(name);
+  if (field == HUF_COUNT) {
+    return sendJson(req, "400 Bad Request", makeErrJson("bad_request", "Unknown 'field' for unit history"));
+  }
+  bool total = strcmp(unitArg, "total") == 0;
+  char* end = nullptr;
+  unsigned long unit = strtoul(unitArg, &end, 10);
+  if (!total && (end == unitArg || *end || unit >= INVERTER_MAX_UNITS)) {
+    return sendJson(req, "400 Bad Request", makeErrJson("bad_request", "unit must be a unit index or total"));
+  }
+  queryArg(req, "res", arg, sizeof(arg));
+  if (arg[0] && strcmp(arg, "1m") != 0) {
+    return sendJson(req, "400 Bad Request", makeErrJson("bad_request", "unit history is 1m only"));
+  }
+  queryArg(req, "from", arg, sizeof(arg));
+  uint32_t from = (uint32_t)strtoul(arg, nullptr, 10);
+
+  httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+  httpd_resp_set_type(req, "application/json");
+
+  char* chunk = g_scratch;
+  const size_t cap = 768;
+  int len = snprintf(chunk, cap, "{\"field\":\"%s\",\"res\":\"1m\",\"unit\":\"%s\",\"scale\":1,\"points\":[",
+                     name, unitArg);
+  bool first = true;
+  const size_t BATCH = 8;
+  for (;;) {
+    HistoryUnitAgg agg[BATCH];
+    size_t n = history_read_units(from, agg, BATCH);
+    if (n == 0) break;
+    for (size_t i = 0; i < n; ++i) {
+      if (len > (int)cap - 48) {
+        if (httpd_resp_send_chunk(req, chunk, len) != ESP_OK) return ESP_FAIL;
+        len = 0;
+      }
+      int16_t v = HISTORY_NO_VALUE;
+      if (total) {
+        int32_t sum = 0;
+        bool any = false;
+        for (int u = 0; u < INVERTER_MAX_UNITS; ++u) {
+          int16_t x = agg[i].avg[u][field];
+          if (x == HISTORY_NO_VALUE) continue;
+          sum += x;
+          any = true;
+        }
+        if (any) v = (int16_t)(sum > 32767 ? 32767 : sum);
+      } else {
+        v = agg[i].avg[unit][field];
+      }
+      len += snprintf(chunk + len, cap - len, "%s[%u,", first ? "" : ",", (unsigned)agg[i].t);
+      len += formatFixed(chunk + len, cap - len, v, 1);
+      chunk[len++] = ']';
+      first = false;
+      from = agg[i].t + 1;
+    }
+    if (n < BATCH) break;
+  }
+  len += snprintf(chunk + len, cap - len, "]}");
+  if (httpd_resp_send_chunk(req, chunk, len) != ESP_OK) return ESP_FAIL;
+  return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// GET /history?field=<name>&from=<epoch s>&res=raw|1m|15m
+// -> {"field":"..","res":"..","points":[[t,v],..]} or [[t,min,avg,max],..]
+// With unit=<n>|total: per-unit history of a parallel system (see above)
+// Only device 0 is recorded; other devices answer 404.
+static esp_err_t handleHistory(httpd_req_t* req) {
+  char arg[32];
+  uint8_t dev;
+  if (!deviceArg(req, &dev)) return sendJson(req, "400 Bad Request", makeErrJson("bad_request", "Unknown 'dev'"));
+  if (dev != 0) return sendJson(req, "404 Not Found", makeErrJson("not_found", "History is recorded for device 0 only"));
+  if (queryArg(req, "unit", arg, sizeof(arg))) return handleHistoryUnits(req, arg);
+  queryArg(req, "field", arg, sizeof(arg));
+  HistoryField field = history_field_by_name(arg);
+  if (field == HF_COUNT) {
+    return sendJson(req, "400 Bad Request", makeErrJson("bad_request", "Unknown or missing 'field'"));
+  }
+  HistoryRes res = HISTORY_RES_RAW;
+  queryArg(req, "res", arg, sizeof(arg));
+  if (strcmp(arg, "1m") == 0) res = HISTORY_RES_1M;
+  else if (strcmp(arg, "15m") == 0) res = HISTORY_RES_15M;
+  else if (arg[0] && strcmp(arg, "raw") != 0) {
+    return sendJson(req, "400 Bad Request", makeErrJson("bad_request", "res must be raw, 1m or 15m"));
+  }
+  queryArg(req, "from", arg, sizeof(arg));
+  uint32_t from = (uint32_t)strtoul(arg, nullptr, 10);
+  const int scale = history_field_scale(field);
+  static const char* const RES_NAMES[] = { "raw", "1m", "15m" };
+
+  httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+  httpd_resp_set_type(req, "application/json");
+
+  char* chunk = g_scratch;
+  const size_t cap = 768;   // leaves headroom below sizeof(g_scratch)
+  int len = snprintf(chunk, cap, "{\"field\":\"%s\",\"res\":\"%s\",\"scale\":%d,\"points\":[",
+                     history_field_name(field), RES_NAMES[res], scale);
+  bool first = true;
+  const size_t BATCH = 8;
+  uint32_t skip = 0;   // raw records at t == from already sent
+  for (;;) {
+    HistorySample raw[BATCH];
+    HistoryAgg agg[BATCH];
+    size_t n = (res == HISTORY_RES_RAW) ? history_read_raw(from, skip, raw, BATCH)
+                                        : history_read_agg(res, from, agg, BATCH);
+    if (n == 0) break;
+    for (size_t i = 0; i < n; ++i) {
+      // Flush before the buffer could overflow (one point is < 64 chars)
+      if (len > (int)cap - 64) {
+        if (httpd_resp_send_chunk(req, chunk, len) != ESP_OK) return ESP_FAIL;
+        len = 0;
+      }
+      uint32_t t = (res == HISTORY_RES_RAW) ? raw[i].t : agg[i].t;
+      len += snprintf(chunk + len, cap - len, "%s[%u", first ? "" : ",", (unsigned)t);
+      first = false;
+      if (res == HISTORY_RES_RAW) {
+        chunk[len++] = ',';
+        len += formatFixed(chunk + len, cap - len, raw[i].v[field], scale);
+      } else {
+        const int16_t vals[3] = { agg[i].min[field], agg[i].avg[field], agg[i].max[field] };
+        for (int16_t v : vals) {
+          chunk[len++] = ',';
+          len += formatFixed(chunk + len, cap - len, v, scale);
+        }
+      }
+      chunk[len++] = ']';
+      if (res != HISTORY_RES_RAW) {
+        from = t + 1;
+      } else if (t == from) {
+        skip++;
+      } else {
+        from = t;
+        skip = 1;
+      }
+    }
+    if (n < BATCH) break;
+  }
+  len += snprintf(chunk + len, cap - len, "]}");
+  if (httpd_resp_send_chunk(req, chunk, len) != ESP_OK) return ESP_FAIL;
+  return httpd_resp_send_chunk(req, NULL, 0); // end of chunked response
+}
+
+// --------- Log file (streamed from an offset, e.g. for `tail -f` style polling) ---------
+
+// GET /log?offset=<bytes> -> text/plain from offset to the current end of
+// /app.log. X-Log-Size carries the file size to use as the next offset; an
+// offset past the end (file was rotated) restarts from 0.
+static esp_err_t handleLog(httpd_req_t* req) {
+  char arg[16];
+  queryArg(req, "offset", arg, sizeof(arg));
+  uint32_t offset = (uint32_t)strtoul(arg, nullptr, 10);
+  uint8_t* chunk = (uint8_t*)g_scratch;
+  uint32_t size = 0;
+  size_t n = log_file_read(offset, chunk, sizeof(g_scratch), &size);
+  if (offset > size) {
+    offset = 0;
+    n = log_file_read(offset, chunk, sizeof(g_scratch), &size);
+  }
+
+  char sizeHdr[12];
+  snprintf(sizeHdr, sizeof(sizeHdr), "%u", (unsigned)size);
+  httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+  httpd_resp_set_hdr(req, "X-Log-Size", sizeHdr);
+  httpd_resp_set_type(req, "text/plain; charset=utf-8");
+  // Stop at the size seen first so a busy logger cannot keep the request open
+  while (n > 0) {
+    if (offset + n > size) n = size - offset;
+    if (httpd_resp_send_chunk(req, (const char*)chunk, n) != ESP_OK) return ESP_FAIL;
+    offset += n;
+    if (offset >= size) break;
+    uint32_t ignored;
+    n = log_file_read(offset, chunk, sizeof(g_scratch), &ignored);
+  }
+  return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// GET  /log/level                       -> levels of all modules + logger stats
+// POST /log/level?module=inv&level=debug -> set one module's level, same answer
+static esp_err_t sendLogLevels(httpd_req_t* req) {
+  JsonDocument doc;
+  JsonObject levels = doc["levels"].to<JsonObject>();
+  for (int m = 0; m < LOG_MOD_COUNT; ++m) {
+    levels[log_module_name((LogModule)m)] = log_level_name(log_get_level((LogModule)m));
+  }
+  LogStats st;
+  log_get_stats(&st);
+  doc["written"] = st.written;
+  doc["dropped_full"] = st.dropped_full;
+  doc["dropped_rate"] = st.dropped_rate;
+  doc["flushed_bytes"] = st.flushed_bytes;
+  doc["file_rotations"] = st.file_rotations;
+  doc["flush_stack_free"] = st.flush_stack_free;
+  String out;
+  serializeJson(doc, out);
+  return sendJson(req, "200 OK", out);
+}
+
+static esp_err_t handleLogLevel(httpd_req_t* req) {
+  char modArg[16];
+  // Prefetchers and crawlers follow GET links; changing state needs POST
+  if (queryArg(req, "module", modArg, sizeof(modArg))) {
+    return sendJson(req, "405 Method Not Allowed", makeErrJson("method_not_allowed", "Use POST to set a level"));
+  }
+  return sendLogLevels(req);
+}
+
+static esp_err_t handleLogLevelSet(httpd_req_t* req) {
+  char modArg[16], lvlArg[16];
+  if (!queryArg(req, "module", modArg, sizeof(modArg)) || !queryArg(req, "level", lvlArg, sizeof(lvlArg))) {
+    return sendJson(req, "400 Bad Request", makeErrJson("bad_request", "Need 'module' and 'level'"));
+  }
+  LogModule mod = log_module_by_name(modArg);
+  LogLevel lvl;
+  if (mod == LOG_MOD_COUNT || !log_level_by_name(lvlArg, &lvl)) {
+    return sendJson(req, "400 Bad Request", makeErrJson("bad_request", "Unknown 'module' or 'level'"));
+  }
+  log_set_level(mod, lvl);
+  return sendLogLevels(req);
+}
+
+// ---- loop() cadence, recorded by main.cpp and read by /events/stats ----
+static portMUX_TYPE g_loop_mux = portMUX_INITIALIZER_UNLOCKED;
+static LoopStats g_loop_stats = {};
+
+void webserver_note_loop(uint32_t period_us) {
+  portENTER_CRITICAL(&g_loop_mux);
+  g_loop_stats.iterations++;
+  g_loop_stats.sum_us += period_us;
+  if (period_us > g_loop_stats.max_us) g_loop_stats.max_us = period_us;
+  portEXIT_CRITICAL(&g_loop_mux);
+}
+
+void webserver_take_loop_stats(LoopStats* out) {
+  portENTER_CRITICAL(&g_loop_mux);
+  *out = g_loop_stats;
+  g_loop_stats = {};
+  portEXIT_CRITICAL(&g_loop_mux);
+}
+
+// ---- Handler timing ----
+// Every route is registered through timedHandler with the real handler in
+// user_ctx. Observed and read (by /metrics) only in the httpd task.
+static const uint32_t HANDLER_BOUNDS_US[] = { 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000 };
+static Histogram g_handler_hist = {};
+
+typedef esp_err_t (*RouteHandler)(httpd_req_t* req);
+
+// ---- Idle connection reaping (httpd task only) ----
+struct SockSeen {
+  int fd;            // -1 free
+  uint32_t ms;       // last request finished
+};
+static SockSeen g_seen[WEB_MAX_SOCKETS];
+static std::atomic<bool> g_reap_queued{false};
+
+static SockSeen* seenSlot(int fd, bool add) {
+  SockSeen* free_slot = nullptr;
+  for (auto& e : g_seen) {
+    if (e.fd == fd) return &e;
+    if (e.fd < 0 && !free_slot) free_slot = &e;
+  }
+  if (!add || !free_slot) return nullptr;
+  free_slot->fd = fd;
+  free_slot->ms = millis();
+  return free_slot;
+}
+
+static void reapWork(void* arg) {
+  (void)arg;
+  g_reap_queued.store(false);
+  size_t n = WEB_MAX_SOCKETS;
+  int fds[WEB_MAX_SOCKETS];
+  if (httpd_get_client_list(g_httpd, &n, fds) != ESP_OK) return;
+  uint32_t now = millis();
+  for (size_t i = 0; i < n; ++i) {
+    if (status_events_owns(fds[i])) continue;
+    // Connected without a request yet: the clock starts now
+    SockSeen* e = seenSlot(fds[i], true);
+    if (e && now - e->ms >= WEB_IDLE_CLOSE_S * 1000u) {
+      e->fd = -1;
+      httpd_sess_trigger_close(g_httpd, fds[i]);
+    }
+  }
+}
+
+void webserver_reap_idle() {
+  if (!g_httpd || g_reap_queued.exchange(true)) return;
+  if (httpd_queue_work(g_httpd, reapWork, NULL) != ESP_OK) g_reap_queued.store(false);
+}
+
+static esp_err_t timedHandler(httpd_req_t* req) {
+  uint32_t t0 = micros();
+  esp_err_t err = ((RouteHandler)req->user_ctx)(req);
+  histogram_observe(&g_handler_hist, micros() - t0);
+  SockSeen* e = seenSlot(httpd_req_to_sockfd(req), true);
+  if (e) e->ms = millis();
+  return err;
+}
+
+// GET /metrics -> Prometheus / OpenMetrics text (see metrics.h)
+static esp_err_t handleMetrics(httpd_req_t* req) {
+  uint8_t dev;
+  if (!deviceArg(req, &dev)) return sendJson(req, "400 Bad Request", makeErrJson("bad_request", "Unknown 'dev'"));
+  MetricsContext ctx = { g_reset_reason_ws, g_reset_reason_str_ws, &g_handler_hist, dev, diversionAuto.load() };
+  portENTER_CRITICAL(&diversionMux);
+  ctx.diversion = diversionState;
+  portEXIT_CRITICAL(&diversionMux);
+  return metrics_send(req, g_scratch, sizeof(g_scratch), ctx);
+}
+
+// ---- Server setup ----
+static void onSocketClose(httpd_handle_t hd, int sockfd) {
+  status_events_on_close(sockfd);
+  SockSeen* e = seenSlot(sockfd, false);
+  if (e) e->fd = -1;
+  close(sockfd); // a custom close_fn owns closing the socket
 }
 
 void webserver_setup_routes() {
-  server.on("/", HTTP_GET, handleRoot);
-  server.on("/status", HTTP_GET, handleStatus);
-  server.on("/cmd", HTTP_POST, handleCmdHttp);
-  server.onNotFound(handleNotFound);
+  httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+  config.server_port = 80;
+  config.core_id = 0;                  // keep core 1 for inverter_task
+  config.task_priority = 4;
+  config.stack_size = 8192;            // ArduinoJson + snprintf of floats
+  config.max_open_sockets = WEB_MAX_SOCKETS;
+  config.max_uri_handlers = 16;
+  config.lru_purge_enable = false;     // would evict SSE streams, see webserver_reap_idle()
+  config.recv_wait_timeout = WEB_RECV_TIMEOUT_S;
+  config.send_wait_timeout = WEB_SEND_TIMEOUT_S;
+  config.close_fn = onSocketClose;
+  config.uri_match_fn = httpd_uri_match_wildcard;
+
+  if (httpd_start(&g_httpd, &config) != ESP_OK) {
+    LOGE(LOG_MOD_WEB, "httpd_start failed");
+    return;
+  }
+  static const httpd_uri_t routes[] = {
+    { "/status",       HTTP_GET,  handleStatus,      NULL },
+    { "/events",       HTTP_GET,  handleEvents,      NULL },
+    { "/events/stats", HTTP_GET,  handleEventsStats, NULL },
+    { "/cmd",          HTTP_POST, handleCmdHttp,     NULL },
+    { "/cmd",          HTTP_GET,  handleCmdResult,   NULL },
+    { "/history",      HTTP_GET,  handleHistory,     NULL },
+    { "/log",          HTTP_GET,  handleLog,         NULL },
+    { "/log/level",    HTTP_GET,  handleLogLevel,    NULL },
+    { "/log/level",    HTTP_POST, handleLogLevelSet, NULL },
+    { "/metrics",      HTTP_GET,  handleMetrics,     NULL },
+    { "/inverter",     HTTP_GET,  handleInverter,    NULL },
+    { "/*",            HTTP_GET,  handleFile,        NULL },  // must stay last
+  };
+  for (auto& e : g_seen) e.fd = -1;
+  histogram_init(&g_handler_hist, HANDLER_BOUNDS_US, sizeof(HANDLER_BOUNDS_US) / sizeof(HANDLER_BOUNDS_US[0]), 1000000);
+  for (const auto& r : routes) {
+    httpd_uri_t timed = r;
+    timed.handler = timedHandler;
+    timed.user_ctx = (void*)r.handler;
+    httpd_register_uri_handler(g_httpd, &timed);
+  }
+  status_events_attach(g_httpd);
+  LOGI(LOG_MOD_WEB, "HTTP :80 (%d sockets)", WEB_MAX_SOCKETS);
 }
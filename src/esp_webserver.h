@@ -1,13 +1,36 @@
 #pragma once
+#include <stdint.h>
 
-class WebServer;
+// HTTP server (esp_http_server, own task on core 0, HTTP/1.1 keep-alive)
+// No LRU purge: it would evict SSE streams first (they never send another
+// request). Instead idle keep-alive connections that are not SSE streams are
+// closed after WEB_IDLE_CLOSE_S, so with all SSE_MAX_CLIENTS (4) subscribed
+// there are still 3 sockets that free up for ordinary requests.
+#define WEB_MAX_SOCKETS     7   // CONFIG_LWIP_MAX_SOCKETS (10) - 3 used by httpd itself
+#define WEB_RECV_TIMEOUT_S  5   // drop clients that stall mid-request
+#define WEB_RECV_RETRIES    1   // further recv timeouts tolerated per request body (then 408)
+#define WEB_SEND_TIMEOUT_S  5
+#define WEB_IDLE_CLOSE_S    10
 
+// Mount LittleFS (web UI files in data/ are uploaded to the device)
 void initWebServer();
-void handleRoot();
-void handleNotFound();
 
 // Provide reset information for JSON status (called from setup())
 void webserver_set_reset_info(int reason, const char* reason_str);
 
-// Register HTTP routes (/, /status, /cmd, notFound) on the global `server`
+// Start the server and register routes (/, /status, /events, /cmd, /history,
+// /log, /metrics, /inverter, static files). Call after WiFi is up.
 void webserver_setup_routes();
+
+// Close idle keep-alive connections (not SSE); queues the work to the httpd
+// task, call about once a second
+void webserver_reap_idle();
+
+// loop() cadence statistics for /events/stats (window since the last read)
+struct LoopStats {
+  uint32_t iterations;
+  uint64_t sum_us;
+  uint32_t max_us;
+};
+void webserver_note_loop(uint32_t period_us);
+void webserver_take_loop_stats(LoopStats* out);
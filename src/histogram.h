@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+
+// Fixed-bucket latency histogram (no allocation, plain copyable struct).
+// Observations are integers in the histogram's unit (ms or us); the owner
+// serializes observe() against copies with its own lock.
+
+#define HISTOGRAM_MAX_BOUNDS 12
+
+struct Histogram {
+  const uint32_t* bounds;                     // ascending upper bounds (inclusive)
+  uint8_t n_bounds;
+  uint32_t unit_per_s;                        // 1000 for ms, 1000000 for us
+  uint32_t counts[HISTOGRAM_MAX_BOUNDS + 1];  // per bucket, last is +Inf; not cumulative
+  uint32_t count;
+  uint64_t sum;
+};
+
+static inline void histogram_init(Histogram* h, const uint32_t* bounds, uint8_t n_bounds, uint32_t unit_per_s) {
+  *h = Histogram{};
+  h->bounds = bounds;
+  h->n_bounds = n_bounds > HISTOGRAM_MAX_BOUNDS ? HISTOGRAM_MAX_BOUNDS : n_bounds;
+  h->unit_per_s = unit_per_s;
+}
+
+static inline void histogram_observe(Histogram* h, uint32_t v) {
+  uint8_t i = 0;
+  while (i < h->n_bounds && v > h->bounds[i]) ++i;
+  h->counts[i]++;
+  h->count++;
+  h->sum += v;
+}
@@ -0,0 +1,296 @@
+#include "history.h"
+#include "history_store.h"
+#include <math.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+// Fixed-size ring buffer; index 0 is the oldest record
+template <typename T, size_t N>
+struct Ring {
+  T items[N];
+  size_t head = 0;   // next write position
+  size_t count = 0;
+
+  void push(const T& v) {
+    items[head] = v;
+    head = (head + 1) % N;
+    if (count < N) count++;
+  }
+  const T& at(size_t i) const { return items[(head + N - count + i) % N]; }
+
+  // First logical index with t >= from_t (records are appended in time order)
+  size_t lower_bound(uint32_t from_t) const {
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+      size_t mid = (lo + hi) / 2;
+      if (at(mid).t < from_t) lo = mid + 1;
+      else hi = mid;
+    }
+    return lo;
+  }
+
+  // skip: records at exactly from_t the caller already has
+  size_t copy_from(uint32_t from_t, T* out, size_t max, uint32_t skip = 0) const {
+    size_t n = 0;
+    size_t i = lower_bound(from_t);
+    for (; skip && i < count && at(i).t == from_t; --skip) ++i;
+    for (; i < count && n < max; ++i) out[n++] = at(i);
+    return n;
+  }
+};
+
+// Running min/sum/max for the bucket currently being filled
+struct Accumulator {
+  uint32_t bucket_t;
+  uint16_t n[HF_COUNT];
+  int32_t sum[HF_COUNT];
+  int16_t min[HF_COUNT];
+  int16_t max[HF_COUNT];
+  bool active;
+
+  void start(uint32_t t) {
+    bucket_t = t;
+    memset(n, 0, sizeof(n));
+    memset(sum, 0, sizeof(sum));
+    active = true;
+  }
+
+  void add(const HistorySample& s) {
+    for (int f = 0; f < HF_COUNT; ++f) {
+      int16_t v = s.v[f];
+      if (v == HISTORY_NO_VALUE) continue;
+      if (n[f] == 0 || v < min[f]) min[f] = v;
+      if (n[f] == 0 || v > max[f]) max[f] = v;
+      sum[f] += v;
+      n[f]++;
+    }
+  }
+
+  HistoryAgg finish() const {
+    HistoryAgg a;
+    a.t = bucket_t;
+    for (int f = 0; f < HF_COUNT; ++f) {
+      if (n[f] == 0) {
+        a.min[f] = a.avg[f] = a.max[f] = HISTORY_NO_VALUE;
+      } else {
+        a.min[f] = min[f];
+        a.max[f] = max[f];
+        a.avg[f] = (int16_t)((sum[f] + (sum[f] >= 0 ? n[f] / 2 : -(int32_t)(n[f] / 2))) / (int32_t)n[f]);
+      }
+    }
+    return a;
+  }
+};
+
+static Ring<HistorySample, HISTORY_RAW_LEN> g_raw;
+static Ring<HistoryAgg, HISTORY_1M_LEN> g_1m;
+static Ring<HistoryAgg, HISTORY_15M_LEN> g_15m;
+static Accumulator g_acc_1m = {};
+static Accumulator g_acc_15m = {};
+static Ring<HistoryUnitAgg, HISTORY_UNIT_LEN> g_units;
+
+// Per-unit minute bucket being filled
+struct UnitAccumulator {
+  uint32_t bucket_t;
+  uint16_t n[INVERTER_MAX_UNITS];
+  int32_t sum[INVERTER_MAX_UNITS][HUF_COUNT];
+  bool active;
+
+  void start(uint32_t t) {
+    bucket_t = t;
+    memset(n, 0, sizeof(n));
+    memset(sum, 0, sizeof(sum));
+    active = true;
+  }
+
+  HistoryUnitAgg finish() const {
+    HistoryUnitAgg a;
+    a.t = bucket_t;
+    for (int u = 0; u < INVERTER_MAX_UNITS; ++u) {
+      for (int f = 0; f < HUF_COUNT; ++f) {
+        a.avg[u][f] = n[u] ? (int16_t)((sum[u][f] + (int32_t)(n[u] / 2)) / (int32_t)n[u]) : HISTORY_NO_VALUE;
+      }
+    }
+    return a;
+  }
+};
+static UnitAccumulator g_acc_units = {};
+static SemaphoreHandle_t g_hist_mutex = NULL;
+
+struct FieldDef {
+  const char* name;
+  int scale;
+};
+
+static const FieldDef FIELDS[HF_COUNT] = {
+  { "grid_voltage",           10 },
+  { "ac_out_voltage",         10 },
+  { "ac_active_w",            1 },
+  { "ac_apparent_va",         1 },
+  { "load_percent",           1 },
+  { "batt_voltage",           100 },
+  { "batt_charge_current",    1 },
+  { "batt_discharge_current", 1 },
+  { "batt_soc",               1 },
+  { "pv_input_voltage",       10 },
+  { "pv_input_current",       10 },
+  { "pv_charging_power",      1 },
+  { "temp_h",                 10 },
+  { "temp_l",                 10 },
+};
+
+static int16_t to_fixed(float v, int scale) {
+  if (isnan(v)) return HISTORY_NO_VALUE;
+  float x = roundf(v * (float)scale);
+  if (x > 32767.0f) return 32767;
+  if (x < -32767.0f) return -32767;
+  return (int16_t)x;
+}
+
+void history_init() {
+  if (!g_hist_mutex) g_hist_mutex = xSemaphoreCreateMutex();
+}
+
+// Close the bucket if t moved past it, then add the sample
+static void roll(Accumulator& acc, uint32_t period_s, const HistorySample& s, void (*emit)(const HistoryAgg&)) {
+  uint32_t bucket = s.t - (s.t % period_s);
+  if (acc.active && acc.bucket_t != bucket) {
+    emit(acc.finish());
+    acc.active = false;
+  }
+  if (!acc.active) acc.start(bucket);
+  acc.add(s);
+}
+
+static void emit_1m(const HistoryAgg& a) { g_1m.push(a); }
+static void emit_15m(const HistoryAgg& a) { g_15m.push(a); }
+
+void history_add(uint32_t t, const InverterState& s, float temp_h, float temp_l) {
+  float vals[HF_COUNT];
+  vals[HF_GRID_VOLTAGE] = s.grid_voltage;
+  vals[HF_AC_OUT_VOLTAGE] = s.ac_out_voltage;
+  vals[HF_AC_ACTIVE_W] = (float)s.ac_active_w;
+  vals[HF_AC_APPARENT_VA] = (float)s.ac_apparent_va;
+  vals[HF_LOAD_PERCENT] = (float)s.load_percent;
+  vals[HF_BATT_VOLTAGE] = s.batt_voltage;
+  vals[HF_BATT_CHARGE_CURRENT] = s.batt_charge_current;
+  vals[HF_BATT_DISCHARGE_CURRENT] = s.batt_discharge_current;
+  vals[HF_BATT_SOC] = (float)s.batt_soc;
+  vals[HF_PV_INPUT_VOLTAGE] = s.pv_input_voltage;
+  vals[HF_PV_INPUT_CURRENT] = s.pv_input_current;
+  vals[HF_PV_CHARGING_POWER] = (float)s.pv_charging_power;
+  vals[HF_TEMP_H] = temp_h;
+  vals[HF_TEMP_L] = temp_l;
+
+  HistorySample r;
+  r.t = t;
+  for (int f = 0; f < HF_COUNT; ++f) r.v[f] = to_fixed(vals[f], FIELDS[f].scale);
+
+  if (g_hist_mutex) xSemaphoreTake(g_hist_mutex, portMAX_DELAY);
+  // Keep rings ordered if the clock jumped back (e.g. late NTP sync)
+  if (g_raw.count && r.t < g_raw.at(g_raw.count - 1).t) r.t = g_raw.at(g_raw.count - 1).t;
+  g_raw.push(r);
+  roll(g_acc_1m, 60, r, &emit_1m);
+  roll(g_acc_15m, 900, r, &emit_15m);
+  if (g_hist_mutex) xSemaphoreGive(g_hist_mutex);
+  history_store_append(r);
+}
+
+size_t history_read_raw(uint32_t from_t, uint32_t skip, HistorySample* out, size_t max) {
+  // Flash holds epoch timestamps only. Samples from before the clock was set
+  // (uptime seconds) sort below all of them, so for an epoch query the RAM
+  // ring starts at its first epoch sample.
+  HistorySample first;
+  uint32_t ram_oldest = UINT32_MAX;
+  if (g_hist_mutex) xSemaphoreTake(g_hist_mutex, portMAX_DELAY);
+  if (g_raw.copy_from(from_t >= HISTORY_MIN_EPOCH ? HISTORY_MIN_EPOCH : 0, &first, 1)) ram_oldest = first.t;
+  if (g_hist_mutex) xSemaphoreGive(g_hist_mutex);
+
+  // Older than the RAM ring: serve from flash up to where RAM takes over,
+  // then top up from RAM so a short batch still means "no more data"
+  size_t n = 0;
+  if (from_t < ram_oldest) {
+    n = history_store_read(from_t, skip, out, max);
+    while (n && out[n - 1].t >= ram_oldest) n--;
+    if (n == max) return n;
+    // Flash had everything below ram_oldest; RAM has nothing below it
+    from_t = ram_oldest;
+    skip = 0;
+  }
+
+  if (g_hist_mutex) xSemaphoreTake(g_hist_mutex, portMAX_DELAY);
+  n += g_raw.copy_from(from_t, out + n, max - n, skip);
+  if (g_hist_mutex) xSemaphoreGive(g_hist_mutex);
+  return n;
+}
+
+static const char* const UNIT_FIELD_NAMES[HUF_COUNT] = {
+  "ac_active_w", "batt_charge_current", "batt_discharge_current"
+};
+
+static int16_t clamp16(int32_t v) {
+  return (int16_t)(v > 32767 ? 32767 : (v < -32767 ? -32767 : v));
+}
+
+void history_add_unit(uint32_t t, uint8_t unit, const InverterUnitState& u) {
+  if (unit >= INVERTER_MAX_UNITS) return;
+  const int32_t vals[HUF_COUNT] = { u.ac_active_w, u.batt_charge_current, u.batt_discharge_current };
+  uint32_t bucket = t - (t % 60);
+  if (g_hist_mutex) xSemaphoreTake(g_hist_mutex, portMAX_DELAY);
+  UnitAccumulator& acc = g_acc_units;
+  if (acc.active && bucket < acc.bucket_t) bucket = acc.bucket_t;   // clock jumped back
+  if (acc.active && acc.bucket_t != bucket) {
+    g_units.push(acc.finish());
+    acc.active = false;
+  }
+  if (!acc.active) acc.start(bucket);
+  for (int f = 0; f < HUF_COUNT; ++f) acc.sum[unit][f] += clamp16(vals[f]);
+  acc.n[unit]++;
+  if (g_hist_mutex) xSemaphoreGive(g_hist_mutex);
+}
+
+size_t history_read_units(uint32_t from_t, HistoryUnitAgg* out, size_t max) {
+  if (g_hist_mutex) xSemaphoreTake(g_hist_mutex, portMAX_DELAY);
+  size_t n = g_units.copy_from(from_t, out, max);
+  if (g_hist_mutex) xSemaphoreGive(g_hist_mutex);
+  return n;
+}
+
+HistoryUnitField history_unit_field_by_name(const char* name) {
+  if (!name) return HUF_COUNT;
+  for (int f = 0; f < HUF_COUNT; ++f) {
+    if (strcmp(UNIT_FIELD_NAMES[f], name) == 0) return (HistoryUnitField)f;
+  }
+  return HUF_COUNT;
+}
+
+size_t history_read_agg(HistoryRes res, uint32_t from_t, HistoryAgg* out, size_t max) {
+  size_t n = 0;
+  if (g_hist_mutex) xSemaphoreTake(g_hist_mutex, portMAX_DELAY);
+  if (res == HISTORY_RES_1M) n = g_1m.copy_from(from_t, out, max);
+  else if (res == HISTORY_RES_15M) n = g_15m.copy_from(from_t, out, max);
+  if (g_hist_mutex) xSemaphoreGive(g_hist_mutex);
+  return n;
+}
+
+HistoryField history_field_by_name(const char* name) {
+  if (!name) return HF_COUNT;
+  for (int f = 0; f < HF_COUNT; ++f) {
+    if (strcmp(FIELDS[f].name, name) == 0) return (HistoryField)f;
+  }
+  return HF_COUNT;
+}
+
+const char* history_field_name(HistoryField f) {
+  return f < HF_COUNT ? FIELDS[f].name : "";
+}
+
+int history_field_scale(HistoryField f) {
+  return f < HF_COUNT ? FIELDS[f].scale : 1;
+}
+
+size_t history_ram_bytes() {
+  return sizeof(g_raw) + sizeof(g_1m) + sizeof(g_15m) + sizeof(g_acc_1m) + sizeof(g_acc_15m) +
+         sizeof(g_units) + sizeof(g_acc_units);
+}
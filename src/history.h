@@ -0,0 +1,111 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "inverter_state.h"
+
+// On-device time-series history of inverter samples.
+//
+// Samples are stored as compact fixed-point records in three statically
+// allocated ring buffers, updated incrementally from inverter_task:
+//   raw   one record per poll             HISTORY_RAW_LEN  x 32 B
+//   1m    min/avg/max per minute          HISTORY_1M_LEN   x 88 B
+//   15m   min/avg/max per 15 minutes      HISTORY_15M_LEN  x 88 B
+// With the defaults below: 400 x 32 + 240 x 88 + 96 x 88 = 42 368 B of RAM,
+// i.e. 10 min of raw data at the default 1.5 s poll period (POLL_DEFAULT_MS;
+// longer when the poll rate backs off), 4 h of 1-minute and 24 h of
+// 15-minute rollups. Nothing is allocated at runtime.
+
+#define HISTORY_RAW_LEN 400
+#define HISTORY_1M_LEN  240
+#define HISTORY_15M_LEN 96
+
+// Recorded fields; value = raw / scale (see history_field_scale())
+enum HistoryField : uint8_t {
+  HF_GRID_VOLTAGE = 0,        // 0.1 V
+  HF_AC_OUT_VOLTAGE,          // 0.1 V
+  HF_AC_ACTIVE_W,             // 1 W
+  HF_AC_APPARENT_VA,          // 1 VA
+  HF_LOAD_PERCENT,            // 1 %
+  HF_BATT_VOLTAGE,            // 0.01 V
+  HF_BATT_CHARGE_CURRENT,     // 1 A
+  HF_BATT_DISCHARGE_CURRENT,  // 1 A
+  HF_BATT_SOC,                // 1 %
+  HF_PV_INPUT_VOLTAGE,        // 0.1 V
+  HF_PV_INPUT_CURRENT,        // 0.1 A
+  HF_PV_CHARGING_POWER,       // 1 W
+  HF_TEMP_H,                  // 0.1 °C
+  HF_TEMP_L,                  // 0.1 °C
+  HF_COUNT
+};
+
+// Missing value (e.g. thermistor not connected)
+#define HISTORY_NO_VALUE INT16_MIN
+
+enum HistoryRes : uint8_t {
+  HISTORY_RES_RAW = 0,
+  HISTORY_RES_1M,
+  HISTORY_RES_15M
+};
+
+struct HistorySample {
+  uint32_t t;               // epoch seconds (uptime seconds until NTP sync)
+  int16_t v[HF_COUNT];
+};
+
+struct HistoryAgg {
+  uint32_t t;               // start of the bucket
+  int16_t min[HF_COUNT];
+  int16_t avg[HF_COUNT];
+  int16_t max[HF_COUNT];
+};
+
+static_assert(sizeof(HistorySample) == 32, "HistorySample layout");
+static_assert(sizeof(HistoryAgg) == 88, "HistoryAgg layout");
+
+void history_init();
+
+// Append one valid poll result (called from inverter_task)
+void history_add(uint32_t t, const InverterState& s, float temp_h, float temp_l);
+
+// Copy up to max records with t >= from_t, oldest first. Returns count.
+// Aggregates have one record per bucket: use last.t + 1 as the next from_t to
+// continue (stable under concurrent adds). Raw records can share a second
+// (sub-second polls, clock stepped back), so a raw read is continued from
+// (last.t, skip = records already returned with that t), never last.t + 1.
+// Raw reads older than the RAM ring fall back to the flash store (history_store.h).
+size_t history_read_raw(uint32_t from_t, uint32_t skip, HistorySample* out, size_t max);
+size_t history_read_agg(HistoryRes res, uint32_t from_t, HistoryAgg* out, size_t max);
+
+// Field lookup by JSON name ("batt_voltage", ...); returns HF_COUNT if unknown
+HistoryField history_field_by_name(const char* name);
+const char* history_field_name(HistoryField f);
+int history_field_scale(HistoryField f);
+
+// ---- Parallel units ----
+// Per-unit 1-minute averages of a few QPGSn fields, kept in a separate ring
+// (HISTORY_UNIT_LEN x 28 B, 4 h) so the HistorySample layout and the flash
+// store stay unchanged. Units without data in a minute read HISTORY_NO_VALUE.
+#define HISTORY_UNIT_LEN 240
+
+enum HistoryUnitField : uint8_t {
+  HUF_AC_ACTIVE_W = 0,        // 1 W
+  HUF_BATT_CHARGE_CURRENT,    // 1 A
+  HUF_BATT_DISCHARGE_CURRENT, // 1 A
+  HUF_COUNT
+};
+
+struct HistoryUnitAgg {
+  uint32_t t;               // start of the minute
+  int16_t avg[INVERTER_MAX_UNITS][HUF_COUNT];
+};
+
+static_assert(sizeof(HistoryUnitAgg) == 4 + INVERTER_MAX_UNITS * HUF_COUNT * 2, "HistoryUnitAgg layout");
+
+// Append one QPGSn answer of a present unit (called from inverter_task)
+void history_add_unit(uint32_t t, uint8_t unit, const InverterUnitState& u);
+size_t history_read_units(uint32_t from_t, HistoryUnitAgg* out, size_t max);
+// Same names as the matching HistoryField; HUF_COUNT if not recorded per unit
+HistoryUnitField history_unit_field_by_name(const char* name);
+
+// Static RAM used by the ring buffers (bytes)
+size_t history_ram_bytes();
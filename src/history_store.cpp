@@ -0,0 +1,288 @@
+#include "history_store.h"
+#include "logger.h"
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#define HISTORY_DIR "/hist"
+#define HISTORY_MAX_SEGMENTS (HISTORY_STORE_BUDGET / (HISTORY_SEG_BLOCKS * HISTORY_BLOCK_SIZE) + 2)
+
+struct BlockHeader {
+  uint32_t magic;
+  uint16_t rec_size;
+  uint16_t count;
+  uint32_t t_first;
+  uint32_t t_last;
+  uint32_t index[HISTORY_BLOCK_INDEX];
+};
+
+struct Block {
+  BlockHeader h;
+  HistorySample rec[HISTORY_BLOCK_RECORDS];
+  uint8_t pad[HISTORY_BLOCK_SIZE - HISTORY_BLOCK_HEADER - HISTORY_BLOCK_RECORDS * sizeof(HistorySample)];
+};
+
+static_assert(sizeof(BlockHeader) == HISTORY_BLOCK_HEADER, "block header layout");
+static_assert(sizeof(Block) == HISTORY_BLOCK_SIZE, "block layout");
+static_assert(HISTORY_BLOCK_INDEX * HISTORY_BLOCK_INDEX_STEP >= HISTORY_BLOCK_RECORDS, "index covers block");
+
+struct SegInfo {
+  uint32_t seq;
+  uint32_t t_first;
+  uint32_t blocks;
+};
+
+// Double-buffered blocks: the poll task fills one while the writer flushes the other
+static Block g_blocks[2];
+static volatile bool g_block_busy[2] = { false, false };
+static uint8_t g_fill = 0;
+static uint32_t g_last_t = 0;      // newest t queued (or found on flash at init)
+static QueueHandle_t g_write_queue = NULL;
+
+// Segment index, file access and stats are guarded by g_store_mutex
+static SemaphoreHandle_t g_store_mutex = NULL;
+static SegInfo g_segs[HISTORY_MAX_SEGMENTS];
+static uint32_t g_seg_count = 0;
+static HistoryStoreStats g_stats = {};
+// Counted by the poll task, which must not wait for the mutex while the
+// writer holds it for a flash write; merged in history_store_get_stats()
+static std::atomic<uint32_t> g_records_skipped{0};
+static std::atomic<uint32_t> g_records_dropped{0};
+static std::atomic<uint32_t> g_blocks_unqueued{0};
+
+static void seg_path(char* out, size_t cap, uint32_t seq) {
+  snprintf(out, cap, HISTORY_DIR "/%08X.seg", (unsigned)seq);
+}
+
+static void update_stats_locked() {
+  g_stats.segments = g_seg_count;
+  g_stats.bytes = 0;
+  for (uint32_t i = 0; i < g_seg_count; ++i) g_stats.bytes += g_segs[i].blocks * HISTORY_BLOCK_SIZE;
+  g_stats.t_oldest = g_seg_count ? g_segs[0].t_first : 0;
+}
+
+static bool read_header(File& f, uint32_t block, BlockHeader* h) {
+  if (!f.seek(block * HISTORY_BLOCK_SIZE)) return false;
+  if (f.read((uint8_t*)h, sizeof(*h)) != sizeof(*h)) return false;
+  return h->magic == HISTORY_BLOCK_MAGIC && h->rec_size == sizeof(HistorySample) &&
+         h->count <= HISTORY_BLOCK_RECORDS;
+}
+
+// Drop oldest segments until the budget holds (keeps the one being written)
+static void enforce_budget_locked() {
+  for (;;) {
+    update_stats_locked();
+    if (g_stats.bytes <= HISTORY_STORE_BUDGET || g_seg_count <= 1) return;
+    char path[32];
+    seg_path(path, sizeof(path), g_segs[0].seq);
+    LittleFS.remove(path);
+    memmove(&g_segs[0], &g_segs[1], (g_seg_count - 1) * sizeof(SegInfo));
+    g_seg_count--;
+  }
+}
+
+static void write_block(const Block& b) {
+  xSemaphoreTake(g_store_mutex, portMAX_DELAY);
+  if (g_seg_count == 0 || g_segs[g_seg_count - 1].blocks >= HISTORY_SEG_BLOCKS) {
+    if (g_seg_count == HISTORY_MAX_SEGMENTS) {
+      // Budget math guarantees room; this only protects against a changed budget
+      char path[32];
+      seg_path(path, sizeof(path), g_segs[0].seq);
+      LittleFS.remove(path);
+      memmove(&g_segs[0], &g_segs[1], (g_seg_count - 1) * sizeof(SegInfo));
+      g_seg_count--;
+    }
+    SegInfo s;
+    s.seq = g_seg_count ? g_segs[g_seg_count - 1].seq + 1 : 0;
+    s.t_first = b.h.t_first;
+    s.blocks = 0;
+    g_segs[g_seg_count++] = s;
+  }
+  SegInfo& seg = g_segs[g_seg_count - 1];
+  char path[32];
+  seg_path(path, sizeof(path), seg.seq);
+  File f = LittleFS.open(path, "a");
+  size_t written = f ? f.write((const uint8_t*)&b, sizeof(b)) : 0;
+  if (f) f.close();
+  if (written == sizeof(b)) {
+    seg.blocks++;
+    g_stats.blocks_written++;
+  } else {
+    g_stats.blocks_dropped++;
+    if (seg.blocks == 0) {
+      LittleFS.remove(path);
+      g_seg_count--;
+    }
+  }
+  enforce_budget_locked();
+  xSemaphoreGive(g_store_mutex);
+}
+
+static void history_writer_task(void* arg) {
+  (void)arg;
+  for (;;) {
+    uint8_t idx;
+    if (xQueueReceive(g_write_queue, &idx, portMAX_DELAY) != pdTRUE) continue;
+    write_block(g_blocks[idx]);
+    g_block_busy[idx] = false;
+  }
+}
+
+static int compare_seg(const void* a, const void* b) {
+  uint32_t sa = ((const SegInfo*)a)->seq, sb = ((const SegInfo*)b)->seq;
+  return (sa > sb) - (sa < sb);
+}
+
+void history_store_init() {
+  if (g_store_mutex) return;
+  g_store_mutex = xSemaphoreCreateMutex();
+  g_write_queue = xQueueCreate(2, sizeof(uint8_t));
+
+  if (!LittleFS.exists(HISTORY_DIR)) LittleFS.mkdir(HISTORY_DIR);
+  File dir = LittleFS.open(HISTORY_DIR);
+  for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+    const char* name = strrchr(f.name(), '/');
+    name = name ? name + 1 : f.name();
+    char* end = nullptr;
+    uint32_t seq = (uint32_t)strtoul(name, &end, 16);
+    // LittleFS commits a file's size on close, so a reset mid-write leaves
+    // whole blocks only; anything else is not ours.
+    BlockHeader h;
+    uint32_t blocks = f.size() / HISTORY_BLOCK_SIZE;
+    bool ok = end && strcmp(end, ".seg") == 0 && blocks > 0 && read_header(f, 0, &h);
+    f.close();
+    if (!ok || g_seg_count >= HISTORY_MAX_SEGMENTS) continue;
+    g_segs[g_seg_count++] = { seq, h.t_first, blocks };
+  }
+  dir.close();
+  qsort(g_segs, g_seg_count, sizeof(SegInfo), compare_seg);
+  enforce_budget_locked();
+  // New records must not go before what is on flash already
+  if (g_seg_count) {
+    const SegInfo& last = g_segs[g_seg_count - 1];
+    char path[32];
+    seg_path(path, sizeof(path), last.seq);
+    File f = LittleFS.open(path, "r");
+    BlockHeader h;
+    if (f && read_header(f, last.blocks - 1, &h)) g_last_t = h.t_last;
+    if (f) f.close();
+  }
+  LOGI(LOG_MOD_HIST, "store: %u segments, %u bytes, budget %u",
+    (unsigned)g_stats.segments, (unsigned)g_stats.bytes, (unsigned)HISTORY_STORE_BUDGET);
+
+  xTaskCreatePinnedToCore(history_writer_task, "history_writer", 3072, NULL, 0, NULL, 0);
+}
+
+void history_store_append(const HistorySample& s) {
+  if (!g_write_queue) return;
+  if (s.t < HISTORY_MIN_EPOCH || s.t < g_last_t) {
+    if (g_records_skipped.fetch_add(1) == 0) {
+      LOGW(LOG_MOD_HIST, "store: skipping t=%u (clock %s)", (unsigned)s.t,
+        s.t < HISTORY_MIN_EPOCH ? "not set" : "behind the stored history");
+    }
+    return;
+  }
+  Block& b = g_blocks[g_fill];
+  // Writer still flushing this buffer (flash slower than a whole block of polls)
+  if (g_block_busy[g_fill]) {
+    if (g_records_dropped.fetch_add(1) == 0) LOGW(LOG_MOD_HIST, "store: writer behind, dropping samples");
+    return;
+  }
+  // Still full from before the swap if it was busy then: start it over
+  if (b.h.count >= HISTORY_BLOCK_RECORDS) memset(&b, 0, sizeof(b));
+  g_last_t = s.t;
+  uint16_t i = b.h.count;
+  if (i == 0) {
+    b.h.magic = HISTORY_BLOCK_MAGIC;
+    b.h.rec_size = sizeof(HistorySample);
+    b.h.t_first = s.t;
+  }
+  if (i % HISTORY_BLOCK_INDEX_STEP == 0) b.h.index[i / HISTORY_BLOCK_INDEX_STEP] = s.t;
+  b.rec[i] = s;
+  b.h.t_last = s.t;
+  b.h.count = i + 1;
+
+  if (b.h.count == HISTORY_BLOCK_RECORDS) {
+    // Unused index slots point past the end so seeks stop at count
+    for (uint32_t k = (b.h.count + HISTORY_BLOCK_INDEX_STEP - 1) / HISTORY_BLOCK_INDEX_STEP; k < HISTORY_BLOCK_INDEX; ++k) {
+      b.h.index[k] = UINT32_MAX;
+    }
+    uint8_t idx = g_fill;
+    g_block_busy[idx] = true;
+    if (xQueueSend(g_write_queue, &idx, 0) != pdTRUE) {
+      g_block_busy[idx] = false;
+      g_blocks_unqueued.fetch_add(1);
+    }
+    g_fill ^= 1;
+    Block& next = g_blocks[g_fill];
+    if (!g_block_busy[g_fill]) memset(&next, 0, sizeof(next));
+  }
+}
+
+// Read records of one block with t >= from_t, starting at the index stride.
+// Records at exactly from_t are dropped while *skip is non-zero.
+static size_t read_block_from(File& f, uint32_t block, const BlockHeader& h, uint32_t from_t, uint32_t* skip,
+                              HistorySample* out, size_t max) {
+  uint32_t k = 0;
+  while (k + 1 < HISTORY_BLOCK_INDEX && h.index[k + 1] < from_t) ++k;
+  uint32_t i = k * HISTORY_BLOCK_INDEX_STEP;
+  if (i >= h.count) return 0;
+  f.seek(block * HISTORY_BLOCK_SIZE + HISTORY_BLOCK_HEADER + i * sizeof(HistorySample));
+  size_t n = 0;
+  for (; i < h.count && n < max; ++i) {
+    if (f.read((uint8_t*)&out[n], sizeof(HistorySample)) != sizeof(HistorySample)) break;
+    if (out[n].t < from_t) continue;
+    if (out[n].t == from_t && *skip) {
+      --*skip;
+      continue;
+    }
+    n++;
+  }
+  return n;
+}
+
+size_t history_store_read(uint32_t from_t, uint32_t skip, HistorySample* out, size_t max) {
+  if (!g_store_mutex || max == 0) return 0;
+  size_t n = 0;
+  xSemaphoreTake(g_store_mutex, portMAX_DELAY);
+  // Last segment starting before from_t (segments are in time order); a run
+  // of equal t can continue across a segment boundary
+  uint32_t si = 0;
+  while (si + 1 < g_seg_count && g_segs[si + 1].t_first < from_t) ++si;
+
+  for (; si < g_seg_count && n < max; ++si) {
+    char path[32];
+    seg_path(path, sizeof(path), g_segs[si].seq);
+    File f = LittleFS.open(path, "r");
+    if (!f) continue;
+    // Binary search for the first block whose t_last >= from_t
+    BlockHeader h;
+    uint32_t lo = 0, hi = g_segs[si].blocks;
+    while (lo < hi) {
+      uint32_t mid = (lo + hi) / 2;
+      if (read_header(f, mid, &h) && h.t_last < from_t) lo = mid + 1;
+      else hi = mid;
+    }
+    for (uint32_t b = lo; b < g_segs[si].blocks && n < max; ++b) {
+      if (!read_header(f, b, &h)) continue;
+      n += read_block_from(f, b, h, from_t, &skip, out + n, max - n);
+    }
+    f.close();
+  }
+  xSemaphoreGive(g_store_mutex);
+  return n;
+}
+
+void history_store_get_stats(HistoryStoreStats* out) {
+  if (!out) return;
+  if (g_store_mutex) xSemaphoreTake(g_store_mutex, portMAX_DELAY);
+  *out = g_stats;
+  if (g_store_mutex) xSemaphoreGive(g_store_mutex);
+  out->blocks_dropped += g_blocks_unqueued.load();
+  out->records_skipped = g_records_skipped.load();
+  out->records_dropped = g_records_dropped.load();
+}
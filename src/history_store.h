@@ -0,0 +1,64 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "history.h"
+
+// Persistent append-only history on the LittleFS partition.
+//
+// Raw HistorySample records are batched in RAM into 4 KB blocks (one flash
+// page / LittleFS block) and handed to a low-priority writer task, which
+// appends each full block to the current segment file in one write. Segments
+// (/hist/XXXXXXXX.seg, hex sequence number) hold HISTORY_SEG_BLOCKS blocks;
+// the oldest segments are deleted to stay within HISTORY_STORE_BUDGET bytes.
+//
+// Block layout (little endian, all blocks HISTORY_BLOCK_SIZE bytes):
+//   0  u32 magic 'HSB1'     4  u16 record size   6  u16 record count
+//   8  u32 t_first         12  u32 t_last       16  u32 index[HISTORY_BLOCK_INDEX]
+//   48 records (HistorySample, 32 B each)
+// index[k] is the t of record k * HISTORY_BLOCK_INDEX_STEP, so a query can
+// seek to the right 16-record stride without reading the whole block.
+//
+// Only epoch timestamps are persisted, in order: records from before the
+// clock is set (t below HISTORY_MIN_EPOCH, uptime seconds) or older than
+// the newest record already stored (clock stepped back) are skipped, so the
+// segment walk and the block/stride searches can rely on t never
+// decreasing.
+//
+// Defaults: 64 KB segments, 768 KB budget = 12 segments x 16 blocks x 126
+// records = 24 192 samples, ~10 h at the default 1.5 s poll period (more
+// when the poll rate backs off at night). Up to one block (126 samples,
+// ~3 min) that is still in RAM is lost on reset.
+// doc/historyDump.py decodes segment files or a partition dump on a host.
+
+#define HISTORY_BLOCK_SIZE        4096
+#define HISTORY_BLOCK_HEADER      48
+#define HISTORY_BLOCK_INDEX       8
+#define HISTORY_BLOCK_INDEX_STEP  16
+#define HISTORY_BLOCK_RECORDS     ((HISTORY_BLOCK_SIZE - HISTORY_BLOCK_HEADER) / sizeof(HistorySample))
+#define HISTORY_SEG_BLOCKS        16
+#define HISTORY_STORE_BUDGET      (768u * 1024u)
+#define HISTORY_BLOCK_MAGIC       0x31425348u // "HSB1"
+#define HISTORY_MIN_EPOCH         1600000000u // 2020-09-13: below this t is uptime
+
+// Scan existing segments and start the writer task. Call after LittleFS.begin().
+void history_store_init();
+
+// Queue one sample (called from inverter_task; never touches flash). Skips
+// samples that would break time order, see above.
+void history_store_append(const HistorySample& s);
+
+// Copy up to max persisted records with t >= from_t, oldest first, skipping
+// the first `skip` records at exactly from_t, using the segment/block/stride
+// indexes to seek. Returns count; same cursor rules as history_read_raw().
+size_t history_store_read(uint32_t from_t, uint32_t skip, HistorySample* out, size_t max);
+
+struct HistoryStoreStats {
+  uint32_t segments;
+  uint32_t bytes;
+  uint32_t blocks_written;
+  uint32_t blocks_dropped;   // writer fell behind or flash write failed
+  uint32_t records_skipped;  // clock not set yet or stepped back
+  uint32_t records_dropped;  // next buffer still being written (writer behind)
+  uint32_t t_oldest;         // 0 if empty
+};
+void history_store_get_stats(HistoryStoreStats* out);
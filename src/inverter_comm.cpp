@@ -1,72 +1,19 @@
 #include "inverter_comm.h"
-#include <HardwareSerial.h>
-
-static SemaphoreHandle_t g_inv_mutex = NULL;
-
-InverterState g_inverter_status = { 0 };
-bool g_inverter_data_valid = false;
-float g_temp_h = NAN;
-float g_temp_l = NAN;
-char g_inverter_mode_code = '\0';
-char g_inverter_mode_name[32] = "Unknown";
-
-// CRC-16/XMODEM implementation
-static uint16_t crc16_xmodem(const uint8_t* data, size_t len) {
-  uint16_t crc = 0x0000;
-  for (size_t i = 0; i < len; ++i) {
-    crc ^= ((uint16_t)data[i]) << 8;
-    for (int b = 0; b < 8; ++b) {
-      if (crc & 0x8000) crc = (crc << 1) ^ 0x1021;
-      else crc <<= 1;
-    }
-  }
-  return crc & 0xFFFF;
-}
-
-static void adjust_crc_bytes(uint8_t& hi, uint8_t& lo) {
-  // Device increments reserved values 0x28 '(' , 0x0D CR, 0x0A LF
-  const uint8_t RESERVED[] = { 0x28, 0x0D, 0x0A };
-  for (uint8_t r : RESERVED) {
-    if (hi == r) hi = (hi + 1) & 0xFF;
-    if (lo == r) lo = (lo + 1) & 0xFF;
-  }
-}
-
-// Build frame: payload ASCII + CRC(hi,lo adjusted) + CR
-static void build_frame(const String& payload, uint8_t* out, size_t& out_len) {
-  size_t plen = payload.length();
-  memcpy(out, (const char*)payload.c_str(), plen);
-  uint16_t crc = crc16_xmodem((const uint8_t*)payload.c_str(), plen);
-  uint8_t hi = (crc >> 8) & 0xFF;
-  uint8_t lo = crc & 0xFF;
-  adjust_crc_bytes(hi, lo);
-  out[plen + 0] = hi;
-  out[plen + 1] = lo;
-  out[plen + 2] = 0x0D; // CR
-  out_len = plen + 3;
-}
-
-// Read from Serial1 until CR or timeout. Returns length in bytes stored in buf.
-static size_t read_until_cr(HardwareSerial& s, uint8_t* buf, size_t max_len, unsigned long timeout_ms) {
-  size_t idx = 0;
-  unsigned long start = millis();
-  while (idx < max_len) {
-    if (s.available()) {
-      int b = s.read();
-      if (b < 0) break;
-      buf[idx++] = (uint8_t)b;
-      if ((uint8_t)b == 0x0D) break;
-    } else {
-      if (millis() - start >= timeout_ms) break;
-      vTaskDelay(pdMS_TO_TICKS(2));
-    }
-  }
-  return idx;
-}
-
-// Debug helper: print payload (between '(' and CRC), raw hex and ASCII
+#include "inverter_crc.h"
+#include "inverter_frame.h"
+#include "inverter_parse.h"
+#include "inverter_uart.h"
+#include "seqlock.h"
+#include "history.h"
+#include "logger.h"
+#include <atomic>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+// Debug helper: log payload (between '(' and CRC) and raw hex, 32 bytes per line
 static void debug_print_rx(const uint8_t* rx, size_t rx_len) {
-  if (!rx || rx_len == 0) return;
+  if (!rx || rx_len == 0 || !log_enabled(LOG_MOD_INV, LOG_DEBUG)) return;
 
   bool has_cr = (rx[rx_len - 1] == 0x0D);
   size_t body_len = has_cr ? (rx_len - 1) : rx_len;
@@ -74,263 +21,659 @@ static void debug_print_rx(const uint8_t* rx, size_t rx_len) {
     size_t payload_len_with_paren = body_len - 2; // includes leading '('
     size_t payload_ascii_len = (payload_len_with_paren > 0) ? payload_len_with_paren - 1 : 0;
     if (payload_ascii_len > 0) {
-      String payload_str((const char*)(rx + 1), payload_ascii_len);
-      Serial.print("[INV] RX (payload): ");
-      Serial.println(payload_str);
+      LOGD(LOG_MOD_INV, "RX (payload): %.*s", (int)payload_ascii_len, (const char*)rx + 1);
     }
   }
 
-  Serial.print("[INV] RX (hex): ");
-  for (size_t i = 0; i < rx_len; ++i) {
-    Serial.printf("%02X ", rx[i]);
-  }
-  Serial.println();
-
-  Serial.print("[INV] RX (ascii): ");
-  Serial.write(rx, rx_len);
-  Serial.println();
-}
-
-// Send ASCII command and read response. Returns payload (inside '('.. ).
-// On CRC mismatch the function prints the raw response and returns false.
-static bool send_command_and_get_payload(const String& cmd, String& out_payload) {
-  HardwareSerial& ser = Serial1;
-  uint8_t tx[128];
-  size_t tx_len = 0;
-  build_frame(cmd, tx, tx_len);
-
-  // Flush RX and TX buffers
-  while (ser.available()) ser.read();
-  ser.write(tx, tx_len);
-  ser.flush();
-
-  // Wait for response up to 1000ms
-  uint8_t rx[512];
-  size_t rx_len = read_until_cr(ser, rx, sizeof(rx), 1000);
-  if (rx_len == 0) {
-    Serial.printf("[INV] No response for cmd '%s'\n", cmd.c_str());
-    return false;
+  for (size_t off = 0; off < rx_len; off += 32) {
+    char hex[32 * 3 + 1];
+    size_t n = 0;
+    for (size_t i = off; i < rx_len && i < off + 32; ++i) n += snprintf(hex + n, sizeof(hex) - n, "%02X ", rx[i]);
+    LOGD(LOG_MOD_INV, "RX (hex) +%u: %s", (unsigned)off, hex);
   }
+}
 
-  // Response should end with CR
-  if (rx[rx_len - 1] != 0x0D) {
-    Serial.printf("[INV] Incomplete response for cmd '%s' (no CR)\n", cmd.c_str());
-    return false;
-  }
+// Per-command bookkeeping: expected response length drives the timeout
+// Request frames are precomputed at compile time (see inverter_crc.h)
+struct InverterCmdDef {
+  const char* name;
+  const uint8_t* frame;
+  size_t frame_len;
+  size_t expected_rx_len; // full response incl. '(' CRC CR
+};
+
+#define INV_FRAME(f) inv_frames::f.data(), inv_frames::f.size
+
+static constexpr InverterCmdDef g_cmd_defs[INV_CMD_COUNT] = {
+  { "QMOD",  INV_FRAME(QMOD),  5 },   // (M<CRC><CR>
+  { "QPIGS", INV_FRAME(QPIGS), 110 }, // (BBB.B CC.C ... b10b9b8<CRC><CR>
+  { "QPIWS", INV_FRAME(QPIWS), 40 },  // (a0..a35<CRC><CR>
+  { "QFLAG", INV_FRAME(QFLAG), 16 },  // (ExxxDxxx<CRC><CR>
+  { "QPIRI", INV_FRAME(QPIRI), 102 }, // (BBB.B CC.C ... VV.V W X<CRC><CR>
+  { "QDI",   INV_FRAME(QDI),   84 },  // (BBB.B CC.C 00DD ... Z<CRC><CR>
+  { "QVFW",  INV_FRAME(QVFW),  18 },  // (VERFW:00123.45<CRC><CR>
+  { "QPGS",  INV_FRAME(QPGS0), 133 }, // (A BBBBBBBBBBBBBB C DD ... XX YYY<CRC><CR>
+};
+
+// QPGSn request per unit index (g_cmd_defs holds QPGS0)
+struct InverterFrameRef {
+  const uint8_t* frame;
+  size_t frame_len;
+};
+static constexpr InverterFrameRef QPGS_FRAMES[INVERTER_MAX_UNITS] = {
+  { INV_FRAME(QPGS0) }, { INV_FRAME(QPGS1) }, { INV_FRAME(QPGS2) }, { INV_FRAME(QPGS3) },
+};
+
+
+// Schedule: QPIGS/QMOD are cadence-critical, the rest only fills slack.
+// One QPIGS+QMOD pair occupies ~650 ms of the link, leaving room for the
+// longest background inquiry (QPIRI, ~500 ms) in every 1500 ms period.
+// The QPIGS period adapts at runtime (InverterLink::rate); QMOD follows it
+// but never faster than POLL_DEFAULT_MS. QPGS probes for parallel units in
+// the background; once units answer it moves up to priority 1 with a
+// deadline of one QPIGS period and that period split across the units, so
+// every unit is read once per QPIGS period. It stays out of the critical
+// class: a ~620 ms QPGS released just before QPIGS would push QPIGS past
+// its 250 ms deadline on every cycle.
+// Each link gets a copy; est_ms is seeded from its UART timeout in
+// inverter_comm_init().
+#define SCHED_IDX_QPIGS 0
+#define SCHED_IDX_QMOD  1
+#define SCHED_IDX_QPGS  2
+#define QPGS_PROBE_PRIORITY 2
+#define QPGS_UNIT_PRIORITY  1
+static const SchedEntry SCHEDULE[] = {
+  // cmd            period            prio deadline
+  { INV_CMD_QPIGS,  POLL_DEFAULT_MS,  0,   250u,     0 },
+  { INV_CMD_QMOD,   POLL_DEFAULT_MS,  0,   750u,     0 },
+  { INV_CMD_QPGS,  PARALLEL_PROBE_MS, QPGS_PROBE_PRIORITY, PARALLEL_PROBE_MS, 0 },
+  { INV_CMD_QPIWS,   10000u,  1,   10000u,   0 },
+  { INV_CMD_QFLAG,   60000u,  2,   60000u,   0 },
+  { INV_CMD_QPIRI,   60000u,  2,   60000u,   0 },
+  { INV_CMD_QDI,    600000u,  3,   600000u,  0 },
+  { INV_CMD_QVFW,  3600000u,  3,   3600000u, 0 },
+};
+static const size_t SCHEDULE_LEN = sizeof(SCHEDULE) / sizeof(SCHEDULE[0]);
+
+// Last good payload of the slow inquiries (QMOD/QPIGS are in the snapshot)
+struct InverterResponse {
+  char text[INVERTER_RESPONSE_MAX + 1];
+  uint32_t ts_ms;
+  bool valid;
+};
+
+// Everything one serial link owns. Each link runs its own poll task on its
+// own UART; links share nothing but the read-only tables above, so they
+// poll fully in parallel.
+struct InverterLink {
+  uint8_t dev;
+  InverterDeviceInfo info;
+  InverterUart uart;
+  // Serializes snapshot writers and guards statistics and scheduler state;
+  // readers of the snapshot never take it
+  SemaphoreHandle_t mutex;
+  SeqLock<InverterSnapshot> snapshot;
+  SchedEntry schedule[SCHEDULE_LEN];
+  InquiryScheduler sched;
+  // Adaptive QPIGS rate; only the poll task updates it, readers take the mutex
+  PollRateController rate;
+  // Parallel units: owned by the poll task, readers copy the published view.
+  // Totals also go into the snapshot (and bump its generation).
+  ParallelSystem parallel;
+  SeqLock<ParallelView> parallel_view;
+  InverterResponse responses[INV_CMD_COUNT];
+  InverterCmdStats cmd_stats[INV_CMD_COUNT];
+  Histogram cycle_hist;
+  // Setters waiting for the link; the poll task is woken on submission
+  WriteQueue writes;
+  Histogram write_hist;
+  TaskHandle_t task;
+  // RX buffer owned by the poll task; payload spans point into it until the next command
+  uint8_t rx_buf[512];
+};
+
+static InverterLink g_links[INVERTER_MAX_DEVICES];
+static uint8_t g_link_count = 0;
+static std::atomic<uint32_t> g_live_clients{0};
+
+static InverterLink* link_at(uint8_t dev) {
+  return dev < g_link_count ? &g_links[dev] : nullptr;
+}
 
-  // Print raw response immediately for debugging (before CRC check)
-  // debug_print_rx(rx, rx_len);
+static void link_lock(InverterLink& link) {
+  if (link.mutex) xSemaphoreTake(link.mutex, portMAX_DELAY);
+}
 
-  // body without CR
-  size_t body_len = rx_len - 1;
-  if (body_len < 3) {
-    Serial.printf("[INV] Response too short for cmd '%s'\n", cmd.c_str());
-    return false; // at least '(' + CRC(2)
-  }
+static void link_unlock(InverterLink& link) {
+  if (link.mutex) xSemaphoreGive(link.mutex);
+}
+
+// Bucket bounds [ms]; a QPIGS response alone is ~460 ms at 2400 baud
+static const uint32_t RTT_BOUNDS_MS[] = { 50, 100, 200, 300, 400, 500, 600, 800, 1000, 1500, 2000 };
+static const uint32_t CYCLE_BOUNDS_MS[] = { 1000, 1250, 1400, 1500, 1600, 1750, 2000, 3000, 5000 };
+static const uint32_t WRITE_BOUNDS_MS[] = { 100, 250, 500, 750, 1000, 1500, 2000, 3000, 5000 };
+
+// Setter answer: (ACK<CRC><CR> or (NAK<CRC><CR>
+#define WRITE_RX_LEN 7
+
+static void record_rtt(InverterCmdStats& st, uint32_t rtt_ms) {
+  st.rtt_last_ms = rtt_ms;
+  if (st.ok == 0 || rtt_ms < st.rtt_min_ms) st.rtt_min_ms = rtt_ms;
+  if (rtt_ms > st.rtt_max_ms) st.rtt_max_ms = rtt_ms;
+  st.rtt_sum_ms += rtt_ms;
+  histogram_observe(&st.rtt_hist, rtt_ms);
+  st.ok++;
+}
 
-  uint8_t recv_crc_hi = rx[body_len - 2];
-  uint8_t recv_crc_lo = rx[body_len - 1];
-  // payload includes leading '('
-  size_t payload_len = body_len - 2;
-
-  uint16_t calc = crc16_xmodem(rx, payload_len);
-  uint8_t calc_hi = (calc >> 8) & 0xFF;
-  uint8_t calc_lo = calc & 0xFF;
-  adjust_crc_bytes(calc_hi, calc_lo);
-  bool crc_ok = (recv_crc_hi == calc_hi) && (recv_crc_lo == calc_lo);
-
-  if (!crc_ok) {
-    Serial.printf("[INV] CRC MISMATCH for cmd '%s' - recv: %02X %02X calc: %02X %02X\n",
-      cmd.c_str(), recv_crc_hi, recv_crc_lo, calc_hi, calc_lo);
-    // Print raw response (single helper)
-    debug_print_rx(rx, rx_len);
+// Send command and stream the response through the frame parser.
+// Returns payload span (inside '('.. ) on success; CRC is verified as bytes arrive.
+// `frame` overrides the command's default request frame (QPGSn).
+static bool send_command_and_get_payload(InverterLink& link, InverterCmdId id, const char** out_payload, size_t* out_len,
+                                         const InverterFrameRef* frame = nullptr) {
+  const InverterCmdDef& def = g_cmd_defs[id];
+  FrameParser parser;
+  uint32_t rtt_ms = 0;
+  FrameStatus fs = inverter_uart_transact(&link.uart, frame ? frame->frame : def.frame,
+                                          frame ? frame->frame_len : def.frame_len, def.expected_rx_len,
+                                          parser, link.rx_buf, sizeof(link.rx_buf), &rtt_ms);
+
+  link_lock(link);
+  InverterCmdStats& stats = link.cmd_stats[id];
+  stats.sent++;
+  switch (fs) {
+  case FrameStatus::Complete:  record_rtt(stats, rtt_ms); break;
+  case FrameStatus::InProgress: stats.timeouts++; break;
+  case FrameStatus::CrcError:  stats.crc_errors++; break;
+  case FrameStatus::Nak:       stats.naks++; break;
+  default:                     stats.malformed++; break;
+  }
+  link_unlock(link);
+
+  const unsigned dev = link.dev;
+  switch (fs) {
+  case FrameStatus::Complete:
+    break;
+  case FrameStatus::InProgress:
+    if (parser.length() == 0) {
+      LOGW(LOG_MOD_INV, "inv%u: No response for cmd '%s' (%ums)", dev, def.name, (unsigned)rtt_ms);
+    } else {
+      LOGW(LOG_MOD_INV, "inv%u: Incomplete response for cmd '%s' (%u bytes, no CR)", dev, def.name, (unsigned)parser.length());
+    }
+    return false;
+  case FrameStatus::CrcError:
+    LOGW(LOG_MOD_INV, "inv%u: CRC MISMATCH for cmd '%s' - recv: %02X %02X calc: %02X %02X",
+      dev, def.name, parser.recv_crc_hi(), parser.recv_crc_lo(), parser.calc_crc_hi(), parser.calc_crc_lo());
+    debug_print_rx(link.rx_buf, parser.length());
     return false; // do not process further when CRC fails
+  case FrameStatus::Nak:
+    LOGW(LOG_MOD_INV, "inv%u: NAK for cmd '%s'", dev, def.name);
+    return false;
+  case FrameStatus::Overflow:
+    LOGW(LOG_MOD_INV, "inv%u: Response overflow for cmd '%s'", dev, def.name);
+    return false;
+  default:
+    LOGW(LOG_MOD_INV, "inv%u: Malformed response for cmd '%s'", dev, def.name);
+    return false;
   }
 
-  // Validate leading '('
-  if (rx[0] != 0x28) return false; // '('
-
-  out_payload = String((const char*)(rx + 1), payload_len - 1);
+  *out_payload = (const char*)parser.payload();
+  *out_len = parser.payload_length();
   return true;
 }
 
-// Parse QMOD payload (first char is code)
-static void parse_qmod_payload(const String& p) {
-  char code = p.length() ? p.charAt(0) : '\0';
-  const char* names[] = { "Power On","Standby","Line","Battery","Fault","Power saving","Unknown" };
-  const char map[] = { 'P','S','L','B','F','H','?' };
-  const char* name = "Unknown";
-  for (size_t i = 0; i < sizeof(map); ++i) {
-    if (map[i] == code) { name = names[i]; break; }
+// Publish the poll cycle result: status, mode and validity in one update
+static void publish_poll_result(InverterLink& link, const InverterState& status, char mode_code, const char* mode_name,
+                                bool valid) {
+  link_lock(link);
+  link.snapshot.update([&](InverterSnapshot& snap) {
+    snap.status = status;
+    snap.mode_code = mode_code;
+    snap.mode_name = mode_name;
+    snap.valid = valid;
+    snap.generation++;
+  });
+  link_unlock(link);
+}
+
+// Log status and mode as one line per sample with the chosen poll interval
+static void print_status_and_mode_snapshot(InverterLink& link, uint32_t period_ms, PollReason reason) {
+  if (!log_enabled(LOG_MOD_INV, LOG_INFO)) return;
+  InverterSnapshot snap;
+  link.snapshot.read(&snap);
+  const InverterState& s = snap.status;
+
+  if (!snap.valid) {
+    LOGI(LOG_MOD_INV, "inv%u snapshot: read failed, no data available (next in %ums)", (unsigned)link.dev, (unsigned)period_ms);
+    return;
   }
+  LOGI(LOG_MOD_INV, "inv%u snapshot: mode %c grid %.1fV/%.1fHz out %.1fV/%.1fHz %dVA %dW %d%% bus %.0fV "
+    "batt %.2fV +%.0fA -%.0fA %d%% pv %.1fV %.1fA %dW hs %.0fC st %02X/%02X next %ums (%s)",
+    (unsigned)link.dev, snap.mode_code ? snap.mode_code : '?', s.grid_voltage, s.grid_frequency, s.ac_out_voltage,
+    s.ac_out_frequency, s.ac_apparent_va, s.ac_active_w, s.load_percent, s.bus_voltage, s.batt_voltage,
+    s.batt_charge_current, s.batt_discharge_current, s.batt_soc, s.pv_input_voltage, s.pv_input_current,
+    s.pv_charging_power, s.heatsink_temp, s.device_status_bits, s.additional_status_bits,
+    (unsigned)period_ms, PollRateController::reason_name(reason));
+}
 
-  if (g_inv_mutex) xSemaphoreTake(g_inv_mutex, portMAX_DELAY);
-  g_inverter_mode_code = code;
-  strncpy(g_inverter_mode_name, name, sizeof(g_inverter_mode_name) - 1);
-  g_inverter_mode_name[sizeof(g_inverter_mode_name) - 1] = '\0';
-  if (g_inv_mutex) xSemaphoreGive(g_inv_mutex);
-}
-
-// Parse QPIGS payload tokens and update g_inverter_status
-static void parse_qpigs_payload(const String& p) {
-  // Tokens separated by a single space
-  const int MAX_TOK = 64;
-  String toks[MAX_TOK];
-  int tcount = 0;
-  int start = 0;
-  for (int i = 0; i <= (int)p.length() && tcount < MAX_TOK; ++i) {
-    if (i == (int)p.length() || p.charAt(i) == ' ') {
-      if (i - start > 0) {
-        toks[tcount++] = p.substring(start, i);
-      }
-      start = i + 1;
-    }
+static void store_response(InverterLink& link, InverterCmdId id, const char* payload, size_t len) {
+  InverterResponse& r = link.responses[id];
+  if (len > INVERTER_RESPONSE_MAX) len = INVERTER_RESPONSE_MAX;
+  link_lock(link);
+  memcpy(r.text, payload, len);
+  r.text[len] = '\0';
+  r.ts_ms = millis();
+  r.valid = true;
+  link_unlock(link);
+}
+
+static bool same_totals(const ParallelTotals& a, const ParallelTotals& b) {
+  return a.units == b.units && a.present == b.present && a.faulted == b.faulted &&
+         a.ac_apparent_va == b.ac_apparent_va && a.ac_active_w == b.ac_active_w &&
+         a.batt_charge_current == b.batt_charge_current && a.batt_discharge_current == b.batt_discharge_current &&
+         a.pv_input_current == b.pv_input_current;
+}
+
+// Publish the parallel view and its totals (called by the poll task only).
+// Every QPGS answer changes the view (unit timestamps); the snapshot and its
+// generation only move when the totals do.
+static void publish_parallel(InverterLink& link) {
+  const ParallelView& v = link.parallel.view();
+  link_lock(link);
+  link.parallel_view.update([&](ParallelView& out) { out = v; });
+  InverterSnapshot cur;
+  link.snapshot.read(&cur);
+  if (!same_totals(cur.parallel, v.total)) {
+    link.snapshot.update([&](InverterSnapshot& snap) {
+      snap.parallel = v.total;
+      snap.generation++;
+    });
   }
+  link_unlock(link);
+}
 
-  // Expect a complete set of items (indexes 0..20 => 21 tokens)
-  const int EXPECTED_TOKENS = 21;
-  bool valid_data = (tcount >= EXPECTED_TOKENS);
-
-  InverterState s = { 0 };
-  if (valid_data) {
-    // Full set received -> fill values and mark data as valid
-    s.ts_ms = millis();
-
-    s.grid_voltage = toks[0].toFloat();
-    s.grid_frequency = toks[1].toFloat();
-    s.ac_out_voltage = toks[2].toFloat();
-    s.ac_out_frequency = toks[3].toFloat();
-    s.ac_apparent_va = toks[4].toInt();
-    s.ac_active_w = toks[5].toInt();
-    s.load_percent = toks[6].toInt();
-    s.bus_voltage = toks[7].toFloat();
-    s.batt_voltage = toks[8].toFloat();
-    s.batt_charge_current = toks[9].toFloat();
-    s.batt_soc = toks[10].toInt();
-    s.heatsink_temp = toks[11].toFloat();
-    s.pv_input_current = toks[12].toFloat();
-    s.pv_input_voltage = toks[13].toFloat();
-    s.batt_voltage_from_scc = toks[14].toFloat();
-    s.batt_discharge_current = toks[15].toFloat();
-    s.device_status_bits = (uint8_t)(toks[16].toInt() & 0xFF);
-    s.batt_fan_offset_10mv = toks[17].toInt();
-    s.eeprom_version = toks[18].toInt();
-    s.pv_charging_power = toks[19].toInt();
-    s.additional_status_bits = (uint8_t)(toks[20].toInt() & 0xFF);
+// Apply a QPIGS period: QMOD follows it, QPGS splits it across the known
+// units (or probes in the background). Caller holds the link mutex.
+static void tune_schedule(InverterLink& link, uint32_t period, uint32_t now_ms) {
+  link.sched.set_period(SCHED_IDX_QPIGS, period, now_ms);
+  link.sched.set_period(SCHED_IDX_QMOD, period < POLL_DEFAULT_MS ? POLL_DEFAULT_MS : period, now_ms);
+  uint8_t units = link.parallel.count();
+  if (units) {
+    link.sched.set_priority(SCHED_IDX_QPGS, QPGS_UNIT_PRIORITY, period);
+    link.sched.set_period(SCHED_IDX_QPGS, period / units, now_ms);
+  } else {
+    link.sched.set_priority(SCHED_IDX_QPGS, QPGS_PROBE_PRIORITY, PARALLEL_PROBE_MS);
+    link.sched.set_period(SCHED_IDX_QPGS, PARALLEL_PROBE_MS, now_ms);
   }
+}
 
-  if (g_inv_mutex) xSemaphoreTake(g_inv_mutex, portMAX_DELAY);
-  g_inverter_status = s;
-  // If we parsed a full set, consider data valid; otherwise remains as previously set
-  g_inverter_data_valid = valid_data;
-  if (g_inv_mutex) xSemaphoreGive(g_inv_mutex);
+// Pick the next QPIGS period from the new sample. The floor is the measured
+// time of one QPIGS+QMOD pair, i.e. the fastest the link can sustain. With
+// parallel units it also holds one QPGS per unit plus room for the longest
+// background inquiry, otherwise the unit polls would take all the slack
+// and QPIRI/QDI would never run.
+static void adapt_poll_rate(InverterLink& link, const InverterState& status, uint32_t now_ms) {
+  link_lock(link);
+  uint32_t min_ms = link.sched.stats(SCHED_IDX_QPIGS).est_ms + link.sched.stats(SCHED_IDX_QMOD).est_ms + 50;
+  uint8_t units = link.parallel.count();
+  if (units) {
+    uint32_t slack = 0;
+    for (size_t i = 0; i < link.sched.size(); ++i) {
+      if (i == SCHED_IDX_QPGS || SCHEDULE[i].priority == 0) continue;
+      if (link.sched.stats(i).est_ms > slack) slack = link.sched.stats(i).est_ms;
+    }
+    min_ms += units * link.sched.stats(SCHED_IDX_QPGS).est_ms + slack;
+  }
+  link.rate.set_min(min_ms);
+  tune_schedule(link, link.rate.update(status, now_ms, g_live_clients.load() > 0), now_ms);
+  link_unlock(link);
 }
 
-// Print full status and mode to Serial (thread-safe snapshot)
-static void print_status_and_mode_snapshot() {
-  InverterState s;
-  char mode_code = '\0';
-  char mode_name[32] = { 0 };
-  bool valid;
+// Handle one QPGSn answer (or its failure) for `unit`
+static void handle_qpgs(InverterLink& link, uint8_t unit, bool ok, const char* payload, size_t payload_len,
+                        uint32_t end_ms) {
+  InverterUnitState u;
+  if (ok && !inverter_parse_qpgs(payload, payload_len, &u)) {
+    LOGW(LOG_MOD_INV, "inv%u: QPGS%u payload rejected (%u bytes)", (unsigned)link.dev, (unsigned)unit, (unsigned)payload_len);
+    ok = false;
+  }
+  uint8_t units_before = link.parallel.count();
+  if (!link.parallel.apply(unit, ok ? &u : nullptr, end_ms)) return;
+  publish_parallel(link);
+  const InverterUnitState& cur = link.parallel.view().units[unit];
+  if (cur.present && link.dev == 0) history_add_unit((uint32_t)time(nullptr), unit, cur);
+  if (link.parallel.count() != units_before) {
+    LOGI(LOG_MOD_INV, "inv%u parallel: %u unit(s) (unit %u %s)", (unsigned)link.dev, (unsigned)link.parallel.count(),
+      (unsigned)unit, cur.present ? cur.serial : "gone");
+    link_lock(link);
+    tune_schedule(link, link.rate.period(), end_ms);
+    link_unlock(link);
+  }
+}
 
-  if (g_inv_mutex) xSemaphoreTake(g_inv_mutex, portMAX_DELAY);
-  s = g_inverter_status;
-  mode_code = g_inverter_mode_code;
-  strncpy(mode_name, g_inverter_mode_name, sizeof(mode_name) - 1);
-  valid = g_inverter_data_valid;
-  if (g_inv_mutex) xSemaphoreGive(g_inv_mutex);
+// Send the oldest queued setter, if any, and record its answer. Setters
+// only set values, so repeating one whose ACK got lost is harmless.
+static bool run_write(InverterLink& link) {
+  WriteJob job;
+  link_lock(link);
+  bool have = link.writes.take(&job);
+  link_unlock(link);
+  if (!have) return false;
+
+  uint8_t tx[WRITE_CMD_MAX + 3];
+  size_t tx_len = inverter_build_frame(job.cmd, strlen(job.cmd), tx);
+  FrameParser parser;
+  uint32_t rtt_ms = 0;
+  uint32_t start_ms = millis();
+  FrameStatus fs = inverter_uart_transact(&link.uart, tx, tx_len, WRITE_RX_LEN, parser, link.rx_buf,
+                                          sizeof(link.rx_buf), &rtt_ms);
+  uint32_t end_ms = millis();
+  WriteResult r = WRITE_RESULT_NO_ANSWER;
+  if (fs == FrameStatus::Nak) {
+    r = WRITE_RESULT_NAK;
+  } else if (fs == FrameStatus::Complete && parser.payload_length() == 3 &&
+             memcmp(parser.payload(), "ACK", 3) == 0) {
+    r = WRITE_RESULT_ACK;
+  }
 
-  Serial.println("--- Inverter Status Snapshot ---");
-  if (!valid) {
-    Serial.println("Read failed, no data available");
+  link_lock(link);
+  link.sched.note_busy(start_ms, end_ms);
+  WriteState st = link.writes.complete(job.id, r, end_ms);
+  if (inverter_write_final(st)) histogram_observe(&link.write_hist, end_ms - job.submit_ms);
+  link_unlock(link);
+
+  const unsigned dev = link.dev;
+  if (st == WRITE_ACK) {
+    LOGI(LOG_MOD_INV, "inv%u: %s ACK (#%u, %ums after submit)", dev, job.cmd, (unsigned)job.id,
+      (unsigned)(end_ms - job.submit_ms));
+  } else if (st == WRITE_QUEUED) {
+    LOGW(LOG_MOD_INV, "inv%u: %s no answer (attempt %u), retrying", dev, job.cmd, (unsigned)job.attempts);
   } else {
-    Serial.printf("Mode: %c (%s)\n", mode_code ? mode_code : '?', mode_name);
-    Serial.printf("Grid V: %.2f V, Grid F: %.2f Hz\n", s.grid_voltage, s.grid_frequency);
-    Serial.printf("AC Out V: %.2f V, AC Out F: %.2f Hz\n", s.ac_out_voltage, s.ac_out_frequency);
-    Serial.printf("Apparent VA: %d VA, Active W: %d W, Load %%: %d\n", s.ac_apparent_va, s.ac_active_w, s.load_percent);
-    Serial.printf("BUS V: %.2f V, Batt V: %.2f V, Batt Charge I: %.2f A, Batt SOC: %d %%\n", s.bus_voltage, s.batt_voltage, s.batt_charge_current, s.batt_soc);
-    Serial.printf("Heatsink: %.2f C, PV I: %.2f A, PV V: %.2f V\n", s.heatsink_temp, s.pv_input_current, s.pv_input_voltage);
-    Serial.printf("Batt V from SCC: %.2f V, Batt Disch I: %.2f A\n", s.batt_voltage_from_scc, s.batt_discharge_current);
-    Serial.printf("Device status bits: 0x%02X, Additional status bits: 0x%02X\n", s.device_status_bits, s.additional_status_bits);
-    Serial.printf("Batt fan offset: %d (10mV), EEPROM ver: %d, PV charging power: %d W\n", s.batt_fan_offset_10mv, s.eeprom_version, s.pv_charging_power);
-    Serial.printf("Timestamp: %u ms\n", (unsigned)s.ts_ms);
+    LOGW(LOG_MOD_INV, "inv%u: %s %s (#%u)", dev, job.cmd, inverter_write_state_name(st), (unsigned)job.id);
   }
-  Serial.println("---------------------------------");
+  return true;
 }
 
-// Background task that queries QMOD and QPIGS periodically
+// Poll task, one per link: runs queued setters first, then inquiry commands
+// as the scheduler releases them. The snapshot is published after every QPIGS with the latest QMOD mode.
+// Only device 0 feeds the history (the RAM rings and flash store hold one
+// series).
 static void inverter_task(void* arg) {
-  (void)arg;
+  InverterLink& link = *(InverterLink*)arg;
+  // Working copy of the latest results
+  InverterState status = {};
+  char mode_code = '\0';
+  const char* mode_name = "Unknown";
+  uint32_t last_update_ms = 0;
   for (;;) {
-    // Query inverter
-    // QMOD
-    String payload;
-    bool failed = false;
-    if (send_command_and_get_payload("QMOD", payload)) {
-      parse_qmod_payload(payload);
-    } else {
-      failed = true;
+    if (run_write(link)) continue;
+    uint32_t wait_ms = 0;
+    link_lock(link);
+    int idx = link.sched.next(millis(), &wait_ms);
+    link_unlock(link);
+    if (idx < 0) {
+      // inverter_write_submit() ends the wait early
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait_ms));
+      continue;
     }
 
-    // QPIGS
-    payload = String();
-    if (send_command_and_get_payload("QPIGS", payload)) {
-      parse_qpigs_payload(payload);
-    } else {
-      failed = true;
-    }
-    
-    if (failed) {
-      // On any failure, mark data as invalid
-      if (g_inv_mutex) xSemaphoreTake(g_inv_mutex, portMAX_DELAY);
-      g_inverter_data_valid = false;
-      if (g_inv_mutex) xSemaphoreGive(g_inv_mutex);
-    }
+    InverterCmdId id = (InverterCmdId)link.schedule[idx].cmd;
+    const char* payload = nullptr;
+    size_t payload_len = 0;
+    uint32_t start_ms = millis();
+    uint8_t unit = (id == INV_CMD_QPGS) ? link.parallel.next_unit(start_ms) : 0;
+    bool ok = send_command_and_get_payload(link, id, &payload, &payload_len,
+                                           id == INV_CMD_QPGS ? &QPGS_FRAMES[unit] : nullptr);
+    uint32_t end_ms = millis();
+    link_lock(link);
+    link.sched.complete(idx, start_ms, end_ms);
+    link_unlock(link);
+
+    switch (id) {
+    case INV_CMD_QMOD:
+      if (ok) mode_code = inverter_parse_qmod(payload, payload_len, &mode_name);
+      break;
+
+    case INV_CMD_QPIGS:
+      if (ok && !inverter_parse_qpigs(payload, payload_len, &status)) {
+        LOGW(LOG_MOD_INV, "inv%u: QPIGS payload rejected (%u bytes)", (unsigned)link.dev, (unsigned)payload_len);
+        ok = false;
+      }
+      if (ok) status.ts_ms = end_ms;
+      // On failure, mark data as invalid
+      publish_poll_result(link, status, mode_code, mode_name, ok);
+      if (last_update_ms) {
+        link_lock(link);
+        histogram_observe(&link.cycle_hist, end_ms - last_update_ms);
+        link_unlock(link);
+      }
+      last_update_ms = end_ms;
+      if (ok) {
+        if (link.dev == 0) {
+          InverterSnapshot snap;
+          link.snapshot.read(&snap);
+          history_add((uint32_t)time(nullptr), status, snap.temp_h, snap.temp_l);
+        }
+        adapt_poll_rate(link, status, end_ms);
+      }
+      print_status_and_mode_snapshot(link, link.rate.period(), link.rate.reason());
+      break;
 
-    // Print snapshot after each poll cycle
-    print_status_and_mode_snapshot();
+    case INV_CMD_QPGS:
+      handle_qpgs(link, unit, ok, payload, payload_len, end_ms);
+      break;
 
-    vTaskDelay(pdMS_TO_TICKS(INVERTER_POLL_INTERVAL_MS));
+    default:
+      if (ok) store_response(link, id, payload, payload_len);
+      break;
+    }
   }
 }
 
-void inverter_comm_init() {
-  if (!g_inv_mutex) {
-    g_inv_mutex = xSemaphoreCreateMutex();
+// UART and pins per device (see config.h)
+static const InverterDeviceInfo DEVICES[] = {
+  { INVERTER_UART_NUM, INVERTER_RX_PIN, INVERTER_TX_PIN, INVERTER_BAUD },
+#if INVERTER_LINK_COUNT > 1
+  { INVERTER2_UART_NUM, INVERTER2_RX_PIN, INVERTER2_TX_PIN, INVERTER_BAUD },
+#endif
+};
+static_assert(sizeof(DEVICES) / sizeof(DEVICES[0]) <= INVERTER_MAX_DEVICES, "too many inverter links");
+
+static void link_init(InverterLink& link, uint8_t dev, const InverterDeviceInfo& info) {
+  link.dev = dev;
+  link.info = info;
+  link.mutex = xSemaphoreCreateMutex();
+  // Generation 1 counts this update too, so it stays equal to sequence() / 2
+  link.snapshot.update([](InverterSnapshot& snap) {
+    snap = InverterSnapshot{ {}, '\0', "Unknown", false, NAN, NAN, {}, 1 };
+  });
+  for (auto& st : link.cmd_stats) {
+    st = InverterCmdStats{};
+    histogram_init(&st.rtt_hist, RTT_BOUNDS_MS, sizeof(RTT_BOUNDS_MS) / sizeof(RTT_BOUNDS_MS[0]), 1000);
+  }
+  histogram_init(&link.cycle_hist, CYCLE_BOUNDS_MS, sizeof(CYCLE_BOUNDS_MS) / sizeof(CYCLE_BOUNDS_MS[0]), 1000);
+  histogram_init(&link.write_hist, WRITE_BOUNDS_MS, sizeof(WRITE_BOUNDS_MS) / sizeof(WRITE_BOUNDS_MS[0]), 1000);
+  // Initialize UART for RS232 via MAX3232 at 2400 8N1 (event-driven driver)
+  if (!inverter_uart_begin(&link.uart, info.uart_num, info.rx_pin, info.tx_pin, info.baud)) {
+    LOGE(LOG_MOD_INV, "inv%u: UART%d not available, device not polled", (unsigned)dev, info.uart_num);
+    return;
   }
-  // Initialize Serial1 for RS232 via MAX3232 at 2400 8N1
-  Serial1.begin(2400, SERIAL_8N1, INVERTER_RX_PIN, INVERTER_TX_PIN);
+  for (size_t i = 0; i < SCHEDULE_LEN; ++i) {
+    link.schedule[i] = SCHEDULE[i];
+    const InverterCmdDef& def = g_cmd_defs[link.schedule[i].cmd];
+    link.schedule[i].est_ms = inverter_uart_timeout_ms(&link.uart, def.frame_len, def.expected_rx_len);
+  }
+  link.sched.begin(link.schedule, SCHEDULE_LEN, millis());
+  link.rate.begin(POLL_DEFAULT_MS);
 
-  // Create background task
+  char name[16];
+  snprintf(name, sizeof(name), "inverter_task%u", (unsigned)dev);
   xTaskCreatePinnedToCore(
     inverter_task,
-    "inverter_task",
+    name,
     4096,
-    NULL,
+    &link,
     1,
-    NULL,
+    &link.task,
     1);
+  LOGI(LOG_MOD_INV, "inv%u: UART%d rx %d tx %d at %u baud", (unsigned)dev, info.uart_num, info.rx_pin, info.tx_pin,
+    (unsigned)info.baud);
+}
+
+void inverter_comm_init() {
+  if (g_link_count) return;
+  history_init();
+  LOGI(LOG_MOD_HIST, "history: %u bytes RAM (%u raw / %u x 1m / %u x 15m)", (unsigned)history_ram_bytes(),
+    (unsigned)HISTORY_RAW_LEN, (unsigned)HISTORY_1M_LEN, (unsigned)HISTORY_15M_LEN);
+  // Devices are indexed before their tasks start so getters see all of them
+  g_link_count = sizeof(DEVICES) / sizeof(DEVICES[0]);
+  for (uint8_t i = 0; i < g_link_count; ++i) link_init(g_links[i], i, DEVICES[i]);
 }
 
-bool inverter_get_status(InverterState* out) {
-  if (!out) return false;
-  if (g_inv_mutex) xSemaphoreTake(g_inv_mutex, portMAX_DELAY);
-  *out = g_inverter_status;
-  if (g_inv_mutex) xSemaphoreGive(g_inv_mutex);
+uint8_t inverter_device_count() {
+  return g_link_count;
+}
+
+bool inverter_get_device_info(uint8_t dev, InverterDeviceInfo* out) {
+  InverterLink* link = link_at(dev);
+  if (!link || !out) return false;
+  *out = link->info;
   return true;
 }
 
-bool inverter_get_mode(char* out_code, char* out_name, size_t name_cap) {
-  if (out_code) {
-    if (g_inv_mutex) xSemaphoreTake(g_inv_mutex, portMAX_DELAY);
-    *out_code = g_inverter_mode_code;
-    if (g_inv_mutex) xSemaphoreGive(g_inv_mutex);
-  }
-  if (out_name && name_cap > 0) {
-    if (g_inv_mutex) xSemaphoreTake(g_inv_mutex, portMAX_DELAY);
-    strncpy(out_name, g_inverter_mode_name, name_cap - 1);
-    out_name[name_cap - 1] = '\0';
-    if (g_inv_mutex) xSemaphoreGive(g_inv_mutex);
+void inverter_get_snapshot(InverterSnapshot* out, uint8_t dev) {
+  InverterLink* link = link_at(dev);
+  if (out && link) link->snapshot.read(out);
+}
+
+uint32_t inverter_snapshot_generation(uint8_t dev) {
+  InverterLink* link = link_at(dev);
+  // Every update bumps the sequence by 2 and the generation by 1
+  return link ? link->snapshot.sequence() / 2 : 0;
+}
+
+// A reading moved by less than the step, or NAN both times, is not news
+static bool temp_moved(float published, float now) {
+  if (isnan(published) || isnan(now)) return isnan(published) != isnan(now);
+  return fabsf(now - published) >= INVERTER_TEMP_PUBLISH_STEP_C;
+}
+
+void inverter_publish_temperatures(float temp_h, float temp_l) {
+  InverterLink* link = link_at(0);
+  if (!link) return;
+  link_lock(*link);
+  // The thermistor task calls every second; publishing each reading would
+  // bump the generation at 1 Hz and defeat every consumer that skips work
+  // (and the /status ETag) while it is unchanged
+  InverterSnapshot cur;
+  link->snapshot.read(&cur);
+  if (!temp_moved(cur.temp_h, temp_h) && !temp_moved(cur.temp_l, temp_l)) {
+    link_unlock(*link);
+    return;
   }
+  link->snapshot.update([&](InverterSnapshot& snap) {
+    snap.temp_h = temp_h;
+    snap.temp_l = temp_l;
+    snap.generation++;
+  });
+  link_unlock(*link);
+}
+
+bool inverter_get_cmd_stats(InverterCmdId id, InverterCmdStats* out, uint8_t dev) {
+  InverterLink* link = link_at(dev);
+  if (!out || !link || id >= INV_CMD_COUNT) return false;
+  link_lock(*link);
+  *out = link->cmd_stats[id];
+  link_unlock(*link);
   return true;
 }
+
+const char* inverter_cmd_name(InverterCmdId id) {
+  return id < INV_CMD_COUNT ? g_cmd_defs[id].name : "?";
+}
+
+void inverter_get_cycle_histogram(Histogram* out, uint8_t dev) {
+  InverterLink* link = link_at(dev);
+  if (!out || !link) return;
+  link_lock(*link);
+  *out = link->cycle_hist;
+  link_unlock(*link);
+}
+
+bool inverter_get_schedule(size_t i, SchedEntry* entry, SchedCmdStats* stats, uint8_t dev) {
+  InverterLink* link = link_at(dev);
+  if (!link || i >= link->sched.size()) return false;
+  link_lock(*link);
+  if (entry) *entry = link->sched.entry(i);
+  if (stats) *stats = link->sched.stats(i);
+  link_unlock(*link);
+  return true;
+}
+
+void inverter_get_link_stats(SchedLinkStats* out, uint8_t dev) {
+  InverterLink* link = link_at(dev);
+  if (!out || !link) return;
+  link_lock(*link);
+  *out = link->sched.link();
+  link_unlock(*link);
+}
+
+bool inverter_get_response(InverterCmdId id, char* buf, size_t cap, uint32_t* age_ms, uint8_t dev) {
+  InverterLink* link = link_at(dev);
+  if (!link || id >= INV_CMD_COUNT || !buf || cap == 0) return false;
+  link_lock(*link);
+  const InverterResponse& r = link->responses[id];
+  bool valid = r.valid;
+  if (valid) {
+    strncpy(buf, r.text, cap - 1);
+    buf[cap - 1] = '\0';
+    if (age_ms) *age_ms = millis() - r.ts_ms;
+  }
+  link_unlock(*link);
+  return valid;
+}
+
+void inverter_get_parallel(ParallelView* out, uint8_t dev) {
+  InverterLink* link = link_at(dev);
+  if (out && link) link->parallel_view.read(out);
+}
+
+void inverter_set_live_clients(uint32_t n) {
+  g_live_clients.store(n);
+}
+
+void inverter_get_poll_rate(uint32_t* period_ms, PollReason* reason, uint8_t dev) {
+  InverterLink* link = link_at(dev);
+  if (!link) return;
+  link_lock(*link);
+  if (period_ms) *period_ms = link->rate.period();
+  if (reason) *reason = link->rate.reason();
+  link_unlock(*link);
+}
+
+uint32_t inverter_write_submit(const char* cmd, uint8_t dev) {
+  InverterLink* link = link_at(dev);
+  if (!link || !link->task || !inverter_write_valid(cmd)) return 0;
+  link_lock(*link);
+  uint32_t id = link->writes.submit(cmd, millis());
+  link_unlock(*link);
+  if (id) xTaskNotifyGive(link->task);
+  return id;
+}
+
+bool inverter_write_status(uint32_t id, WriteJob* out, uint8_t dev) {
+  InverterLink* link = link_at(dev);
+  if (!link || !out) return false;
+  link_lock(*link);
+  bool found = link->writes.find(id, out);
+  link_unlock(*link);
+  return found;
+}
+
+void inverter_get_write_stats(WriteStats* stats, Histogram* latency, uint8_t dev) {
+  InverterLink* link = link_at(dev);
+  if (!link) return;
+  link_lock(*link);
+  if (stats) *stats = link->writes.stats();
+  if (latency) *latency = link->write_hist;
+  link_unlock(*link);
+}
@@ -3,48 +3,120 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 #include "config.h"
+#include "inverter_state.h"
+#include "histogram.h"
+#include "inverter_sched.h"
+#include "poll_rate.h"
+#include "parallel.h"
+#include "inverter_write.h"
 
-// Polling interval (ms) between QMOD+QPIGS cycles
-#define INVERTER_POLL_INTERVAL_MS 3000
-
-// Parsed status structure (subset of QPIGS fields)
-struct InverterState {
-  float grid_voltage;           // BBB.B  Grid voltage [V]
-  float grid_frequency;         // CC.C   Grid frequency [Hz]
-  float ac_out_voltage;         // DDD.D  AC output voltage [V]
-  float ac_out_frequency;       // EE.E   AC output frequency [Hz]
-  int   ac_apparent_va;         // FFFF   AC output apparent power [VA]
-  int   ac_active_w;            // GGGG   AC output active power [W]
-  int   load_percent;           // HHH    Output load percent [%] (max of W% or VA%)
-  float bus_voltage;            // III    BUS voltage [V]
-  float batt_voltage;           // JJ.JJ  Battery voltage [V]
-  float batt_charge_current;    // KKK    Battery charging current [A]
-  int   batt_soc;               // OOO    Battery capacity [%]
-  float heatsink_temp;          // TTTT   Inverter heat sink temperature [°C] (or NTC A/D)
-  float pv_input_current;       // EEEE   PV input current for battery [A]
-  float pv_input_voltage;       // UUU.U  PV input voltage [V]
-  float batt_voltage_from_scc;  // WW.WW  Battery voltage from SCC [V]
-  float batt_discharge_current; // PPPPP  Battery discharge current [A]
-  uint8_t device_status_bits;   // b7..b0 Device status bits (b7 SBU, b6 config changed, b5 SCC fw, b4 load status, b3 reserved, b2 charging status, b1 SCC charging, b0 AC charging)
-  int   batt_fan_offset_10mv;   // QQ     Battery voltage offset for fans on (10mV units)
-  int   eeprom_version;         // VV     EEPROM version
-  int   pv_charging_power;      // MMMMM  PV charging power [W]
-  uint8_t additional_status_bits;// b10..b8 Additional status bits (b10 charging to float flag, b9 Switch On, b8 reserved)
-  uint32_t ts_ms;               // timestamp (millis) when these values were last updated
+// Inquiry commands polled by the background task (periods and priorities
+// are in the schedule table in inverter_comm.cpp, see inverter_sched.h)
+enum InverterCmdId : uint8_t {
+  INV_CMD_QMOD = 0,
+  INV_CMD_QPIGS,
+  INV_CMD_QPIWS,   // warning status
+  INV_CMD_QFLAG,   // enabled/disabled flags
+  INV_CMD_QPIRI,   // rated information
+  INV_CMD_QDI,     // default settings
+  INV_CMD_QVFW,    // main CPU firmware version
+  INV_CMD_QPGS,    // parallel unit n (round-robin over the units, see parallel.h)
+  INV_CMD_COUNT
 };
 
-// Global variables (updated by background task)
-extern InverterState g_inverter_status;
-// Global validity flag for inverter data (demo mode always true)
-extern bool g_inverter_data_valid;
-extern float g_temp_h;
-extern float g_temp_l;
-extern char g_inverter_mode_code; // single-letter mode code from QMOD
-extern char g_inverter_mode_name[32];
+// Inverters on separate UARTs, one poll task each (see config.h). Devices are
+// addressed by index; device 0 is the primary inverter (history, LCD, SSE).
+#define INVERTER_MAX_DEVICES 2
 
-// Initialize inverter communication and start background polling task
+struct InverterDeviceInfo {
+  int uart_num;
+  int rx_pin;
+  int tx_pin;
+  uint32_t baud;
+};
+
+// Longest stored raw response payload (QPIRI/QDI are ~95 characters)
+#define INVERTER_RESPONSE_MAX 112
+
+// Per-command link statistics (RTT from TX start to CR of the response)
+struct InverterCmdStats {
+  uint32_t sent;
+  uint32_t ok;
+  uint32_t timeouts;     // no response or no CR before the deadline
+  uint32_t crc_errors;
+  uint32_t naks;
+  uint32_t malformed;    // bad start byte, too short or overflow
+  uint32_t rtt_last_ms;
+  uint32_t rtt_min_ms;
+  uint32_t rtt_max_ms;
+  uint64_t rtt_sum_ms;   // divide by `ok` for the mean
+  Histogram rtt_hist;    // RTT of successful transactions [ms]
+};
+
+// Versioned record published by the poll task (and the temperature task).
+// Readers get a consistent copy without taking a lock (seqlock), so they never
+// block the poll task and never see status from one cycle and mode from another.
+struct InverterSnapshot {
+  InverterState status;
+  char mode_code;            // single-letter mode code from QMOD
+  const char* mode_name;     // static string, never null
+  bool valid;                // last poll cycle succeeded
+  float temp_h;              // thermistor temperatures [°C], NAN if invalid
+  float temp_l;
+  ParallelTotals parallel;   // sums over parallel units; parallel.units == 0 on a single unit
+  uint32_t generation;       // incremented on every publish (status, mode, parallel totals, temperature step)
+};
+
+// Initialize inverter communication and start one polling task per device
 void inverter_comm_init();
 
-// Access functions that copy protected data (thread-safe)
-bool inverter_get_status(InverterState* out);
-bool inverter_get_mode(char* out_code, char* out_name, size_t name_cap);
+// Configured devices and their UART/pins
+uint8_t inverter_device_count();
+bool inverter_get_device_info(uint8_t dev, InverterDeviceInfo* out);
+
+// Getters below take the device index last (default 0). An index past
+// inverter_device_count() leaves the output untouched (or returns false).
+
+// Lock-free consistent copy of the latest snapshot (callable from any task)
+void inverter_get_snapshot(InverterSnapshot* out, uint8_t dev = 0);
+// Current generation; compare with a stored value to skip work when unchanged
+uint32_t inverter_snapshot_generation(uint8_t dev = 0);
+// Publish thermistor temperatures into the snapshot of device 0. Only a
+// change of at least INVERTER_TEMP_PUBLISH_STEP_C (or to/from NAN) on either
+// channel is published, so the generation follows inverter data, not the
+// 1 s thermistor cadence. The LCD reads the thermistors directly.
+#define INVERTER_TEMP_PUBLISH_STEP_C 0.5f
+void inverter_publish_temperatures(float temp_h, float temp_l);
+
+// Copy link statistics for one command (thread-safe)
+bool inverter_get_cmd_stats(InverterCmdId id, InverterCmdStats* out, uint8_t dev = 0);
+const char* inverter_cmd_name(InverterCmdId id);
+// Copy the histogram of intervals between QPIGS status updates [ms]
+void inverter_get_cycle_histogram(Histogram* out, uint8_t dev = 0);
+
+// Schedule entry i (0..count-1) with its statistics; false past the end
+bool inverter_get_schedule(size_t i, SchedEntry* entry, SchedCmdStats* stats, uint8_t dev = 0);
+void inverter_get_link_stats(SchedLinkStats* out, uint8_t dev = 0);
+
+// Last good response payload of a command (NUL-terminated, without '(' and
+// CRC). Returns false if none was received yet; age_ms is time since then.
+bool inverter_get_response(InverterCmdId id, char* buf, size_t cap, uint32_t* age_ms, uint8_t dev = 0);
+
+// Lock-free copy of the per-unit parallel view (units 0..total.units-1)
+void inverter_get_parallel(ParallelView* out, uint8_t dev = 0);
+
+// Number of live subscribers (SSE); while non-zero QPIGS is polled at
+// POLL_LIVE_MS or faster (see poll_rate.h). Callable from any task.
+void inverter_set_live_clients(uint32_t n);
+// Current adaptive QPIGS period and why it was chosen
+void inverter_get_poll_rate(uint32_t* period_ms, PollReason* reason, uint8_t dev = 0);
+
+// ---- Setter commands (see inverter_write.h) ----
+// Queue cmd for the device's poll task, ahead of every inquiry. Returns the
+// ticket, or 0 if cmd is not an allowed setter, dev is unknown or the queue
+// is full. Callable from any task; never waits for the link.
+uint32_t inverter_write_submit(const char* cmd, uint8_t dev = 0);
+// Current state of a ticket; false once its slot was reused (or unknown)
+bool inverter_write_status(uint32_t id, WriteJob* out, uint8_t dev = 0);
+// Queue counters and the submission-to-answer latency histogram [ms]
+void inverter_get_write_stats(WriteStats* stats, Histogram* latency, uint8_t dev = 0);
@@ -0,0 +1,112 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// CRC-16/XMODEM (poly 0x1021, init 0x0000, no reflection, no xorout) driven by
+// a 256-entry table generated at compile time. The table lives in flash
+// (.rodata); one lookup per byte keeps the streaming receive path cheap.
+// Slicing-by-N does not pay off here: frames are <=110 bytes and arrive one
+// byte at a time at 2400 baud, so only the single-byte update is used.
+
+struct Crc16Table {
+  uint16_t v[256];
+};
+
+constexpr Crc16Table make_crc16_xmodem_table() {
+  Crc16Table t = {};
+  for (int i = 0; i < 256; ++i) {
+    uint16_t crc = (uint16_t)(i << 8);
+    for (int b = 0; b < 8; ++b) {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    t.v[i] = crc;
+  }
+  return t;
+}
+
+inline constexpr Crc16Table CRC16_XMODEM_TABLE = make_crc16_xmodem_table();
+
+// Incremental single-byte update; feed bytes as they stream in
+constexpr uint16_t crc16_xmodem_update(uint16_t crc, uint8_t b) {
+  return (uint16_t)((crc << 8) ^ CRC16_XMODEM_TABLE.v[((crc >> 8) ^ b) & 0xFF]);
+}
+
+constexpr uint16_t crc16_xmodem(const uint8_t* data, size_t len, uint16_t crc = 0) {
+  for (size_t i = 0; i < len; ++i) crc = crc16_xmodem_update(crc, data[i]);
+  return crc;
+}
+
+// Device increments reserved values 0x28 '(' , 0x0D CR, 0x0A LF in CRC bytes
+constexpr uint8_t adjust_crc_byte(uint8_t b) {
+  return (b == 0x28 || b == 0x0D || b == 0x0A) ? (uint8_t)(b + 1) : b;
+}
+
+// --- Request frames: <CMD><CRC_hi><CRC_lo><CR> ---
+
+template <size_t N>
+struct InverterTxFrame {
+  uint8_t bytes[N];
+  static constexpr size_t size = N;
+  constexpr const uint8_t* data() const { return bytes; }
+};
+
+// Build a frame from a string literal at compile time (N includes the '\0')
+template <size_t N>
+constexpr InverterTxFrame<N + 2> make_inverter_frame(const char (&cmd)[N]) {
+  InverterTxFrame<N + 2> f = {};
+  uint16_t crc = 0;
+  for (size_t i = 0; i + 1 < N; ++i) {
+    f.bytes[i] = (uint8_t)cmd[i];
+    crc = crc16_xmodem_update(crc, (uint8_t)cmd[i]);
+  }
+  f.bytes[N - 1] = adjust_crc_byte((uint8_t)(crc >> 8));
+  f.bytes[N + 0] = adjust_crc_byte((uint8_t)(crc & 0xFF));
+  f.bytes[N + 1] = 0x0D; // CR
+  return f;
+}
+
+// Build a frame for a runtime command (setters with parameters).
+// out must hold len + 3 bytes. Returns the frame length.
+inline size_t inverter_build_frame(const char* cmd, size_t len, uint8_t* out) {
+  uint16_t crc = 0;
+  for (size_t i = 0; i < len; ++i) {
+    out[i] = (uint8_t)cmd[i];
+    crc = crc16_xmodem_update(crc, out[i]);
+  }
+  out[len + 0] = adjust_crc_byte((uint8_t)(crc >> 8));
+  out[len + 1] = adjust_crc_byte((uint8_t)(crc & 0xFF));
+  out[len + 2] = 0x0D; // CR
+  return len + 3;
+}
+
+// Fixed inquiry commands, fully precomputed (flash resident)
+namespace inv_frames {
+inline constexpr auto QPI      = make_inverter_frame("QPI");
+inline constexpr auto QID      = make_inverter_frame("QID");
+inline constexpr auto QSID     = make_inverter_frame("QSID");
+inline constexpr auto QVFW     = make_inverter_frame("QVFW");
+inline constexpr auto QVFW2    = make_inverter_frame("QVFW2");
+inline constexpr auto QPIRI    = make_inverter_frame("QPIRI");
+inline constexpr auto QFLAG    = make_inverter_frame("QFLAG");
+inline constexpr auto QPIGS    = make_inverter_frame("QPIGS");
+inline constexpr auto QMOD     = make_inverter_frame("QMOD");
+inline constexpr auto QPIWS    = make_inverter_frame("QPIWS");
+inline constexpr auto QDI      = make_inverter_frame("QDI");
+inline constexpr auto QMCHGCR  = make_inverter_frame("QMCHGCR");
+inline constexpr auto QMUCHGCR = make_inverter_frame("QMUCHGCR");
+inline constexpr auto QBOOT    = make_inverter_frame("QBOOT");
+inline constexpr auto QOPM     = make_inverter_frame("QOPM");
+inline constexpr auto QPGS0    = make_inverter_frame("QPGS0");   // parallel unit n
+inline constexpr auto QPGS1    = make_inverter_frame("QPGS1");
+inline constexpr auto QPGS2    = make_inverter_frame("QPGS2");
+inline constexpr auto QPGS3    = make_inverter_frame("QPGS3");
+} // namespace inv_frames
+
+// Byte-for-byte checks against the bitwise reference (doc/inverterTest.py)
+static_assert(CRC16_XMODEM_TABLE.v[1] == 0x1021, "CRC table");
+static_assert(inv_frames::QPIGS.bytes[5] == 0xB7 && inv_frames::QPIGS.bytes[6] == 0xA9 &&
+              inv_frames::QPIGS.bytes[7] == 0x0D, "QPIGS frame");
+static_assert(inv_frames::QMOD.bytes[4] == 0x49 && inv_frames::QMOD.bytes[5] == 0xC1, "QMOD frame");
+static_assert(inv_frames::QPIRI.bytes[5] == 0xF8 && inv_frames::QPIRI.bytes[6] == 0x54, "QPIRI frame");
+// QBOOT CRC is 0x0A88: the LF high byte must be adjusted to 0x0B
+static_assert(inv_frames::QBOOT.bytes[5] == 0x0B && inv_frames::QBOOT.bytes[6] == 0x88, "QBOOT frame");
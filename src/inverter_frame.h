@@ -0,0 +1,82 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "inverter_crc.h"
+
+// Incremental parser for inverter response frames: '(' PAYLOAD CRC_hi CRC_lo CR
+// Bytes are fed one at a time as they arrive from the UART. The CRC is updated
+// on the fly, lagging two bytes behind the input, because the CRC bytes are only
+// known to be the CRC once the terminating CR arrives. No allocation, no copy
+// of the whole buffer at the end.
+
+enum class FrameStatus : uint8_t {
+  InProgress,   // waiting for more bytes
+  Complete,     // CR received, CRC matched
+  CrcError,     // CR received, CRC mismatch
+  Nak,          // "(NAK" received (with or without CRC)
+  Malformed,    // first byte was not '(' or frame too short
+  Overflow      // frame longer than the buffer
+};
+
+class FrameParser {
+public:
+  // buf receives every frame byte except the CR; it must outlive the parser use.
+  void reset(uint8_t* buf, size_t cap) {
+    buf_ = buf;
+    cap_ = cap;
+    len_ = 0;
+    crc_ = 0;
+    status_ = FrameStatus::InProgress;
+  }
+
+  FrameStatus feed(uint8_t b) {
+    if (status_ != FrameStatus::InProgress) return status_;
+
+    if (len_ == 0 && b != 0x28) {
+      return status_ = FrameStatus::Malformed;
+    }
+    if (b == 0x0D) {
+      return status_ = finish();
+    }
+    if (len_ >= cap_) {
+      return status_ = FrameStatus::Overflow;
+    }
+    // The byte two positions back can no longer be a CRC byte -> fold it in
+    if (len_ >= 2) crc_ = crc16_xmodem_update(crc_, buf_[len_ - 2]);
+    buf_[len_++] = b;
+    return status_;
+  }
+
+  FrameStatus status() const { return status_; }
+  // Number of bytes received so far (excluding CR)
+  size_t length() const { return len_; }
+  // Payload between '(' and the CRC; valid once status() == Complete
+  const uint8_t* payload() const { return buf_ + 1; }
+  size_t payload_length() const { return len_ >= 3 ? len_ - 3 : 0; }
+  // Raw CRC bytes received and expected (for diagnostics after CrcError)
+  uint8_t recv_crc_hi() const { return len_ >= 2 ? buf_[len_ - 2] : 0; }
+  uint8_t recv_crc_lo() const { return len_ >= 1 ? buf_[len_ - 1] : 0; }
+  uint8_t calc_crc_hi() const { return adjust_crc_byte((uint8_t)(crc_ >> 8)); }
+  uint8_t calc_crc_lo() const { return adjust_crc_byte((uint8_t)(crc_ & 0xFF)); }
+
+private:
+  FrameStatus finish() {
+    // Some devices answer "(NAK<CR>" without CRC
+    if (len_ == 4 && buf_[1] == 'N' && buf_[2] == 'A' && buf_[3] == 'K') {
+      return FrameStatus::Nak;
+    }
+    if (len_ < 3) return FrameStatus::Malformed; // at least '(' + CRC(2)
+    bool crc_ok = (recv_crc_hi() == calc_crc_hi()) && (recv_crc_lo() == calc_crc_lo());
+    if (!crc_ok) return FrameStatus::CrcError;
+    if (payload_length() == 3 && buf_[1] == 'N' && buf_[2] == 'A' && buf_[3] == 'K') {
+      return FrameStatus::Nak;
+    }
+    return FrameStatus::Complete;
+  }
+
+  uint8_t* buf_ = nullptr;
+  size_t cap_ = 0;
+  size_t len_ = 0;
+  uint16_t crc_ = 0;
+  FrameStatus status_ = FrameStatus::InProgress;
+};
@@ -0,0 +1,191 @@
+#include "inverter_parse.h"
+#include <string.h>
+
+static const int32_t POW10[] = { 1, 10, 100, 1000, 10000 };
+
+size_t inverter_tokenize(const char* p, size_t len, TokenSpan* out, size_t max_tokens) {
+  size_t count = 0;
+  size_t i = 0;
+  while (i < len && count < max_tokens) {
+    while (i < len && p[i] == ' ') ++i;
+    size_t start = i;
+    while (i < len && p[i] != ' ') ++i;
+    if (i > start) {
+      size_t n = i - start;
+      out[count].p = p + start;
+      out[count].n = (uint8_t)(n > 255 ? 255 : n);
+      ++count;
+    }
+  }
+  return count;
+}
+
+bool inverter_decode_fixed(TokenSpan t, uint8_t decimals, int32_t* out) {
+  if (t.n == 0 || decimals > 4) return false;
+  size_t i = 0;
+  bool neg = false;
+  if (t.p[0] == '-' || t.p[0] == '+') {
+    neg = (t.p[0] == '-');
+    ++i;
+  }
+  int32_t v = 0;
+  int frac = -1; // digits seen after '.', -1 = no '.' yet
+  bool any_digit = false;
+  for (; i < t.n; ++i) {
+    char c = t.p[i];
+    if (c == '.' && frac < 0) {
+      frac = 0;
+      continue;
+    }
+    if (c < '0' || c > '9') return false;
+    any_digit = true;
+    if (frac >= 0) {
+      if (frac >= decimals) continue; // truncate extra precision
+      ++frac;
+    }
+    if (v > (INT32_MAX - (c - '0')) / 10) return false; // field far wider than protocol allows
+    v = v * 10 + (c - '0');
+  }
+  if (!any_digit) return false;
+  int32_t scale = POW10[decimals - (frac > 0 ? frac : 0)];
+  if (v > INT32_MAX / scale) return false;
+  v *= scale;
+  *out = neg ? -v : v;
+  return true;
+}
+
+bool inverter_decode_bits(TokenSpan t, uint32_t* out) {
+  if (t.n == 0 || t.n > 32) return false;
+  uint32_t v = 0;
+  for (size_t i = 0; i < t.n; ++i) {
+    char c = t.p[i];
+    if (c != '0' && c != '1') return false;
+    v = (v << 1) | (uint32_t)(c - '0');
+  }
+  *out = v;
+  return true;
+}
+
+// Expect a complete set of items (indexes 0..20 => 21 tokens)
+static const size_t QPIGS_FIELDS = 21;
+
+bool inverter_parse_qpigs(const char* p, size_t len, InverterState* out) {
+  TokenSpan t[QPIGS_FIELDS];
+  if (inverter_tokenize(p, len, t, QPIGS_FIELDS) < QPIGS_FIELDS) return false;
+
+  // Scaled integers; every field is decoded before anything is written
+  int32_t v[16];
+  static const uint8_t DEC[16] = {
+    1, 1, 1, 1,  // grid V, grid Hz, AC out V, AC out Hz
+    0, 0, 0, 0,  // VA, W, load %, BUS V
+    2, 0, 0, 0,  // batt V, batt charge A, SOC, heatsink
+    1, 1, 2, 0   // PV A, PV V, SCC batt V, discharge A
+  };
+  for (int i = 0; i < 16; ++i) {
+    if (!inverter_decode_fixed(t[i], DEC[i], &v[i])) return false;
+  }
+  uint32_t dev_bits = 0, add_bits = 0;
+  int32_t fan_offset = 0, eeprom = 0, pv_power = 0;
+  if (!inverter_decode_bits(t[16], &dev_bits)) return false;
+  if (!inverter_decode_fixed(t[17], 0, &fan_offset)) return false;
+  if (!inverter_decode_fixed(t[18], 0, &eeprom)) return false;
+  if (!inverter_decode_fixed(t[19], 0, &pv_power)) return false;
+  if (!inverter_decode_bits(t[20], &add_bits)) return false;
+
+  out->grid_voltage = v[0] / 10.0f;
+  out->grid_frequency = v[1] / 10.0f;
+  out->ac_out_voltage = v[2] / 10.0f;
+  out->ac_out_frequency = v[3] / 10.0f;
+  out->ac_apparent_va = v[4];
+  out->ac_active_w = v[5];
+  out->load_percent = v[6];
+  out->bus_voltage = (float)v[7];
+  out->batt_voltage = v[8] / 100.0f;
+  out->batt_charge_current = (float)v[9];
+  out->batt_soc = v[10];
+  out->heatsink_temp = (float)v[11];
+  out->pv_input_current = v[12] / 10.0f;
+  out->pv_input_voltage = v[13] / 10.0f;
+  out->batt_voltage_from_scc = v[14] / 100.0f;
+  out->batt_discharge_current = (float)v[15];
+  out->device_status_bits = (uint8_t)(dev_bits & 0xFF);
+  out->batt_fan_offset_10mv = fan_offset;
+  out->eeprom_version = eeprom;
+  out->pv_charging_power = pv_power;
+  out->additional_status_bits = (uint8_t)(add_bits & 0x07);
+  return true;
+}
+
+// QPGSn: exist, serial, mode, 16 numbers (fault first), status bits, 7 numbers
+static const size_t QPGS_FIELDS = 27;
+
+bool inverter_parse_qpgs(const char* p, size_t len, InverterUnitState* out) {
+  TokenSpan t[QPGS_FIELDS];
+  if (inverter_tokenize(p, len, t, QPGS_FIELDS) < QPGS_FIELDS) return false;
+  if (t[0].n != 1 || (t[0].p[0] != '0' && t[0].p[0] != '1')) return false;
+  if (t[1].n >= sizeof(out->serial) || t[2].n != 1) return false;
+
+  // Tokens 3..18 and 20..26; the status bits (19) are decoded separately
+  static const uint8_t NUM_FIRST = 3;
+  static const uint8_t DEC[16] = {
+    0,           // fault code
+    1, 2, 1, 2,  // grid V, grid Hz, AC out V, AC out Hz
+    0, 0, 0, 1,  // VA, W, load %, batt V
+    0, 0, 1,     // charge A, SOC, PV V
+    0, 0, 0, 0   // total charge A, total VA, total W, total %
+  };
+  int32_t v[16];
+  for (int i = 0; i < 16; ++i) {
+    if (!inverter_decode_fixed(t[NUM_FIRST + i], DEC[i], &v[i])) return false;
+  }
+  uint32_t bits = 0;
+  if (!inverter_decode_bits(t[19], &bits)) return false;
+  int32_t tail[7];
+  for (int i = 0; i < 7; ++i) {
+    if (!inverter_decode_fixed(t[20 + i], 0, &tail[i])) return false;
+  }
+
+  out->present = t[0].p[0] == '1';
+  memcpy(out->serial, t[1].p, t[1].n);
+  out->serial[t[1].n] = '\0';
+  out->work_mode = t[2].p[0];
+  out->fault_code = (uint8_t)v[0];
+  out->grid_voltage = v[1] / 10.0f;
+  out->grid_frequency = v[2] / 100.0f;
+  out->ac_out_voltage = v[3] / 10.0f;
+  out->ac_out_frequency = v[4] / 100.0f;
+  out->ac_apparent_va = v[5];
+  out->ac_active_w = v[6];
+  out->load_percent = v[7];
+  out->batt_voltage = v[8] / 10.0f;
+  out->batt_charge_current = v[9];
+  out->batt_soc = v[10];
+  out->pv_input_voltage = v[11] / 10.0f;
+  out->total_charge_current = v[12];
+  out->total_apparent_va = v[13];
+  out->total_active_w = v[14];
+  out->total_load_percent = v[15];
+  out->status_bits = (uint8_t)(bits & 0xFF);
+  out->output_mode = (uint8_t)tail[0];
+  out->charger_priority = (uint8_t)tail[1];
+  out->max_charge_current = tail[2];
+  out->max_charge_range = tail[3];
+  out->max_ac_charge_current = tail[4];
+  out->pv_input_current = tail[5];
+  out->batt_discharge_current = tail[6];
+  return true;
+}
+
+char inverter_parse_qmod(const char* p, size_t len, const char** name) {
+  static const char* const NAMES[] = { "Power On","Standby","Line","Battery","Fault","Power saving" };
+  static const char MAP[] = { 'P','S','L','B','F','H' };
+  char code = len ? p[0] : '\0';
+  if (name) *name = "Unknown";
+  for (size_t i = 0; i < sizeof(MAP); ++i) {
+    if (MAP[i] == code) {
+      if (name) *name = NAMES[i];
+      break;
+    }
+  }
+  return code;
+}
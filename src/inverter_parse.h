@@ -0,0 +1,38 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "inverter_state.h"
+
+// Allocation-free parsers for inverter response payloads.
+// Payloads are tokenized in place (pointer/length spans into the RX buffer)
+// and numbers are decoded as fixed point, no String/strtod involved.
+// Plain C++ without Arduino dependencies so it can be built on a host.
+
+struct TokenSpan {
+  const char* p;
+  uint8_t n;
+};
+
+// Split on single/multiple spaces. Returns number of tokens written to out.
+size_t inverter_tokenize(const char* p, size_t len, TokenSpan* out, size_t max_tokens);
+
+// Decode "[-]ddd[.ddd]" scaled by 10^decimals (extra digits truncated,
+// missing ones padded). Returns false on any other character or when the
+// scaled value does not fit an int32.
+bool inverter_decode_fixed(TokenSpan t, uint8_t decimals, int32_t* out);
+
+// Decode a '0'/'1' bit string, first char is the most significant bit
+bool inverter_decode_bits(TokenSpan t, uint32_t* out);
+
+// QPIGS payload (without '(' and CRC) -> InverterState. Returns false when
+// fewer than 21 fields are present or a field is not numeric; out is then
+// left untouched. ts_ms is not set here.
+bool inverter_parse_qpigs(const char* p, size_t len, InverterState* out);
+
+// QPGSn payload -> InverterUnitState. Returns false when fewer than 27
+// fields are present or a field is malformed; out is then left untouched.
+// A unit that does not exist parses fine with present = false.
+bool inverter_parse_qpgs(const char* p, size_t len, InverterUnitState* out);
+
+// QMOD payload -> mode code; name points to a static string.
+char inverter_parse_qmod(const char* p, size_t len, const char** name);
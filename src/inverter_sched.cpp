@@ -0,0 +1,141 @@
+#include "inverter_sched.h"
+
+void InquiryScheduler::begin(const SchedEntry* entries, size_t n, uint32_t now) {
+  entries_ = entries;
+  n_ = n > SCHED_MAX_ENTRIES ? SCHED_MAX_ENTRIES : n;
+  for (size_t i = 0; i < n_; ++i) {
+    state_[i] = State{};
+    state_[i].release_ms = now;
+    state_[i].stats.est_ms = entries[i].est_ms;
+    state_[i].stats.period_ms = entries[i].period_ms;
+    state_[i].priority = entries[i].priority;
+    state_[i].deadline_ms = entries[i].deadline_ms;
+  }
+  link_ = SchedLinkStats{};
+  link_.window_ms = SCHED_UTIL_WINDOW_MS;
+  window_start_ = now;
+  window_busy_ = 0;
+}
+
+// Earliest release among critical commands that are not released yet
+bool InquiryScheduler::next_critical_release(uint32_t now, uint32_t* at) const {
+  bool found = false;
+  for (size_t i = 0; i < n_; ++i) {
+    if (state_[i].priority != 0 || due(now, state_[i].release_ms)) continue;
+    if (!found || (int32_t)(state_[i].release_ms - *at) < 0) *at = state_[i].release_ms;
+    found = true;
+  }
+  return found;
+}
+
+int InquiryScheduler::next(uint32_t now, uint32_t* wait_ms) {
+  int best_crit = -1;
+  int best_bg = -1;
+  int best_late = -1;
+  uint32_t wake = now + 1000;
+  uint32_t crit_at = 0;
+  bool crit_pending = next_critical_release(now, &crit_at);
+  for (size_t i = 0; i < n_; ++i) {
+    State& s = state_[i];
+    if (!due(now, s.release_ms)) {
+      if ((int32_t)(s.release_ms - wake) < 0) wake = s.release_ms;
+      continue;
+    }
+    uint32_t abs_deadline = s.release_ms + s.deadline_ms;
+    if (!s.miss_counted && (int32_t)(now - abs_deadline) > 0) {
+      s.stats.deadline_misses++;
+      s.miss_counted = true;
+    }
+    // A background command that does not fit before the next critical one
+    // competes separately, so it cannot hold back shorter ones that do fit
+    bool fits = !crit_pending || (int32_t)(crit_at - (now + s.stats.est_ms)) >= 0;
+    if (s.priority != 0 && !fits && !s.miss_counted) continue;
+    int& best = (s.priority == 0) ? best_crit : fits ? best_bg : best_late;
+    if (best < 0) {
+      best = (int)i;
+      continue;
+    }
+    const State& b = state_[best];
+    uint32_t b_deadline = b.release_ms + b.deadline_ms;
+    if (s.priority < b.priority || (s.priority == b.priority && (int32_t)(abs_deadline - b_deadline) < 0)) {
+      best = (int)i;
+    }
+  }
+  if (best_crit >= 0) return best_crit;
+  if (best_bg >= 0) return best_bg;
+  // Past its deadline and still not fitting: the estimate may be the
+  // pessimistic seed, so run it once and let the measurement correct it
+  if (best_late >= 0) return best_late;
+  *wait_ms = (int32_t)(wake - now) > 0 ? wake - now : 1;
+  return -1;
+}
+
+void InquiryScheduler::complete(int idx, uint32_t start_ms, uint32_t end_ms) {
+  if (idx < 0 || (size_t)idx >= n_) return;
+  State& s = state_[idx];
+  SchedCmdStats& st = s.stats;
+
+  uint32_t lateness = start_ms - s.release_ms;
+  if (lateness > st.max_lateness_ms) st.max_lateness_ms = lateness;
+  if (lateness > s.deadline_ms && !s.miss_counted) st.deadline_misses++;
+  st.runs++;
+  st.last_start_ms = start_ms;
+
+  // Estimate: the first measurement replaces the seed, then EWMA (1/4) of
+  // measured durations, never below the last one's half
+  uint32_t dur = end_ms - start_ms;
+  if (st.runs == 1) st.est_ms = dur;
+  else st.est_ms = (st.est_ms * 3 + dur + 3) / 4;
+  if (st.est_ms < dur / 2) st.est_ms = dur / 2;
+
+  // Next release keeps the phase; whole periods that already passed are dropped
+  s.release_ms += st.period_ms;
+  while (due(end_ms, s.release_ms + st.period_ms)) {
+    s.release_ms += st.period_ms;
+    st.skipped++;
+  }
+  s.miss_counted = false;
+  account(dur, end_ms);
+}
+
+void InquiryScheduler::note_busy(uint32_t start_ms, uint32_t end_ms) {
+  account(end_ms - start_ms, end_ms);
+}
+
+void InquiryScheduler::account(uint32_t dur, uint32_t end_ms) {
+  link_.busy_ms += dur;
+  window_busy_ += dur;
+  uint32_t elapsed = end_ms - window_start_;
+  if (elapsed >= SCHED_UTIL_WINDOW_MS) {
+    link_.util_permille = (uint32_t)((uint64_t)window_busy_ * 1000 / elapsed);
+    window_start_ = end_ms;
+    window_busy_ = 0;
+  }
+}
+
+void InquiryScheduler::set_period(int idx, uint32_t period_ms, uint32_t now) {
+  if (idx < 0 || (size_t)idx >= n_ || period_ms == 0) return;
+  State& s = state_[idx];
+  uint32_t old_period = s.stats.period_ms;
+  if (old_period == period_ms) return;
+  s.stats.period_ms = period_ms;
+  if (due(now, s.release_ms)) return;   // already released, keep it
+  // Re-derive the pending release from the previous one
+  uint32_t release = s.release_ms - old_period + period_ms;
+  s.release_ms = due(now, release) ? now : release;
+}
+
+void InquiryScheduler::set_priority(int idx, uint8_t priority, uint32_t deadline_ms) {
+  if (idx < 0 || (size_t)idx >= n_) return;
+  State& s = state_[idx];
+  s.priority = priority;
+  s.deadline_ms = deadline_ms;
+}
+
+SchedEntry InquiryScheduler::entry(size_t i) const {
+  SchedEntry e = entries_[i];
+  e.period_ms = state_[i].stats.period_ms;
+  e.priority = state_[i].priority;
+  e.deadline_ms = state_[i].deadline_ms;
+  return e;
+}
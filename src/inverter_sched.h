@@ -0,0 +1,96 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Multi-rate scheduler for inquiry commands on the half-duplex serial link.
+// Plain C++ without Arduino dependencies so it can be built on a host.
+//
+// Every command has a period, a priority and a relative deadline (how late
+// after its release it may start). Priority 0 commands are cadence-critical
+// and are dispatched earliest-deadline-first as soon as they are released,
+// back to back. Commands with priority > 0 only run in slack: when their
+// estimated duration ends before the next priority-0 release, so they can
+// never push QPIGS off its cadence. Among those, lower priority value wins,
+// then the earlier deadline. One that reaches its deadline without fitting
+// runs in the next gap anyway, delaying the critical commands at most once
+// per its period: its estimate may still be the pessimistic seed, and only
+// a measured run corrects it.
+//
+// Durations are estimated per command: the UART timeout (pessimistic) until
+// the first run, then an EWMA of measured transactions.
+
+#define SCHED_MAX_ENTRIES       12
+#define SCHED_UTIL_WINDOW_MS    10000   // link utilization window
+
+struct SchedEntry {
+  uint8_t cmd;           // caller's command id
+  uint32_t period_ms;
+  uint8_t priority;      // 0 = cadence-critical, higher = background
+  uint32_t deadline_ms;  // start at most this long after release
+  uint32_t est_ms;       // initial duration estimate
+};
+
+struct SchedCmdStats {
+  uint32_t runs;
+  uint32_t deadline_misses;   // started late, or still waiting at the deadline
+  uint32_t skipped;           // releases dropped because a whole period passed
+  uint32_t max_lateness_ms;   // worst start delay after release
+  uint32_t est_ms;            // current duration estimate
+  uint32_t last_start_ms;
+  uint32_t period_ms;         // current period (see set_period)
+};
+
+struct SchedLinkStats {
+  uint64_t busy_ms;           // total time in transactions
+  uint32_t util_permille;     // busy share of the last full window
+  uint32_t window_ms;
+};
+
+class InquiryScheduler {
+public:
+  // Entries must outlive the scheduler. All commands are released at `now`.
+  void begin(const SchedEntry* entries, size_t n, uint32_t now);
+
+  // Index of the entry to run now, or -1 with *wait_ms set to the time until
+  // something may become runnable.
+  int next(uint32_t now, uint32_t* wait_ms);
+
+  // Report a finished transaction of entry idx (started by next()).
+  void complete(int idx, uint32_t start_ms, uint32_t end_ms);
+
+  // Account link time used outside the schedule (write commands)
+  void note_busy(uint32_t start_ms, uint32_t end_ms);
+
+  // Change the period of entry idx at runtime. A shorter period pulls the
+  // pending release in (never before now), a longer one pushes it out.
+  void set_period(int idx, uint32_t period_ms, uint32_t now);
+
+  // Move entry idx between cadence-critical (0) and background at runtime
+  void set_priority(int idx, uint8_t priority, uint32_t deadline_ms);
+
+  size_t size() const { return n_; }
+  // Entry as configured, with the current period, priority and deadline
+  SchedEntry entry(size_t i) const;
+  const SchedCmdStats& stats(size_t i) const { return state_[i].stats; }
+  const SchedLinkStats& link() const { return link_; }
+
+private:
+  struct State {
+    uint32_t release_ms;      // current (or next) release time
+    bool miss_counted;        // deadline miss already counted for this release
+    uint8_t priority;
+    uint32_t deadline_ms;
+    SchedCmdStats stats;
+  };
+
+  static bool due(uint32_t now, uint32_t t) { return (int32_t)(now - t) >= 0; }
+  bool next_critical_release(uint32_t now, uint32_t* at) const;
+  void account(uint32_t dur, uint32_t end_ms);
+
+  const SchedEntry* entries_ = nullptr;
+  size_t n_ = 0;
+  State state_[SCHED_MAX_ENTRIES] = {};
+  SchedLinkStats link_ = {};
+  uint32_t window_start_ = 0;
+  uint32_t window_busy_ = 0;
+};
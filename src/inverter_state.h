@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+
+// Parsed status structure (subset of QPIGS fields)
+struct InverterState {
+  float grid_voltage;           // BBB.B  Grid voltage [V]
+  float grid_frequency;         // CC.C   Grid frequency [Hz]
+  float ac_out_voltage;         // DDD.D  AC output voltage [V]
+  float ac_out_frequency;       // EE.E   AC output frequency [Hz]
+  int   ac_apparent_va;         // FFFF   AC output apparent power [VA]
+  int   ac_active_w;            // GGGG   AC output active power [W]
+  int   load_percent;           // HHH    Output load percent [%] (max of W% or VA%)
+  float bus_voltage;            // III    BUS voltage [V]
+  float batt_voltage;           // JJ.JJ  Battery voltage [V]
+  float batt_charge_current;    // KKK    Battery charging current [A]
+  int   batt_soc;               // OOO    Battery capacity [%]
+  float heatsink_temp;          // TTTT   Inverter heat sink temperature [°C] (or NTC A/D)
+  float pv_input_current;       // EEEE   PV input current for battery [A]
+  float pv_input_voltage;       // UUU.U  PV input voltage [V]
+  float batt_voltage_from_scc;  // WW.WW  Battery voltage from SCC [V]
+  float batt_discharge_current; // PPPPP  Battery discharge current [A]
+  uint8_t device_status_bits;   // b7..b0 Device status bits (b7 SBU, b6 config changed, b5 SCC fw, b4 load status, b3 reserved, b2 charging status, b1 SCC charging, b0 AC charging)
+  int   batt_fan_offset_10mv;   // QQ     Battery voltage offset for fans on (10mV units)
+  int   eeprom_version;         // VV     EEPROM version
+  int   pv_charging_power;      // MMMMM  PV charging power [W]
+  uint8_t additional_status_bits;// b10..b8 Additional status bits (b10 charging to float flag, b9 Switch On, b8 reserved)
+  uint32_t ts_ms;               // timestamp (millis) when these values were last updated
+};
+
+// Parallel systems: units answer QPGSn (n = 0..), see doc/protocol
+#define INVERTER_MAX_UNITS 4
+
+// One unit of a parallel system (QPGSn payload)
+struct InverterUnitState {
+  bool present;                 // A      Parallel unit exists
+  char serial[15];              // B      Serial number (14 digits)
+  char work_mode;               // C      Work mode (P/S/L/B/F/H/D)
+  uint8_t fault_code;           // DD     Fault code, 0 = none
+  float grid_voltage;           // EEE.E  Grid voltage [V]
+  float grid_frequency;         // FF.FF  Grid frequency [Hz]
+  float ac_out_voltage;         // GGG.G  AC output voltage [V]
+  float ac_out_frequency;       // HH.HH  AC output frequency [Hz]
+  int   ac_apparent_va;         // IIII   AC output apparent power [VA]
+  int   ac_active_w;            // JJJJ   AC output active power [W]
+  int   load_percent;           // KKK    Load percentage [%]
+  float batt_voltage;           // LL.L   Battery voltage [V]
+  int   batt_charge_current;    // MMM    Battery charging current [A]
+  int   batt_soc;               // NNN    Battery capacity [%]
+  float pv_input_voltage;       // OOO.O  PV input voltage [V]
+  int   total_charge_current;   // PPP    Total charging current reported by the unit [A]
+  int   total_apparent_va;      // QQQQQ  Total AC output apparent power [VA]
+  int   total_active_w;         // RRRRR  Total AC output active power [W]
+  int   total_load_percent;     // SSS    Total AC output percentage [%]
+  uint8_t status_bits;          // b7..b0 Inverter status (b7 SCC OK, b6 AC charging, b5 SCC charging, b4..b3 battery, b2 line loss, b1 load on, b0 config changed)
+  uint8_t output_mode;          // T      0 single, 1 parallel, 2..4 phase 1..3
+  uint8_t charger_priority;     // U      0 utility first, 1 solar first, 2 solar + utility, 3 solar only
+  int   max_charge_current;     // VVV    Max charger current [A]
+  int   max_charge_range;       // WWW    Max charger range [A]
+  int   max_ac_charge_current;  // ZZ     Max AC charger current [A]
+  int   pv_input_current;       // XX     PV input current [A]
+  int   batt_discharge_current; // YYY    Battery discharge current [A]
+  uint32_t ts_ms;               // timestamp (millis) of the last answer
+};
+
+// Sums over the present units (maintained incrementally as units report)
+struct ParallelTotals {
+  uint8_t units;                // units seen so far (highest present index + 1)
+  uint8_t present;              // units currently answering
+  uint8_t faulted;              // present units with a fault code
+  int32_t ac_apparent_va;
+  int32_t ac_active_w;
+  int32_t batt_charge_current;
+  int32_t batt_discharge_current;
+  int32_t pv_input_current;
+};
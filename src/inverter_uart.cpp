@@ -0,0 +1,119 @@
+#include "inverter_uart.h"
+#include "logger.h"
+#include <driver/uart.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+bool inverter_uart_begin(InverterUart* u, int uart_num, int rx_pin, int tx_pin, uint32_t baud) {
+  u->port = uart_num;
+  u->queue = NULL;
+  u->baud = baud;
+  const uart_port_t port = (uart_port_t)uart_num;
+
+  uart_config_t cfg = {};
+  cfg.baud_rate = (int)baud;
+  cfg.data_bits = UART_DATA_8_BITS;
+  cfg.parity = UART_PARITY_DISABLE;
+  cfg.stop_bits = UART_STOP_BITS_1;
+  cfg.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+  cfg.source_clk = UART_SCLK_APB;
+
+  if (uart_driver_install(port, 1024, 0, 20, &u->queue, 0) != ESP_OK) {
+    LOGE(LOG_MOD_INV, "uart_driver_install(%d) failed", uart_num);
+    return false;
+  }
+  uart_param_config(port, &cfg);
+  uart_set_pin(port, tx_pin, rx_pin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+
+  // Wake on every few bytes and on a short idle gap, so inter-byte timing is observable
+  uart_set_rx_full_threshold(port, INVERTER_UART_RX_THRESHOLD);
+  uart_set_rx_timeout(port, 2);
+  // Frame terminator: one CR, no idle requirements around it
+  uart_enable_pattern_det_baud_intr(port, 0x0D, 1, 9, 0, 0);
+  uart_pattern_queue_reset(port, 20);
+  return true;
+}
+
+// Time (ms) to shift n bytes at 8N1, rounded up
+static uint32_t bytes_time_ms(size_t n, uint32_t baud) {
+  return (uint32_t)((n * 10u * 1000u + baud - 1) / baud);
+}
+
+uint32_t inverter_uart_timeout_ms(const InverterUart* u, size_t tx_len, size_t expected_rx_len) {
+  // TX + inverter think time + RX with 25% slack for slow/stretched frames
+  uint32_t rx_ms = bytes_time_ms(expected_rx_len, u->baud);
+  return bytes_time_ms(tx_len, u->baud) + INVERTER_FIRST_BYTE_TIMEOUT_MS + rx_ms + rx_ms / 4;
+}
+
+// Drain whatever the driver has buffered into the parser
+static FrameStatus drain_rx(uart_port_t port, FrameParser& parser) {
+  uint8_t chunk[64];
+  FrameStatus st = parser.status();
+  size_t avail = 0;
+  uart_get_buffered_data_len(port, &avail);
+  while (avail > 0 && st == FrameStatus::InProgress) {
+    int n = uart_read_bytes(port, chunk, avail < sizeof(chunk) ? avail : sizeof(chunk), 0);
+    if (n <= 0) break;
+    for (int i = 0; i < n && st == FrameStatus::InProgress; ++i) {
+      st = parser.feed(chunk[i]);
+    }
+    avail -= (size_t)n;
+  }
+  return st;
+}
+
+FrameStatus inverter_uart_transact(InverterUart* u, const uint8_t* tx, size_t tx_len, size_t expected_rx_len,
+                                   FrameParser& parser, uint8_t* rx, size_t rx_cap,
+                                   uint32_t* rtt_ms) {
+  const uart_port_t port = (uart_port_t)u->port;
+  parser.reset(rx, rx_cap);
+  if (rtt_ms) *rtt_ms = 0;
+
+  // Drop stale bytes and events from a previous (late or aborted) response
+  uart_flush_input(port);
+  xQueueReset(u->queue);
+  uart_pattern_queue_reset(port, 20);
+
+  const uint32_t start = millis();
+  const uint32_t deadline = start + inverter_uart_timeout_ms(u, tx_len, expected_rx_len);
+  uart_write_bytes(port, (const char*)tx, tx_len);
+
+  uint32_t last_rx = 0;
+  FrameStatus st = FrameStatus::InProgress;
+  while (st == FrameStatus::InProgress) {
+    uint32_t now = millis();
+    int32_t wait = (int32_t)(deadline - now);
+    if (parser.length() > 0) {
+      int32_t gap = (int32_t)(last_rx + INVERTER_INTERBYTE_TIMEOUT_MS - now);
+      if (gap < wait) wait = gap;
+    }
+    if (wait <= 0) break; // timeout
+
+    uart_event_t ev;
+    if (xQueueReceive(u->queue, &ev, pdMS_TO_TICKS((uint32_t)wait) + 1) != pdTRUE) {
+      continue; // re-evaluate deadlines
+    }
+    switch (ev.type) {
+    case UART_PATTERN_DET:
+      uart_pattern_pop_pos(port);
+      // fallthrough
+    case UART_DATA: {
+      size_t before = parser.length();
+      st = drain_rx(port, parser);
+      if (parser.length() != before || st != FrameStatus::InProgress) last_rx = millis();
+      break;
+    }
+    case UART_FIFO_OVF:
+    case UART_BUFFER_FULL:
+      uart_flush_input(port);
+      xQueueReset(u->queue);
+      st = FrameStatus::Overflow;
+      break;
+    default:
+      break; // frame/parity errors: the CRC check will reject the frame
+    }
+  }
+
+  if (rtt_ms) *rtt_ms = millis() - start;
+  return st;
+}
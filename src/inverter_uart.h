@@ -0,0 +1,40 @@
+#pragma once
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include "inverter_frame.h"
+
+// Event-driven half-duplex UART link to the inverter (ESP-IDF UART driver).
+// The driver's event queue wakes the caller as soon as bytes arrive; CR pattern
+// detection (0x0D never appears inside a frame, CRC bytes are adjusted) ends a
+// frame immediately instead of waiting out a fixed timeout.
+
+// Inter-byte timeout once a response has started. The driver delivers data at
+// least every INVERTER_UART_RX_THRESHOLD bytes, so this must exceed that time.
+#define INVERTER_INTERBYTE_TIMEOUT_MS 100
+// Time the inverter may take before the first response byte
+#define INVERTER_FIRST_BYTE_TIMEOUT_MS 300
+// RX FIFO threshold (bytes) for UART_DATA events while a frame is streaming
+#define INVERTER_UART_RX_THRESHOLD 8
+
+// One UART port; each inverter link owns one and only its poll task uses it
+struct InverterUart {
+  int port;              // uart_port_t
+  QueueHandle_t queue;   // driver event queue
+  uint32_t baud;
+};
+
+// Install UART driver and event queue. Returns false on driver error.
+bool inverter_uart_begin(InverterUart* u, int uart_num, int rx_pin, int tx_pin, uint32_t baud);
+
+// Send a complete TX frame and stream the response into rx through the frame
+// parser. Returns when CR arrives, on inter-byte timeout, or when the overall
+// timeout (derived from tx_len and expected_rx_len) expires.
+// On return, parser holds the frame state; rtt_ms is time from TX start to CR.
+// Returns FrameStatus::InProgress on timeout.
+FrameStatus inverter_uart_transact(InverterUart* u, const uint8_t* tx, size_t tx_len, size_t expected_rx_len,
+                                   FrameParser& parser, uint8_t* rx, size_t rx_cap,
+                                   uint32_t* rtt_ms);
+
+// Overall response timeout for a command (ms) given frame lengths
+uint32_t inverter_uart_timeout_ms(const InverterUart* u, size_t tx_len, size_t expected_rx_len);
@@ -0,0 +1,152 @@
+#include "inverter_write.h"
+#include <string.h>
+
+// Allowed setters: command prefix and argument pattern
+//   'd' one digit, '.' literal dot, 'F' one or more flag letters, "" none
+struct WriteCmdDef {
+  const char* prefix;
+  const char* args;
+};
+
+// Arguments must match exactly, so overlapping prefixes (POP / POPM) are safe
+static const WriteCmdDef WRITE_CMDS[] = {
+  { "PE",     "F" },      // enable flags
+  { "PD",     "F" },      // disable flags
+  { "PF",     "" },       // reset control parameters to default
+  { "MCHGC",  "ddd" },    // max charging current
+  { "MNCHGC", "dddd" },   // max charging current of parallel unit m
+  { "MUCHGC", "ddd" },    // max utility charging current
+  { "F",      "dd" },     // output frequency
+  { "POPM",   "dd" },     // output mode (single / parallel / phase)
+  { "POP",    "dd" },     // output source priority
+  { "PBCV",   "dd.d" },   // battery re-charge voltage
+  { "PBDV",   "dd.d" },   // battery re-discharge voltage
+  { "PBFT",   "dd.d" },   // battery float voltage
+  { "PBT",    "dd" },     // battery type
+  { "PPCP",   "ddd" },    // charger priority of parallel unit m
+  { "PCVV",   "dd.d" },   // battery C.V. voltage
+  { "PCP",    "dd" },     // charger priority
+  { "PGR",    "dd" },     // grid working range
+  { "PSDV",   "dd.d" },   // battery cut-off voltage
+  { "PPVOKC", "d" },      // PV OK condition
+  { "PSPB",   "d" },      // solar power balance
+};
+
+static const char FLAG_LETTERS[] = "ABJKUVXYZ";
+
+static bool args_match(const char* s, const char* pattern) {
+  if (strcmp(pattern, "F") == 0) {
+    if (!*s) return false;
+    for (; *s; ++s) {
+      if (!strchr(FLAG_LETTERS, *s)) return false;
+    }
+    return true;
+  }
+  for (; *pattern; ++pattern, ++s) {
+    if (*pattern == 'd' ? (*s < '0' || *s > '9') : *s != *pattern) return false;
+  }
+  return *s == '\0';
+}
+
+bool inverter_write_valid(const char* cmd) {
+  if (!cmd || strlen(cmd) > WRITE_CMD_MAX) return false;
+  for (const auto& d : WRITE_CMDS) {
+    size_t n = strlen(d.prefix);
+    if (strncmp(cmd, d.prefix, n) == 0 && args_match(cmd + n, d.args)) return true;
+  }
+  return false;
+}
+
+const char* inverter_write_state_name(WriteState s) {
+  switch (s) {
+  case WRITE_QUEUED:  return "queued";
+  case WRITE_SENDING: return "sending";
+  case WRITE_ACK:     return "ack";
+  case WRITE_NAK:     return "nak";
+  case WRITE_FAILED:  return "failed";
+  default:            return "unknown";
+  }
+}
+
+// Tickets grow monotonically (wrapping, skipping 0); older = smaller distance
+static bool older(uint32_t a, uint32_t b) { return (int32_t)(a - b) < 0; }
+
+uint32_t WriteQueue::submit(const char* cmd, uint32_t now_ms) {
+  // A free slot, else the oldest finished job
+  WriteJob* dst = nullptr;
+  for (auto& j : jobs_) {
+    if (j.state == WRITE_FREE) {
+      dst = &j;
+      break;
+    }
+    if (inverter_write_final(j.state) && (!dst || older(j.id, dst->id))) dst = &j;
+  }
+  if (!dst) {
+    stats_.rejected++;
+    return 0;
+  }
+  *dst = WriteJob{};
+  dst->id = next_id_++;
+  if (next_id_ == 0) next_id_ = 1;
+  strncpy(dst->cmd, cmd, WRITE_CMD_MAX);
+  dst->cmd[WRITE_CMD_MAX] = '\0';
+  dst->state = WRITE_QUEUED;
+  dst->submit_ms = now_ms;
+  stats_.submitted++;
+  return dst->id;
+}
+
+bool WriteQueue::take(WriteJob* out) {
+  WriteJob* first = nullptr;
+  for (auto& j : jobs_) {
+    if (j.state == WRITE_QUEUED && (!first || older(j.id, first->id))) first = &j;
+  }
+  if (!first) return false;
+  first->state = WRITE_SENDING;
+  first->attempts++;
+  *out = *first;
+  return true;
+}
+
+WriteState WriteQueue::complete(uint32_t id, WriteResult r, uint32_t now_ms) {
+  WriteJob* j = slot(id);
+  if (!j || j->state != WRITE_SENDING) return j ? j->state : WRITE_FREE;
+  if (r == WRITE_RESULT_NO_ANSWER && j->attempts < WRITE_MAX_ATTEMPTS) {
+    j->state = WRITE_QUEUED;
+    stats_.retries++;
+    return j->state;
+  }
+  switch (r) {
+  case WRITE_RESULT_ACK: j->state = WRITE_ACK; stats_.acks++; break;
+  case WRITE_RESULT_NAK: j->state = WRITE_NAK; stats_.naks++; break;
+  default:               j->state = WRITE_FAILED; stats_.failed++; break;
+  }
+  j->done_ms = now_ms;
+  uint32_t latency = now_ms - j->submit_ms;
+  if (latency > stats_.max_latency_ms) stats_.max_latency_ms = latency;
+  return j->state;
+}
+
+bool WriteQueue::find(uint32_t id, WriteJob* out) const {
+  for (const auto& j : jobs_) {
+    if (id && j.id == id && j.state != WRITE_FREE) {
+      *out = j;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool WriteQueue::pending() const {
+  for (const auto& j : jobs_) {
+    if (j.state == WRITE_QUEUED) return true;
+  }
+  return false;
+}
+
+WriteJob* WriteQueue::slot(uint32_t id) {
+  for (auto& j : jobs_) {
+    if (id && j.id == id) return &j;
+  }
+  return nullptr;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Setter commands (POP, PCP, PE/PD, MCHGC, ...) queued for the poll task,
+// which owns the serial link. Plain C++ without Arduino dependencies so it
+// can be built on a host; the owner serializes calls with its own lock.
+//
+// Writes outrank every inquiry: the poll task takes the oldest queued write
+// before asking the scheduler, and a submission wakes the task out of its
+// wait, so a write only ever waits for the transaction already on the wire.
+// "(ACK" and "(NAK" are final answers; no answer (timeout, CRC error,
+// garbage) is retried right away, up to WRITE_MAX_ATTEMPTS in total.
+//
+// Worst-case latency from submission to the final answer, at 2400 Bd with
+// the timeouts of inverter_uart.h (tx ~12 B, "(ACK" 7 B -> ~390 ms each):
+//   in-flight inquiry (QPGS timing out)                ~1030 ms
+//   + writes queued ahead, each up to 3 attempts       k x 3 x 390 ms
+//   + this write, up to 3 attempts                     3 x 390 ms
+// i.e. ~1.4 s for an ACK on the first attempt behind a failing QPGS and
+// ~2.2 s for a write that ends up FAILED with an empty queue. On a healthy
+// link the in-flight inquiry ends with its response (QPIGS ~500 ms) and an
+// ACK takes ~100 ms plus the inverter's reaction time; doc/writeLatencyBench.py
+// measures it end to end from the HTTP POST.
+
+#define WRITE_QUEUE_LEN     8     // queued + finished jobs kept for polling
+#define WRITE_CMD_MAX       15    // longest setter text ("MNCHGC1100" is 10)
+#define WRITE_MAX_ATTEMPTS  3
+
+enum WriteState : uint8_t {
+  WRITE_FREE = 0,
+  WRITE_QUEUED,
+  WRITE_SENDING,
+  WRITE_ACK,       // final: accepted
+  WRITE_NAK,       // final: rejected by the inverter (value out of range, ...)
+  WRITE_FAILED,    // final: no valid answer after WRITE_MAX_ATTEMPTS
+};
+
+enum WriteResult : uint8_t {
+  WRITE_RESULT_ACK = 0,
+  WRITE_RESULT_NAK,
+  WRITE_RESULT_NO_ANSWER,
+};
+
+struct WriteJob {
+  uint32_t id;              // ticket returned by submit(), never 0
+  char cmd[WRITE_CMD_MAX + 1];
+  WriteState state;
+  uint8_t attempts;
+  uint32_t submit_ms;
+  uint32_t done_ms;         // when the final state was reached
+};
+
+struct WriteStats {
+  uint32_t submitted;
+  uint32_t rejected;        // queue full
+  uint32_t acks;
+  uint32_t naks;
+  uint32_t failed;
+  uint32_t retries;
+  uint32_t max_latency_ms;  // submission to final answer
+};
+
+// True if cmd is a setter this firmware lets through, with well-formed
+// arguments (e.g. "POP02", "PEab" is not: flags are A B J K U V X Y Z).
+// Value ranges are device specific and left to the inverter (NAK).
+// Calibration and service commands (PBATH, BTA1, SID, ...) are not allowed.
+bool inverter_write_valid(const char* cmd);
+const char* inverter_write_state_name(WriteState s);
+inline bool inverter_write_final(WriteState s) { return s >= WRITE_ACK; }
+
+class WriteQueue {
+public:
+  // Queue cmd (validated by the caller). Returns the ticket, or 0 when every
+  // slot holds a job that is not finished yet.
+  uint32_t submit(const char* cmd, uint32_t now_ms);
+
+  // Oldest queued job, now marked SENDING; false if nothing is queued
+  bool take(WriteJob* out);
+
+  // Outcome of the job from take(). NO_ANSWER re-queues it (it stays the
+  // oldest) until its attempts are used up. Returns the job's new state.
+  WriteState complete(uint32_t id, WriteResult r, uint32_t now_ms);
+
+  bool find(uint32_t id, WriteJob* out) const;
+  bool pending() const;
+  const WriteStats& stats() const { return stats_; }
+
+private:
+  WriteJob* slot(uint32_t id);
+
+  WriteJob jobs_[WRITE_QUEUE_LEN] = {};
+  uint32_t next_id_ = 1;
+  WriteStats stats_ = {};
+};
@@ -0,0 +1,297 @@
+#include "logger.h"
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <atomic>
+#include <stdarg.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+static_assert((LOG_RING_SLOTS & (LOG_RING_SLOTS - 1)) == 0, "LOG_RING_SLOTS must be a power of two");
+
+// Bounded MPSC ring (Vyukov): a slot's sequence tells producers and the
+// consumer whose turn it is, so claiming a slot is a single CAS.
+struct LogSlot {
+  std::atomic<uint32_t> seq;
+  uint32_t ts_ms;
+  uint8_t mod;
+  uint8_t lvl;
+  uint16_t len;
+  char msg[LOG_MSG_MAX];
+};
+
+static LogSlot g_slots[LOG_RING_SLOTS];
+static std::atomic<uint32_t> g_enqueue_pos{0};
+static uint32_t g_dequeue_pos = 0;      // flusher only
+static std::atomic<bool> g_ring_ready{false};
+static portMUX_TYPE g_ring_init_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static std::atomic<uint32_t> g_written{0};
+static std::atomic<uint32_t> g_dropped_full{0};
+static std::atomic<uint32_t> g_dropped_rate{0};
+static uint32_t g_flushed_bytes = 0;
+static uint32_t g_file_rotations = 0;
+
+static TaskHandle_t g_flush_task = NULL;
+static SemaphoreHandle_t g_file_mutex = NULL;
+
+struct ModuleState {
+  const char* name;
+  LogLevel level;
+  uint16_t per_sec;   // 0 = unlimited
+  uint16_t burst;
+  uint32_t tokens_x1000;
+  uint32_t last_ms;
+};
+
+static ModuleState g_mods[LOG_MOD_COUNT] = {
+  { "APP",  LOG_INFO, 0,  0,  0, 0 },
+  { "INV",  LOG_INFO, 5,  20, 0, 0 },
+  { "WEB",  LOG_INFO, 5,  20, 0, 0 },
+  { "HIST", LOG_INFO, 2,  10, 0, 0 },
+  { "NET",  LOG_INFO, 0,  0,  0, 0 },
+};
+static portMUX_TYPE g_rate_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static const char* const LEVEL_NAMES[] = { "ERROR", "WARN", "INFO", "DEBUG" };
+
+// Slot sequences start at their index; done lazily so log_write() works
+// before log_init() (boot messages are queued until the flusher runs).
+static void ring_init_once() {
+  if (g_ring_ready.load(std::memory_order_acquire)) return;
+  portENTER_CRITICAL(&g_ring_init_mux);
+  if (!g_ring_ready.load(std::memory_order_relaxed)) {
+    for (uint32_t i = 0; i < LOG_RING_SLOTS; ++i) g_slots[i].seq.store(i, std::memory_order_relaxed);
+    g_ring_ready.store(true, std::memory_order_release);
+  }
+  portEXIT_CRITICAL(&g_ring_init_mux);
+}
+
+static bool rate_allow(LogModule mod, LogLevel lvl) {
+  ModuleState& m = g_mods[mod];
+  if (lvl == LOG_ERROR || m.per_sec == 0) return true;
+  uint32_t now = millis();
+  bool ok;
+  portENTER_CRITICAL(&g_rate_mux);
+  uint32_t cap = (uint32_t)m.burst * 1000u;
+  uint32_t elapsed = now - m.last_ms;
+  if (elapsed > 60000u) elapsed = 60000u;
+  uint32_t refill = elapsed * m.per_sec;
+  m.last_ms = now;
+  m.tokens_x1000 = (m.tokens_x1000 + refill >= cap) ? cap : m.tokens_x1000 + refill;
+  ok = m.tokens_x1000 >= 1000u;
+  if (ok) m.tokens_x1000 -= 1000u;
+  portEXIT_CRITICAL(&g_rate_mux);
+  return ok;
+}
+
+bool log_enabled(LogModule mod, LogLevel lvl) {
+  return mod < LOG_MOD_COUNT && lvl <= g_mods[mod].level;
+}
+
+void log_write(LogModule mod, LogLevel lvl, const char* fmt, ...) {
+  if (!log_enabled(mod, lvl)) return;
+  if (!rate_allow(mod, lvl)) {
+    g_dropped_rate.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  ring_init_once();
+
+  uint32_t pos = g_enqueue_pos.load(std::memory_order_relaxed);
+  LogSlot* slot;
+  for (;;) {
+    slot = &g_slots[pos & (LOG_RING_SLOTS - 1)];
+    int32_t diff = (int32_t)(slot->seq.load(std::memory_order_acquire) - pos);
+    if (diff == 0) {
+      if (g_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+    } else if (diff < 0) {
+      g_dropped_full.fetch_add(1, std::memory_order_relaxed);
+      return;
+    } else {
+      pos = g_enqueue_pos.load(std::memory_order_relaxed);
+    }
+  }
+
+  slot->ts_ms = millis();
+  slot->mod = mod;
+  slot->lvl = lvl;
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(slot->msg, sizeof(slot->msg), fmt, ap);
+  va_end(ap);
+  if (n < 0) n = 0;
+  slot->len = (uint16_t)((size_t)n < sizeof(slot->msg) ? n : sizeof(slot->msg) - 1);
+  slot->seq.store(pos + 1, std::memory_order_release);
+  g_written.fetch_add(1, std::memory_order_relaxed);
+}
+
+// ---- Flusher ----
+
+// Batches handed to Serial / LittleFS in one call each
+static char g_serial_batch[1024];
+static char g_file_batch[1024];
+static size_t g_serial_len = 0;
+static size_t g_file_len = 0;
+
+static void flush_file_batch() {
+  if (g_file_len == 0) return;
+  xSemaphoreTake(g_file_mutex, portMAX_DELAY);
+  File f = LittleFS.open(LOG_FILE_PATH, "a");
+  if (f) {
+    f.write((const uint8_t*)g_file_batch, g_file_len);
+    size_t size = f.size();
+    f.close();
+    if (size >= LOG_FILE_MAX) {
+      LittleFS.remove(LOG_FILE_OLD);
+      LittleFS.rename(LOG_FILE_PATH, LOG_FILE_OLD);
+      g_file_rotations++;
+    }
+  }
+  xSemaphoreGive(g_file_mutex);
+  g_file_len = 0;
+}
+
+static void flush_serial_batch() {
+  if (g_serial_len == 0) return;
+  Serial.write((const uint8_t*)g_serial_batch, g_serial_len);
+  g_flushed_bytes += g_serial_len;
+  g_serial_len = 0;
+}
+
+static void emit_line(const char* line, size_t len, bool to_file) {
+  if (g_serial_len + len > sizeof(g_serial_batch)) flush_serial_batch();
+  memcpy(g_serial_batch + g_serial_len, line, len);
+  g_serial_len += len;
+  if (to_file) {
+    if (g_file_len + len > sizeof(g_file_batch)) flush_file_batch();
+    memcpy(g_file_batch + g_file_len, line, len);
+    g_file_len += len;
+  }
+}
+
+// "[HH:MM:SS.mmm] [WARN] [INV] message\n"
+static size_t format_line(char* out, size_t cap, uint32_t ms, uint8_t lvl, uint8_t mod, const char* msg, size_t len) {
+  uint32_t sec = ms / 1000;
+  int n = snprintf(out, cap, "[%02u:%02u:%02u.%03u] [%s] [%s] ",
+    (unsigned)(sec / 3600), (unsigned)((sec % 3600) / 60), (unsigned)(sec % 60), (unsigned)(ms % 1000),
+    LEVEL_NAMES[lvl < 4 ? lvl : 3], mod < LOG_MOD_COUNT ? g_mods[mod].name : "?");
+  size_t used = (n > 0 && (size_t)n < cap) ? (size_t)n : 0;
+  if (used + len + 1 > cap) len = cap - used - 1;
+  memcpy(out + used, msg, len);
+  used += len;
+  out[used++] = '\n';
+  return used;
+}
+
+static void log_flush_task(void* arg) {
+  (void)arg;
+  char line[LOG_MSG_MAX + 48];
+  uint32_t reported_full = 0, reported_rate = 0, reported_ms = 0;
+  for (;;) {
+    for (;;) {
+      LogSlot& slot = g_slots[g_dequeue_pos & (LOG_RING_SLOTS - 1)];
+      if (slot.seq.load(std::memory_order_acquire) != g_dequeue_pos + 1) break;
+      size_t n = format_line(line, sizeof(line), slot.ts_ms, slot.lvl, slot.mod, slot.msg, slot.len);
+      bool to_file = slot.lvl <= LOG_WARN;
+      slot.seq.store(g_dequeue_pos + LOG_RING_SLOTS, std::memory_order_release);
+      g_dequeue_pos++;
+      emit_line(line, n, to_file);
+    }
+
+    uint32_t full = g_dropped_full.load(std::memory_order_relaxed);
+    uint32_t rate = g_dropped_rate.load(std::memory_order_relaxed);
+    if ((full != reported_full || rate != reported_rate) && millis() - reported_ms >= 1000u) {
+      char msg[64];
+      int len = snprintf(msg, sizeof(msg), "dropped %u (ring full), %u (rate limit)",
+        (unsigned)(full - reported_full), (unsigned)(rate - reported_rate));
+      size_t n = format_line(line, sizeof(line), millis(), LOG_WARN, LOG_MOD_APP, msg, len > 0 ? (size_t)len : 0);
+      emit_line(line, n, true);
+      reported_full = full;
+      reported_rate = rate;
+      reported_ms = millis();
+    }
+
+    flush_serial_batch();
+    flush_file_batch();
+    vTaskDelay(pdMS_TO_TICKS(LOG_FLUSH_MS));
+  }
+}
+
+void log_init() {
+  if (g_flush_task) return;
+  ring_init_once();
+  g_file_mutex = xSemaphoreCreateMutex();
+  xTaskCreatePinnedToCore(log_flush_task, "log_flush", LOG_FLUSH_STACK, NULL, 0, &g_flush_task, 0);
+}
+
+void log_set_level(LogModule mod, LogLevel lvl) {
+  if (mod < LOG_MOD_COUNT) g_mods[mod].level = lvl;
+}
+
+LogLevel log_get_level(LogModule mod) {
+  return mod < LOG_MOD_COUNT ? g_mods[mod].level : LOG_ERROR;
+}
+
+void log_set_rate(LogModule mod, uint16_t per_sec, uint16_t burst) {
+  if (mod >= LOG_MOD_COUNT) return;
+  portENTER_CRITICAL(&g_rate_mux);
+  g_mods[mod].per_sec = per_sec;
+  g_mods[mod].burst = burst;
+  g_mods[mod].tokens_x1000 = (uint32_t)burst * 1000u;
+  portEXIT_CRITICAL(&g_rate_mux);
+}
+
+LogModule log_module_by_name(const char* name) {
+  if (!name) return LOG_MOD_COUNT;
+  for (int m = 0; m < LOG_MOD_COUNT; ++m) {
+    if (strcasecmp(g_mods[m].name, name) == 0) return (LogModule)m;
+  }
+  return LOG_MOD_COUNT;
+}
+
+const char* log_module_name(LogModule mod) {
+  return mod < LOG_MOD_COUNT ? g_mods[mod].name : "?";
+}
+
+bool log_level_by_name(const char* name, LogLevel* out) {
+  if (!name || !out) return false;
+  for (int l = 0; l <= LOG_DEBUG; ++l) {
+    if (strcasecmp(LEVEL_NAMES[l], name) == 0) {
+      *out = (LogLevel)l;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* log_level_name(LogLevel lvl) {
+  return lvl <= LOG_DEBUG ? LEVEL_NAMES[lvl] : "?";
+}
+
+size_t log_file_read(uint32_t offset, uint8_t* buf, size_t cap, uint32_t* file_size) {
+  if (file_size) *file_size = 0;
+  if (!g_file_mutex) return 0;
+  size_t n = 0;
+  xSemaphoreTake(g_file_mutex, portMAX_DELAY);
+  File f = LittleFS.open(LOG_FILE_PATH, "r");
+  if (f) {
+    uint32_t size = f.size();
+    if (file_size) *file_size = size;
+    if (offset < size && f.seek(offset)) n = f.read(buf, cap);
+    f.close();
+  }
+  xSemaphoreGive(g_file_mutex);
+  return n;
+}
+
+void log_get_stats(LogStats* out) {
+  if (!out) return;
+  out->written = g_written.load(std::memory_order_relaxed);
+  out->dropped_full = g_dropped_full.load(std::memory_order_relaxed);
+  out->dropped_rate = g_dropped_rate.load(std::memory_order_relaxed);
+  out->flushed_bytes = g_flushed_bytes;
+  out->file_rotations = g_file_rotations;
+  // High-water mark is in bytes on ESP-IDF (StackType_t is uint8_t)
+  out->flush_stack_free = g_flush_task ? (uint32_t)uxTaskGetStackHighWaterMark(g_flush_task) : 0;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Asynchronous logger.
+//
+// Any task may log; the caller only formats the message body into a slot of a
+// lock-free multi-producer ring (no mutex, no I/O, no heap). A background task
+// drains the ring in batches, adds the boot-relative timestamp / level / module
+// prefix, writes one block to Serial and appends WARN+ lines to /app.log,
+// rotating it to /app.log.1 at LOG_FILE_MAX bytes.
+//
+// Each module has a runtime level and a token-bucket rate limit; ERROR always
+// passes the rate limit. When the ring is full or a limit trips, messages are
+// counted and reported by the flusher instead of blocking the caller.
+
+#define LOG_RING_SLOTS   64     // power of two
+#define LOG_MSG_MAX      160    // message body incl. NUL (longer is truncated)
+#define LOG_FILE_PATH    "/app.log"
+#define LOG_FILE_OLD     "/app.log.1"
+#define LOG_FILE_MAX     (64u * 1024u)
+#define LOG_FLUSH_MS     100
+#define LOG_FLUSH_STACK  4096   // format_line + LittleFS append/rename; see flush_stack_free
+
+enum LogLevel : uint8_t {
+  LOG_ERROR = 0,
+  LOG_WARN,
+  LOG_INFO,
+  LOG_DEBUG
+};
+
+enum LogModule : uint8_t {
+  LOG_MOD_APP = 0,
+  LOG_MOD_INV,
+  LOG_MOD_WEB,
+  LOG_MOD_HIST,
+  LOG_MOD_NET,
+  LOG_MOD_COUNT
+};
+
+// Create the flusher task. Messages logged earlier are kept in the ring; the
+// file sink is used once LittleFS is mounted (call after LittleFS.begin()).
+void log_init();
+
+void log_write(LogModule mod, LogLevel lvl, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+
+#define LOGE(mod, ...) log_write((mod), LOG_ERROR, __VA_ARGS__)
+#define LOGW(mod, ...) log_write((mod), LOG_WARN, __VA_ARGS__)
+#define LOGI(mod, ...) log_write((mod), LOG_INFO, __VA_ARGS__)
+#define LOGD(mod, ...) log_write((mod), LOG_DEBUG, __VA_ARGS__)
+
+// Messages above the module level are discarded at the call site (cheap check)
+void log_set_level(LogModule mod, LogLevel lvl);
+LogLevel log_get_level(LogModule mod);
+bool log_enabled(LogModule mod, LogLevel lvl);
+
+// Allow `burst` messages at once, refilled at `per_sec`; per_sec 0 = unlimited
+void log_set_rate(LogModule mod, uint16_t per_sec, uint16_t burst);
+
+// Name lookup for the HTTP API ("inv", "debug", ...); COUNT / false if unknown
+LogModule log_module_by_name(const char* name);
+const char* log_module_name(LogModule mod);
+bool log_level_by_name(const char* name, LogLevel* out);
+const char* log_level_name(LogLevel lvl);
+
+// Read log file bytes starting at offset (serialized with the flusher).
+// Returns bytes copied; *file_size receives the current file size.
+size_t log_file_read(uint32_t offset, uint8_t* buf, size_t cap, uint32_t* file_size);
+
+struct LogStats {
+  uint32_t written;        // accepted into the ring
+  uint32_t dropped_full;   // ring full
+  uint32_t dropped_rate;   // rate limit
+  uint32_t flushed_bytes;  // bytes written to Serial
+  uint32_t file_rotations;
+  uint32_t flush_stack_free; // flusher stack never touched so far [bytes]
+};
+void log_get_stats(LogStats* out);
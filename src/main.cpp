@@ -1,6 +1,5 @@
 #include <Arduino.h>
 #include <WiFi.h>
-#include <WebServer.h>
 #include <ESPmDNS.h>
 #include <ArduinoJson.h>
 #include "credentials.h"
@@ -9,14 +8,21 @@
 #include "esp_webserver.h"
 #include "display.h"
 #include "inverter_comm.h"
+#include "logger.h"
+#include "status_events.h"
+#include "history_store.h"
+#include "telemetry.h"
+#include "pwm_output.h"
+#include "diversion.h"
+#include "touch_input.h"
 #include <esp_system.h>
 #include <esp_heap_caps.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
-#include <stdarg.h>
 #include <LittleFS.h>
 #include <driver/adc.h>
 #include <math.h>
+#include <atomic>
 #include <WireGuard-ESP32.h>
 
 IPAddress apIP(192, 168, 4, 1);
@@ -24,43 +30,6 @@ IPAddress netMsk(255, 255, 255, 0);
 
 static WireGuard wg;
 
-WebServer server(80);
-
-// Format boot-relative milliseconds to HH:MM:SS.sss into provided buffer.
-static inline void formatBootTimeMs(char* buf, size_t cap, uint32_t ms) {
-  uint32_t total_ms = ms;
-  uint32_t total_sec = total_ms / 1000;
-  unsigned h = total_sec / 3600;
-  unsigned m = (total_sec % 3600) / 60;
-  unsigned s = total_sec % 60;
-  unsigned ms_part = total_ms % 1000;
-  if (cap > 0) {
-    snprintf(buf, cap, "%02u:%02u:%02u.%03u", h, m, s, ms_part);
-  }
-}
-
-// Print a WARN log with boot-relative timestamp. Accepts printf-style args.
-static inline void printWarning(const char* fmt, ...) {
-  char tbuf[16];
-  formatBootTimeMs(tbuf, sizeof(tbuf), millis());
-  char msg[384];
-  va_list ap;
-  va_start(ap, fmt);
-  vsnprintf(msg, sizeof(msg), fmt, ap);
-  va_end(ap);
-  char out[420];
-  snprintf(out, sizeof(out), "[%s] [WARN] %s\n", tbuf, msg);
-  Serial.print(out);
-  // Append warning into LittleFS logfile
-  if (LittleFS.begin()) {
-    File f = LittleFS.open("/app.log", "a");
-    if (f) {
-      f.print(out);
-      f.close();
-    }
-  }
-}
-
 // --------- App state ----------
 // ---- Reset reason (persisted from setup) ----
 static esp_reset_reason_t g_reset_reason = ESP_RST_UNKNOWN;
@@ -83,17 +52,30 @@ static const char* resetReasonToStr(esp_reset_reason_t r) {
   }
 }
 
-int outputLimitW = 2000;
-float outputDutyCycle = 0.0f; // 0.0 - 1.0 (represented as percent in UI)
+// Written by HTTP handlers (httpd task), read by loop(): atomics
+std::atomic<int> outputLimitW{2000};
+std::atomic<float> outputDutyCycle{0.0f}; // 0.0 - 1.0 (represented as percent in UI)
+// true: outputDutyCycle is driven by the diversion controller, not by /cmd
+std::atomic<bool> diversionAuto{false};
+// Controller as of its last update, copied out under the mux by /metrics
+portMUX_TYPE diversionMux = portMUX_INITIALIZER_UNLOCKED;
+DiversionController diversionState;
 
 // --- Display row definitions ---
+// Thermistors two per row: the first pair on ROW_TEMP, the rest after the battery row
+static constexpr uint8_t TEMP_ROWS = (THERMISTOR_COUNT + 1) / 2;
 enum DisplayRow : uint8_t {
   ROW_SOC = 0,
   ROW_TEMP,
   ROW_PV_POWER,
   ROW_BATT_POWER,
-  ROW_COUNT
+  ROW_TEMP_MORE,
+  ROW_COUNT = ROW_TEMP_MORE + (TEMP_ROWS > 1 ? TEMP_ROWS - 1 : 0),
+  // Parallel systems only: system total, then one row per unit
+  ROW_SYS = ROW_COUNT,
+  ROW_UNIT0
 };
+static_assert(ROW_UNIT0 + INVERTER_MAX_UNITS <= DISPLAY_MAX_ROWS, "display rows");
 
 
 // --------- Embedded web UI helpers (LittleFS) ----------
@@ -187,44 +169,32 @@ void setup() {
   g_reset_reason = esp_reset_reason();
   g_reset_reason_str = resetReasonToStr(g_reset_reason);
   Serial.printf("[BOOT] reset reason=%d (%s)\n", (int)g_reset_reason, g_reset_reason_str);
-  // Also log reboot reason as a WARN (will append to LittleFS via printWarning)
-  printWarning("[BOOT] reset reason=%d (%s)", (int)g_reset_reason, g_reset_reason_str);
+  // Also log reboot reason as a WARN (queued; written to /app.log once the logger runs)
+  LOGW(LOG_MOD_APP, "[BOOT] reset reason=%d (%s)", (int)g_reset_reason, g_reset_reason_str);
   // Initialize QC1602A display (4-bit wiring)
   display_init();
   display_set_row_count(ROW_COUNT);
 
   // Initialize webserver / LittleFS (web UI files in data/ will be uploaded to device)
   initWebServer();
+  // Logger flushes to Serial and /app.log from its own task
+  log_init();
+  // Persistent history segments live on the same LittleFS partition
+  history_store_init();
 
   initializeWiFi();
   // Provide reset info and register HTTP routes
   webserver_set_reset_info((int)g_reset_reason, g_reset_reason_str);
   webserver_setup_routes();
-  server.begin();
-
-  // Setup PWM output pin
-  pinMode(PWM_PIN, OUTPUT);
-  digitalWrite(PWM_PIN, LOW);
-  Serial.println("HTTP :80");
-
-  // Configure ADC for thermistors on GPIO34 and GPIO35
-  analogReadResolution(12); // 12-bit (0..4095), default on ESP32 but explicit
-  analogSetPinAttenuation(THERMISTOR_L_PIN, ADC_11db); // ~0..3.3V range
-  analogSetPinAttenuation(THERMISTOR_H_PIN, ADC_11db); // ~0..3.3V range
-
-  // Optional: quick probe log
-  float tL = read_thermistor_temp_c(THERMISTOR_L_PIN);
-  float tH = read_thermistor_temp_c(THERMISTOR_H_PIN);
-  if (!isnan(tL)) {
-    Serial.printf("Thermistor L initial T = %.2f °C\n", tL);
-  } else {
-    Serial.printf("Thermistor L initial read invalid (check wiring/divider).\n");
-  }
-  if (!isnan(tH)) {
-    Serial.printf("Thermistor H initial T = %.2f °C\n", tH);
-  } else {
-    Serial.printf("Thermistor H initial read invalid (check wiring/divider).\n");
-  }
+
+  // PWM output (hardware driven, starts off)
+  pwm_output_init();
+
+  // Thermistors are sampled in the background (first values logged ~1 s in)
+  thermistor_init();
+
+  // Touch buttons: interrupt-driven task, calibrates the pads as it starts
+  touch_input_init();
 
   // Initialize inverter RS232 communication (background task)
   inverter_comm_init();
@@ -238,86 +208,84 @@ struct Task {
   void (*fn)();      // function to execute
 };
 
-// --- Button state tracking ---
-struct BtnState {
-  bool pressed;
-  uint32_t pressStartMs;
-};
-
-static BtnState btnStates[4] = {{false, 0}, {false, 0}, {false, 0}, {false, 0}};
-
 // --- Button handlers (called on button events) ---
-// Button names reflect physical position: Up, Left, Down, Right
+// Button names reflect physical position: Up, Left, Down, Right.
+// Auto-repeat calls the press handler again while the pad is held.
 void onBtnUpPress() { display_scroll_up(); }
+void onBtnUpLongPress() {}
 void onBtnUpRelease(int durationMs) {}
 
 void onBtnLeftPress() {}
+void onBtnLeftLongPress() {}
 void onBtnLeftRelease(int durationMs) {}
 
 void onBtnDownPress() { display_scroll_down(); }
+void onBtnDownLongPress() {}
 void onBtnDownRelease(int durationMs) {}
 
 void onBtnRightPress() {}
+void onBtnRightLongPress() {}
 void onBtnRightRelease(int durationMs) {}
 
 // Button handler dispatch (indexed: 0=Up, 1=Left, 2=Down, 3=Right)
 typedef void (*BtnPressFn)();
 typedef void (*BtnReleaseFn)(int);
 
-static const BtnPressFn btnPressHandlers[4] = {
+static const BtnPressFn btnPressHandlers[TOUCH_BUTTON_COUNT] = {
   &onBtnUpPress,
   &onBtnLeftPress,
   &onBtnDownPress,
   &onBtnRightPress
 };
 
-static const BtnReleaseFn btnReleaseHandlers[4] = {
+static const BtnPressFn btnLongPressHandlers[TOUCH_BUTTON_COUNT] = {
+  &onBtnUpLongPress,
+  &onBtnLeftLongPress,
+  &onBtnDownLongPress,
+  &onBtnRightLongPress
+};
+
+static const BtnReleaseFn btnReleaseHandlers[TOUCH_BUTTON_COUNT] = {
   &onBtnUpRelease,
   &onBtnLeftRelease,
   &onBtnDownRelease,
   &onBtnRightRelease
 };
 
-static void task_scan_touch() {
-  const uint8_t touches[4] = {BTN_UP_TOUCH, BTN_LEFT_TOUCH, BTN_DOWN_TOUCH, BTN_RIGHT_TOUCH};
-  const uint32_t nowMs = millis();
-  bool btnStateChanged = false;
-
-  for (int i = 0; i < 4; i++) {
-    uint16_t raw = touchRead(touches[i]);
-    bool nowPressed = (raw <= BTN_TOUCH_THRESHOLD);
-    if (nowPressed) {
-      Serial.printf("T%d=%u %s\n", i, (unsigned)raw, nowPressed ? "PRESSED" : "RELEASED");
-    }
-
-    // Detect falling edge (press)
-    if (nowPressed && !btnStates[i].pressed) {
-      btnStates[i].pressed = true;
-      btnStates[i].pressStartMs = nowMs;
-      btnPressHandlers[i]();
-      btnStateChanged = true;
-    }
-    // Detect rising edge (release)
-    else if (!nowPressed && btnStates[i].pressed) {
-      btnStates[i].pressed = false;
-      int durationMs = (int)(nowMs - btnStates[i].pressStartMs);
-      btnReleaseHandlers[i](durationMs);
-      btnStateChanged = true;
+// Touch sensing runs in its own task (touch_input.h); this only drains its queue
+static void dispatch_touch_events() {
+  TouchEvent ev;
+  bool any = false;
+  while (touch_input_next(&ev)) {
+    switch (ev.type) {
+    case TOUCH_PRESS:
+    case TOUCH_REPEAT:  btnPressHandlers[ev.pad](); break;
+    case TOUCH_LONG:    btnLongPressHandlers[ev.pad](); break;
+    case TOUCH_RELEASE: btnReleaseHandlers[ev.pad]((int)ev.held_ms); break;
+    default: break;
     }
+    any = true;
   }
 
   // Activate backlight on any button event
-  if (btnStateChanged) {
+  if (any) {
     displayBacklightOn();
   }
 }
 
 static void refresh_inverter_status() {
-  InverterState s = {};
-  inverter_get_status(&s);
+  // Skip reformatting when nothing was published since the last refresh
+  static uint32_t lastGeneration = UINT32_MAX;
+  uint32_t generation = inverter_snapshot_generation();
+  if (generation == lastGeneration) return;
+  lastGeneration = generation;
+
+  InverterSnapshot snap;
+  inverter_get_snapshot(&snap);
+  const InverterState& s = snap.status;
 
   char buf[17];
-  if (!g_inverter_data_valid) {
+  if (!snap.valid) {
     display_set_row(ROW_SOC, "SoC: --");
     display_set_row(ROW_PV_POWER, "PV: --");
     display_set_row(ROW_BATT_POWER, "Bat: --");
@@ -334,6 +302,27 @@ static void refresh_inverter_status() {
     snprintf(buf, sizeof(buf), "Bat: %d/%dW", charge_w, discharge_w);
     display_set_row(ROW_BATT_POWER, buf);
   }
+
+  // Parallel units appear as extra rows once QPGSn discovered them
+  const ParallelTotals& pt = snap.parallel;
+  static uint8_t lastUnits = 0;
+  if (pt.units != lastUnits) {
+    lastUnits = pt.units;
+    display_set_row_count(pt.units ? ROW_UNIT0 + pt.units : ROW_COUNT);
+  }
+  if (pt.units) {
+    ParallelView pv;
+    inverter_get_parallel(&pv);
+    snprintf(buf, sizeof(buf), "Sys%s %u/%u %dW", pt.faulted ? "!" : ":", pt.present, pt.units, (int)pt.ac_active_w);
+    display_set_row(ROW_SYS, buf);
+    for (uint8_t i = 0; i < pt.units; ++i) {
+      const InverterUnitState& u = pv.units[i];
+      if (!u.present) snprintf(buf, sizeof(buf), "U%u: --", (unsigned)i);
+      else if (u.fault_code) snprintf(buf, sizeof(buf), "U%u %c F%02u %dW", (unsigned)i, u.work_mode, u.fault_code, u.ac_active_w);
+      else snprintf(buf, sizeof(buf), "U%u %c %dW %dA", (unsigned)i, u.work_mode, u.ac_active_w, u.batt_charge_current - u.batt_discharge_current);
+      display_set_row(ROW_UNIT0 + i, buf);
+    }
+  }
   display_redraw();
 }
 
@@ -348,44 +337,91 @@ static void format_temp_str(char* buf, float temp) {
 }
 
 static void task_update_temperature() {
-  g_temp_l = read_thermistor_temp_c(THERMISTOR_L_PIN);
-  g_temp_h = read_thermistor_temp_c(THERMISTOR_H_PIN);
-
-  char h_str[6], l_str[6], buf[17];
-  format_temp_str(h_str, g_temp_h);
-  format_temp_str(l_str, g_temp_l);
-  snprintf(buf, sizeof(buf), "T: %s/%s\xDF" "C", h_str, l_str);
-  display_set_row(ROW_TEMP, buf);
+  static uint32_t lastGeneration = UINT32_MAX;
+  uint32_t generation = thermistor_generation();
+  if (generation == lastGeneration) return;
+  lastGeneration = generation;
+
+  // "H 45.1 L 30.2\xDF" "C": two channels per row
+  for (uint8_t row = 0; row < TEMP_ROWS; ++row) {
+    char buf[24];
+    int len = 0;
+    for (uint8_t i = row * 2; i < THERMISTOR_COUNT && i < row * 2 + 2; ++i) {
+      char t_str[8];
+      format_temp_str(t_str, thermistor_temp_c(i));
+      len += snprintf(buf + len, sizeof(buf) - len, "%s%s %s", i % 2 ? " " : "", thermistor_info(i).label, t_str);
+    }
+    snprintf(buf + len, sizeof(buf) - len, "\xDF" "C");
+    display_set_row(row == 0 ? ROW_TEMP : ROW_TEMP_MORE + row - 1, buf);
+  }
   display_redraw();
 }
 
+// Runs the diversion controller once per new QPIGS sample of device 0
+static void task_diversion() {
+  static DiversionController ctl;
+  static uint32_t lastTs = 0;
+  static bool wasAuto = false;
+
+  bool autoOn = diversionAuto.load();
+  if (autoOn != wasAuto) {
+    wasAuto = autoOn;
+    ctl.reset();
+    outputDutyCycle = 0.0f;
+    LOGI(LOG_MOD_APP, "diversion: %s", autoOn ? "auto" : "manual");
+  }
+  if (!autoOn) return;
+
+  InverterSnapshot snap;
+  inverter_get_snapshot(&snap);
+  if (!snap.valid) {
+    // No data from the inverter: never keep a load running blind
+    if (outputDutyCycle.load() != 0.0f) LOGW(LOG_MOD_APP, "diversion: no inverter data, output off");
+    ctl.reset();
+    outputDutyCycle = 0.0f;
+  } else if (snap.status.ts_ms != lastTs) {
+    lastTs = snap.status.ts_ms;
+    outputDutyCycle = ctl.update(snap.status, snap.temp_h, snap.temp_l, outputLimitW.load());
+  } else {
+    return;
+  }
+  portENTER_CRITICAL(&diversionMux);
+  diversionState = ctl;
+  portEXIT_CRITICAL(&diversionMux);
+}
+
 static void task_diag_heap() {
   // Periodic diagnostics to catch memory/stack issues causing resets after hours
   size_t freeHeap = ESP.getFreeHeap();
   size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT);
-  printWarning("heap free=%u, largest=%u", (unsigned)freeHeap, (unsigned)largest);
+  LOGW(LOG_MOD_APP, "heap free=%u, largest=%u", (unsigned)freeHeap, (unsigned)largest);
 }
 
 // Task table and their periods
 static Task tasks[] = {
-  {  50u,      0u, &task_scan_touch },
   { 250u,      0u, &refresh_inverter_status },
+  { 100u,      0u, &task_diversion },
+  { 250u,      0u, &status_events_pump },
+  { 1000u,     0u, &webserver_reap_idle },
+  { 250u,      0u, &telemetry_udp_pump },
   { 1000u,     0u, &task_update_temperature },
   { 1000u,     0u, &checkDisplayBacklightTimeout },
   { 600000u,   0u, &task_diag_heap }
 };
 
 void loop() {
-  uint32_t t0 = millis();
-  server.handleClient();
-  uint32_t t1 = millis();
-
-  // Log if handleClient takes unusually long (indicates blocking)
-  uint32_t hdlDur = t1 - t0;
-  if (hdlDur > 100) {
-    printWarning("server.handleClient() took %ums", hdlDur);
+  // HTTP is served by its own task; track loop() cadence to show it stays flat
+  static uint32_t lastLoopUs = micros();
+  uint32_t nowUs = micros();
+  uint32_t periodUs = nowUs - lastLoopUs;
+  lastLoopUs = nowUs;
+  webserver_note_loop(periodUs);
+  if (periodUs > 100000u) {
+    LOGW(LOG_MOD_APP, "loop() stalled for %ums", (unsigned)(periodUs / 1000u));
   }
 
+  dispatch_touch_events();
+
   // --- Periodic tasks via a simple Task array ---
   uint32_t nowMs = millis();
   for (auto &t : tasks) {
@@ -396,12 +432,9 @@ void loop() {
     }
   }
 
-  // Software PWM: period 2000 ms (2s). Drive `PWM_PIN` HIGH for
-  // outputDutyCycle * period, otherwise LOW. `outputDutyCycle` is 0.0-1.0.
-  const uint32_t pwmPeriodMs = 2000;
-  uint32_t phase = millis() % pwmPeriodMs;
-  uint32_t onTime = (uint32_t)round(outputDutyCycle * (float)pwmPeriodMs);
-  digitalWrite(PWM_PIN, (phase < onTime) ? HIGH : LOW);
+  // Refresh the PWM duty every iteration: this also feeds its fail-safe, so a
+  // stalled loop() turns the output off (see pwm_output.h)
+  pwm_output_set_duty(outputDutyCycle.load());
   // Small yield to allow WiFi/RTOS background tasks to run and avoid starvation
   delay(5);
 }
\ No newline at end of file
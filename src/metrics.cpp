@@ -0,0 +1,332 @@
+#include "metrics.h"
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <math.h>
+#include <stdarg.h>
+#include <string.h>
+#include "inverter_comm.h"
+#include "pwm_output.h"
+#include "thermistor.h"
+#include "display.h"
+#include "touch_input.h"
+
+#define OPENMETRICS_CONTENT_TYPE "application/openmetrics-text; version=1.0.0; charset=utf-8"
+#define PROM_TEXT_CONTENT_TYPE   "text/plain; version=0.0.4; charset=utf-8"
+
+struct MetricsWriter {
+  httpd_req_t* req;
+  char* buf;
+  size_t cap;
+  size_t len;
+  bool openmetrics;
+  esp_err_t err;
+};
+
+static void mw_flush(MetricsWriter& w) {
+  if (w.len && w.err == ESP_OK) w.err = httpd_resp_send_chunk(w.req, w.buf, w.len);
+  w.len = 0;
+}
+
+// Append one formatted piece; flushes first when it does not fit
+static void mw_printf(MetricsWriter& w, const char* fmt, ...) {
+  if (w.err != ESP_OK) return;
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(w.buf + w.len, w.cap - w.len, fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    if ((size_t)n < w.cap - w.len) {
+      w.len += n;
+      return;
+    }
+    mw_flush(w);   // drop the partial write and retry on an empty buffer
+  }
+}
+
+static void mw_family(MetricsWriter& w, const char* name, const char* type, const char* help) {
+  // Counter families are named without _total in OpenMetrics, with it in 0.0.4
+  bool counter = strcmp(type, "counter") == 0;
+  const char* suffix = (counter && !w.openmetrics) ? "_total" : "";
+  mw_printf(w, "# TYPE %s%s %s\n# HELP %s%s %s\n", name, suffix, type, name, suffix, help);
+}
+
+static void mw_gauge(MetricsWriter& w, const char* name, const char* help, double v) {
+  mw_family(w, name, "gauge", help);
+  mw_printf(w, "%s %.6g\n", name, v);
+}
+
+// One histogram series; labels is "" or `key="value",`
+static void mw_histogram(MetricsWriter& w, const char* name, const char* labels, const Histogram& h) {
+  uint32_t cum = 0;
+  for (uint8_t i = 0; i < h.n_bounds; ++i) {
+    cum += h.counts[i];
+    mw_printf(w, "%s_bucket{%sle=\"%g\"} %u\n", name, labels, (double)h.bounds[i] / h.unit_per_s, (unsigned)cum);
+  }
+  cum += h.counts[h.n_bounds];
+  mw_printf(w, "%s_bucket{%sle=\"+Inf\"} %u\n", name, labels, (unsigned)cum);
+  // Strip the trailing comma for the plain series
+  int ll = (int)strlen(labels);
+  if (ll) ll--;
+  mw_printf(w, "%s_count%s%.*s%s %u\n", name, ll ? "{" : "", ll, labels, ll ? "}" : "", (unsigned)h.count);
+  mw_printf(w, "%s_sum%s%.*s%s %.6g\n", name, ll ? "{" : "", ll, labels, ll ? "}" : "",
+            (double)h.sum / h.unit_per_s);
+}
+
+// InverterState gauges, same order as the struct
+struct StateGauge {
+  const char* name;
+  const char* help;
+  double (*get)(const InverterState& s);
+};
+
+#define SG(name, help, expr) { name, help, [](const InverterState& s) -> double { return (expr); } }
+
+static const StateGauge STATE_GAUGES[] = {
+  SG("inverter_grid_voltage_volts",           "Grid voltage",                          s.grid_voltage),
+  SG("inverter_grid_frequency_hertz",         "Grid frequency",                        s.grid_frequency),
+  SG("inverter_ac_out_voltage_volts",         "AC output voltage",                     s.ac_out_voltage),
+  SG("inverter_ac_out_frequency_hertz",       "AC output frequency",                   s.ac_out_frequency),
+  SG("inverter_ac_out_apparent_power_va",     "AC output apparent power",              s.ac_apparent_va),
+  SG("inverter_ac_out_active_power_watts",    "AC output active power",                s.ac_active_w),
+  SG("inverter_load_percent",                 "Output load",                           s.load_percent),
+  SG("inverter_bus_voltage_volts",            "DC bus voltage",                        s.bus_voltage),
+  SG("inverter_battery_voltage_volts",        "Battery voltage",                       s.batt_voltage),
+  SG("inverter_battery_charge_current_amperes", "Battery charging current",            s.batt_charge_current),
+  SG("inverter_battery_soc_percent",          "Battery capacity",                      s.batt_soc),
+  SG("inverter_heatsink_temperature_celsius", "Heat sink temperature",                 s.heatsink_temp),
+  SG("inverter_pv_input_current_amperes",     "PV input current for battery",          s.pv_input_current),
+  SG("inverter_pv_input_voltage_volts",       "PV input voltage",                      s.pv_input_voltage),
+  SG("inverter_battery_voltage_scc_volts",    "Battery voltage from SCC",              s.batt_voltage_from_scc),
+  SG("inverter_battery_discharge_current_amperes", "Battery discharge current",        s.batt_discharge_current),
+  SG("inverter_device_status_bits",           "QPIGS device status bits b7..b0",       s.device_status_bits),
+  SG("inverter_battery_fan_offset_volts",     "Battery voltage offset for fans on",    s.batt_fan_offset_10mv * 0.01),
+  SG("inverter_eeprom_version",               "EEPROM version",                        s.eeprom_version),
+  SG("inverter_pv_charging_power_watts",      "PV charging power",                     s.pv_charging_power),
+  SG("inverter_additional_status_bits",       "QPIGS additional status bits b10..b8",  s.additional_status_bits),
+};
+
+static const char* const ERROR_KINDS[] = { "timeout", "crc", "nak", "malformed" };
+
+esp_err_t metrics_send(httpd_req_t* req, char* buf, size_t cap, const MetricsContext& ctx) {
+  char accept[96];
+  bool om = httpd_req_get_hdr_value_str(req, "Accept", accept, sizeof(accept)) == ESP_OK &&
+            strstr(accept, "application/openmetrics-text") != nullptr;
+  httpd_resp_set_type(req, om ? OPENMETRICS_CONTENT_TYPE : PROM_TEXT_CONTENT_TYPE);
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  MetricsWriter w = { req, buf, cap, 0, om, ESP_OK };
+
+  InverterSnapshot snap;
+  inverter_get_snapshot(&snap, ctx.dev);
+
+  // ---- Inverter state ----
+  mw_gauge(w, "inverter_devices", "Inverters on separate serial links (select with ?dev=)", inverter_device_count());
+  mw_gauge(w, "inverter_up", "1 if the last poll cycle succeeded", snap.valid ? 1 : 0);
+  mw_gauge(w, "inverter_snapshot_generation", "Snapshot publish counter", snap.generation);
+  if (snap.valid) {
+    for (const auto& g : STATE_GAUGES) mw_gauge(w, g.name, g.help, g.get(snap.status));
+    mw_gauge(w, "inverter_status_age_seconds", "Time since the status was read", (millis() - snap.status.ts_ms) / 1000.0);
+  }
+  mw_family(w, "inverter_mode", "gauge", "Operating mode from QMOD (value is always 1)");
+  mw_printf(w, "inverter_mode{code=\"%c\",name=\"%s\"} 1\n", snap.mode_code ? snap.mode_code : '?', snap.mode_name);
+
+  // ---- Parallel units (only when QPGSn found any) ----
+  if (snap.parallel.units) {
+    ParallelView pv;
+    inverter_get_parallel(&pv, ctx.dev);
+    static const struct { const char* name; const char* help; } UNIT_FAMILIES[] = {
+      { "inverter_unit_up", "1 if the parallel unit answers QPGSn" },
+      { "inverter_unit_active_power_watts", "Parallel unit AC output active power" },
+      { "inverter_unit_apparent_power_va", "Parallel unit AC output apparent power" },
+      { "inverter_unit_battery_charge_current_amperes", "Parallel unit battery charging current" },
+      { "inverter_unit_battery_discharge_current_amperes", "Parallel unit battery discharge current" },
+      { "inverter_unit_fault_code", "Parallel unit fault code (0 = none)" },
+    };
+    for (int f = 0; f < 6; ++f) {
+      mw_family(w, UNIT_FAMILIES[f].name, "gauge", UNIT_FAMILIES[f].help);
+      for (uint8_t i = 0; i < pv.total.units; ++i) {
+        const InverterUnitState& u = pv.units[i];
+        if (f > 0 && !u.present) continue;
+        const int vals[] = { u.present ? 1 : 0, u.ac_active_w, u.ac_apparent_va, u.batt_charge_current,
+                             u.batt_discharge_current, u.fault_code };
+        mw_printf(w, "%s{unit=\"%u\",serial=\"%s\"} %d\n", UNIT_FAMILIES[f].name, (unsigned)i, u.serial, vals[f]);
+      }
+    }
+    const ParallelTotals& t = snap.parallel;
+    mw_gauge(w, "inverter_system_units", "Parallel units answering", t.present);
+    mw_gauge(w, "inverter_system_active_power_watts", "Sum of unit AC output active power", t.ac_active_w);
+    mw_gauge(w, "inverter_system_apparent_power_va", "Sum of unit AC output apparent power", t.ac_apparent_va);
+    mw_gauge(w, "inverter_system_battery_charge_current_amperes", "Sum of unit battery charging current", t.batt_charge_current);
+  }
+
+  // ---- Controller ----
+  // Thermistors belong to the controller, not to a device
+  mw_family(w, "controller_temperature_celsius", "gauge", "Thermistor temperature");
+  for (uint8_t i = 0; i < THERMISTOR_COUNT; ++i) {
+    float t = thermistor_temp_c(i);
+    if (!isnan(t)) mw_printf(w, "controller_temperature_celsius{sensor=\"%s\"} %.2f\n", thermistor_info(i).name, t);
+  }
+  mw_family(w, "controller_temperature_offset_celsius", "gauge", "Thermistor calibration offset (included above)");
+  for (uint8_t i = 0; i < THERMISTOR_COUNT; ++i) {
+    mw_printf(w, "controller_temperature_offset_celsius{sensor=\"%s\"} %.2f\n", thermistor_info(i).name,
+              thermistor_offset_c(i));
+  }
+  mw_gauge(w, "controller_heap_free_bytes", "Free heap", ESP.getFreeHeap());
+  mw_gauge(w, "controller_heap_min_free_bytes", "Lowest free heap since boot", ESP.getMinFreeHeap());
+  mw_gauge(w, "controller_heap_largest_free_block_bytes", "Largest allocatable block",
+           heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT));
+  mw_gauge(w, "controller_uptime_seconds", "Time since boot", millis() / 1000.0);
+  // Reason label is the ESP_RST_xxx token, without the description
+  const char* rr = ctx.reset_reason_str ? ctx.reset_reason_str : "";
+  int rr_len = (int)strcspn(rr, ":\"\\\n");
+  mw_family(w, "controller_reset_reason", "gauge", "Reason of the last reset (value is esp_reset_reason_t)");
+  mw_printf(w, "controller_reset_reason{reason=\"%.*s\"} %d\n", rr_len, rr, ctx.reset_reason);
+
+  // ---- UART link ----
+  InverterCmdStats st[INV_CMD_COUNT];
+  for (int i = 0; i < INV_CMD_COUNT; ++i) inverter_get_cmd_stats((InverterCmdId)i, &st[i], ctx.dev);
+  mw_family(w, "inverter_uart_requests", "counter", "Commands sent to the inverter");
+  for (int i = 0; i < INV_CMD_COUNT; ++i) {
+    mw_printf(w, "inverter_uart_requests_total{command=\"%s\"} %u\n", inverter_cmd_name((InverterCmdId)i), (unsigned)st[i].sent);
+  }
+  mw_family(w, "inverter_uart_errors", "counter", "Failed transactions by kind");
+  for (int i = 0; i < INV_CMD_COUNT; ++i) {
+    const uint32_t counts[] = { st[i].timeouts, st[i].crc_errors, st[i].naks, st[i].malformed };
+    for (int k = 0; k < 4; ++k) {
+      mw_printf(w, "inverter_uart_errors_total{command=\"%s\",kind=\"%s\"} %u\n",
+                inverter_cmd_name((InverterCmdId)i), ERROR_KINDS[k], (unsigned)counts[k]);
+    }
+  }
+  mw_family(w, "inverter_uart_rtt_seconds", "histogram", "Round-trip time of successful commands");
+  for (int i = 0; i < INV_CMD_COUNT; ++i) {
+    char labels[32];
+    snprintf(labels, sizeof(labels), "command=\"%s\",", inverter_cmd_name((InverterCmdId)i));
+    mw_histogram(w, "inverter_uart_rtt_seconds", labels, st[i].rtt_hist);
+  }
+  Histogram cycle;
+  inverter_get_cycle_histogram(&cycle, ctx.dev);
+  mw_family(w, "inverter_status_interval_seconds", "histogram", "Interval between QPIGS status updates");
+  mw_histogram(w, "inverter_status_interval_seconds", "", cycle);
+
+  // ---- Command scheduler ----
+  uint32_t poll_ms;
+  PollReason reason;
+  inverter_get_poll_rate(&poll_ms, &reason, ctx.dev);
+  mw_family(w, "inverter_poll_interval_seconds", "gauge", "Adaptive QPIGS period and the reason it was chosen");
+  mw_printf(w, "inverter_poll_interval_seconds{reason=\"%s\"} %.3f\n", PollRateController::reason_name(reason), poll_ms / 1000.0);
+  SchedLinkStats link;
+  inverter_get_link_stats(&link, ctx.dev);
+  mw_gauge(w, "inverter_link_utilization_ratio", "Busy share of the serial link in the last window",
+           link.util_permille / 1000.0);
+  mw_family(w, "inverter_link_busy_seconds", "counter", "Time the serial link spent in transactions");
+  mw_printf(w, "inverter_link_busy_seconds_total %.3f\n", link.busy_ms / 1000.0);
+  static const struct { const char* name; const char* type; const char* help; } SCHED_FAMILIES[] = {
+    { "inverter_sched_deadline_misses", "counter", "Commands started after their deadline" },
+    { "inverter_sched_skipped", "counter", "Releases dropped because a whole period passed" },
+    { "inverter_sched_max_lateness_seconds", "gauge", "Worst start delay after release" },
+  };
+  for (int f = 0; f < 3; ++f) {
+    mw_family(w, SCHED_FAMILIES[f].name, SCHED_FAMILIES[f].type, SCHED_FAMILIES[f].help);
+    SchedEntry e;
+    SchedCmdStats ss;
+    for (size_t i = 0; inverter_get_schedule(i, &e, &ss, ctx.dev); ++i) {
+      const char* cmd = inverter_cmd_name((InverterCmdId)e.cmd);
+      if (f == 0) mw_printf(w, "inverter_sched_deadline_misses_total{command=\"%s\"} %u\n", cmd, (unsigned)ss.deadline_misses);
+      else if (f == 1) mw_printf(w, "inverter_sched_skipped_total{command=\"%s\"} %u\n", cmd, (unsigned)ss.skipped);
+      else mw_printf(w, "inverter_sched_max_lateness_seconds{command=\"%s\"} %.3f\n", cmd, ss.max_lateness_ms / 1000.0);
+    }
+  }
+
+  // ---- Setter commands ----
+  WriteStats ws;
+  Histogram wh;
+  inverter_get_write_stats(&ws, &wh, ctx.dev);
+  mw_family(w, "inverter_write_commands", "counter", "Setter commands by final answer");
+  const struct { const char* result; uint32_t n; } WRITE_RESULTS[] = {
+    { "ack", ws.acks }, { "nak", ws.naks }, { "failed", ws.failed }, { "rejected", ws.rejected },
+  };
+  for (const auto& r : WRITE_RESULTS) {
+    mw_printf(w, "inverter_write_commands_total{result=\"%s\"} %u\n", r.result, (unsigned)r.n);
+  }
+  mw_family(w, "inverter_write_retries", "counter", "Setter transmissions repeated after no answer");
+  mw_printf(w, "inverter_write_retries_total %u\n", (unsigned)ws.retries);
+  mw_family(w, "inverter_write_latency_seconds", "histogram", "Setter submission to ACK/NAK/failure");
+  mw_histogram(w, "inverter_write_latency_seconds", "", wh);
+
+  // ---- PWM output ----
+  PwmStats ps;
+  pwm_output_get_stats(&ps);
+  mw_family(w, "pwm_info", "gauge", "PWM backend and period (value is always 1)");
+  mw_printf(w, "pwm_info{mode=\"%s\",period_ms=\"%u\",bits=\"%u\"} 1\n", pwm_output_mode_name(ps.mode),
+            (unsigned)ps.period_ms, (unsigned)ps.resolution_bits);
+  mw_gauge(w, "pwm_duty_ratio", "Requested PWM duty", ps.duty);
+  mw_gauge(w, "pwm_failsafe_active", "1 while the fail-safe holds the output off", ps.tripped ? 1 : 0);
+  mw_family(w, "pwm_failsafe_trips", "counter", "Fail-safe activations (controller stopped refreshing)");
+  mw_printf(w, "pwm_failsafe_trips_total %u\n", (unsigned)ps.trips);
+  mw_family(w, "pwm_edge_jitter_seconds", "histogram", "Deviation of rising-edge intervals from the period");
+  mw_histogram(w, "pwm_edge_jitter_seconds", "", ps.jitter);
+  mw_gauge(w, "pwm_edge_jitter_max_seconds", "Worst rising-edge interval deviation", ps.max_jitter_us / 1e6);
+  mw_family(w, "pwm_edge_jitter_lost", "counter", "Edge intervals dropped before binning (probe ring full)");
+  mw_printf(w, "pwm_edge_jitter_lost_total %u\n", (unsigned)ps.jitter_lost);
+
+  // ---- LCD ----
+  DisplayStats ds;
+  display_get_stats(&ds);
+  mw_family(w, "display_frames", "counter", "LCD frames that wrote to the bus");
+  mw_printf(w, "display_frames_total %u\n", (unsigned)ds.frames);
+  mw_family(w, "display_bus_bytes", "counter", "LCD commands and characters sent");
+  mw_printf(w, "display_bus_bytes_total %u\n", (unsigned)ds.bytes);
+  mw_family(w, "display_full_line_bytes", "counter", "Bytes whole-line redraws of the same frames would have sent");
+  mw_printf(w, "display_full_line_bytes_total %u\n", (unsigned)ds.full_line_bytes);
+  mw_family(w, "display_frame_seconds", "histogram", "LCD bus time per frame");
+  mw_histogram(w, "display_frame_seconds", "", ds.frame_us);
+  mw_gauge(w, "display_frame_max_seconds", "Longest LCD frame", ds.max_frame_us / 1e6);
+
+  // ---- Touch buttons ----
+  TouchStats ts;
+  touch_input_get_stats(&ts);
+  mw_family(w, "touch_events", "counter", "Touch button events queued for loop()");
+  for (uint8_t p = 0; p < TOUCH_BUTTON_COUNT; ++p) {
+    for (uint8_t t = 0; t < TOUCH_EVENT_TYPES; ++t) {
+      mw_printf(w, "touch_events_total{pad=\"%s\",type=\"%s\"} %u\n", touch_input_pad_name(p),
+                touch_input_event_name((TouchEventType)t), (unsigned)ts.events[p][t]);
+    }
+  }
+  mw_family(w, "touch_dropped_events", "counter", "Touch events lost to a full queue");
+  mw_printf(w, "touch_dropped_events_total %u\n", (unsigned)ts.dropped);
+  mw_family(w, "touch_interrupts", "counter", "Touch threshold interrupts");
+  mw_printf(w, "touch_interrupts_total %u\n", (unsigned)ts.interrupts);
+  mw_family(w, "touch_recalibrations", "counter", "Stuck presses taken as drift and re-baselined");
+  mw_printf(w, "touch_recalibrations_total %u\n", (unsigned)ts.recalibrations);
+  mw_family(w, "touch_baseline_counts", "gauge", "Tracked untouched reading per pad");
+  for (uint8_t p = 0; p < TOUCH_BUTTON_COUNT; ++p) {
+    mw_printf(w, "touch_baseline_counts{pad=\"%s\"} %u\n", touch_input_pad_name(p), (unsigned)ts.baseline[p]);
+  }
+  mw_family(w, "touch_value_counts", "gauge", "Last reading per pad (drops when touched)");
+  for (uint8_t p = 0; p < TOUCH_BUTTON_COUNT; ++p) {
+    mw_printf(w, "touch_value_counts{pad=\"%s\"} %u\n", touch_input_pad_name(p), (unsigned)ts.value[p]);
+  }
+  mw_family(w, "touch_press_latency_seconds", "histogram", "First touched measurement to press handled in loop()");
+  mw_histogram(w, "touch_press_latency_seconds", "", ts.press_latency_us);
+
+  // ---- Diversion controller ----
+  const DiversionController& dc = ctx.diversion;
+  mw_gauge(w, "diversion_auto", "1 while the diversion controller drives the PWM duty", ctx.diversion_auto ? 1 : 0);
+  mw_family(w, "diversion_state", "gauge", "Diversion controller state (value is always 1)");
+  mw_printf(w, "diversion_state{reason=\"%s\"} 1\n", DiversionController::reason_name(dc.reason()));
+  mw_gauge(w, "diversion_power_watts", "Commanded dump load power", dc.power_w());
+  mw_gauge(w, "diversion_surplus_watts", "Estimated PV surplus (feed-forward)", dc.surplus_w());
+  mw_gauge(w, "diversion_error_watts", "Battery power minus its target", dc.error_w());
+  mw_gauge(w, "diversion_derate_ratio", "Thermal derating of the dump load cap", dc.derate());
+
+  // ---- HTTP ----
+  if (ctx.http_handler) {
+    mw_family(w, "http_handler_duration_seconds", "histogram", "Time spent in HTTP route handlers");
+    mw_histogram(w, "http_handler_duration_seconds", "", *ctx.http_handler);
+  }
+
+  if (om) mw_printf(w, "# EOF\n");
+  mw_flush(w);
+  if (w.err != ESP_OK) return w.err;
+  return httpd_resp_send_chunk(req, NULL, 0);
+}
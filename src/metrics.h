@@ -0,0 +1,34 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <esp_http_server.h>
+#include "histogram.h"
+#include "diversion.h"
+
+// GET /metrics: Prometheus text exposition, OpenMetrics 1.0 when the
+// scraper asks for it (Accept: application/openmetrics-text), else the
+// classic text format 0.0.4. Written with snprintf into a caller-provided
+// buffer and sent as HTTP chunks whenever it fills up, so nothing is
+// allocated however many series there are.
+//
+// Series: every InverterState field (omitted while the last poll failed,
+// see inverter_up), mode, thermistor temperatures, heap, uptime, reset
+// reason, per-command UART counters and RTT histograms, status update
+// interval and HTTP handler duration histograms, command scheduler link
+// utilization and deadline misses, setter command results and latency,
+// PWM output state and edge jitter, LCD bus time, diversion controller state.
+//
+// Inverter series describe one device (MetricsContext::dev, /metrics?dev=N);
+// inverter_devices tells a scraper how many there are to fetch.
+
+// State owned by the web server that the metrics need
+struct MetricsContext {
+  int reset_reason;
+  const char* reset_reason_str;   // "ESP_RST_xxx: description"
+  const Histogram* http_handler;  // [us]
+  uint8_t dev;                    // inverter device (inverter_comm.h)
+  bool diversion_auto;
+  DiversionController diversion;  // copy as of its last update
+};
+
+esp_err_t metrics_send(httpd_req_t* req, char* buf, size_t cap, const MetricsContext& ctx);
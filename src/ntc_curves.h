@@ -0,0 +1,21 @@
+#pragma once
+#include "ntc_table.h"
+
+// NTC + divider combinations the thermistor channels in config.h can use
+// (THERMISTOR_CHANNELS). Each curve is the parameter set plus its table,
+// generated by the compiler. A new sensor type is one pair of lines here.
+
+// NTC 10k B3950, 10k series resistor, 3.3 V (the two original thermistors)
+inline constexpr NtcCurve NTC_10K_B3950_CURVE = ntc_beta(10000.0, 10000.0, 3950.0);
+inline constexpr NtcTable NTC_10K_B3950 = ntc_make_table(NTC_10K_B3950_CURVE);
+
+// Generic 10k epoxy bead (e.g. battery lugs), Steinhart-Hart fit, 10k series
+inline constexpr NtcCurve NTC_10K_SH_CURVE = ntc_steinhart(10000.0, 1.009249522e-3, 2.378405444e-4, 2.019202697e-7);
+inline constexpr NtcTable NTC_10K_SH = ntc_make_table(NTC_10K_SH_CURVE);
+
+// Every curve, for doc/ntcTableCheck.cpp
+struct NtcCurveEntry { const char* name; const NtcCurve* curve; const NtcTable* table; };
+inline constexpr NtcCurveEntry NTC_CURVES[] = {
+  { "NTC_10K_B3950", &NTC_10K_B3950_CURVE, &NTC_10K_B3950 },
+  { "NTC_10K_SH",    &NTC_10K_SH_CURVE,    &NTC_10K_SH },
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+#include <limits>
+
+// NTC thermistor in a divider, low side:
+//   Vs --- r_series ---[ADC]--- NTC --- GND
+// converted from divider voltage to °C by a table generated at compile time
+// (constexpr), so a reading is one division and a linear interpolation
+// instead of logf() per sample. Plain C++ without Arduino dependencies so it
+// can be built on a host (doc/ntcTableCheck.cpp compares every table against
+// ntc_exact_c()).
+//
+// Curve models:
+//   Beta            1/T = 1/T0 + ln(R/R0) / B
+//   Steinhart-Hart  1/T = A + B ln(R) + C ln(R)^3   (used when sh_b != 0)
+
+#define NTC_TABLE_POINTS 257   // uniform in mV over 0..vsupply_mv
+
+struct NtcCurve {
+  double r_series_ohms;
+  double vsupply_mv;
+  double r0_ohms, beta, t0_k;     // Beta model
+  double sh_a, sh_b, sh_c;        // Steinhart-Hart model
+};
+
+struct NtcTable {
+  float mv_step;
+  float c[NTC_TABLE_POINTS];      // °C at i * mv_step; NAN at the rails
+};
+
+constexpr NtcCurve ntc_beta(double r_series_ohms, double r0_ohms, double beta, double vsupply_mv = 3300.0) {
+  return NtcCurve{ r_series_ohms, vsupply_mv, r0_ohms, beta, 298.15, 0.0, 0.0, 0.0 };
+}
+
+constexpr NtcCurve ntc_steinhart(double r_series_ohms, double a, double b, double c, double vsupply_mv = 3300.0) {
+  return NtcCurve{ r_series_ohms, vsupply_mv, 0.0, 0.0, 0.0, a, b, c };
+}
+
+// Natural log usable in constant expressions: scale into [0.5, 2) by powers
+// of two, then 2 atanh((x - 1) / (x + 1)) as a series (|y| <= 1/3)
+constexpr double ntc_ln(double x) {
+  int k = 0;
+  while (x >= 2.0) { x /= 2.0; ++k; }
+  while (x < 0.5) { x *= 2.0; --k; }
+  double y = (x - 1.0) / (x + 1.0);
+  double y2 = y * y, term = y, sum = 0.0;
+  for (int n = 1; n < 64; n += 2) {
+    sum += term / n;
+    term *= y2;
+  }
+  return 2.0 * sum + k * 0.69314718055994530942;
+}
+
+// Exact conversion: divider voltage [mV] -> °C; NAN at the rails
+constexpr double ntc_exact_c(const NtcCurve& curve, double mv) {
+  if (!(mv > 0.1) || !(mv < curve.vsupply_mv - 0.1)) return std::numeric_limits<double>::quiet_NaN();
+  // Vout = Vs * Rntc / (Rser + Rntc)  => Rntc = Rser * Vout / (Vs - Vout)
+  double r = curve.r_series_ohms * mv / (curve.vsupply_mv - mv);
+  double inv_t = 0.0;
+  if (curve.sh_b != 0.0) {
+    double lr = ntc_ln(r);
+    inv_t = curve.sh_a + curve.sh_b * lr + curve.sh_c * lr * lr * lr;
+  } else {
+    inv_t = 1.0 / curve.t0_k + ntc_ln(r / curve.r0_ohms) / curve.beta;
+  }
+  return 1.0 / inv_t - 273.15;
+}
+
+constexpr NtcTable ntc_make_table(const NtcCurve& curve) {
+  NtcTable t{};
+  t.mv_step = (float)(curve.vsupply_mv / (NTC_TABLE_POINTS - 1));
+  for (int i = 0; i < NTC_TABLE_POINTS; ++i) {
+    t.c[i] = (float)ntc_exact_c(curve, curve.vsupply_mv * i / (NTC_TABLE_POINTS - 1));
+  }
+  return t;
+}
+
+// Table conversion; NAN in the first and last segment (open/shorted sensor)
+inline float ntc_table_c(const NtcTable& t, float mv) {
+  if (!(mv >= 0.0f)) return NAN;
+  float pos = mv / t.mv_step;
+  int i = (int)pos;
+  if (i >= NTC_TABLE_POINTS - 1) return NAN;
+  float a = t.c[i], b = t.c[i + 1];
+  if (isnan(a) || isnan(b)) return NAN;
+  return a + (b - a) * (pos - (float)i);
+}
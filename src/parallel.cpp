@@ -0,0 +1,63 @@
+#include "parallel.h"
+
+uint8_t ParallelSystem::next_unit(uint32_t now_ms) {
+  uint8_t count = view_.total.units;
+  if (count == 0) {
+    last_probe_ms_ = now_ms;
+    return 0;
+  }
+  // Probe one index past the known units at the start of a round
+  if (next_ == 0 && count < INVERTER_MAX_UNITS && now_ms - last_probe_ms_ >= PARALLEL_PROBE_MS) {
+    last_probe_ms_ = now_ms;
+    return count;
+  }
+  uint8_t unit = next_ < count ? next_ : 0;
+  next_ = (uint8_t)((unit + 1) % count);
+  return unit;
+}
+
+void ParallelSystem::add(const InverterUnitState& u, int sign) {
+  ParallelTotals& t = view_.total;
+  t.present = (uint8_t)(t.present + sign);
+  if (u.fault_code) t.faulted = (uint8_t)(t.faulted + sign);
+  t.ac_apparent_va += sign * u.ac_apparent_va;
+  t.ac_active_w += sign * u.ac_active_w;
+  t.batt_charge_current += sign * u.batt_charge_current;
+  t.batt_discharge_current += sign * u.batt_discharge_current;
+  t.pv_input_current += sign * u.pv_input_current;
+}
+
+void ParallelSystem::drop(uint8_t unit) {
+  InverterUnitState& u = view_.units[unit];
+  if (u.present) add(u, -1);
+  u.present = false;
+  // The known range ends at the last present unit
+  uint8_t& count = view_.total.units;
+  while (count > 0 && !view_.units[count - 1].present) --count;
+  if (next_ >= count) next_ = 0;
+}
+
+bool ParallelSystem::apply(uint8_t unit, const InverterUnitState* s, uint32_t now_ms) {
+  if (unit >= INVERTER_MAX_UNITS) return false;
+  InverterUnitState& u = view_.units[unit];
+
+  // A standalone inverter answers QPGS0 as well (output mode 0); QPIGS
+  // already covers it, so it does not make a parallel system
+  if (!s || !s->present || s->output_mode == 0) {
+    if (!u.present) return false;   // probe of an empty index
+    if (s || ++misses_[unit] >= PARALLEL_MISS_LIMIT) {
+      misses_[unit] = 0;
+      drop(unit);
+      return true;
+    }
+    return false;
+  }
+
+  misses_[unit] = 0;
+  if (u.present) add(u, -1);
+  u = *s;
+  u.ts_ms = now_ms;
+  add(u, +1);
+  if (unit >= view_.total.units) view_.total.units = (uint8_t)(unit + 1);
+  return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <stdint.h>
+#include "inverter_state.h"
+
+// Parallel system view built from QPGSn answers. Plain C++ without Arduino
+// dependencies so it can be built on a host.
+//
+// Discovery: with no unit known, unit 0 is probed; afterwards the units
+// 0..count-1 are polled round-robin and, once per PARALLEL_PROBE_MS, the
+// next index after the last known unit is probed so units added later are
+// found. A unit that answers "not present" drops out at once; one that
+// does not answer is kept for PARALLEL_MISS_LIMIT polls in a row (a single
+// lost frame must not make the system total jump). A unit in output mode 0
+// (single machine) is not treated as part of a parallel system.
+//
+// Totals are updated incrementally: each answer subtracts the unit's
+// previous contribution and adds the new one, so a poll costs O(1)
+// regardless of the number of units.
+
+#define PARALLEL_PROBE_MS    60000
+#define PARALLEL_MISS_LIMIT  3
+
+struct ParallelView {
+  InverterUnitState units[INVERTER_MAX_UNITS];
+  ParallelTotals total;
+};
+
+class ParallelSystem {
+public:
+  // Unit index to poll next
+  uint8_t next_unit(uint32_t now_ms);
+
+  // Result of polling `unit`: the parsed answer, or nullptr when there was
+  // no valid answer. Returns true if the view changed.
+  bool apply(uint8_t unit, const InverterUnitState* s, uint32_t now_ms);
+
+  uint8_t count() const { return view_.total.units; }
+  const ParallelView& view() const { return view_; }
+
+private:
+  void add(const InverterUnitState& u, int sign);
+  void drop(uint8_t unit);
+
+  ParallelView view_ = {};
+  uint8_t misses_[INVERTER_MAX_UNITS] = {};
+  uint8_t next_ = 0;
+  uint32_t last_probe_ms_ = 0;
+};
@@ -0,0 +1,76 @@
+#include "poll_rate.h"
+#include <math.h>
+
+#define PF(name, expr, deadband, rate) { name, [](const InverterState& s) -> float { return (float)(expr); }, deadband, rate }
+
+// Fields that drive the rate: deadband in units, rate in units per second
+static const PollRateField FIELDS[] = {
+  PF("ac_active_w",            s.ac_active_w,            40.0f, 150.0f),
+  PF("pv_charging_power",      s.pv_charging_power,      40.0f, 150.0f),
+  PF("pv_input_voltage",       s.pv_input_voltage,        3.0f,  10.0f),
+  PF("batt_discharge_current", s.batt_discharge_current,  1.5f,   5.0f),
+  PF("batt_charge_current",    s.batt_charge_current,     1.5f,   5.0f),
+};
+static const int FIELD_COUNT = sizeof(FIELDS) / sizeof(FIELDS[0]);
+static_assert(sizeof(FIELDS) / sizeof(FIELDS[0]) <= 8, "PollRateController::prev_ size");
+
+void PollRateController::begin(uint32_t min_ms) {
+  *this = PollRateController();
+  set_min(min_ms);
+}
+
+uint32_t PollRateController::update(const InverterState& s, uint32_t now_ms, bool live) {
+  bool fast = false;
+  bool outside = false;
+  float dt_s = have_prev_ ? (now_ms - prev_ms_) / 1000.0f : 0.0f;
+  for (int i = 0; i < FIELD_COUNT; ++i) {
+    float v = FIELDS[i].get(s);
+    if (!have_prev_) {
+      prev_[i] = ref_[i] = v;
+      continue;
+    }
+    if (dt_s > 0.0f && fabsf(v - prev_[i]) / dt_s > FIELDS[i].rate_per_s &&
+        fabsf(v - prev_[i]) > FIELDS[i].deadband) {
+      fast = true;
+    }
+    if (fabsf(v - ref_[i]) > FIELDS[i].deadband) {
+      outside = true;
+      ref_[i] = v;
+    }
+    prev_[i] = v;
+  }
+  have_prev_ = true;
+  prev_ms_ = now_ms;
+
+  if (fast) fast_until_ms_ = now_ms + POLL_FAST_HOLD_MS;
+  quiet_ = outside ? 0 : (quiet_ < 255 ? quiet_ + 1 : quiet_);
+
+  uint32_t p;
+  if (fast || (int32_t)(fast_until_ms_ - now_ms) > 0) {
+    p = min_ms_;
+    reason_ = POLL_REASON_FAST;
+  } else if (live) {
+    p = POLL_LIVE_MS;
+    reason_ = POLL_REASON_LIVE;
+  } else if (quiet_ >= POLL_QUIET_SAMPLES) {
+    p = period_ < POLL_DEFAULT_MS ? POLL_DEFAULT_MS : period_ + period_ / 4;
+    reason_ = POLL_REASON_QUIET;
+  } else {
+    p = POLL_DEFAULT_MS;
+    reason_ = POLL_REASON_DEFAULT;
+  }
+  uint32_t max_ms = s.pv_input_voltage > POLL_PV_PRESENT_V ? POLL_MAX_DAY_MS : POLL_MAX_MS;
+  if (p > max_ms) p = max_ms;
+  if (p < min_ms_) p = min_ms_;
+  period_ = p;
+  return p;
+}
+
+const char* PollRateController::reason_name(PollReason r) {
+  switch (r) {
+  case POLL_REASON_FAST:  return "fast";
+  case POLL_REASON_LIVE:  return "live";
+  case POLL_REASON_QUIET: return "quiet";
+  default:                return "default";
+  }
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <stdint.h>
+#include "inverter_state.h"
+
+// Adaptive QPIGS period. Plain C++ without Arduino dependencies so it can be
+// built on a host (doc/pollRateSim.cpp replays traces through it).
+//
+// Per sample, each tracked field is checked against
+//   - a rate threshold: |change since the previous sample| per second above
+//     it means a fast transient (cloud edge, kettle) -> poll at the link
+//     minimum and hold that for POLL_FAST_HOLD_MS after the last transient
+//   - a deadband around the last value that left it: staying inside on
+//     POLL_QUIET_SAMPLES samples in a row backs the period off by 1/4
+//     per sample up to the maximum; leaving it returns to the default.
+//     The maximum is POLL_MAX_DAY_MS while PV is present (cloud edges are
+//     likely and nothing is gained by missing them), POLL_MAX_MS at night.
+// While a live client is subscribed the period is capped at POLL_LIVE_MS.
+
+#define POLL_DEFAULT_MS     1500
+#define POLL_LIVE_MS        1200    // leaves slack for the longest background inquiry
+#define POLL_MAX_MS         10000
+#define POLL_MAX_DAY_MS     3000
+#define POLL_PV_PRESENT_V   50.0f   // pv_input_voltage above this = daytime
+#define POLL_FAST_HOLD_MS   10000
+#define POLL_QUIET_SAMPLES  3
+
+enum PollReason : uint8_t {
+  POLL_REASON_DEFAULT = 0,   // values moving slowly
+  POLL_REASON_FAST,          // transient detected (or holding after one)
+  POLL_REASON_LIVE,          // live subscriber
+  POLL_REASON_QUIET,         // backing off inside the deadband
+};
+
+struct PollRateField {
+  const char* name;
+  float (*get)(const InverterState& s);
+  float deadband;
+  float rate_per_s;
+};
+
+class PollRateController {
+public:
+  void begin(uint32_t min_ms);
+
+  // Link minimum (measured transaction time of one poll); clamps the period
+  void set_min(uint32_t min_ms) { min_ms_ = min_ms < POLL_MAX_MS ? min_ms : POLL_MAX_MS; }
+
+  // Feed a good sample taken at now_ms; returns the period for the next one
+  uint32_t update(const InverterState& s, uint32_t now_ms, bool live);
+
+  uint32_t period() const { return period_; }
+  PollReason reason() const { return reason_; }
+  static const char* reason_name(PollReason r);
+
+private:
+  uint32_t min_ms_ = POLL_DEFAULT_MS;
+  uint32_t period_ = POLL_DEFAULT_MS;
+  PollReason reason_ = POLL_REASON_DEFAULT;
+  bool have_prev_ = false;
+  uint32_t prev_ms_ = 0;
+  uint32_t fast_until_ms_ = 0;
+  uint8_t quiet_ = 0;
+  float prev_[8] = {};
+  float ref_[8] = {};
+};
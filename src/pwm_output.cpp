@@ -0,0 +1,207 @@
+#include "pwm_output.h"
+#include <Arduino.h>
+#include <atomic>
+#include <math.h>
+#include <esp_timer.h>
+#include <driver/gpio.h>
+#include <rom/gpio.h>
+#include <soc/gpio_sig_map.h>
+#include <soc/io_mux_reg.h>
+#include "config.h"
+#include "logger.h"
+
+static constexpr uint32_t PERIOD_US = (uint32_t)PWM_PERIOD_MS * 1000u;
+static const uint32_t DUTY_MAX = (1u << PWM_RESOLUTION_BITS) - 1;   // == full on
+
+static uint8_t g_mode = PWM_MODE_SOFTWARE;
+static std::atomic<float> g_duty{0.0f};
+static std::atomic<uint32_t> g_on_us{0};          // TIMER: on-time for the next period
+static hw_timer_t* g_wdt = nullptr;
+static volatile bool g_tripped = false;
+static volatile uint32_t g_trips = 0;
+
+// ---- Fail-safe ----
+// Route the pin back to the GPIO output register and clear it. Only ROM code
+// and register writes, so it is safe in an ISR whatever the backend does.
+static void IRAM_ATTR failsafe_isr() {
+  gpio_matrix_out(PWM_PIN, SIG_GPIO_OUT_IDX, false, false);
+  GPIO_FAST_SET_0(PWM_PIN);
+  if (!g_tripped) g_trips++;
+  g_tripped = true;
+}
+
+// ---- TIMER backend: one esp_timer, re-armed at every edge ----
+static esp_timer_handle_t g_edge_timer = nullptr;
+static int64_t g_period_start_us = 0;
+static int64_t g_fall_us = 0;            // pending falling edge, 0 if none
+
+static void arm_at(int64_t at_us) {
+  int64_t delta = at_us - esp_timer_get_time();
+  esp_timer_start_once(g_edge_timer, delta > 0 ? (uint64_t)delta : 1);
+}
+
+// Runs in the esp_timer task: either the falling edge of the running period
+// or the start of the next one (which takes the latest duty)
+static void on_edge(void* arg) {
+  (void)arg;
+  if (g_fall_us) {
+    GPIO_FAST_SET_0(PWM_PIN);
+    g_fall_us = 0;
+    arm_at(g_period_start_us + PERIOD_US);
+    return;
+  }
+  g_period_start_us += PERIOD_US;
+  // Far behind (e.g. the timer task was blocked): restart the grid from now
+  int64_t now = esp_timer_get_time();
+  if (now - g_period_start_us > (int64_t)PERIOD_US) g_period_start_us = now;
+  uint32_t on_us = g_tripped ? 0 : g_on_us.load();
+  if (on_us == 0) {
+    GPIO_FAST_SET_0(PWM_PIN);
+  } else {
+    GPIO_FAST_SET_1(PWM_PIN);
+    if (on_us < PERIOD_US) g_fall_us = g_period_start_us + on_us;
+  }
+  arm_at(g_fall_us ? g_fall_us : g_period_start_us + PERIOD_US);
+}
+
+// ---- Edge probe ----
+// The ISR is an IRAM interrupt (attachInterrupt) and may run while the flash
+// cache is off (LittleFS writes): it only touches DRAM and hands the raw
+// deviations over in a ring. Binning (flash code, bounds in .rodata) is done
+// by probe_drain() in task context.
+#define JITTER_RING 32   // power of two; drained every loop() iteration
+static const uint32_t JITTER_BOUNDS_US[] = { 10, 50, 100, 500, 1000, 5000, 10000, 50000, 100000 };
+static portMUX_TYPE g_probe_mux = portMUX_INITIALIZER_UNLOCKED;
+static DRAM_ATTR uint32_t g_ring[JITTER_RING];
+static DRAM_ATTR uint32_t g_ring_head = 0;     // written by the ISR
+static DRAM_ATTR uint32_t g_ring_tail = 0;     // written by probe_drain()
+static DRAM_ATTR uint32_t g_ring_lost = 0;
+static DRAM_ATTR uint32_t g_edges = 0;
+static DRAM_ATTR int64_t g_last_rise_us = 0;
+static Histogram g_jitter = {};
+static uint32_t g_max_jitter_us = 0;
+
+static void IRAM_ATTR on_rise() {
+  int64_t now = esp_timer_get_time();
+  portENTER_CRITICAL_ISR(&g_probe_mux);
+  if (g_last_rise_us) {
+    int64_t d = now - g_last_rise_us - (int64_t)PERIOD_US;
+    uint32_t j = (uint32_t)(d < 0 ? -d : d);
+    // Periods without a rise (duty 0 / 1, fail-safe) are not jitter
+    if (j < PERIOD_US / 2) {
+      if (g_ring_head - g_ring_tail < JITTER_RING) g_ring[g_ring_head++ % JITTER_RING] = j;
+      else g_ring_lost++;
+    }
+  }
+  g_last_rise_us = now;
+  g_edges++;
+  portEXIT_CRITICAL_ISR(&g_probe_mux);
+}
+
+static void probe_drain() {
+  portENTER_CRITICAL(&g_probe_mux);
+  while (g_ring_tail != g_ring_head) {
+    uint32_t j = g_ring[g_ring_tail++ % JITTER_RING];
+    histogram_observe(&g_jitter, j);
+    if (j > g_max_jitter_us) g_max_jitter_us = j;
+  }
+  portEXIT_CRITICAL(&g_probe_mux);
+}
+
+void pwm_output_init() {
+  pinMode(PWM_PIN, OUTPUT);
+  digitalWrite(PWM_PIN, LOW);
+  histogram_init(&g_jitter, JITTER_BOUNDS_US, sizeof(JITTER_BOUNDS_US) / sizeof(JITTER_BOUNDS_US[0]), 1000000);
+
+  uint8_t mode = PWM_MODE;
+  if (mode == PWM_MODE_AUTO) mode = PWM_PERIOD_MS <= PWM_LEDC_MAX_PERIOD_MS ? PWM_MODE_LEDC : PWM_MODE_TIMER;
+  if (mode == PWM_MODE_LEDC) {
+    if (PWM_PERIOD_MS <= PWM_LEDC_MAX_PERIOD_MS &&
+        ledcSetup(PWM_LEDC_CHANNEL, 1000.0 / PWM_PERIOD_MS, PWM_RESOLUTION_BITS) > 0) {
+      ledcWrite(PWM_LEDC_CHANNEL, 0);
+      ledcAttachPin(PWM_PIN, PWM_LEDC_CHANNEL);
+    } else {
+      LOGW(LOG_MOD_APP, "PWM: LEDC cannot do %u ms at %u bits, using esp_timer", (unsigned)PWM_PERIOD_MS,
+        (unsigned)PWM_RESOLUTION_BITS);
+      mode = PWM_MODE_TIMER;
+    }
+  }
+  if (mode == PWM_MODE_TIMER) {
+    esp_timer_create_args_t args = {};
+    args.callback = &on_edge;
+    args.name = "pwm";
+    esp_timer_create(&args, &g_edge_timer);
+    g_period_start_us = esp_timer_get_time();
+    arm_at(g_period_start_us + PERIOD_US);
+  }
+  g_mode = mode;
+
+  // Read back the pin's own edges (the input buffer works alongside the output)
+  PIN_INPUT_ENABLE(GPIO_PIN_MUX_REG[PWM_PIN]);
+  attachInterrupt(PWM_PIN, on_rise, RISING);
+
+  // 1 us ticks; auto-reload so a stalled controller keeps the output off
+  g_wdt = timerBegin(0, 80, true);
+  timerAttachInterrupt(g_wdt, &failsafe_isr, true);
+  timerAlarmWrite(g_wdt, (uint64_t)PWM_WATCHDOG_MS * 1000u, true);
+  timerAlarmEnable(g_wdt);
+
+  LOGI(LOG_MOD_APP, "PWM: GPIO%d %s, period %u ms, %u bits, fail-safe %u ms", PWM_PIN, pwm_output_mode_name(g_mode),
+    (unsigned)PWM_PERIOD_MS, (unsigned)PWM_RESOLUTION_BITS, (unsigned)PWM_WATCHDOG_MS);
+}
+
+void pwm_output_set_duty(float duty) {
+  if (isnan(duty) || duty < 0.0f) duty = 0.0f;
+  if (duty > 1.0f) duty = 1.0f;
+  uint32_t steps = (uint32_t)lroundf(duty * (float)DUTY_MAX);
+  g_duty.store(duty);
+  if (g_wdt) timerWrite(g_wdt, 0);
+  probe_drain();
+
+  if (g_tripped) {
+    g_tripped = false;
+    if (g_mode == PWM_MODE_LEDC) ledcAttachPin(PWM_PIN, PWM_LEDC_CHANNEL);
+    LOGW(LOG_MOD_APP, "PWM: output was held off by the fail-safe (%u trips), resuming", (unsigned)g_trips);
+  }
+
+  switch (g_mode) {
+  case PWM_MODE_LEDC:
+    ledcWrite(PWM_LEDC_CHANNEL, steps);
+    break;
+  case PWM_MODE_TIMER:
+    g_on_us.store((uint32_t)((uint64_t)steps * PERIOD_US / DUTY_MAX));
+    break;
+  default: {
+    uint32_t phase = millis() % PWM_PERIOD_MS;
+    uint32_t on_ms = (uint32_t)((uint64_t)steps * PWM_PERIOD_MS / DUTY_MAX);
+    digitalWrite(PWM_PIN, (phase < on_ms) ? HIGH : LOW);
+    break;
+  }
+  }
+}
+
+const char* pwm_output_mode_name(uint8_t mode) {
+  switch (mode) {
+  case PWM_MODE_LEDC:     return "ledc";
+  case PWM_MODE_TIMER:    return "timer";
+  case PWM_MODE_SOFTWARE: return "software";
+  default:                return "auto";
+  }
+}
+
+void pwm_output_get_stats(PwmStats* out) {
+  if (!out) return;
+  out->mode = g_mode;
+  out->period_ms = PWM_PERIOD_MS;
+  out->resolution_bits = PWM_RESOLUTION_BITS;
+  out->duty = g_duty.load();
+  out->tripped = g_tripped;
+  out->trips = g_trips;
+  probe_drain();
+  portENTER_CRITICAL(&g_probe_mux);
+  out->edges = g_edges;
+  out->jitter_lost = g_ring_lost;
+  out->max_jitter_us = g_max_jitter_us;
+  out->jitter = g_jitter;
+  portEXIT_CRITICAL(&g_probe_mux);
+}
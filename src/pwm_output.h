@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include "histogram.h"
+
+// Duty-cycle output on PWM_PIN (SSR / heater), independent of loop() timing.
+//
+// Backends (PWM_MODE in config.h):
+//   LEDC      hardware PWM; a new duty is latched by the peripheral at the end
+//             of the running cycle. LEDC cannot go below 1 Hz, so periods up
+//             to PWM_LEDC_MAX_PERIOD_MS only.
+//   TIMER     slow SSR-friendly periods: esp_timer one-shots at each edge
+//             (rise at the period start, fall after the on-time) on absolute
+//             deadlines, so edges do not drift. A new duty is taken at the
+//             next period start; a running cycle is never cut or stretched.
+//   SOFTWARE  the old phase comparison in loop() (edges late by up to one
+//             loop iteration); kept to compare jitter against.
+//   AUTO      LEDC when the period allows it, else TIMER.
+//
+// Fail-safe: hardware timer 0 counts towards PWM_WATCHDOG_MS and is reset by
+// every pwm_output_set_duty(). When it expires, its ISR routes the pin back
+// to plain GPIO and drives it low, whatever the backend is doing. The next
+// set_duty() reattaches the output. The controlling task must therefore call
+// set_duty() periodically, not only when the duty changes.
+//
+// Edge jitter: an interrupt on the pin's own rising edges measures each
+// period against PWM_PERIOD_MS; set_duty() and get_stats() bin the results
+// (see pwm_output_get_stats()).
+
+#define PWM_MODE_AUTO     0
+#define PWM_MODE_LEDC     1
+#define PWM_MODE_TIMER    2
+#define PWM_MODE_SOFTWARE 3
+
+#define PWM_LEDC_MAX_PERIOD_MS 1000
+#define PWM_LEDC_CHANNEL       0
+
+struct PwmStats {
+  uint8_t mode;               // backend in use (PWM_MODE_*)
+  uint32_t period_ms;
+  uint8_t resolution_bits;
+  float duty;                 // last requested duty 0..1
+  bool tripped;               // fail-safe holding the output low
+  uint32_t trips;             // fail-safe activations since boot
+  uint32_t edges;             // rising edges observed
+  uint32_t jitter_lost;       // intervals not binned (handover ring full)
+  uint32_t max_jitter_us;     // worst |rise-to-rise - period|
+  Histogram jitter;           // |rise-to-rise - period| [us]
+};
+
+// Configure the pin, backend, fail-safe timer and edge probe (output off)
+void pwm_output_init();
+
+// Set the duty (0..1, quantized to PWM_RESOLUTION_BITS) and feed the fail-safe
+void pwm_output_set_duty(float duty);
+
+const char* pwm_output_mode_name(uint8_t mode);
+void pwm_output_get_stats(PwmStats* out);
@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Sequence lock for publishing a small POD record to readers on either core.
+// Readers never block writers: they copy the record and retry if a write was
+// in progress (odd sequence) or happened during the copy. Writers must be
+// serialized by the caller (e.g. a mutex that only writers take).
+template <typename T>
+class SeqLock {
+public:
+  explicit SeqLock(const T& init = T()) : data_(init) {}
+
+  // Modify the record in place; fn(T&) must be short and must not block.
+  template <typename Fn>
+  void update(Fn fn) {
+    uint32_t s = seq_.load(std::memory_order_relaxed);
+    seq_.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    fn(data_);
+    seq_.store(s + 2, std::memory_order_release);
+  }
+
+  // Consistent copy of the record. If a lower-priority writer on the same core
+  // was preempted mid-write, back off for a tick so it can finish.
+  void read(T* out) const {
+    for (uint32_t attempt = 0;; ++attempt) {
+      uint32_t s1 = seq_.load(std::memory_order_acquire);
+      if ((s1 & 1) == 0) {
+        *out = data_;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq_.load(std::memory_order_relaxed) == s1) return;
+      }
+      if (attempt >= 16) vTaskDelay(1);
+    }
+  }
+
+  // Even value that changes on every update (cheap change detection)
+  uint32_t sequence() const { return seq_.load(std::memory_order_acquire) & ~1u; }
+
+private:
+  std::atomic<uint32_t> seq_{0};
+  T data_;
+};
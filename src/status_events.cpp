@@ -0,0 +1,241 @@
+#include "status_events.h"
+#include <Arduino.h>
+#include <atomic>
+#include <math.h>
+#include <string.h>
+#include "inverter_comm.h"
+#include "logger.h"
+
+// ---- Externals from main.cpp (control state reflected in the stream) ----
+extern std::atomic<int> outputLimitW;
+extern std::atomic<float> outputDutyCycle;
+
+struct PushState {
+  InverterSnapshot snap;
+  int limit_w;
+  float duty;
+};
+
+#define SSE_VALUE_MAX 24
+
+// One pushed field: JSON key and value formatter (writes JSON text)
+struct PushField {
+  const char* key;
+  void (*fmt)(char* out, size_t cap, const PushState& st);
+};
+
+static void fmt_float(char* out, size_t cap, float v, int decimals) {
+  if (isnan(v)) snprintf(out, cap, "null");
+  else snprintf(out, cap, "%.*f", decimals, v);
+}
+
+#define F_FLOAT(key, expr, dec) { key, [](char* o, size_t c, const PushState& st) { fmt_float(o, c, (expr), dec); } }
+#define F_INT(key, expr)        { key, [](char* o, size_t c, const PushState& st) { snprintf(o, c, "%ld", (long)(expr)); } }
+
+// Same keys as /status so the UI applies both with one function
+static const PushField FIELDS[] = {
+  F_FLOAT("ac_out_voltage",         st.snap.status.ac_out_voltage, 1),
+  F_FLOAT("ac_out_frequency",       st.snap.status.ac_out_frequency, 2),
+  F_INT  ("ac_apparent_va",         st.snap.status.ac_apparent_va),
+  F_INT  ("ac_active_w",            st.snap.status.ac_active_w),
+  F_INT  ("load_percent",           st.snap.status.load_percent),
+  F_FLOAT("batt_voltage",           st.snap.status.batt_voltage, 2),
+  F_FLOAT("batt_charge_current",    st.snap.status.batt_charge_current, 2),
+  F_INT  ("batt_soc",               st.snap.status.batt_soc),
+  F_FLOAT("heatsink_temp",          st.snap.status.heatsink_temp, 1),
+  F_FLOAT("pv_input_current",       st.snap.status.pv_input_current, 2),
+  F_FLOAT("pv_input_voltage",       st.snap.status.pv_input_voltage, 2),
+  F_FLOAT("batt_voltage_from_scc",  st.snap.status.batt_voltage_from_scc, 2),
+  F_FLOAT("batt_discharge_current", st.snap.status.batt_discharge_current, 2),
+  F_INT  ("pv_charging_power",      st.snap.status.pv_charging_power),
+  { "g_inverter_mode_code", [](char* o, size_t c, const PushState& st) {
+      if (st.snap.mode_code) snprintf(o, c, "\"%c\"", st.snap.mode_code);
+      else snprintf(o, c, "\"\"");
+    } },
+  { "g_inverter_mode_name", [](char* o, size_t c, const PushState& st) { snprintf(o, c, "\"%s\"", st.snap.mode_name); } },
+  { "valid", [](char* o, size_t c, const PushState& st) { snprintf(o, c, "%s", st.snap.valid ? "true" : "false"); } },
+  F_INT  ("ts_ms",                  st.snap.status.ts_ms),
+  F_FLOAT("temp_h",                 st.snap.temp_h, 1),
+  F_FLOAT("temp_l",                 st.snap.temp_l, 1),
+  F_INT  ("sys_units",              st.snap.parallel.present),
+  F_INT  ("sys_apparent_va",        st.snap.parallel.ac_apparent_va),
+  F_INT  ("sys_active_w",           st.snap.parallel.ac_active_w),
+  F_INT  ("sys_charge_current",     st.snap.parallel.batt_charge_current),
+  F_INT  ("sys_discharge_current",  st.snap.parallel.batt_discharge_current),
+  F_INT  ("output_limit_w",         st.limit_w),
+  F_FLOAT("output_duty_cycle",      st.duty, 2),
+};
+
+#undef F_FLOAT
+#undef F_INT
+
+static const size_t FIELD_COUNT = sizeof(FIELDS) / sizeof(FIELDS[0]);
+
+struct SseClient {
+  int fd;
+  bool active;
+  bool needs_full;
+};
+
+static httpd_handle_t g_hd = NULL;
+static SseClient g_clients[SSE_MAX_CLIENTS];
+// Serialized values as last broadcast; deltas are computed against these
+static char g_last[FIELD_COUNT][SSE_VALUE_MAX];
+static bool g_have_last = false;
+static uint32_t g_last_keepalive_ms = 0;
+static WebTrafficStats g_stats = {};
+static std::atomic<bool> g_pump_queued{false};
+
+static void drop_client(SseClient& c, bool close_socket) {
+  if (!c.active) return;
+  c.active = false;
+  g_stats.sse_clients--;
+  inverter_set_live_clients(g_stats.sse_clients);
+  if (close_socket) httpd_sess_trigger_close(g_hd, c.fd);
+}
+
+static bool send_all(int fd, const char* buf, size_t len) {
+  while (len > 0) {
+    int n = httpd_socket_send(g_hd, fd, buf, len, 0);
+    if (n < 0) return false;
+    buf += n;
+    len -= (size_t)n;
+  }
+  return true;
+}
+
+// Write a whole frame or drop the client (never leave a half-written event)
+static void send_frame(SseClient& c, const char* buf, size_t len) {
+  if (!send_all(c.fd, buf, len)) {
+    drop_client(c, true);
+    return;
+  }
+  g_stats.sse_frames++;
+  g_stats.sse_bytes += len;
+}
+
+void status_events_attach(httpd_handle_t hd) {
+  g_hd = hd;
+}
+
+bool status_events_subscribe(httpd_req_t* req) {
+  for (auto& c : g_clients) {
+    if (c.active) continue;
+    c.fd = httpd_req_to_sockfd(req);
+    // Raw response head: the body is an endless event stream, so no
+    // Content-Length / chunking, and httpd must not send a response of its own
+    char head[192];
+    int n = snprintf(head, sizeof(head),
+                     "HTTP/1.1 200 OK\r\n"
+                     "Content-Type: text/event-stream\r\n"
+                     "Cache-Control: no-cache\r\n"
+                     "Connection: keep-alive\r\n"
+                     "Access-Control-Allow-Origin: *\r\n\r\n"
+                     "retry: %u\n\n", (unsigned)SSE_RETRY_MS);
+    if (!send_all(c.fd, head, (size_t)n)) return true; // client already gone; nothing to answer
+    c.active = true;
+    c.needs_full = true;
+    g_stats.sse_clients++;
+    inverter_set_live_clients(g_stats.sse_clients);
+    LOGI(LOG_MOD_WEB, "SSE client subscribed (%u active)", (unsigned)g_stats.sse_clients);
+    status_events_pump();   // send the full frame right away
+    return true;
+  }
+  return false;
+}
+
+bool status_events_owns(int sockfd) {
+  for (const auto& c : g_clients) {
+    if (c.active && c.fd == sockfd) return true;
+  }
+  return false;
+}
+
+void status_events_on_close(int sockfd) {
+  for (auto& c : g_clients) {
+    if (c.active && c.fd == sockfd) drop_client(c, false);
+  }
+}
+
+// Build "event: <type>\nid: <gen>\ndata: {...}\n\n"; only fields with mask bit set
+static size_t build_frame(char* out, size_t cap, const char* type, uint32_t gen,
+                          const char (*vals)[SSE_VALUE_MAX], const bool* include) {
+  int n = snprintf(out, cap, "event: %s\nid: %u\ndata: {\"type\":\"%s\",\"generation\":%u",
+                   type, (unsigned)gen, type, (unsigned)gen);
+  size_t len = (n > 0) ? (size_t)n : 0;
+  for (size_t i = 0; i < FIELD_COUNT && len < cap; ++i) {
+    if (!include[i]) continue;
+    n = snprintf(out + len, cap - len, ",\"%s\":%s", FIELDS[i].key, vals[i]);
+    if (n > 0) len += (size_t)n;
+  }
+  n = (len < cap) ? snprintf(out + len, cap - len, "}\n\n") : 0;
+  if (n > 0) len += (size_t)n;
+  return len < cap ? len : cap - 1;
+}
+
+static void pump_work(void* arg) {
+  (void)arg;
+  g_pump_queued.store(false);
+  if (g_stats.sse_clients == 0) {
+    g_have_last = false;   // next subscriber starts from a clean baseline
+    return;
+  }
+  uint32_t t0 = micros();
+
+  PushState st;
+  inverter_get_snapshot(&st.snap);
+  st.limit_w = outputLimitW.load();
+  st.duty = outputDutyCycle.load();
+
+  char vals[FIELD_COUNT][SSE_VALUE_MAX];
+  bool changed[FIELD_COUNT];
+  bool all[FIELD_COUNT];
+  bool any_changed = false;
+  for (size_t i = 0; i < FIELD_COUNT; ++i) {
+    FIELDS[i].fmt(vals[i], SSE_VALUE_MAX, st);
+    changed[i] = !g_have_last || strcmp(vals[i], g_last[i]) != 0;
+    any_changed |= changed[i];
+    all[i] = true;
+  }
+
+  // Worst case full frame: header + fields x (key + value + punctuation)
+  static char full[96 + FIELD_COUNT * (SSE_VALUE_MAX + 32)];
+  static char delta[sizeof(full)];
+  size_t full_len = 0, delta_len = 0;
+  uint32_t now = millis();
+  bool keepalive_due = (uint32_t)(now - g_last_keepalive_ms) >= SSE_KEEPALIVE_MS;
+
+  for (auto& c : g_clients) {
+    if (!c.active) continue;
+    if (c.needs_full) {
+      if (!full_len) full_len = build_frame(full, sizeof(full), "status", st.snap.generation, vals, all);
+      send_frame(c, full, full_len);
+      c.needs_full = false;
+    } else if (any_changed) {
+      if (!delta_len) delta_len = build_frame(delta, sizeof(delta), "delta", st.snap.generation, vals, changed);
+      send_frame(c, delta, delta_len);
+    } else if (keepalive_due) {
+      send_frame(c, ":\n\n", 3);
+    }
+  }
+  if (keepalive_due || any_changed) g_last_keepalive_ms = now;
+
+  memcpy(g_last, vals, sizeof(g_last));
+  g_have_last = true;
+  g_stats.sse_cpu_us += micros() - t0;
+}
+
+void status_events_pump() {
+  if (!g_hd || g_pump_queued.exchange(true)) return;
+  if (httpd_queue_work(g_hd, pump_work, NULL) != ESP_OK) g_pump_queued.store(false);
+}
+
+void status_events_get_stats(WebTrafficStats* out) {
+  if (out) *out = g_stats;
+}
+
+void status_events_count_poll(uint32_t bytes, uint32_t cpu_us) {
+  g_stats.poll_requests++;
+  g_stats.poll_bytes += bytes;
+  g_stats.poll_cpu_us += cpu_us;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <stdint.h>
+#include <esp_http_server.h>
+
+// Server-Sent Events push of the status record on GET /events.
+//
+// A subscriber first receives one `status` event with every field (same keys
+// as /status), then a `delta` event only when something changed, carrying
+// just the changed fields. Values are compared in their serialized form, so
+// a delta never contains a field whose text would not change. The event id
+// is the snapshot generation. A comment line every SSE_KEEPALIVE_MS keeps
+// proxies and the WireGuard NAT mapping open.
+//
+// Sockets are only written from the httpd task: subscribe runs in the route
+// handler, and status_events_pump() (from the loop() task table) just queues
+// the actual work there with httpd_queue_work().
+
+#define SSE_MAX_CLIENTS   4
+#define SSE_KEEPALIVE_MS  15000
+#define SSE_RETRY_MS      3000
+
+// Server handle used for sends and queued work (call once after httpd_start)
+void status_events_attach(httpd_handle_t hd);
+
+// Take over the socket of the current request. Returns false (and the
+// caller should answer 503) when all slots are in use.
+bool status_events_subscribe(httpd_req_t* req);
+
+// True if sockfd is a subscribed event stream
+bool status_events_owns(int sockfd);
+
+// Forget a subscriber whose socket httpd is closing (from close_fn)
+void status_events_on_close(int sockfd);
+
+// Schedule sending pending full/delta frames and keep-alives; safe from any task
+void status_events_pump();
+
+// Per-mode traffic counters for comparing push vs. polling
+struct WebTrafficStats {
+  uint32_t sse_clients;
+  uint32_t sse_frames;
+  uint32_t sse_bytes;
+  uint32_t sse_cpu_us;      // time spent building + writing frames
+  uint32_t poll_requests;   // GET /status
+  uint32_t poll_bytes;
+  uint32_t poll_cpu_us;
+};
+void status_events_get_stats(WebTrafficStats* out);
+
+// Account one /status response (called by the /status handler)
+void status_events_count_poll(uint32_t bytes, uint32_t cpu_us);
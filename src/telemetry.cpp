@@ -0,0 +1,128 @@
+#include "telemetry.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <atomic>
+#include <stdlib.h>
+#include "logger.h"
+
+// ---- Externals from main.cpp (control state carried in each frame) ----
+extern std::atomic<int> outputLimitW;
+extern std::atomic<float> outputDutyCycle;
+
+void telemetry_fill(const InverterSnapshot& snap, int limitW, float duty, uint32_t seq, TelemetrySample* out) {
+  telemetry_clear(out);
+  out->seq = seq;
+  out->generation = snap.generation;
+  out->ts_ms = snap.status.ts_ms;
+  out->flags = snap.valid ? TELEMETRY_FLAG_VALID : 0;
+  if (snap.valid) {
+    const InverterState& s = snap.status;
+    telemetry_set(out, TELEM_AC_OUT_VOLTAGE, s.ac_out_voltage);
+    telemetry_set(out, TELEM_AC_OUT_FREQUENCY, s.ac_out_frequency);
+    telemetry_set(out, TELEM_AC_APPARENT_VA, s.ac_apparent_va);
+    telemetry_set(out, TELEM_AC_ACTIVE_W, s.ac_active_w);
+    telemetry_set(out, TELEM_LOAD_PERCENT, s.load_percent);
+    telemetry_set(out, TELEM_BATT_VOLTAGE, s.batt_voltage);
+    telemetry_set(out, TELEM_BATT_CHARGE_CURRENT, s.batt_charge_current);
+    telemetry_set(out, TELEM_BATT_SOC, s.batt_soc);
+    telemetry_set(out, TELEM_HEATSINK_TEMP, s.heatsink_temp);
+    telemetry_set(out, TELEM_PV_INPUT_CURRENT, s.pv_input_current);
+    telemetry_set(out, TELEM_PV_INPUT_VOLTAGE, s.pv_input_voltage);
+    telemetry_set(out, TELEM_BATT_VOLTAGE_FROM_SCC, s.batt_voltage_from_scc);
+    telemetry_set(out, TELEM_BATT_DISCHARGE_CURRENT, s.batt_discharge_current);
+    telemetry_set(out, TELEM_PV_CHARGING_POWER, s.pv_charging_power);
+    telemetry_set(out, TELEM_GRID_VOLTAGE, s.grid_voltage);
+    telemetry_set(out, TELEM_GRID_FREQUENCY, s.grid_frequency);
+    telemetry_set(out, TELEM_BUS_VOLTAGE, s.bus_voltage);
+    telemetry_set(out, TELEM_DEVICE_STATUS_BITS, s.device_status_bits);
+    telemetry_set(out, TELEM_ADDITIONAL_STATUS_BITS, s.additional_status_bits);
+  }
+  if (snap.mode_code) telemetry_set(out, TELEM_MODE_CODE, (uint8_t)snap.mode_code);
+  telemetry_set(out, TELEM_TEMP_H, snap.temp_h);
+  telemetry_set(out, TELEM_TEMP_L, snap.temp_l);
+  telemetry_set(out, TELEM_OUTPUT_LIMIT_W, limitW);
+  telemetry_set(out, TELEM_OUTPUT_DUTY_CYCLE, duty);
+}
+
+// ---- UDP stream ----
+// Target is written by the httpd task (/cmd), stats are read by it; both
+// are guarded by g_udp_mux. Everything else is only touched from loop().
+static portMUX_TYPE g_udp_mux = portMUX_INITIALIZER_UNLOCKED;
+static IPAddress g_udp_ip;
+static uint16_t g_udp_port = 0;        // 0 = disabled
+static TelemetryUdpStats g_udp_stats = { false, 0, 0, 0, 0 };
+
+static WiFiUDP g_udp;
+static uint32_t g_udp_last_gen = 0;
+static uint32_t g_udp_last_ms = 0;
+static uint32_t g_udp_seq = 0;
+
+bool telemetry_udp_set_target(const char* target) {
+  if (!target || !*target || strcmp(target, "off") == 0) {
+    portENTER_CRITICAL(&g_udp_mux);
+    g_udp_port = 0;
+    portEXIT_CRITICAL(&g_udp_mux);
+    LOGI(LOG_MOD_NET, "telemetry UDP off");
+    return true;
+  }
+  char host[24];
+  const char* colon = strchr(target, ':');
+  size_t hlen = colon ? (size_t)(colon - target) : strlen(target);
+  if (hlen == 0 || hlen >= sizeof(host)) return false;
+  memcpy(host, target, hlen);
+  host[hlen] = '\0';
+  long port = TELEMETRY_UDP_PORT;
+  if (colon) {
+    char* end;
+    port = strtol(colon + 1, &end, 10);
+    if (*end || port <= 0 || port > 65535) return false;
+  }
+  IPAddress ip;
+  if (!ip.fromString(host)) return false;
+  portENTER_CRITICAL(&g_udp_mux);
+  g_udp_ip = ip;
+  g_udp_port = (uint16_t)port;
+  portEXIT_CRITICAL(&g_udp_mux);
+  LOGI(LOG_MOD_NET, "telemetry UDP -> %s:%ld", host, port);
+  return true;
+}
+
+void telemetry_udp_pump() {
+  portENTER_CRITICAL(&g_udp_mux);
+  IPAddress ip = g_udp_ip;
+  uint16_t port = g_udp_port;
+  g_udp_stats.enabled = port != 0;
+  portEXIT_CRITICAL(&g_udp_mux);
+  if (!port || WiFi.status() != WL_CONNECTED) return;
+
+  uint32_t now = millis();
+  uint32_t gen = inverter_snapshot_generation();
+  if (gen == g_udp_last_gen && now - g_udp_last_ms < TELEMETRY_UDP_HEARTBEAT_MS) return;
+
+  InverterSnapshot snap;
+  inverter_get_snapshot(&snap);
+  TelemetrySample s;
+  telemetry_fill(snap, outputLimitW.load(), outputDutyCycle.load(), ++g_udp_seq, &s);
+  uint8_t frame[TELEMETRY_MAX_FRAME];
+  size_t len = telemetry_encode(s, frame, sizeof(frame));
+  g_udp_last_gen = snap.generation;
+  g_udp_last_ms = now;
+  // Multicast targets need no special handling for sending
+  bool ok = len && g_udp.beginPacket(ip, port) && g_udp.write(frame, len) == len && g_udp.endPacket();
+  portENTER_CRITICAL(&g_udp_mux);
+  g_udp_stats.seq = g_udp_seq;
+  if (ok) {
+    g_udp_stats.frames++;
+    g_udp_stats.bytes += len;
+  } else {
+    g_udp_stats.errors++;
+  }
+  portEXIT_CRITICAL(&g_udp_mux);
+}
+
+void telemetry_udp_get_stats(TelemetryUdpStats* out) {
+  portENTER_CRITICAL(&g_udp_mux);
+  *out = g_udp_stats;
+  portEXIT_CRITICAL(&g_udp_mux);
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <inverter_telemetry.h>
+#include "inverter_comm.h"
+
+// Binary status frames (lib/InverterTelemetry) for machine consumers:
+// served on GET /status when the client asks for TELEMETRY_CONTENT_TYPE,
+// and optionally streamed as UDP datagrams (unicast or multicast) to one
+// target set at runtime with the /cmd "set_telemetry_udp" command.
+
+#define TELEMETRY_UDP_PORT          47800   // default when the target has no port
+#define TELEMETRY_UDP_HEARTBEAT_MS  5000    // resend unchanged status this often
+
+// Fill a sample from a snapshot and the control state. Inverter fields are
+// left absent while the snapshot is not valid, temperatures when NaN.
+void telemetry_fill(const InverterSnapshot& snap, int limitW, float duty, uint32_t seq, TelemetrySample* out);
+
+// Set the UDP target as "a.b.c.d[:port]"; "" or "off" disables the stream.
+// Returns false (target unchanged) if the address does not parse.
+bool telemetry_udp_set_target(const char* target);
+
+// Send a frame if the status changed or the heartbeat is due (loop() task)
+void telemetry_udp_pump();
+
+struct TelemetryUdpStats {
+  bool enabled;
+  uint32_t seq;       // last sequence number sent
+  uint32_t frames;
+  uint32_t bytes;
+  uint32_t errors;
+};
+void telemetry_udp_get_stats(TelemetryUdpStats* out);
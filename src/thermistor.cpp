@@ -1,39 +1,150 @@
 #include "thermistor.h"
+#include <Arduino.h>
+#include <Preferences.h>
+#include <atomic>
 #include <cmath>
+#include <string.h>
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "inverter_comm.h"
+#include "logger.h"
+#include "ntc_curves.h"
 
-// Local module constants (for NTC 10k B3950 with 10k divider / 3.3V)
-static constexpr float TH_R_SERIES_OHMS = 10000.0f;   // series resistor (ohms)
-static constexpr float TH_R0_OHMS       = 10000.0f;   // NTC at T0 (ohms)
-static constexpr float TH_BETA          = 3950.0f;    // Beta constant (K)
-static constexpr float TH_T0_K          = 298.15f;    // 25 °C in Kelvin
-static constexpr float TH_VSUPPLY_MV    = 3300.0f;    // divider supply voltage (mV)
-
-float read_thermistor_temp_c(int adc_pin) {
-  // Sample in mV and average for stability
-  const int samples = 16;
-  long sumMv = 0;
-  for (int i = 0; i < samples; ++i) {
-    int mv = analogReadMilliVolts(adc_pin);
-    sumMv += mv;
-    delayMicroseconds(500);
+#define THERMISTOR_INFO_ENTRY(name, label, pin, curve) { #name, label, pin },
+#define THERMISTOR_TABLE_ENTRY(name, label, pin, curve) &curve,
+static const ThermistorInfo CHANNELS[THERMISTOR_COUNT] = { THERMISTOR_CHANNELS(THERMISTOR_INFO_ENTRY) };
+static const NtcTable* const TABLES[THERMISTOR_COUNT] = { THERMISTOR_CHANNELS(THERMISTOR_TABLE_ENTRY) };
+#define THERMISTOR_NAME_CHECK(name, label, pin, curve) \
+  static_assert(sizeof(#name) <= 16, "thermistor names are NVS keys (15 chars max)");
+THERMISTOR_CHANNELS(THERMISTOR_NAME_CHECK)
+
+static const char* NVS_NAMESPACE = "thermistor";
+
+static esp_adc_cal_characteristics_t g_adc_chars;
+static std::atomic<float> g_temp_c[THERMISTOR_COUNT];
+static std::atomic<float> g_offset_c[THERMISTOR_COUNT];
+static std::atomic<uint32_t> g_generation{0};
+
+// Per-channel filter state (only touched by the sampling task)
+struct ThermChannel {
+  adc1_channel_t ch;
+  float burst_mv[3];     // last three burst means, for the median
+  uint8_t bursts;        // filled entries of burst_mv (saturates at 3)
+  float iir_mv;          // seeded from the first bursts
+};
+
+static float median3(float a, float b, float c) {
+  if (a > b) { float t = a; a = b; b = t; }
+  if (b > c) b = c;
+  return a > b ? a : b;
+}
+
+static void sample_channel(ThermChannel& c, float alpha) {
+  // Oversample: back-to-back conversions, averaged in raw counts
+  uint32_t sum = 0;
+  for (int i = 0; i < THERMISTOR_OVERSAMPLE; ++i) sum += (uint32_t)adc1_get_raw(c.ch);
+  // Keep the fraction: interpolate the calibration curve between the codes
+  uint32_t raw = sum / THERMISTOR_OVERSAMPLE;
+  float frac = (float)(sum % THERMISTOR_OVERSAMPLE) / (float)THERMISTOR_OVERSAMPLE;
+  float mv0 = (float)esp_adc_cal_raw_to_voltage(raw, &g_adc_chars);
+  float mv1 = (float)esp_adc_cal_raw_to_voltage(raw + 1, &g_adc_chars);
+  float mv = mv0 + frac * (mv1 - mv0);
+
+  c.burst_mv[0] = c.burst_mv[1];
+  c.burst_mv[1] = c.burst_mv[2];
+  c.burst_mv[2] = mv;
+  if (c.bursts < 3) {
+    // Until the median window is full, start the IIR from the raw value
+    if (++c.bursts < 3) { c.iir_mv = mv; return; }
   }
-  float vout_mv = (float)sumMv / (float)samples;
+  float m = median3(c.burst_mv[0], c.burst_mv[1], c.burst_mv[2]);
+  c.iir_mv += alpha * (m - c.iir_mv);
+}
+
+static void thermistor_task(void* arg) {
+  (void)arg;
+  ThermChannel chans[THERMISTOR_COUNT] = {};
+  for (uint8_t i = 0; i < THERMISTOR_COUNT; ++i) chans[i].ch = (adc1_channel_t)digitalPinToAnalogChannel(CHANNELS[i].pin);
+  const float alpha = (float)THERMISTOR_SAMPLE_MS / (float)(THERMISTOR_TAU_MS + THERMISTOR_SAMPLE_MS);
+  const uint32_t per_output = THERMISTOR_OUTPUT_MS / THERMISTOR_SAMPLE_MS ? THERMISTOR_OUTPUT_MS / THERMISTOR_SAMPLE_MS : 1;
+  const int idx_h = thermistor_find("h");
+  const int idx_l = thermistor_find("l");
+  uint32_t n = 0;
+  bool logged = false;
+
+  TickType_t wake = xTaskGetTickCount();
+  for (;;) {
+    for (uint8_t i = 0; i < THERMISTOR_COUNT; ++i) sample_channel(chans[i], alpha);
+    if (++n % per_output == 0) {
+      for (uint8_t i = 0; i < THERMISTOR_COUNT; ++i) {
+        float t = ntc_table_c(*TABLES[i], chans[i].iir_mv) + g_offset_c[i].load();
+        g_temp_c[i].store(t);
+        if (!logged) {
+          LOGI(LOG_MOD_APP, "thermistor %s (GPIO%u): %.2f °C%s", CHANNELS[i].name, (unsigned)CHANNELS[i].pin, t,
+            isnan(t) ? " (NAN: check wiring/divider)" : "");
+        }
+      }
+      logged = true;
+      g_generation.fetch_add(1);
+      inverter_publish_temperatures(idx_h >= 0 ? thermistor_temp_c(idx_h) : NAN,
+                                    idx_l >= 0 ? thermistor_temp_c(idx_l) : NAN);
+    }
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(THERMISTOR_SAMPLE_MS));
+  }
+}
 
-  // Guard against rail limits
-  if (vout_mv <= 0.1f || vout_mv >= (TH_VSUPPLY_MV - 0.1f)) {
-    return NAN;
+void thermistor_init() {
+  Preferences prefs;
+  bool have_prefs = prefs.begin(NVS_NAMESPACE, true);
+  for (uint8_t i = 0; i < THERMISTOR_COUNT; ++i) {
+    g_temp_c[i].store(NAN);
+    g_offset_c[i].store(have_prefs ? prefs.getFloat(CHANNELS[i].name, 0.0f) : 0.0f);
   }
+  if (have_prefs) prefs.end();
 
-  // Compute NTC resistance from divider
-  // Vout = Vs * Rntc / (Rser + Rntc)  => Rntc = Rser * Vout / (Vs - Vout)
-  float denom = (TH_VSUPPLY_MV - vout_mv);
-  if (!(denom > 0.0f)) return NAN;
-  float r_ntc = TH_R_SERIES_OHMS * (vout_mv) / denom;
-  if (!(r_ntc > 0.0f)) return NAN;
+  adc1_config_width(ADC_WIDTH_BIT_12); // 12-bit (0..4095)
+  for (uint8_t i = 0; i < THERMISTOR_COUNT; ++i) {
+    adc1_config_channel_atten((adc1_channel_t)digitalPinToAnalogChannel(CHANNELS[i].pin), ADC_ATTEN_DB_11); // ~0..3.3V range
+  }
+  // eFuse Vref / two-point values when burned in, 1100 mV default otherwise
+  esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, 1100, &g_adc_chars);
 
-  // Beta equation: 1/T = 1/T0 + (1/B)*ln(R/R0)
-  float invT = (1.0f / TH_T0_K) + (1.0f / TH_BETA) * logf(r_ntc / TH_R0_OHMS);
-  float tK = 1.0f / invT;
-  float tC = tK - 273.15f;
-  return tC;
+  // Low priority on core 0, away from loop(); late bursts only shift the filter
+  xTaskCreatePinnedToCore(thermistor_task, "thermistor", 2560, NULL, 1, NULL, 0);
 }
+
+const ThermistorInfo& thermistor_info(uint8_t i) {
+  return CHANNELS[i < THERMISTOR_COUNT ? i : 0];
+}
+
+int thermistor_find(const char* name) {
+  if (!name) return -1;
+  for (uint8_t i = 0; i < THERMISTOR_COUNT; ++i) {
+    if (strcmp(CHANNELS[i].name, name) == 0) return i;
+  }
+  return -1;
+}
+
+float thermistor_temp_c(uint8_t i) {
+  return i < THERMISTOR_COUNT ? g_temp_c[i].load() : NAN;
+}
+
+float thermistor_offset_c(uint8_t i) {
+  return i < THERMISTOR_COUNT ? g_offset_c[i].load() : 0.0f;
+}
+
+bool thermistor_set_offset_c(uint8_t i, float offset_c) {
+  if (i >= THERMISTOR_COUNT || isnan(offset_c) || fabsf(offset_c) > THERMISTOR_MAX_OFFSET_C) return false;
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, false)) return false;
+  bool ok = prefs.putFloat(CHANNELS[i].name, offset_c) == sizeof(float);
+  prefs.end();
+  if (!ok) return false;
+  g_offset_c[i].store(offset_c);
+  LOGI(LOG_MOD_APP, "thermistor %s: offset %.2f °C", CHANNELS[i].name, offset_c);
+  return true;
+}
+
+uint32_t thermistor_generation() { return g_generation.load(); }
@@ -1,7 +1,47 @@
 #pragma once
-#include <Arduino.h>
+#include <stdint.h>
+#include "config.h"
 
-// Read temperature from an NTC 10k B3950 connected in a voltage divider.
-// - adc_pin: ADC pin number (e.g., 34 for GPIO34/ADC1_CH6)
-// Returns: temperature in °C; on error/invalid reading returns NAN.
-float read_thermistor_temp_c(int adc_pin);
+// NTC thermistor channels, declared in config.h (THERMISTOR_CHANNELS): each
+// has a name, an LCD label, an ADC1 pin and a curve (NTC + divider, see
+// ntc_curves.h) converted through a compile-time table.
+//
+// A low-priority task samples every channel every THERMISTOR_SAMPLE_MS: a
+// burst of THERMISTOR_OVERSAMPLE conversions is averaged (oversampling), the
+// last three bursts go through a median (drops single spikes, e.g. from WiFi
+// TX current), then an IIR low-pass with THERMISTOR_TAU_MS time constant.
+// Every THERMISTOR_OUTPUT_MS the filtered voltages are converted to °C, the
+// channel's calibration offset is added and the results are stored in
+// atomics; channels "h" and "l" are also pushed into the inverter snapshot
+// (inverter_publish_temperatures). Readers never touch the ADC or wait.
+//
+// Calibration: one additive offset per channel, persisted in NVS
+// (namespace "thermistor", key = channel name) and loaded at init.
+
+#define THERMISTOR_COUNT_ONE(name, label, pin, curve) +1
+static constexpr uint8_t THERMISTOR_COUNT = 0 THERMISTOR_CHANNELS(THERMISTOR_COUNT_ONE);
+#define THERMISTOR_MAX_OFFSET_C 20.0f
+
+struct ThermistorInfo {
+  const char* name;     // metrics label / JSON key / NVS key
+  const char* label;    // short LCD label
+  uint8_t pin;
+};
+
+// Load calibration, configure ADC1 and start the sampling task
+void thermistor_init();
+
+const ThermistorInfo& thermistor_info(uint8_t i);
+// Channel index by name, -1 if there is none
+int thermistor_find(const char* name);
+
+// Latest filtered, calibrated temperature [°C]; NAN before the first output,
+// for an unknown channel or when the divider reads at a rail
+float thermistor_temp_c(uint8_t i);
+
+float thermistor_offset_c(uint8_t i);
+// Set and persist a channel's offset; false if out of range / NVS failed
+bool thermistor_set_offset_c(uint8_t i, float offset_c);
+
+// Outputs published so far (changes whenever new values are available)
+uint32_t thermistor_generation();
@@ -0,0 +1,77 @@
+#include "touch_button.h"
+
+void TouchButton::calibrate(uint16_t baseline) {
+  baseline_q_ = (uint32_t)baseline << 4;
+  pressed_ = false;
+  pending_ = false;
+  long_sent_ = false;
+}
+
+void TouchButton::track(uint16_t value, uint32_t now_ms) {
+  // A baseline under the press level of the reading was taken with a finger
+  // on the pad: start over from here rather than creep up
+  if ((uint32_t)value * (100 - TOUCH_PRESS_PCT) / 100 > baseline()) {
+    baseline_q_ = (uint32_t)value << 4;
+    tracked_ms_ = now_ms;
+    return;
+  }
+  if ((uint32_t)(now_ms - tracked_ms_) < TOUCH_BASELINE_MS) return;
+  tracked_ms_ = now_ms;
+  int32_t diff = ((int32_t)value << 4) - (int32_t)baseline_q_;
+  // Rising back is recovery from drift: follow 4x faster
+  int32_t step = diff / (diff > 0 ? TOUCH_BASELINE_DIV / 4 : TOUCH_BASELINE_DIV);
+  if (step == 0 && diff != 0) step = diff > 0 ? 1 : -1;
+  baseline_q_ = (uint32_t)((int32_t)baseline_q_ + step);
+}
+
+uint8_t TouchButton::update(uint16_t value, uint32_t now_ms, TouchEvent out[2]) {
+  uint8_t n = 0;
+  bool touching = pressed_ ? value < release_level() : value < press_level();
+
+  if (touching == pressed_) {
+    pending_ = false;
+    if (!pressed_) track(value, now_ms);
+  } else if (!pending_) {
+    pending_ = true;
+    pending_since_ms_ = now_ms;
+  }
+
+  if (pending_ && (uint32_t)(now_ms - pending_since_ms_) >= TOUCH_DEBOUNCE_MS) {
+    pending_ = false;
+    pressed_ = touching;
+    if (pressed_) {
+      // Held since the first sample that saw it
+      pressed_since_ms_ = pending_since_ms_;
+      long_sent_ = false;
+      next_repeat_ms_ = pressed_since_ms_ + TOUCH_REPEAT_DELAY_MS;
+      repeats_ = 0;
+      emit(&out[n++], TOUCH_PRESS, 0);
+    } else {
+      // Released when the finger left, not when the debounce ran out
+      emit(&out[n++], TOUCH_RELEASE, pending_since_ms_ - pressed_since_ms_);
+      tracked_ms_ = now_ms;
+    }
+    return n;
+  }
+
+  if (!pressed_) return n;
+  uint32_t held = now_ms - pressed_since_ms_;
+  if (held >= TOUCH_STUCK_MS) {
+    calibrate(value);
+    recalibrations_++;
+    emit(&out[n++], TOUCH_RELEASE, held);
+    return n;
+  }
+  if (!long_sent_ && held >= TOUCH_LONG_MS) {
+    long_sent_ = true;
+    emit(&out[n++], TOUCH_LONG, held);
+  }
+  if (repeats_ < TOUCH_REPEAT_MAX && (int32_t)(now_ms - next_repeat_ms_) >= 0) {
+    repeats_++;
+    next_repeat_ms_ += TOUCH_REPEAT_MS;
+    // A late sample gives one repeat, not a burst to catch up
+    if ((int32_t)(now_ms - next_repeat_ms_) >= 0) next_repeat_ms_ = now_ms + TOUCH_REPEAT_MS;
+    emit(&out[n++], TOUCH_REPEAT, held);
+  }
+  return n;
+}
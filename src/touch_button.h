@@ -0,0 +1,86 @@
+#pragma once
+#include <stdint.h>
+
+// One capacitive touch pad: baseline tracking, hysteresis, debouncing and
+// gestures. Plain C++ without Arduino dependencies so it can be built on a
+// host (doc/touchReplay.cpp feeds recorded traces through it).
+//
+// ESP32 touch counts drop when a finger is on the pad. Levels are relative
+// to a per-pad baseline, so one setting fits every pad and board:
+//   press    value below baseline x (100 - TOUCH_PRESS_PCT) %
+//   release  value back above baseline x (100 - TOUCH_RELEASE_PCT) %
+// and either change has to hold for TOUCH_DEBOUNCE_MS before it counts.
+// The baseline starts from the calibration mean and follows the untouched
+// value by 1/TOUCH_BASELINE_DIV of the difference every TOUCH_BASELINE_MS
+// (4x faster upward) and is frozen while the pad is pressed or a press is
+// pending. A reading whose own press level is above the baseline means a
+// finger was on the pad at calibration: the baseline restarts from it.
+// A press held for TOUCH_STUCK_MS is taken as drift (water, a part resting
+// on the pad): the pad is released and recalibrated to the current value.
+//
+// Events while pressed: TOUCH_LONG once after TOUCH_LONG_MS, TOUCH_REPEAT
+// after TOUCH_REPEAT_DELAY_MS and then every TOUCH_REPEAT_MS, at most
+// TOUCH_REPEAT_MAX times per press. A film or a resting part looks like a
+// held finger until TOUCH_STUCK_MS, so the cap bounds how far it scrolls.
+
+#define TOUCH_PRESS_PCT        30      // drop below baseline that presses
+#define TOUCH_RELEASE_PCT      15      // drop that still holds a press (hysteresis)
+#define TOUCH_DEBOUNCE_MS      10
+#define TOUCH_BASELINE_DIV     32
+#define TOUCH_BASELINE_MS      500     // tracking step period, independent of the sample rate
+#define TOUCH_LONG_MS          800
+#define TOUCH_REPEAT_DELAY_MS  500
+#define TOUCH_REPEAT_MS        150
+#define TOUCH_REPEAT_MAX       20      // repeats per press (~3.5 s held), then silence
+#define TOUCH_STUCK_MS         30000
+
+enum TouchEventType : uint8_t {
+  TOUCH_PRESS = 0,
+  TOUCH_RELEASE,      // held_ms = press duration
+  TOUCH_LONG,
+  TOUCH_REPEAT,
+  TOUCH_EVENT_TYPES
+};
+
+struct TouchEvent {
+  uint8_t pad;
+  TouchEventType type;
+  uint32_t held_ms;   // since the press was accepted (0 for TOUCH_PRESS)
+  int64_t t_us;       // when the touch was first seen, for latency (set by the caller)
+};
+
+class TouchButton {
+public:
+  // Start from an untouched mean (counts)
+  void calibrate(uint16_t baseline);
+
+  // Feed one measurement taken at now_ms. Writes up to 2 events (type and
+  // held_ms; pad and t_us are left to the caller) to out and returns how many.
+  uint8_t update(uint16_t value, uint32_t now_ms, TouchEvent out[2]);
+
+  bool pressed() const { return pressed_; }
+  // A change of state is waiting out the debounce
+  bool pending() const { return pending_; }
+  bool active() const { return pressed_ || pending_; }
+  uint16_t baseline() const { return (uint16_t)(baseline_q_ >> 4); }
+  // Hardware interrupt threshold: the press level
+  uint16_t press_level() const { return level(TOUCH_PRESS_PCT); }
+  uint16_t release_level() const { return level(TOUCH_RELEASE_PCT); }
+  uint32_t recalibrations() const { return recalibrations_; }
+
+private:
+  uint16_t level(uint32_t pct) const { return (uint16_t)((uint32_t)baseline() * (100 - pct) / 100); }
+  void track(uint16_t value, uint32_t now_ms);
+  static void emit(TouchEvent* e, TouchEventType type, uint32_t held_ms) { e->type = type; e->held_ms = held_ms; }
+
+  uint32_t baseline_q_ = 0;       // baseline x 16
+  uint32_t tracked_ms_ = 0;
+  bool pressed_ = false;
+  bool pending_ = false;
+  uint32_t pending_since_ms_ = 0;
+  uint32_t pressed_since_ms_ = 0;
+  bool long_sent_ = false;
+  uint32_t next_repeat_ms_ = 0;
+  uint16_t repeats_ = 0;
+  uint32_t recalibrations_ = 0;
+};
@@ -0,0 +1,170 @@
+#include "touch_input.h"
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <driver/touch_pad.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include "logger.h"
+
+#define TOUCH_QUEUE_LEN 16
+
+static const uint8_t PAD_PINS[TOUCH_BUTTON_COUNT] = { BTN_UP_TOUCH, BTN_LEFT_TOUCH, BTN_DOWN_TOUCH, BTN_RIGHT_TOUCH };
+static const char* const PAD_NAMES[TOUCH_BUTTON_COUNT] = { "up", "left", "down", "right" };
+static const char* const EVENT_NAMES[TOUCH_EVENT_TYPES] = { "press", "release", "long", "repeat" };
+
+static touch_pad_t g_pads[TOUCH_BUTTON_COUNT];
+static QueueHandle_t g_queue = nullptr;
+static TaskHandle_t g_task = nullptr;
+static volatile int64_t g_irq_us = 0;     // last touch interrupt
+
+static portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+static const uint32_t LATENCY_BOUNDS_US[] = { 5000, 10000, 15000, 20000, 30000, 50000, 75000, 100000 };
+static TouchStats g_stats = {};
+
+// Fires on every measurement round with a pad below its threshold; the task
+// disables it while it polls
+static void touch_isr(void* arg) {
+  (void)arg;
+  touch_pad_clear_status();
+  g_irq_us = esp_timer_get_time();
+  portENTER_CRITICAL_ISR(&g_mux);
+  g_stats.interrupts++;
+  portEXIT_CRITICAL_ISR(&g_mux);
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(g_task, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+static void post(const TouchEvent& ev) {
+  bool ok = xQueueSend(g_queue, &ev, 0) == pdTRUE;
+  portENTER_CRITICAL(&g_mux);
+  if (ok) g_stats.events[ev.pad][ev.type]++;
+  else g_stats.dropped++;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+static void calibrate(TouchButton* btns) {
+  uint32_t sum[TOUCH_BUTTON_COUNT] = {};
+  // Let the FSM finish a round with the final settings first
+  vTaskDelay(pdMS_TO_TICKS(TOUCH_SAMPLE_MS * 2));
+  for (int n = 0; n < TOUCH_CALIBRATE_SAMPLES; ++n) {
+    for (uint8_t i = 0; i < TOUCH_BUTTON_COUNT; ++i) {
+      uint16_t v = 0;
+      touch_pad_read(g_pads[i], &v);
+      sum[i] += v;
+    }
+    vTaskDelay(pdMS_TO_TICKS(TOUCH_SAMPLE_MS));
+  }
+  for (uint8_t i = 0; i < TOUCH_BUTTON_COUNT; ++i) {
+    btns[i].calibrate((uint16_t)(sum[i] / TOUCH_CALIBRATE_SAMPLES));
+    touch_pad_set_thresh(g_pads[i], btns[i].press_level());
+    LOGI(LOG_MOD_APP, "touch %s (GPIO%u): baseline %u, press below %u", PAD_NAMES[i], (unsigned)PAD_PINS[i],
+         (unsigned)btns[i].baseline(), (unsigned)btns[i].press_level());
+  }
+}
+
+static void touch_task(void* arg) {
+  (void)arg;
+  TouchButton btns[TOUCH_BUTTON_COUNT];
+  uint16_t thresh[TOUCH_BUTTON_COUNT];
+  int64_t first_us[TOUCH_BUTTON_COUNT] = {};
+  calibrate(btns);
+  for (uint8_t i = 0; i < TOUCH_BUTTON_COUNT; ++i) thresh[i] = btns[i].press_level();
+
+  bool active = false;
+  for (;;) {
+    int64_t irq_us = 0;
+    if (active) {
+      vTaskDelay(pdMS_TO_TICKS(TOUCH_SAMPLE_MS));
+    } else {
+      touch_pad_clear_status();
+      touch_pad_intr_enable();
+      if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TOUCH_IDLE_MS))) irq_us = g_irq_us;
+      touch_pad_intr_disable();
+      ulTaskNotifyTake(pdTRUE, 0);   // one that slipped in before the disable
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    uint32_t now_ms = (uint32_t)(now_us / 1000);
+    uint16_t values[TOUCH_BUTTON_COUNT];
+    uint32_t recal = 0;
+    active = false;
+    for (uint8_t i = 0; i < TOUCH_BUTTON_COUNT; ++i) {
+      uint16_t v = 0;
+      touch_pad_read(g_pads[i], &v);   // last FSM result
+      values[i] = v;
+      bool was_active = btns[i].active();
+      TouchEvent evs[2];
+      uint8_t n = btns[i].update(v, now_ms, evs);
+      // The interrupt saw it first when it woke us
+      if (!was_active && btns[i].active()) first_us[i] = irq_us ? irq_us : now_us;
+      for (uint8_t k = 0; k < n; ++k) {
+        evs[k].pad = i;
+        evs[k].t_us = first_us[i];
+        post(evs[k]);
+      }
+      if (btns[i].active()) active = true;
+      recal += btns[i].recalibrations();
+      if (btns[i].press_level() != thresh[i]) {
+        thresh[i] = btns[i].press_level();
+        touch_pad_set_thresh(g_pads[i], thresh[i]);
+      }
+    }
+
+    portENTER_CRITICAL(&g_mux);
+    for (uint8_t i = 0; i < TOUCH_BUTTON_COUNT; ++i) {
+      g_stats.baseline[i] = btns[i].baseline();
+      g_stats.value[i] = values[i];
+    }
+    g_stats.recalibrations = recal;
+    portEXIT_CRITICAL(&g_mux);
+  }
+}
+
+// --- Public API ---
+
+void touch_input_init() {
+  histogram_init(&g_stats.press_latency_us, LATENCY_BOUNDS_US,
+                 sizeof(LATENCY_BOUNDS_US) / sizeof(LATENCY_BOUNDS_US[0]), 1000000);
+  g_queue = xQueueCreate(TOUCH_QUEUE_LEN, sizeof(TouchEvent));
+
+  touch_pad_init();
+  touch_pad_set_voltage(TOUCH_HVOLT_2V7, TOUCH_LVOLT_0V5, TOUCH_HVOLT_ATTEN_1V);
+  touch_pad_set_meas_time(TOUCH_SLEEP_CYCLES, TOUCH_MEAS_CYCLES);
+  for (uint8_t i = 0; i < TOUCH_BUTTON_COUNT; ++i) {
+    g_pads[i] = (touch_pad_t)digitalPinToTouchChannel(PAD_PINS[i]);
+    touch_pad_config(g_pads[i], 0);   // no interrupt until calibrated
+  }
+  touch_pad_set_fsm_mode(TOUCH_FSM_MODE_TIMER);
+
+  // Low priority on core 0; the interrupt gets it running within a tick
+  xTaskCreatePinnedToCore(touch_task, "touch", 2560, NULL, 1, &g_task, 0);
+  touch_pad_isr_register(touch_isr, NULL);
+}
+
+bool touch_input_next(TouchEvent* ev) {
+  if (!g_queue || xQueueReceive(g_queue, ev, 0) != pdTRUE) return false;
+  if (ev->type == TOUCH_PRESS) {
+    uint32_t us = (uint32_t)(esp_timer_get_time() - ev->t_us);
+    portENTER_CRITICAL(&g_mux);
+    histogram_observe(&g_stats.press_latency_us, us);
+    portEXIT_CRITICAL(&g_mux);
+  }
+  return true;
+}
+
+const char* touch_input_pad_name(uint8_t pad) {
+  return pad < TOUCH_BUTTON_COUNT ? PAD_NAMES[pad] : "?";
+}
+
+const char* touch_input_event_name(TouchEventType type) {
+  return type < TOUCH_EVENT_TYPES ? EVENT_NAMES[type] : "?";
+}
+
+void touch_input_get_stats(TouchStats* out) {
+  if (!out) return;
+  portENTER_CRITICAL(&g_mux);
+  *out = g_stats;
+  portEXIT_CRITICAL(&g_mux);
+}
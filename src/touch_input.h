@@ -0,0 +1,44 @@
+#pragma once
+#include <stdint.h>
+#include "config.h"
+#include "histogram.h"
+#include "touch_button.h"
+
+// Capacitive touch buttons (config.h BTN_*_TOUCH), index order Up, Left,
+// Down, Right as in main.cpp's handler tables.
+//
+// The touch peripheral measures every pad in hardware (FSM timer mode,
+// TOUCH_MEAS_CYCLES per pad, TOUCH_SLEEP_CYCLES between rounds) and raises
+// an interrupt when a pad drops below its press level. A low-priority task
+// sleeps until that interrupt, then reads the pads every TOUCH_SAMPLE_MS
+// (register reads, no waiting on a measurement) and runs each through a
+// TouchButton (touch_button.h: baseline, hysteresis, debounce, long press,
+// repeat) until all are idle again. While idle it wakes every TOUCH_IDLE_MS
+// to let the baselines follow drift and moves the interrupt thresholds with
+// them. Baselines are calibrated from TOUCH_CALIBRATE_SAMPLES reads when the
+// task starts.
+//
+// Events go into a queue; loop() drains it with touch_input_next() and runs
+// the handlers, so they stay on the loop() thread as before.
+
+#define TOUCH_BUTTON_COUNT 4
+
+// Configure the touch peripheral and start the task (returns immediately)
+void touch_input_init();
+
+// Next event, false when the queue is empty (never blocks)
+bool touch_input_next(TouchEvent* ev);
+
+const char* touch_input_pad_name(uint8_t pad);
+const char* touch_input_event_name(TouchEventType type);
+
+struct TouchStats {
+  uint32_t events[TOUCH_BUTTON_COUNT][TOUCH_EVENT_TYPES];
+  uint32_t dropped;                    // queue full
+  uint32_t interrupts;
+  uint32_t recalibrations;             // stuck presses re-baselined
+  uint16_t baseline[TOUCH_BUTTON_COUNT];  // counts
+  uint16_t value[TOUCH_BUTTON_COUNT];     // last read
+  Histogram press_latency_us;          // first touched measurement -> press handed to loop()
+};
+void touch_input_get_stats(TouchStats* out);
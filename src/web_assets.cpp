@@ -0,0 +1,25 @@
+#include "web_assets.h"
+#include <string.h>
+#include "web_assets_data.h"
+
+static const size_t WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);
+
+static uint32_t fnv1a32(const char* s, size_t len) {
+  uint32_t h = 0x811C9DC5u;
+  for (size_t i = 0; i < len; ++i) h = (h ^ (uint8_t)s[i]) * 0x01000193u;
+  return h;
+}
+
+const WebAsset* web_asset_find(const char* path, size_t len) {
+  uint32_t h = fnv1a32(path, len);
+  // Table is sorted by hash (the generator rejects collisions)
+  size_t lo = 0, hi = WEB_ASSET_COUNT;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (WEB_ASSETS[mid].path_hash < h) lo = mid + 1;
+    else hi = mid;
+  }
+  if (lo == WEB_ASSET_COUNT || WEB_ASSETS[lo].path_hash != h) return nullptr;
+  const WebAsset& a = WEB_ASSETS[lo];
+  return (strlen(a.path) == len && memcmp(a.path, path, len) == 0) ? &a : nullptr;
+}
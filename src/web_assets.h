@@ -0,0 +1,23 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Web UI files compiled into flash at build time (scripts/gen_web_assets.py
+// gzips and fingerprints data/ into src/web_assets_data.h). Served with
+// Content-Encoding: gzip and an ETag; fingerprinted paths (app.<hash>.js)
+// are immutable. LittleFS is only a fallback for files not in the table or
+// clients that do not accept gzip.
+
+struct WebAsset {
+  uint32_t path_hash;        // FNV-1a of path
+  const char* path;
+  const uint8_t* data;       // flash-resident
+  size_t length;
+  const char* content_type;
+  const char* etag;          // quoted, as sent
+  bool immutable;
+  bool gzip;
+};
+
+// Find the asset for a URL path (no query string); nullptr if not built in
+const WebAsset* web_asset_find(const char* path, size_t len);